@@ -21,6 +21,7 @@
 
 #include "wine/debug.h"
 #include "wine/heap.h"
+#include "wine/list.h"
 
 #include <assert.h>
 #include <limits.h>
@@ -158,6 +159,7 @@ struct d2d_device_context
     D2D1_RENDER_TARGET_PROPERTIES desc;
     D2D1_SIZE_U pixel_size;
     struct d2d_clip_stack clip_stack;
+    struct list fill_buffers;
 };
 
 HRESULT d2d_d3d_create_render_target(ID2D1Device *device, IDXGISurface *surface, IUnknown *outer_unknown,
@@ -424,6 +426,21 @@ struct d2d_curve_outline_vertex
     D2D1_POINT_2F prev, next;
 };
 
+/* Device buffers holding a geometry's fill, reused across FillGeometry()
+ * calls for as long as the geometry is drawn by the same device context. The
+ * device context keeps a list of the buffers it created, and destroys them
+ * when it is destroyed itself. */
+struct d2d_fill_buffers
+{
+    struct list entry;
+    struct d2d_device_context *owner;
+    struct d2d_geometry *geometry;
+    ID3D10Buffer *ib;
+    ID3D10Buffer *vb;
+    ID3D10Buffer *bezier_vb;
+    ID3D10Buffer *arc_vb;
+};
+
 struct d2d_geometry
 {
     ID2D1Geometry ID2D1Geometry_iface;
@@ -433,6 +450,11 @@ struct d2d_geometry
 
     D2D_MATRIX_3X2_F transform;
 
+    /* The geometry owning the fill data, and therefore the fill buffers.
+     * Transformed geometries share the fill data of their source. */
+    struct d2d_geometry *fill_source;
+    struct d2d_fill_buffers *fill_buffers;
+
     struct
     {
         D2D1_POINT_2F *vertices;
@@ -532,6 +554,7 @@ void d2d_transformed_geometry_init(struct d2d_geometry *geometry, ID2D1Factory *
 HRESULT d2d_geometry_group_init(struct d2d_geometry *geometry, ID2D1Factory *factory,
         D2D1_FILL_MODE fill_mode, ID2D1Geometry **src_geometries, unsigned int geometry_count) DECLSPEC_HIDDEN;
 struct d2d_geometry *unsafe_impl_from_ID2D1Geometry(ID2D1Geometry *iface) DECLSPEC_HIDDEN;
+void d2d_geometry_release_fill_buffers(struct d2d_geometry *geometry) DECLSPEC_HIDDEN;
 
 struct d2d_device
 {
@@ -20,6 +20,18 @@
 
 WINE_DEFAULT_DEBUG_CHANNEL(d2d);
 
+/* Protects the fill buffers cached by geometries, which may be shared by
+ * device contexts used from different threads. */
+static CRITICAL_SECTION d2d_fill_buffers_cs;
+static CRITICAL_SECTION_DEBUG d2d_fill_buffers_cs_debug =
+{
+    0, 0, &d2d_fill_buffers_cs,
+    { &d2d_fill_buffers_cs_debug.ProcessLocksList,
+      &d2d_fill_buffers_cs_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": d2d_fill_buffers_cs") }
+};
+static CRITICAL_SECTION d2d_fill_buffers_cs = { &d2d_fill_buffers_cs_debug, -1, 0, 0, 0, 0 };
+
 #define INITIAL_CLIP_STACK_SIZE 4
 
 static const D2D1_MATRIX_3X2_F identity =
@@ -245,6 +257,60 @@ static ULONG STDMETHODCALLTYPE d2d_device_context_inner_AddRef(IUnknown *iface)
     return refcount;
 }
 
+static void d2d_fill_buffers_cleanup(struct d2d_fill_buffers *buffers)
+{
+    if (buffers->arc_vb)
+        ID3D10Buffer_Release(buffers->arc_vb);
+    if (buffers->bezier_vb)
+        ID3D10Buffer_Release(buffers->bezier_vb);
+    if (buffers->vb)
+        ID3D10Buffer_Release(buffers->vb);
+    if (buffers->ib)
+        ID3D10Buffer_Release(buffers->ib);
+}
+
+static void d2d_fill_buffers_get_references(const struct d2d_fill_buffers *buffers, struct d2d_fill_buffers *out)
+{
+    memset(out, 0, sizeof(*out));
+    if ((out->ib = buffers->ib))
+        ID3D10Buffer_AddRef(out->ib);
+    if ((out->vb = buffers->vb))
+        ID3D10Buffer_AddRef(out->vb);
+    if ((out->bezier_vb = buffers->bezier_vb))
+        ID3D10Buffer_AddRef(out->bezier_vb);
+    if ((out->arc_vb = buffers->arc_vb))
+        ID3D10Buffer_AddRef(out->arc_vb);
+}
+
+/* Must be called with d2d_fill_buffers_cs held. */
+static void d2d_fill_buffers_destroy(struct d2d_fill_buffers *buffers)
+{
+    list_remove(&buffers->entry);
+    buffers->geometry->fill_buffers = NULL;
+    d2d_fill_buffers_cleanup(buffers);
+    heap_free(buffers);
+}
+
+void d2d_geometry_release_fill_buffers(struct d2d_geometry *geometry)
+{
+    EnterCriticalSection(&d2d_fill_buffers_cs);
+    if (geometry->fill_buffers)
+        d2d_fill_buffers_destroy(geometry->fill_buffers);
+    LeaveCriticalSection(&d2d_fill_buffers_cs);
+}
+
+static void d2d_device_context_release_fill_buffers(struct d2d_device_context *context)
+{
+    struct d2d_fill_buffers *buffers, *next;
+
+    EnterCriticalSection(&d2d_fill_buffers_cs);
+    LIST_FOR_EACH_ENTRY_SAFE(buffers, next, &context->fill_buffers, struct d2d_fill_buffers, entry)
+    {
+        d2d_fill_buffers_destroy(buffers);
+    }
+    LeaveCriticalSection(&d2d_fill_buffers_cs);
+}
+
 static ULONG STDMETHODCALLTYPE d2d_device_context_inner_Release(IUnknown *iface)
 {
     struct d2d_device_context *context = impl_from_IUnknown(iface);
@@ -256,6 +322,7 @@ static ULONG STDMETHODCALLTYPE d2d_device_context_inner_Release(IUnknown *iface)
     {
         unsigned int i;
 
+        d2d_device_context_release_fill_buffers(context);
         d2d_clip_stack_cleanup(&context->clip_stack);
         IDWriteRenderingParams_Release(context->default_text_rendering_params);
         if (context->text_rendering_params)
@@ -883,10 +950,134 @@ static void STDMETHODCALLTYPE d2d_device_context_DrawGeometry(ID2D1DeviceContext
     d2d_device_context_draw_geometry(render_target, geometry_impl, brush_impl, stroke_width);
 }
 
+static HRESULT d2d_device_context_create_fill_buffers(struct d2d_device_context *render_target,
+        const struct d2d_geometry *geometry, struct d2d_fill_buffers *buffers)
+{
+    D3D10_SUBRESOURCE_DATA buffer_data;
+    D3D10_BUFFER_DESC buffer_desc;
+    HRESULT hr;
+
+    buffer_desc.Usage = D3D10_USAGE_DEFAULT;
+    buffer_desc.CPUAccessFlags = 0;
+    buffer_desc.MiscFlags = 0;
+
+    buffer_data.SysMemPitch = 0;
+    buffer_data.SysMemSlicePitch = 0;
+
+    if (geometry->fill.face_count)
+    {
+        buffer_desc.ByteWidth = geometry->fill.face_count * sizeof(*geometry->fill.faces);
+        buffer_desc.BindFlags = D3D10_BIND_INDEX_BUFFER;
+        buffer_data.pSysMem = geometry->fill.faces;
+
+        if (FAILED(hr = ID3D10Device_CreateBuffer(render_target->d3d_device,
+                &buffer_desc, &buffer_data, &buffers->ib)))
+        {
+            WARN("Failed to create index buffer, hr %#x.\n", hr);
+            return hr;
+        }
+
+        buffer_desc.ByteWidth = geometry->fill.vertex_count * sizeof(*geometry->fill.vertices);
+        buffer_desc.BindFlags = D3D10_BIND_VERTEX_BUFFER;
+        buffer_data.pSysMem = geometry->fill.vertices;
+
+        if (FAILED(hr = ID3D10Device_CreateBuffer(render_target->d3d_device,
+                &buffer_desc, &buffer_data, &buffers->vb)))
+        {
+            ERR("Failed to create vertex buffer, hr %#x.\n", hr);
+            return hr;
+        }
+    }
+
+    if (geometry->fill.bezier_vertex_count)
+    {
+        buffer_desc.ByteWidth = geometry->fill.bezier_vertex_count * sizeof(*geometry->fill.bezier_vertices);
+        buffer_desc.BindFlags = D3D10_BIND_VERTEX_BUFFER;
+        buffer_data.pSysMem = geometry->fill.bezier_vertices;
+
+        if (FAILED(hr = ID3D10Device_CreateBuffer(render_target->d3d_device,
+                &buffer_desc, &buffer_data, &buffers->bezier_vb)))
+        {
+            ERR("Failed to create beziers vertex buffer, hr %#x.\n", hr);
+            return hr;
+        }
+    }
+
+    if (geometry->fill.arc_vertex_count)
+    {
+        buffer_desc.ByteWidth = geometry->fill.arc_vertex_count * sizeof(*geometry->fill.arc_vertices);
+        buffer_desc.BindFlags = D3D10_BIND_VERTEX_BUFFER;
+        buffer_data.pSysMem = geometry->fill.arc_vertices;
+
+        if (FAILED(hr = ID3D10Device_CreateBuffer(render_target->d3d_device,
+                &buffer_desc, &buffer_data, &buffers->arc_vb)))
+        {
+            ERR("Failed to create arc vertex buffer, hr %#x.\n", hr);
+            return hr;
+        }
+    }
+
+    return S_OK;
+}
+
+/* The fill buffers are created on first use and then cached by the geometry
+ * owning the fill data, so that drawing the same geometry again, or drawing a
+ * transformed geometry sharing its fill, doesn't upload the fill again. A
+ * geometry caches buffers for a single device context; drawing it with
+ * another one replaces them. "buffers" receives references to the buffers,
+ * which the caller releases with d2d_fill_buffers_cleanup() after drawing. */
+static BOOL d2d_device_context_get_fill_buffers(struct d2d_device_context *render_target,
+        const struct d2d_geometry *geometry, struct d2d_fill_buffers *buffers)
+{
+    struct d2d_geometry *source = geometry->fill_source;
+    struct d2d_fill_buffers *cached;
+
+    EnterCriticalSection(&d2d_fill_buffers_cs);
+    if ((cached = source->fill_buffers) && cached->owner == render_target)
+    {
+        d2d_fill_buffers_get_references(cached, buffers);
+        LeaveCriticalSection(&d2d_fill_buffers_cs);
+        return TRUE;
+    }
+    LeaveCriticalSection(&d2d_fill_buffers_cs);
+
+    if (!(cached = heap_alloc_zero(sizeof(*cached))))
+        return FALSE;
+
+    if (FAILED(d2d_device_context_create_fill_buffers(render_target, geometry, cached)))
+    {
+        d2d_fill_buffers_cleanup(cached);
+        heap_free(cached);
+        return FALSE;
+    }
+    d2d_fill_buffers_get_references(cached, buffers);
+
+    /* Path geometries only get their fill when they're closed; don't cache
+     * buffers for geometries without one. */
+    if (!cached->ib && !cached->bezier_vb && !cached->arc_vb)
+    {
+        d2d_fill_buffers_cleanup(cached);
+        heap_free(cached);
+        return TRUE;
+    }
+
+    EnterCriticalSection(&d2d_fill_buffers_cs);
+    if (source->fill_buffers)
+        d2d_fill_buffers_destroy(source->fill_buffers);
+    cached->owner = render_target;
+    cached->geometry = source;
+    list_add_head(&render_target->fill_buffers, &cached->entry);
+    source->fill_buffers = cached;
+    LeaveCriticalSection(&d2d_fill_buffers_cs);
+
+    return TRUE;
+}
+
 static void d2d_device_context_fill_geometry(struct d2d_device_context *render_target,
         const struct d2d_geometry *geometry, struct d2d_brush *brush, struct d2d_brush *opacity_brush)
 {
-    ID3D10Buffer *ib, *vb, *vs_cb, *ps_cb_bezier, *ps_cb_arc;
+    ID3D10Buffer *vs_cb, *ps_cb_bezier, *ps_cb_arc;
+    struct d2d_fill_buffers buffers;
     D3D10_SUBRESOURCE_DATA buffer_data;
     D3D10_BUFFER_DESC buffer_desc;
     D2D1_MATRIX_3X2_F *w;
@@ -957,71 +1148,23 @@ static void d2d_device_context_fill_geometry(struct d2d_device_context *render_t
         return;
     }
 
-    if (geometry->fill.face_count)
-    {
-        buffer_desc.ByteWidth = geometry->fill.face_count * sizeof(*geometry->fill.faces);
-        buffer_desc.BindFlags = D3D10_BIND_INDEX_BUFFER;
-        buffer_data.pSysMem = geometry->fill.faces;
-
-        if (FAILED(hr = ID3D10Device_CreateBuffer(render_target->d3d_device, &buffer_desc, &buffer_data, &ib)))
-        {
-            WARN("Failed to create index buffer, hr %#x.\n", hr);
-            goto done;
-        }
-
-        buffer_desc.ByteWidth = geometry->fill.vertex_count * sizeof(*geometry->fill.vertices);
-        buffer_desc.BindFlags = D3D10_BIND_VERTEX_BUFFER;
-        buffer_data.pSysMem = geometry->fill.vertices;
-
-        if (FAILED(hr = ID3D10Device_CreateBuffer(render_target->d3d_device, &buffer_desc, &buffer_data, &vb)))
-        {
-            ERR("Failed to create vertex buffer, hr %#x.\n", hr);
-            ID3D10Buffer_Release(ib);
-            goto done;
-        }
-
-        d2d_device_context_draw(render_target, D2D_SHAPE_TYPE_TRIANGLE, ib, 3 * geometry->fill.face_count, vb,
-                sizeof(*geometry->fill.vertices), vs_cb, ps_cb_bezier, brush, opacity_brush);
-
-        ID3D10Buffer_Release(vb);
-        ID3D10Buffer_Release(ib);
-    }
-
-    if (geometry->fill.bezier_vertex_count)
-    {
-        buffer_desc.ByteWidth = geometry->fill.bezier_vertex_count * sizeof(*geometry->fill.bezier_vertices);
-        buffer_desc.BindFlags = D3D10_BIND_VERTEX_BUFFER;
-        buffer_data.pSysMem = geometry->fill.bezier_vertices;
-
-        if (FAILED(hr = ID3D10Device_CreateBuffer(render_target->d3d_device, &buffer_desc, &buffer_data, &vb)))
-        {
-            ERR("Failed to create beziers vertex buffer, hr %#x.\n", hr);
-            goto done;
-        }
+    if (!d2d_device_context_get_fill_buffers(render_target, geometry, &buffers))
+        goto done;
 
-        d2d_device_context_draw(render_target, D2D_SHAPE_TYPE_CURVE, NULL, geometry->fill.bezier_vertex_count, vb,
-                sizeof(*geometry->fill.bezier_vertices), vs_cb, ps_cb_bezier, brush, opacity_brush);
+    if (buffers.ib)
+        d2d_device_context_draw(render_target, D2D_SHAPE_TYPE_TRIANGLE, buffers.ib, 3 * geometry->fill.face_count,
+                buffers.vb, sizeof(*geometry->fill.vertices), vs_cb, ps_cb_bezier, brush, opacity_brush);
 
-        ID3D10Buffer_Release(vb);
-    }
+    if (buffers.bezier_vb)
+        d2d_device_context_draw(render_target, D2D_SHAPE_TYPE_CURVE, NULL, geometry->fill.bezier_vertex_count,
+                buffers.bezier_vb, sizeof(*geometry->fill.bezier_vertices), vs_cb, ps_cb_bezier,
+                brush, opacity_brush);
 
-    if (geometry->fill.arc_vertex_count)
-    {
-        buffer_desc.ByteWidth = geometry->fill.arc_vertex_count * sizeof(*geometry->fill.arc_vertices);
-        buffer_desc.BindFlags = D3D10_BIND_VERTEX_BUFFER;
-        buffer_data.pSysMem = geometry->fill.arc_vertices;
+    if (buffers.arc_vb)
+        d2d_device_context_draw(render_target, D2D_SHAPE_TYPE_CURVE, NULL, geometry->fill.arc_vertex_count,
+                buffers.arc_vb, sizeof(*geometry->fill.arc_vertices), vs_cb, ps_cb_arc, brush, opacity_brush);
 
-        if (FAILED(hr = ID3D10Device_CreateBuffer(render_target->d3d_device, &buffer_desc, &buffer_data, &vb)))
-        {
-            ERR("Failed to create arc vertex buffer, hr %#x.\n", hr);
-            goto done;
-        }
-
-        d2d_device_context_draw(render_target, D2D_SHAPE_TYPE_CURVE, NULL, geometry->fill.arc_vertex_count, vb,
-                sizeof(*geometry->fill.arc_vertices), vs_cb, ps_cb_arc, brush, opacity_brush);
-
-        ID3D10Buffer_Release(vb);
-    }
+    d2d_fill_buffers_cleanup(&buffers);
 
 done:
     ID3D10Buffer_Release(ps_cb_arc);
@@ -3844,6 +3987,7 @@ static HRESULT d2d_device_context_init(struct d2d_device_context *render_target,
     render_target->IDWriteTextRenderer_iface.lpVtbl = &d2d_text_renderer_vtbl;
     render_target->IUnknown_iface.lpVtbl = &d2d_device_context_inner_unknown_vtbl;
     render_target->refcount = 1;
+    list_init(&render_target->fill_buffers);
     ID2D1Device_GetFactory(device, &render_target->factory);
     render_target->device = device;
     ID2D1Device_AddRef(render_target->device);
@@ -110,6 +110,13 @@ struct d2d_geometry_intersection
     D2D1_POINT_2F p;
 };
 
+struct d2d_geometry_segment
+{
+    struct d2d_segment_idx idx;
+    D2D_RECT_F bounds;
+    BOOL bezier;
+};
+
 struct d2d_geometry_intersections
 {
     struct d2d_geometry_intersection *intersections;
@@ -1933,78 +1940,144 @@ static BOOL d2d_geometry_apply_intersections(struct d2d_geometry *geometry,
     return TRUE;
 }
 
-/* Intersect the geometry's segments with themselves. This uses the
- * straightforward approach of testing everything against everything, but
- * there certainly exist more scalable algorithms for this. */
+static int __cdecl d2d_geometry_segment_compare(const void *a, const void *b)
+{
+    const struct d2d_geometry_segment *s0 = a;
+    const struct d2d_geometry_segment *s1 = b;
+
+    if (s0->bounds.left != s1->bounds.left)
+        return s0->bounds.left > s1->bounds.left ? 1 : -1;
+    if (s0->idx.figure_idx != s1->idx.figure_idx)
+        return s0->idx.figure_idx > s1->idx.figure_idx ? 1 : -1;
+    if (s0->idx.vertex_idx != s1->idx.vertex_idx)
+        return s0->idx.vertex_idx > s1->idx.vertex_idx ? 1 : -1;
+    return 0;
+}
+
+/* "p" is expected to come after "q" in figure and vertex order. */
+static BOOL d2d_geometry_intersect_segments(struct d2d_geometry *geometry,
+        struct d2d_geometry_intersections *intersections,
+        const struct d2d_geometry_segment *p, const struct d2d_geometry_segment *q)
+{
+    if (q->bezier)
+    {
+        if (p->bezier)
+            return d2d_geometry_intersect_bezier_bezier(geometry, intersections,
+                    &p->idx, 0.0f, 1.0f, &q->idx, 0.0f, 1.0f);
+        return d2d_geometry_intersect_bezier_line(geometry, intersections, &q->idx, &p->idx);
+    }
+
+    if (p->bezier)
+        return d2d_geometry_intersect_bezier_line(geometry, intersections, &p->idx, &q->idx);
+    return d2d_geometry_intersect_line_line(geometry, intersections, &p->idx, &q->idx);
+}
+
+/* Intersect the geometry's segments with themselves. The segments are sorted
+ * by the left edge of their bounding boxes, and each segment is only tested
+ * against the segments whose bounding boxes overlap it. This is a simple
+ * sweep along the x-axis; in the common case of segments that are short
+ * relative to the geometry, it avoids testing every segment against every
+ * other segment. */
 static BOOL d2d_geometry_intersect_self(struct d2d_geometry *geometry)
 {
     struct d2d_geometry_intersections intersections = {0};
-    const struct d2d_figure *figure_p, *figure_q;
-    struct d2d_segment_idx idx_p, idx_q;
-    enum d2d_vertex_type type_p, type_q;
+    const struct d2d_geometry_segment *p, *q, *tmp;
+    struct d2d_geometry_segment *segments, *segment;
+    size_t segment_count, next, i, j;
+    const struct d2d_figure *figure;
+    struct d2d_segment_idx idx;
+    float epsilon, extent;
     BOOL ret = FALSE;
-    size_t max_q;
 
     if (!geometry->u.path.figure_count)
         return TRUE;
 
-    for (idx_p.figure_idx = 0; idx_p.figure_idx < geometry->u.path.figure_count; ++idx_p.figure_idx)
+    for (i = 0, segment_count = 0, extent = 0.0f; i < geometry->u.path.figure_count; ++i)
+    {
+        figure = &geometry->u.path.figures[i];
+        if (!figure->vertex_count)
+            continue;
+        segment_count += figure->vertex_count;
+        extent = max(extent, max(max(fabsf(figure->bounds.left), fabsf(figure->bounds.right)),
+                max(fabsf(figure->bounds.top), fabsf(figure->bounds.bottom))));
+    }
+    if (!segment_count)
+        return TRUE;
+
+    if (!(segments = heap_calloc(segment_count, sizeof(*segments))))
+    {
+        ERR("Failed to allocate segments array.\n");
+        return FALSE;
+    }
+
+    /* Pad the bounding boxes a little, so that rounding in the bounds
+     * calculation doesn't cause touching segments to be skipped. */
+    epsilon = extent * 1e-5f;
+
+    segment = segments;
+    for (idx.figure_idx = 0; idx.figure_idx < geometry->u.path.figure_count; ++idx.figure_idx)
     {
-        figure_p = &geometry->u.path.figures[idx_p.figure_idx];
-        idx_p.control_idx = 0;
-        for (idx_p.vertex_idx = 0; idx_p.vertex_idx < figure_p->vertex_count; ++idx_p.vertex_idx)
+        figure = &geometry->u.path.figures[idx.figure_idx];
+        idx.control_idx = 0;
+        for (idx.vertex_idx = 0; idx.vertex_idx < figure->vertex_count; ++idx.vertex_idx, ++segment)
         {
-            type_p = figure_p->vertex_types[idx_p.vertex_idx];
-            for (idx_q.figure_idx = 0; idx_q.figure_idx <= idx_p.figure_idx; ++idx_q.figure_idx)
+            next = idx.vertex_idx + 1;
+            if (next == figure->vertex_count)
+                next = 0;
+
+            segment->idx = idx;
+            if ((segment->bezier = d2d_vertex_type_is_bezier(figure->vertex_types[idx.vertex_idx])))
             {
-                figure_q = &geometry->u.path.figures[idx_q.figure_idx];
-                if (idx_q.figure_idx != idx_p.figure_idx)
-                {
-                    if (!d2d_rect_check_overlap(&figure_p->bounds, &figure_q->bounds))
-                        continue;
-                    max_q = figure_q->vertex_count;
-                }
-                else
-                {
-                    max_q = idx_p.vertex_idx;
-                }
+                d2d_rect_get_bezier_bounds(&segment->bounds, &figure->vertices[idx.vertex_idx],
+                        &figure->bezier_controls[idx.control_idx], &figure->vertices[next]);
+                ++idx.control_idx;
+            }
+            else
+            {
+                segment->bounds.left = segment->bounds.right = figure->vertices[idx.vertex_idx].x;
+                segment->bounds.top = segment->bounds.bottom = figure->vertices[idx.vertex_idx].y;
+                d2d_rect_expand(&segment->bounds, &figure->vertices[next]);
+            }
+            segment->bounds.left -= epsilon;
+            segment->bounds.top -= epsilon;
+            segment->bounds.right += epsilon;
+            segment->bounds.bottom += epsilon;
+        }
+    }
+
+    qsort(segments, segment_count, sizeof(*segments), d2d_geometry_segment_compare);
 
-                idx_q.control_idx = 0;
-                for (idx_q.vertex_idx = 0; idx_q.vertex_idx < max_q; ++idx_q.vertex_idx)
+    for (i = 0; i < segment_count; ++i)
+    {
+        for (j = i + 1; j < segment_count && segments[j].bounds.left <= segments[i].bounds.right; ++j)
+        {
+            p = &segments[i];
+            q = &segments[j];
+
+            if (q->bounds.top > p->bounds.bottom || q->bounds.bottom < p->bounds.top)
+                continue;
+
+            if (p->idx.figure_idx != q->idx.figure_idx)
+            {
+                if (!d2d_rect_check_overlap(&geometry->u.path.figures[p->idx.figure_idx].bounds,
+                        &geometry->u.path.figures[q->idx.figure_idx].bounds))
+                    continue;
+                if (p->idx.figure_idx < q->idx.figure_idx)
                 {
-                    type_q = figure_q->vertex_types[idx_q.vertex_idx];
-                    if (d2d_vertex_type_is_bezier(type_q))
-                    {
-                        if (d2d_vertex_type_is_bezier(type_p))
-                        {
-                            if (!d2d_geometry_intersect_bezier_bezier(geometry, &intersections,
-                                    &idx_p, 0.0f, 1.0f, &idx_q, 0.0f, 1.0f))
-                                goto done;
-                        }
-                        else
-                        {
-                            if (!d2d_geometry_intersect_bezier_line(geometry, &intersections, &idx_q, &idx_p))
-                                goto done;
-                        }
-                        ++idx_q.control_idx;
-                    }
-                    else
-                    {
-                        if (d2d_vertex_type_is_bezier(type_p))
-                        {
-                            if (!d2d_geometry_intersect_bezier_line(geometry, &intersections, &idx_p, &idx_q))
-                                goto done;
-                        }
-                        else
-                        {
-                            if (!d2d_geometry_intersect_line_line(geometry, &intersections, &idx_p, &idx_q))
-                                goto done;
-                        }
-                    }
+                    tmp = p;
+                    p = q;
+                    q = tmp;
                 }
             }
-            if (d2d_vertex_type_is_bezier(type_p))
-                ++idx_p.control_idx;
+            else if (p->idx.vertex_idx < q->idx.vertex_idx)
+            {
+                tmp = p;
+                p = q;
+                q = tmp;
+            }
+
+            if (!d2d_geometry_intersect_segments(geometry, &intersections, p, q))
+                goto done;
         }
     }
 
@@ -2014,6 +2087,7 @@ static BOOL d2d_geometry_intersect_self(struct d2d_geometry *geometry)
 
 done:
     heap_free(intersections.intersections);
+    heap_free(segments);
     return ret;
 }
 
@@ -2424,6 +2498,7 @@ static BOOL d2d_geometry_fill_add_arc_triangle(struct d2d_geometry *geometry,
 
 static void d2d_geometry_cleanup(struct d2d_geometry *geometry)
 {
+    d2d_geometry_release_fill_buffers(geometry);
     heap_free(geometry->outline.arc_faces);
     heap_free(geometry->outline.arcs);
     heap_free(geometry->outline.bezier_faces);
@@ -2444,6 +2519,7 @@ static void d2d_geometry_init(struct d2d_geometry *geometry, ID2D1Factory *facto
     geometry->refcount = 1;
     ID2D1Factory_AddRef(geometry->factory = factory);
     geometry->transform = *transform;
+    geometry->fill_source = geometry;
 }
 
 static inline struct d2d_geometry *impl_from_ID2D1GeometrySink(ID2D1GeometrySink *iface)
@@ -4809,6 +4885,7 @@ void d2d_transformed_geometry_init(struct d2d_geometry *geometry, ID2D1Factory *
     geometry->u.transformed.transform = *transform;
     geometry->fill = src_impl->fill;
     geometry->outline = src_impl->outline;
+    geometry->fill_source = src_impl->fill_source;
 }
 
 static inline struct d2d_geometry *impl_from_ID2D1GeometryGroup(ID2D1GeometryGroup *iface)
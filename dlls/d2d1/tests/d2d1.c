@@ -7570,6 +7570,104 @@ static void test_fill_geometry(void)
     DestroyWindow(window);
 }
 
+static void test_fill_geometry_devices(void)
+{
+    ID2D1RectangleGeometry *geometry;
+    ID2D1SolidColorBrush *brush[2];
+    struct resource_readback rb;
+    IDXGISwapChain *swapchain[2];
+    ID2D1RenderTarget *rt[2];
+    ID3D10Device1 *device[2];
+    IDXGISurface *surface[2];
+    ID2D1Factory *factory;
+    unsigned int i, j;
+    D2D1_COLOR_F color;
+    D2D1_RECT_F rect;
+    HWND window[2];
+    ULONG refcount;
+    DWORD colour;
+    HRESULT hr;
+
+    if (!(device[0] = create_device()))
+    {
+        skip("Failed to create device, skipping tests.\n");
+        return;
+    }
+    if (!(device[1] = create_device()))
+    {
+        skip("Failed to create device, skipping tests.\n");
+        ID3D10Device1_Release(device[0]);
+        return;
+    }
+
+    hr = D2D1CreateFactory(D2D1_FACTORY_TYPE_SINGLE_THREADED, &IID_ID2D1Factory, NULL, (void **)&factory);
+    ok(SUCCEEDED(hr), "Failed to create factory, hr %#x.\n", hr);
+    set_rect(&rect, 160.0f, 120.0f, 480.0f, 360.0f);
+    hr = ID2D1Factory_CreateRectangleGeometry(factory, &rect, &geometry);
+    ok(SUCCEEDED(hr), "Failed to create geometry, hr %#x.\n", hr);
+
+    for (i = 0; i < ARRAY_SIZE(device); ++i)
+    {
+        D2D1_RENDER_TARGET_PROPERTIES desc;
+
+        window[i] = create_window();
+        swapchain[i] = create_swapchain(device[i], window[i], TRUE);
+        hr = IDXGISwapChain_GetBuffer(swapchain[i], 0, &IID_IDXGISurface, (void **)&surface[i]);
+        ok(SUCCEEDED(hr), "Failed to get buffer, hr %#x.\n", hr);
+
+        desc.type = D2D1_RENDER_TARGET_TYPE_DEFAULT;
+        desc.pixelFormat.format = DXGI_FORMAT_UNKNOWN;
+        desc.pixelFormat.alphaMode = D2D1_ALPHA_MODE_PREMULTIPLIED;
+        desc.dpiX = 96.0f;
+        desc.dpiY = 96.0f;
+        desc.usage = D2D1_RENDER_TARGET_USAGE_NONE;
+        desc.minLevel = D2D1_FEATURE_LEVEL_DEFAULT;
+        hr = ID2D1Factory_CreateDxgiSurfaceRenderTarget(factory, surface[i], &desc, &rt[i]);
+        ok(SUCCEEDED(hr), "Failed to create render target, hr %#x.\n", hr);
+
+        set_color(&color, 0.890f, 0.851f, 0.600f, 1.0f);
+        hr = ID2D1RenderTarget_CreateSolidColorBrush(rt[i], &color, NULL, &brush[i]);
+        ok(SUCCEEDED(hr), "Failed to create brush, hr %#x.\n", hr);
+    }
+
+    /* Alternate between the two render targets, so that each draw finds the
+     * geometry's fill buffers belonging to the other one. */
+    for (j = 0; j < 4; ++j)
+    {
+        i = (j + 1) % ARRAY_SIZE(rt);
+
+        ID2D1RenderTarget_BeginDraw(rt[i]);
+        set_color(&color, 0.396f, 0.180f, 0.537f, 1.0f);
+        ID2D1RenderTarget_Clear(rt[i], &color);
+        ID2D1RenderTarget_FillGeometry(rt[i], (ID2D1Geometry *)geometry, (ID2D1Brush *)brush[i], NULL);
+        hr = ID2D1RenderTarget_EndDraw(rt[i], NULL, NULL);
+        ok(SUCCEEDED(hr), "Draw %u: Failed to end draw, hr %#x.\n", j, hr);
+
+        get_surface_readback(surface[i], &rb);
+        colour = get_readback_colour(&rb, 320, 240);
+        ok(compare_colour(colour, 0xffe3d999, 1), "Draw %u: Got unexpected colour 0x%08x.\n", j, colour);
+        colour = get_readback_colour(&rb, 10, 10);
+        ok(compare_colour(colour, 0xff652e89, 1), "Draw %u: Got unexpected colour 0x%08x.\n", j, colour);
+        release_resource_readback(&rb);
+    }
+
+    /* The geometry is still alive, but shouldn't keep either device alive. */
+    for (i = 0; i < ARRAY_SIZE(device); ++i)
+    {
+        ID2D1SolidColorBrush_Release(brush[i]);
+        ID2D1RenderTarget_Release(rt[i]);
+        IDXGISurface_Release(surface[i]);
+        IDXGISwapChain_Release(swapchain[i]);
+        refcount = ID3D10Device1_Release(device[i]);
+        ok(!refcount, "Device %u has %u references left.\n", i, refcount);
+        DestroyWindow(window[i]);
+    }
+
+    ID2D1RectangleGeometry_Release(geometry);
+    refcount = ID2D1Factory_Release(factory);
+    ok(!refcount, "Factory has %u references left.\n", refcount);
+}
+
 static void test_gdi_interop(void)
 {
     ID2D1GdiInteropRenderTarget *interop;
@@ -9465,6 +9563,7 @@ START_TEST(d2d1)
     queue_test(test_gradient);
     queue_test(test_draw_geometry);
     queue_test(test_fill_geometry);
+    queue_test(test_fill_geometry_devices);
     queue_test(test_gdi_interop);
     queue_test(test_layer);
     queue_test(test_bezier_intersect);
@@ -29299,6 +29299,104 @@ static void test_staging_buffers(void)
     release_test_context(&test_context);
 }
 
+static void test_buffer_updates_multiple_swapchains(void)
+{
+    static const float red[] = {1.0f, 0.0f, 0.0f, 1.0f};
+    ID3D11RenderTargetView *rtv[2];
+    struct d3d11_test_context test_context;
+    ID3D11DeviceContext *context;
+    struct resource_readback rb;
+    IDXGISwapChain *swapchain;
+    ID3D11Texture2D *texture;
+    ID3D11Buffer *buffer;
+    ID3D11Device *device;
+    unsigned int i, j;
+    DWORD *data;
+    HWND window;
+    HRESULT hr;
+
+    if (!init_test_context(&test_context, NULL))
+        return;
+    device = test_context.device;
+    context = test_context.immediate_context;
+
+    window = CreateWindowA("static", "d3d11_test", WS_OVERLAPPEDWINDOW | WS_VISIBLE,
+            0, 0, 640, 480, NULL, NULL, NULL, NULL);
+    swapchain = create_swapchain(device, window, NULL);
+    hr = IDXGISwapChain_GetBuffer(swapchain, 0, &IID_ID3D11Texture2D, (void **)&texture);
+    ok(hr == S_OK, "Failed to get backbuffer, hr %#x.\n", hr);
+    hr = ID3D11Device_CreateRenderTargetView(device, (ID3D11Resource *)texture, NULL, &rtv[1]);
+    ok(hr == S_OK, "Failed to create rendertarget view, hr %#x.\n", hr);
+    ID3D11Texture2D_Release(texture);
+    rtv[0] = test_context.backbuffer_rtv;
+
+    data = heap_alloc(0x4000);
+    memset(data, 0, 0x4000);
+    buffer = create_buffer(device, D3D11_BIND_VERTEX_BUFFER, 0x4000, data);
+
+    /* Enough updates to go around the wined3d upload heap several times,
+     * while the render target switches between the swapchains, and so
+     * between GL contexts. */
+    for (i = 0; i < 2048; ++i)
+    {
+        for (j = 0; j < 0x4000 / sizeof(*data); ++j)
+            data[j] = i * 0x10000 + j;
+        ID3D11DeviceContext_UpdateSubresource(context, (ID3D11Resource *)buffer, 0, NULL, data, 0, 0);
+        ID3D11DeviceContext_ClearRenderTargetView(context, rtv[i & 1], red);
+
+        if (!(i % 512) || i == 2047)
+        {
+            get_buffer_readback(buffer, &rb);
+            for (j = 0; j < 0x4000 / sizeof(*data); ++j)
+            {
+                if (get_readback_u32(&rb, j, 0, 0) != data[j])
+                    break;
+            }
+            ok(j == 0x4000 / sizeof(*data), "Update %u: got unexpected value 0x%08x at %u.\n",
+                    i, j < 0x4000 / sizeof(*data) ? get_readback_u32(&rb, j, 0, 0) : 0, j);
+            release_resource_readback(&rb);
+        }
+    }
+    check_texture_color(test_context.backbuffer, 0xff0000ff, 0);
+
+    ID3D11Buffer_Release(buffer);
+    heap_free(data);
+    ID3D11RenderTargetView_Release(rtv[1]);
+    IDXGISwapChain_Release(swapchain);
+    DestroyWindow(window);
+    release_test_context(&test_context);
+}
+
+static void test_command_stream_flood(void)
+{
+    struct d3d11_test_context test_context;
+    DWORD start, elapsed;
+    struct vec4 color;
+    unsigned int i;
+
+    if (!init_test_context(&test_context, NULL))
+        return;
+
+    /* Enough small draws to fill the initial command stream queue several
+     * times without an intervening flush. The queue grows while the command
+     * stream thread is still busy with the older packets. */
+    start = GetTickCount();
+    for (i = 0; i < 20000; ++i)
+    {
+        color.x = (i & 0xff) / 255.0f;
+        color.y = ((i >> 8) & 0xff) / 255.0f;
+        color.z = 0.0f;
+        color.w = 1.0f;
+        draw_color_quad(&test_context, &color);
+    }
+    check_texture_color(test_context.backbuffer, 0xff004e1f, 1);
+    elapsed = GetTickCount() - start;
+    if (winetest_debug > 1)
+        trace("20000 draws in %u ms, %u draws/s.\n", elapsed, elapsed ? 20000000 / elapsed : 0);
+
+    release_test_context(&test_context);
+}
+
 static void test_render_a8(void)
 {
     static const float black[] = {0.0f, 0.0f, 0.0f, 0.0f};
@@ -30466,6 +30564,295 @@ static void test_deferred_context_rendering(void)
     release_test_context(&test_context);
 }
 
+static void test_shader_cache_child(void)
+{
+    static const struct vec4 green = {0.0f, 1.0f, 0.0f, 1.0f};
+    struct d3d11_test_context test_context;
+
+    if (!init_test_context(&test_context, NULL))
+        return;
+
+    draw_color_quad(&test_context, &green);
+    check_texture_color(test_context.backbuffer, 0xff00ff00, 1);
+
+    release_test_context(&test_context);
+}
+
+static void run_shader_cache_child(void)
+{
+    STARTUPINFOA si = {sizeof(si)};
+    PROCESS_INFORMATION pi;
+    char cmdline[MAX_PATH];
+    char **argv;
+    BOOL ret;
+
+    winetest_get_mainargs(&argv);
+    sprintf(cmdline, "\"%s\" d3d11 shader_cache", argv[0]);
+    ret = CreateProcessA(NULL, cmdline, NULL, NULL, FALSE, 0, NULL, NULL, &si, &pi);
+    ok(ret, "Failed to create process, error %u.\n", GetLastError());
+    if (!ret)
+        return;
+    wait_child_process(pi.hProcess);
+    CloseHandle(pi.hProcess);
+    CloseHandle(pi.hThread);
+}
+
+/* The files written by wined3d start with a 20 byte header, followed by the
+ * program key, which starts with the GL vendor string. */
+static unsigned int check_shader_cache(const char *dir, BYTE *key_byte, BOOL corrupt, BOOL remove)
+{
+    char path[MAX_PATH];
+    WIN32_FIND_DATAA data;
+    unsigned int count = 0;
+    HANDLE find, file;
+    DWORD size;
+    BYTE byte;
+
+    sprintf(path, "%s\\*.bin", dir);
+    if ((find = FindFirstFileA(path, &data)) == INVALID_HANDLE_VALUE)
+        return 0;
+    do
+    {
+        sprintf(path, "%s\\%s", dir, data.cFileName);
+        if (remove)
+        {
+            DeleteFileA(path);
+            continue;
+        }
+
+        file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING, 0, NULL);
+        ok(file != INVALID_HANDLE_VALUE, "Failed to open %s, error %u.\n", path, GetLastError());
+        SetFilePointer(file, 20, NULL, FILE_BEGIN);
+        ok(ReadFile(file, &byte, 1, &size, NULL) && size == 1, "Failed to read %s.\n", path);
+        if (!*key_byte)
+            *key_byte = byte;
+        ok(byte == *key_byte, "Got unexpected key byte %#x in %s.\n", byte, path);
+        if (corrupt)
+        {
+            byte ^= 0xff;
+            SetFilePointer(file, 20, NULL, FILE_BEGIN);
+            ok(WriteFile(file, &byte, 1, &size, NULL) && size == 1, "Failed to write %s.\n", path);
+        }
+        CloseHandle(file);
+        ++count;
+    } while (FindNextFileA(find, &data));
+    FindClose(find);
+
+    return count;
+}
+
+/* Set the modification time of the cached programs, or count the programs
+ * whose modification time differs from it. */
+static unsigned int check_shader_cache_time(const char *dir, const FILETIME *time, BOOL set)
+{
+    char path[MAX_PATH];
+    WIN32_FIND_DATAA data;
+    unsigned int count = 0;
+    FILETIME write_time;
+    HANDLE find, file;
+    BOOL ret;
+
+    sprintf(path, "%s\\*.bin", dir);
+    if ((find = FindFirstFileA(path, &data)) == INVALID_HANDLE_VALUE)
+        return 0;
+    do
+    {
+        sprintf(path, "%s\\%s", dir, data.cFileName);
+        file = CreateFileA(path, GENERIC_READ | FILE_WRITE_ATTRIBUTES, 0, NULL, OPEN_EXISTING, 0, NULL);
+        ok(file != INVALID_HANDLE_VALUE, "Failed to open %s, error %u.\n", path, GetLastError());
+        if (set)
+        {
+            ret = SetFileTime(file, NULL, NULL, time);
+            ok(ret, "Failed to set time of %s, error %u.\n", path, GetLastError());
+        }
+        else
+        {
+            ret = GetFileTime(file, NULL, NULL, &write_time);
+            ok(ret, "Failed to get time of %s, error %u.\n", path, GetLastError());
+            if (CompareFileTime(&write_time, time))
+                ++count;
+        }
+        CloseHandle(file);
+    } while (FindNextFileA(find, &data));
+    FindClose(find);
+
+    return count;
+}
+
+static void test_shader_cache(void)
+{
+    static const SYSTEMTIME old_system_time = {2000, 1, 6, 1};
+    unsigned int count, rewritten;
+    FILETIME old_time;
+    char dir[MAX_PATH];
+    BYTE key_byte = 0;
+    HKEY key;
+    LONG ret;
+
+    if (strcmp(winetest_platform, "wine"))
+    {
+        skip("The shader cache is a Wine extension.\n");
+        return;
+    }
+
+    ret = RegCreateKeyExA(HKEY_CURRENT_USER, "Software\\Wine\\Direct3D", 0, NULL, 0,
+            KEY_QUERY_VALUE | KEY_SET_VALUE, NULL, &key, NULL);
+    ok(!ret, "Failed to create key, error %u.\n", ret);
+    if (ret)
+        return;
+    if (!RegQueryValueExA(key, "ShaderCachePath", NULL, NULL, NULL, NULL))
+    {
+        skip("ShaderCachePath is already set.\n");
+        RegCloseKey(key);
+        return;
+    }
+
+    GetTempPathA(ARRAY_SIZE(dir), dir);
+    strcat(dir, "d3d11_shader_cache");
+    check_shader_cache(dir, &key_byte, FALSE, TRUE);
+    RemoveDirectoryA(dir);
+    ret = RegSetValueExA(key, "ShaderCachePath", 0, REG_SZ, (const BYTE *)dir, strlen(dir) + 1);
+    ok(!ret, "Failed to set value, error %u.\n", ret);
+
+    run_shader_cache_child();
+    if (!(count = check_shader_cache(dir, &key_byte, FALSE, FALSE)))
+    {
+        skip("No programs were cached.\n");
+        goto done;
+    }
+
+    /* Load the programs from the cache. Backdate the files, so that any of
+     * them being written again shows up as a changed modification time. */
+    SystemTimeToFileTime(&old_system_time, &old_time);
+    check_shader_cache_time(dir, &old_time, TRUE);
+    run_shader_cache_child();
+    ok(check_shader_cache(dir, &key_byte, FALSE, FALSE) == count, "Got unexpected number of programs.\n");
+    rewritten = check_shader_cache_time(dir, &old_time, FALSE);
+    ok(!rewritten, "%u programs were rewritten.\n", rewritten);
+
+    /* Programs with a different key must be linked again and rewritten, even
+     * if the files have the same name. */
+    check_shader_cache(dir, &key_byte, TRUE, FALSE);
+    check_shader_cache_time(dir, &old_time, TRUE);
+    run_shader_cache_child();
+    ok(check_shader_cache(dir, &key_byte, FALSE, FALSE) == count, "Got unexpected number of programs.\n");
+    rewritten = check_shader_cache_time(dir, &old_time, FALSE);
+    ok(rewritten == count, "Got %u rewritten programs, expected %u.\n", rewritten, count);
+
+done:
+    check_shader_cache(dir, &key_byte, FALSE, TRUE);
+    RemoveDirectoryA(dir);
+    RegDeleteValueA(key, "ShaderCachePath");
+    RegCloseKey(key);
+}
+
+/* The Vulkan pipeline cache is a single file per device, named after the
+ * vendor, device and pipeline cache UUID. */
+static BOOL get_vk_pipeline_cache_file(const char *dir, char *path, FILETIME *write_time, DWORD *size)
+{
+    WIN32_FIND_DATAA data;
+    HANDLE find;
+
+    sprintf(path, "%s\\vk-*.bin", dir);
+    if ((find = FindFirstFileA(path, &data)) == INVALID_HANDLE_VALUE)
+        return FALSE;
+    FindClose(find);
+    sprintf(path, "%s\\%s", dir, data.cFileName);
+    if (write_time)
+        *write_time = data.ftLastWriteTime;
+    if (size)
+        *size = data.nFileSizeLow;
+    return TRUE;
+}
+
+static void set_vk_pipeline_cache_file(const char *path, const FILETIME *write_time, BOOL corrupt)
+{
+    static const BYTE garbage[64] = {0xde, 0xad, 0xbe, 0xef};
+    HANDLE file;
+    DWORD size;
+    BOOL ret;
+
+    file = CreateFileA(path, GENERIC_WRITE, 0, NULL, corrupt ? CREATE_ALWAYS : OPEN_EXISTING, 0, NULL);
+    ok(file != INVALID_HANDLE_VALUE, "Failed to open %s, error %u.\n", path, GetLastError());
+    if (corrupt)
+    {
+        ret = WriteFile(file, garbage, sizeof(garbage), &size, NULL);
+        ok(ret && size == sizeof(garbage), "Failed to write %s, error %u.\n", path, GetLastError());
+    }
+    ret = SetFileTime(file, NULL, NULL, write_time);
+    ok(ret, "Failed to set time of %s, error %u.\n", path, GetLastError());
+    CloseHandle(file);
+}
+
+static void test_vk_pipeline_cache(void)
+{
+    static const SYSTEMTIME old_system_time = {2000, 1, 6, 1};
+    FILETIME old_time, write_time;
+    char dir[MAX_PATH], path[MAX_PATH];
+    DWORD size;
+    HKEY key;
+    LONG ret;
+
+    if (strcmp(winetest_platform, "wine"))
+    {
+        skip("The pipeline cache is a Wine extension.\n");
+        return;
+    }
+
+    ret = RegCreateKeyExA(HKEY_CURRENT_USER, "Software\\Wine\\Direct3D", 0, NULL, 0,
+            KEY_QUERY_VALUE | KEY_SET_VALUE, NULL, &key, NULL);
+    ok(!ret, "Failed to create key, error %u.\n", ret);
+    if (ret)
+        return;
+    if (!RegQueryValueExA(key, "ShaderCachePath", NULL, NULL, NULL, NULL)
+            || !RegQueryValueExA(key, "renderer", NULL, NULL, NULL, NULL))
+    {
+        skip("ShaderCachePath or renderer is already set.\n");
+        RegCloseKey(key);
+        return;
+    }
+
+    GetTempPathA(ARRAY_SIZE(dir), dir);
+    strcat(dir, "d3d11_vk_pipeline_cache");
+    if (get_vk_pipeline_cache_file(dir, path, NULL, NULL))
+        DeleteFileA(path);
+    RemoveDirectoryA(dir);
+    ret = RegSetValueExA(key, "ShaderCachePath", 0, REG_SZ, (const BYTE *)dir, strlen(dir) + 1);
+    ok(!ret, "Failed to set value, error %u.\n", ret);
+    ret = RegSetValueExA(key, "renderer", 0, REG_SZ, (const BYTE *)"vulkan", sizeof("vulkan"));
+    ok(!ret, "Failed to set value, error %u.\n", ret);
+
+    run_shader_cache_child();
+    if (!get_vk_pipeline_cache_file(dir, path, NULL, &size))
+    {
+        skip("No pipeline cache was written, Vulkan is probably not available.\n");
+        goto done;
+    }
+    ok(size > 16, "Got unexpected size %u.\n", size);
+
+    /* The same pipelines are found in the cache, it must not be written again. */
+    SystemTimeToFileTime(&old_system_time, &old_time);
+    set_vk_pipeline_cache_file(path, &old_time, FALSE);
+    run_shader_cache_child();
+    ok(get_vk_pipeline_cache_file(dir, path, &write_time, NULL), "The pipeline cache was removed.\n");
+    ok(!CompareFileTime(&write_time, &old_time), "The pipeline cache was rewritten.\n");
+
+    /* Invalid data is ignored, and replaced with the new pipelines. */
+    set_vk_pipeline_cache_file(path, &old_time, TRUE);
+    run_shader_cache_child();
+    ok(get_vk_pipeline_cache_file(dir, path, &write_time, &size), "The pipeline cache was removed.\n");
+    ok(CompareFileTime(&write_time, &old_time), "The pipeline cache wasn't rewritten.\n");
+    ok(size > 16, "Got unexpected size %u.\n", size);
+
+done:
+    if (get_vk_pipeline_cache_file(dir, path, NULL, NULL))
+        DeleteFileA(path);
+    RemoveDirectoryA(dir);
+    RegDeleteValueA(key, "renderer");
+    RegDeleteValueA(key, "ShaderCachePath");
+    RegCloseKey(key);
+}
+
 START_TEST(d3d11)
 {
     unsigned int argc, i;
@@ -30474,6 +30861,11 @@ START_TEST(d3d11)
     use_mt = !getenv("WINETEST_NO_MT_D3D");
 
     argc = winetest_get_mainargs(&argv);
+    if (argc >= 3 && !strcmp(argv[2], "shader_cache"))
+    {
+        test_shader_cache_child();
+        return;
+    }
     for (i = 2; i < argc; ++i)
     {
         if (!strcmp(argv[i], "--validate"))
@@ -30622,6 +31014,8 @@ START_TEST(d3d11)
     queue_test(test_sample_mask);
     queue_test(test_depth_clip);
     queue_test(test_staging_buffers);
+    queue_test(test_buffer_updates_multiple_swapchains);
+    queue_test(test_command_stream_flood);
     queue_test(test_render_a8);
     queue_test(test_standard_pattern);
     queue_test(test_desktop_window);
@@ -30633,4 +31027,7 @@ START_TEST(d3d11)
     queue_test(test_deferred_context_rendering);
 
     run_queued_tests();
+
+    test_shader_cache();
+    test_vk_pipeline_cache();
 }
@@ -26829,6 +26829,62 @@ static void test_sample_mask(void)
     DestroyWindow(window);
 }
 
+static void test_clear_many_rects(void)
+{
+    IDirect3DDevice9 *device;
+    unsigned int i, count;
+    IDirect3D9 *d3d;
+    D3DRECT *rects;
+    ULONG refcount;
+    D3DCOLOR color;
+    HWND window;
+    HRESULT hr;
+
+    window = create_window();
+    d3d = Direct3DCreate9(D3D_SDK_VERSION);
+    ok(!!d3d, "Failed to create a D3D object.\n");
+    if (!(device = create_device(d3d, window, window, TRUE)))
+    {
+        skip("Failed to create a D3D device.\n");
+        IDirect3D9_Release(d3d);
+        DestroyWindow(window);
+        return;
+    }
+
+    /* One rectangle per pixel in the top 128 rows. The rectangles alone take
+     * more than 1 MiB, more than the initial size of the wined3d command
+     * stream queue. */
+    count = 640 * 128;
+    rects = HeapAlloc(GetProcessHeap(), 0, count * sizeof(*rects));
+    for (i = 0; i < count; ++i)
+    {
+        rects[i].x1 = i % 640;
+        rects[i].y1 = i / 640;
+        rects[i].x2 = rects[i].x1 + 1;
+        rects[i].y2 = rects[i].y1 + 1;
+    }
+
+    hr = IDirect3DDevice9_Clear(device, 0, NULL, D3DCLEAR_TARGET, 0xffff0000, 0.0f, 0);
+    ok(SUCCEEDED(hr), "Failed to clear, hr %#x.\n", hr);
+    hr = IDirect3DDevice9_Clear(device, count, rects, D3DCLEAR_TARGET, 0xff00ff00, 0.0f, 0);
+    ok(SUCCEEDED(hr), "Failed to clear, hr %#x.\n", hr);
+
+    color = getPixelColor(device, 0, 0);
+    ok(color_match(color, 0x0000ff00, 1), "Got unexpected color 0x%08x.\n", color);
+    color = getPixelColor(device, 639, 127);
+    ok(color_match(color, 0x0000ff00, 1), "Got unexpected color 0x%08x.\n", color);
+    color = getPixelColor(device, 320, 128);
+    ok(color_match(color, 0x00ff0000, 1), "Got unexpected color 0x%08x.\n", color);
+    color = getPixelColor(device, 320, 240);
+    ok(color_match(color, 0x00ff0000, 1), "Got unexpected color 0x%08x.\n", color);
+
+    HeapFree(GetProcessHeap(), 0, rects);
+    refcount = IDirect3DDevice9_Release(device);
+    ok(!refcount, "Device has %u references left.\n", refcount);
+    IDirect3D9_Release(d3d);
+    DestroyWindow(window);
+}
+
 START_TEST(visual)
 {
     D3DADAPTER_IDENTIFIER9 identifier;
@@ -26977,4 +27033,5 @@ START_TEST(visual)
     test_sample_attached_rendertarget();
     test_alpha_to_coverage();
     test_sample_mask();
+    test_clear_many_rects();
 }
@@ -82,6 +82,19 @@ static CRITICAL_SECTION_DEBUG wpp_mutex_debug =
 };
 static CRITICAL_SECTION wpp_mutex = { &wpp_mutex_debug, -1, 0, 0, 0, 0 };
 
+/* The HLSL parser isn't thread-safe either, but it doesn't share any state
+   with wpp. Using a separate mutex allows one thread to preprocess a shader
+   while another one compiles. */
+static CRITICAL_SECTION hlsl_mutex;
+static CRITICAL_SECTION_DEBUG hlsl_mutex_debug =
+{
+    0, 0, &hlsl_mutex,
+    { &hlsl_mutex_debug.ProcessLocksList,
+      &hlsl_mutex_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": hlsl_mutex") }
+};
+static CRITICAL_SECTION hlsl_mutex = { &hlsl_mutex_debug, -1, 0, 0, 0, 0 };
+
 /* Preprocessor error reporting functions */
 static void wpp_write_message(const char *fmt, __ms_va_list args)
 {
@@ -786,7 +799,9 @@ static HRESULT compile_shader(const char *preproc_shader, const char *target, co
         }
     }
 
+    EnterCriticalSection(&hlsl_mutex);
     hr = parse_hlsl_shader(preproc_shader, shader_type, major, minor, entrypoint, shader, &messages);
+    LeaveCriticalSection(&hlsl_mutex);
 
     if (messages)
     {
@@ -911,6 +926,7 @@ HRESULT WINAPI D3DCompile2(const void *data, SIZE_T data_size, const char *filen
         ID3DBlob **error_messages)
 {
     struct d3dcompiler_include_from_file include_from_file;
+    char *preproc_shader;
     HRESULT hr;
 
     TRACE("data %p, data_size %lu, filename %s, defines %p, include %p, entrypoint %s, "
@@ -933,13 +949,15 @@ HRESULT WINAPI D3DCompile2(const void *data, SIZE_T data_size, const char *filen
     }
 
     EnterCriticalSection(&wpp_mutex);
-
     hr = preprocess_shader(data, data_size, filename, defines, include, error_messages);
+    preproc_shader = wpp_output;
+    wpp_output = NULL;
+    LeaveCriticalSection(&wpp_mutex);
+
     if (SUCCEEDED(hr))
-        hr = compile_shader(wpp_output, target, entrypoint, shader, error_messages);
+        hr = compile_shader(preproc_shader, target, entrypoint, shader, error_messages);
 
-    HeapFree(GetProcessHeap(), 0, wpp_output);
-    LeaveCriticalSection(&wpp_mutex);
+    HeapFree(GetProcessHeap(), 0, preproc_shader);
     return hr;
 }
 
@@ -1515,6 +1515,114 @@ struct test_d3dinclude
     ID3DInclude ID3DInclude_iface;
 };
 
+struct compile_thread_data
+{
+    HRESULT expected_hr[4];
+    ID3D10Blob *expected[4];
+    LONG failures;
+};
+
+static const char compile_thread_source[] =
+    "float4 main(float4 pos : TEXCOORD0) : COLOR\n"
+    "{\n"
+    "    return pos * VALUE;\n"
+    "}";
+
+static HRESULT compile_thread_shader(unsigned int idx, ID3D10Blob **blob)
+{
+    D3D_SHADER_MACRO macros[2];
+    ID3D10Blob *errors = NULL;
+    char value[16];
+    HRESULT hr;
+
+    sprintf(value, "%u.0", idx + 1);
+    macros[0].Name = "VALUE";
+    macros[0].Definition = value;
+    macros[1].Name = NULL;
+    macros[1].Definition = NULL;
+
+    *blob = NULL;
+    hr = ppD3DCompile(compile_thread_source, strlen(compile_thread_source), NULL, macros, NULL,
+            "main", "ps_2_0", 0, 0, blob, &errors);
+    if (errors)
+        ID3D10Blob_Release(errors);
+    return hr;
+}
+
+static DWORD WINAPI compile_thread(void *param)
+{
+    struct compile_thread_data *data = param;
+    unsigned int i, idx;
+    ID3D10Blob *blob;
+    HRESULT hr;
+
+    for (i = 0; i < 64; ++i)
+    {
+        idx = (GetCurrentThreadId() + i) % ARRAY_SIZE(data->expected);
+        hr = compile_thread_shader(idx, &blob);
+        if (hr != data->expected_hr[idx] || !blob != !data->expected[idx])
+            InterlockedIncrement(&data->failures);
+        else if (blob && (ID3D10Blob_GetBufferSize(blob) != ID3D10Blob_GetBufferSize(data->expected[idx])
+                || memcmp(ID3D10Blob_GetBufferPointer(blob), ID3D10Blob_GetBufferPointer(data->expected[idx]),
+                ID3D10Blob_GetBufferSize(blob))))
+            InterlockedIncrement(&data->failures);
+        if (blob)
+            ID3D10Blob_Release(blob);
+    }
+
+    return 0;
+}
+
+static void test_threads(void)
+{
+    static const char fail_source[] =
+        "float4 main() : COLOR\n"
+        "{\n"
+        "    return y;\n"
+        "}";
+    ID3D10Blob *blob, *errors;
+    struct compile_thread_data data;
+    HANDLE threads[4];
+    unsigned int i;
+    HRESULT hr;
+
+    memset(&data, 0, sizeof(data));
+    for (i = 0; i < ARRAY_SIZE(data.expected); ++i)
+    {
+        data.expected_hr[i] = compile_thread_shader(i, &data.expected[i]);
+        todo_wine ok(data.expected_hr[i] == S_OK, "Shader %u: got unexpected hr %#x.\n", i, data.expected_hr[i]);
+    }
+
+    /* Concurrent compilations give the same results as serial ones. */
+    for (i = 0; i < ARRAY_SIZE(threads); ++i)
+        threads[i] = CreateThread(NULL, 0, compile_thread, &data, 0, NULL);
+    for (i = 0; i < ARRAY_SIZE(threads); ++i)
+    {
+        ok(WaitForSingleObject(threads[i], INFINITE) == WAIT_OBJECT_0, "Failed to wait for thread %u.\n", i);
+        CloseHandle(threads[i]);
+    }
+    ok(!data.failures, "Got %d unexpected compilation results.\n", data.failures);
+
+    /* Errors are reported every time, not just on the first compilation. */
+    for (i = 0; i < 2; ++i)
+    {
+        blob = errors = NULL;
+        hr = ppD3DCompile(fail_source, strlen(fail_source), NULL, NULL, NULL, "main", "ps_2_0",
+                0, 0, &blob, &errors);
+        ok(hr == E_FAIL, "Got unexpected hr %#x.\n", hr);
+        ok(!blob, "Expected no compiled shader.\n");
+        ok(!!errors, "Expected error messages.\n");
+        if (errors)
+            ID3D10Blob_Release(errors);
+    }
+
+    for (i = 0; i < ARRAY_SIZE(data.expected); ++i)
+    {
+        if (data.expected[i])
+            ID3D10Blob_Release(data.expected[i]);
+    }
+}
+
 static void test_d3dcompile(void)
 {
     struct test_d3dinclude include = {{&test_d3dinclude_vtbl}};
@@ -1723,5 +1831,6 @@ START_TEST(hlsl_d3d9)
 
     test_constant_table();
     test_fail();
+    test_threads();
     test_d3dcompile();
 }
@@ -2141,6 +2141,11 @@ struct dwrite_fontface *unsafe_impl_from_IDWriteFontFace(IDWriteFontFace *iface)
     return CONTAINING_RECORD(iface, struct dwrite_fontface, IDWriteFontFace5_iface);
 }
 
+BOOL is_dwrite_fontface(IDWriteFontFace *iface)
+{
+    return iface && iface->lpVtbl == (IDWriteFontFaceVtbl *)&dwritefontfacevtbl;
+}
+
 static struct dwrite_fontfacereference *unsafe_impl_from_IDWriteFontFaceReference(IDWriteFontFaceReference *iface)
 {
     if (!iface)
@@ -29,6 +29,7 @@
 #include "wingdi.h"
 #include "dwrite_private.h"
 #include "scripts.h"
+#include "wine/rbtree.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(dwrite);
 
@@ -925,17 +926,299 @@ fatal:
     return hr;
 }
 
+/* Shaped runs are cached process-wide, so layouts created repeatedly for the same text don't shape
+   it again. Only faces loaded from local files are cached, their reference keys include file path
+   and write time, so they identify the same face data across fontface instances and factories. */
+#define SHAPED_RUN_CACHE_MAX_SIZE (4 * 1024 * 1024)
+
+struct shaped_run_key
+{
+    const void *file_key;
+    UINT32 file_key_size;
+    UINT32 face_index;
+    USHORT simulations;
+    const WCHAR *text;
+    UINT32 length;
+    const WCHAR *locale;
+    DWRITE_SCRIPT_ANALYSIS sa;
+    float emsize;
+    BOOL is_sideways;
+    BOOL is_rtl;
+    DWRITE_MEASURING_MODE measuring_mode;
+    float ppdip;
+    DWRITE_MATRIX transform;
+    UINT32 hash;
+};
+
+struct shaped_run_entry
+{
+    struct wine_rb_entry entry;
+    struct list lru_entry;
+    struct shaped_run_key key;
+    SIZE_T size;
+    UINT32 glyph_count;
+    DWRITE_GLYPH_OFFSET *offsets;
+    float *advances;
+    UINT16 *clustermap;
+    UINT16 *glyphs;
+};
+
+static int compare_float(float left, float right)
+{
+    if (left == right)
+        return 0;
+    return left < right ? -1 : 1;
+}
+
+static int shaped_run_cache_compare(const void *k, const struct wine_rb_entry *entry)
+{
+    const struct shaped_run_key *key = k, *other = &WINE_RB_ENTRY_VALUE(entry, struct shaped_run_entry, entry)->key;
+    int ret;
+
+    if (key->hash != other->hash)
+        return key->hash < other->hash ? -1 : 1;
+    if (key->length != other->length)
+        return key->length < other->length ? -1 : 1;
+    if (key->file_key_size != other->file_key_size)
+        return key->file_key_size < other->file_key_size ? -1 : 1;
+    if (key->face_index != other->face_index)
+        return key->face_index < other->face_index ? -1 : 1;
+    if (key->simulations != other->simulations)
+        return key->simulations < other->simulations ? -1 : 1;
+    if (key->sa.script != other->sa.script)
+        return key->sa.script < other->sa.script ? -1 : 1;
+    if (key->sa.shapes != other->sa.shapes)
+        return key->sa.shapes < other->sa.shapes ? -1 : 1;
+    if (key->is_sideways != other->is_sideways)
+        return key->is_sideways < other->is_sideways ? -1 : 1;
+    if (key->is_rtl != other->is_rtl)
+        return key->is_rtl < other->is_rtl ? -1 : 1;
+    if (key->measuring_mode != other->measuring_mode)
+        return key->measuring_mode < other->measuring_mode ? -1 : 1;
+    if ((ret = compare_float(key->emsize, other->emsize)))
+        return ret;
+    if ((ret = compare_float(key->ppdip, other->ppdip)))
+        return ret;
+    if ((ret = memcmp(&key->transform, &other->transform, sizeof(key->transform))))
+        return ret;
+    if ((ret = memcmp(key->text, other->text, key->length * sizeof(*key->text))))
+        return ret;
+    if ((ret = strcmpW(key->locale, other->locale)))
+        return ret;
+    return memcmp(key->file_key, other->file_key, key->file_key_size);
+}
+
+static struct wine_rb_tree shaped_run_cache = { shaped_run_cache_compare };
+static struct list shaped_run_cache_lru = LIST_INIT(shaped_run_cache_lru);
+static SIZE_T shaped_run_cache_size;
+
+static CRITICAL_SECTION shaped_run_cache_cs;
+static CRITICAL_SECTION_DEBUG shaped_run_cache_cs_debug =
+{
+    0, 0, &shaped_run_cache_cs,
+    { &shaped_run_cache_cs_debug.ProcessLocksList, &shaped_run_cache_cs_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": shaped_run_cache_cs") }
+};
+static CRITICAL_SECTION shaped_run_cache_cs = { &shaped_run_cache_cs_debug, -1, 0, 0, 0, 0 };
+
+static UINT32 shaped_run_key_hash(UINT32 hash, const void *data, SIZE_T size)
+{
+    const BYTE *p = data;
+    SIZE_T i;
+
+    /* FNV-1a */
+    for (i = 0; i < size; ++i)
+        hash = (hash ^ p[i]) * 0x01000193;
+    return hash;
+}
+
+static BOOL layout_get_shaped_run_key(const struct dwrite_textlayout *layout, const struct regular_layout_run *run,
+        struct shaped_run_key *key)
+{
+    IDWriteFontFileLoader *loader;
+    struct dwrite_fontface *fontface;
+    BOOL is_local;
+
+    if (!is_dwrite_fontface(run->run.fontFace))
+        return FALSE;
+
+    fontface = unsafe_impl_from_IDWriteFontFace(run->run.fontFace);
+    if (fontface->file_count != 1)
+        return FALSE;
+
+    if (FAILED(IDWriteFontFile_GetLoader(fontface->files[0], &loader)))
+        return FALSE;
+    is_local = loader == get_local_fontfile_loader();
+    IDWriteFontFileLoader_Release(loader);
+    if (!is_local)
+        return FALSE;
+
+    memset(key, 0, sizeof(*key));
+    if (FAILED(IDWriteFontFile_GetReferenceKey(fontface->files[0], &key->file_key, &key->file_key_size)))
+        return FALSE;
+    key->face_index = fontface->index;
+    key->simulations = fontface->simulations;
+    key->text = run->descr.string;
+    key->length = run->descr.stringLength;
+    key->locale = run->descr.localeName;
+    key->sa = run->sa;
+    key->emsize = run->run.fontEmSize;
+    key->is_sideways = run->run.isSideways;
+    key->is_rtl = run->run.bidiLevel & 1;
+    key->measuring_mode = layout->measuringmode;
+    if (is_layout_gdi_compatible(layout))
+    {
+        key->ppdip = layout->ppdip;
+        key->transform = layout->transform;
+    }
+
+    key->hash = shaped_run_key_hash(0x811c9dc5, key->text, key->length * sizeof(*key->text));
+    key->hash = shaped_run_key_hash(key->hash, key->file_key, key->file_key_size);
+    key->hash = shaped_run_key_hash(key->hash, &key->emsize, sizeof(key->emsize));
+
+    return TRUE;
+}
+
+static BOOL shaped_run_cache_get(const struct shaped_run_key *key, struct regular_layout_run *run)
+{
+    struct shaped_run_entry *entry;
+    struct wine_rb_entry *rb_entry;
+    BOOL ret = FALSE;
+
+    EnterCriticalSection(&shaped_run_cache_cs);
+    if ((rb_entry = wine_rb_get(&shaped_run_cache, key)))
+    {
+        entry = WINE_RB_ENTRY_VALUE(rb_entry, struct shaped_run_entry, entry);
+        list_remove(&entry->lru_entry);
+        list_add_head(&shaped_run_cache_lru, &entry->lru_entry);
+
+        run->clustermap = heap_calloc(key->length, sizeof(*run->clustermap));
+        run->glyphs = heap_calloc(entry->glyph_count, sizeof(*run->glyphs));
+        run->advances = heap_calloc(entry->glyph_count, sizeof(*run->advances));
+        run->offsets = heap_calloc(entry->glyph_count, sizeof(*run->offsets));
+        if (run->clustermap && run->glyphs && run->advances && run->offsets)
+        {
+            memcpy(run->clustermap, entry->clustermap, key->length * sizeof(*run->clustermap));
+            memcpy(run->glyphs, entry->glyphs, entry->glyph_count * sizeof(*run->glyphs));
+            memcpy(run->advances, entry->advances, entry->glyph_count * sizeof(*run->advances));
+            memcpy(run->offsets, entry->offsets, entry->glyph_count * sizeof(*run->offsets));
+            run->glyphcount = entry->glyph_count;
+            ret = TRUE;
+        }
+        else
+        {
+            heap_free(run->clustermap);
+            heap_free(run->glyphs);
+            heap_free(run->advances);
+            heap_free(run->offsets);
+            run->clustermap = NULL;
+            run->glyphs = NULL;
+            run->advances = NULL;
+            run->offsets = NULL;
+        }
+    }
+    LeaveCriticalSection(&shaped_run_cache_cs);
+
+    return ret;
+}
+
+static void shaped_run_cache_remove_entry(struct shaped_run_entry *entry)
+{
+    list_remove(&entry->lru_entry);
+    wine_rb_remove(&shaped_run_cache, &entry->entry);
+    shaped_run_cache_size -= entry->size;
+    heap_free(entry);
+}
+
+static void shaped_run_cache_put(const struct shaped_run_key *key, const struct regular_layout_run *run)
+{
+    SIZE_T size, locale_size = (strlenW(key->locale) + 1) * sizeof(WCHAR);
+    struct shaped_run_entry *entry;
+    BYTE *ptr;
+
+    size = sizeof(*entry) + run->glyphcount * (sizeof(*entry->offsets) + sizeof(*entry->advances)
+            + sizeof(*entry->glyphs)) + key->length * (sizeof(*entry->clustermap) + sizeof(*key->text))
+            + locale_size + key->file_key_size;
+    if (size > SHAPED_RUN_CACHE_MAX_SIZE / 16)
+        return;
+    if (!(entry = heap_alloc(size)))
+        return;
+
+    entry->key = *key;
+    entry->size = size;
+    entry->glyph_count = run->glyphcount;
+
+    /* Arrays are laid out by decreasing alignment requirements. */
+    ptr = (BYTE *)(entry + 1);
+    entry->offsets = (DWRITE_GLYPH_OFFSET *)ptr;
+    memcpy(entry->offsets, run->offsets, run->glyphcount * sizeof(*entry->offsets));
+    ptr += run->glyphcount * sizeof(*entry->offsets);
+    entry->advances = (float *)ptr;
+    memcpy(entry->advances, run->advances, run->glyphcount * sizeof(*entry->advances));
+    ptr += run->glyphcount * sizeof(*entry->advances);
+    entry->clustermap = (UINT16 *)ptr;
+    memcpy(entry->clustermap, run->clustermap, key->length * sizeof(*entry->clustermap));
+    ptr += key->length * sizeof(*entry->clustermap);
+    entry->glyphs = (UINT16 *)ptr;
+    memcpy(entry->glyphs, run->glyphs, run->glyphcount * sizeof(*entry->glyphs));
+    ptr += run->glyphcount * sizeof(*entry->glyphs);
+    entry->key.text = (const WCHAR *)ptr;
+    memcpy(ptr, key->text, key->length * sizeof(*key->text));
+    ptr += key->length * sizeof(*key->text);
+    entry->key.locale = (const WCHAR *)ptr;
+    memcpy(ptr, key->locale, locale_size);
+    ptr += locale_size;
+    entry->key.file_key = ptr;
+    memcpy(ptr, key->file_key, key->file_key_size);
+
+    EnterCriticalSection(&shaped_run_cache_cs);
+    if (wine_rb_put(&shaped_run_cache, &entry->key, &entry->entry) == -1)
+    {
+        /* Same run was shaped concurrently by another layout. */
+        LeaveCriticalSection(&shaped_run_cache_cs);
+        heap_free(entry);
+        return;
+    }
+    list_add_head(&shaped_run_cache_lru, &entry->lru_entry);
+    shaped_run_cache_size += size;
+
+    while (shaped_run_cache_size > SHAPED_RUN_CACHE_MAX_SIZE)
+        shaped_run_cache_remove_entry(LIST_ENTRY(list_tail(&shaped_run_cache_lru), struct shaped_run_entry, lru_entry));
+    LeaveCriticalSection(&shaped_run_cache_cs);
+}
+
+void release_shaped_run_cache(void)
+{
+    struct shaped_run_entry *entry, *entry2;
+
+    EnterCriticalSection(&shaped_run_cache_cs);
+    LIST_FOR_EACH_ENTRY_SAFE(entry, entry2, &shaped_run_cache_lru, struct shaped_run_entry, lru_entry)
+        shaped_run_cache_remove_entry(entry);
+    LeaveCriticalSection(&shaped_run_cache_cs);
+}
+
 static HRESULT layout_shape_run(struct dwrite_textlayout *layout, struct regular_layout_run *run)
 {
     DWRITE_SHAPING_GLYPH_PROPERTIES *glyph_props;
     DWRITE_SHAPING_TEXT_PROPERTIES *text_props;
     IDWriteTextAnalyzer *analyzer;
+    struct shaped_run_key key;
     struct layout_range *range;
+    BOOL use_cache;
     UINT32 max_count;
     HRESULT hr;
 
     range = get_layout_range_by_pos(layout, run->descr.textPosition);
     run->descr.localeName = range->locale;
+
+    use_cache = layout_get_shaped_run_key(layout, run, &key);
+    if (use_cache && shaped_run_cache_get(&key, run))
+    {
+        run->run.glyphIndices = run->glyphs;
+        run->descr.clusterMap = run->clustermap;
+        goto done;
+    }
+
     run->clustermap = heap_calloc(run->descr.stringLength, sizeof(*run->clustermap));
 
     max_count = 3 * run->descr.stringLength / 2 + 16;
@@ -1011,7 +1294,10 @@ static HRESULT layout_shape_run(struct dwrite_textlayout *layout, struct regular
         memset(run->offsets, 0, run->glyphcount * sizeof(*run->offsets));
         WARN("%s: failed to get glyph placement info, hr %#x.\n", debugstr_rundescr(&run->descr), hr);
     }
+    else if (use_cache)
+        shaped_run_cache_put(&key, run);
 
+done:
     run->run.glyphAdvances = run->advances;
     run->run.glyphOffsets = run->offsets;
 
@@ -2572,6 +2858,7 @@ static inline HRESULT return_range(const struct layout_range_header *h, DWRITE_T
 static HRESULT set_layout_range_attr(struct dwrite_textlayout *layout, enum layout_range_attr_kind attr, struct layout_range_attr_value *value)
 {
     struct layout_range_header *cur, *right, *left, *outer;
+    USHORT recompute = RECOMPUTE_EVERYTHING;
     BOOL changed = FALSE;
     struct list *ranges;
     DWRITE_TEXT_RANGE r;
@@ -2596,12 +2883,16 @@ static HRESULT set_layout_range_attr(struct dwrite_textlayout *layout, enum layo
         break;
     case LAYOUT_RANGE_ATTR_UNDERLINE:
         ranges = &layout->underline_ranges;
+        /* Only applied when building effective runs, shaping results are unaffected. */
+        recompute = RECOMPUTE_LINES_AND_OVERHANGS;
         break;
     case LAYOUT_RANGE_ATTR_STRIKETHROUGH:
         ranges = &layout->strike_ranges;
+        recompute = RECOMPUTE_LINES_AND_OVERHANGS;
         break;
     case LAYOUT_RANGE_ATTR_EFFECT:
         ranges = &layout->effects;
+        recompute = RECOMPUTE_LINES_AND_OVERHANGS;
         break;
     case LAYOUT_RANGE_ATTR_SPACING:
         ranges = &layout->spacing;
@@ -2672,7 +2963,7 @@ static HRESULT set_layout_range_attr(struct dwrite_textlayout *layout, enum layo
         list_add_after(&outer->entry, &cur->entry);
         list_add_after(&cur->entry, &right->entry);
 
-        layout->recompute = RECOMPUTE_EVERYTHING;
+        layout->recompute |= recompute;
         return S_OK;
     }
 
@@ -2712,7 +3003,7 @@ done:
     if (changed) {
         struct list *next, *i;
 
-        layout->recompute = RECOMPUTE_EVERYTHING;
+        layout->recompute |= recompute;
         i = list_head(ranges);
         while ((next = list_next(ranges, i))) {
             struct layout_range_header *next_range = LIST_ENTRY(next, struct layout_range_header, entry);
@@ -49,6 +49,7 @@ BOOL WINAPI DllMain(HINSTANCE hinstDLL, DWORD reason, LPVOID reserved)
     case DLL_PROCESS_DETACH:
         if (reserved) break;
         release_shared_factory(shared_factory);
+        release_shaped_run_cache();
         release_freetype();
     }
     return TRUE;
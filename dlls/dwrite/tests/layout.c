@@ -5732,6 +5732,83 @@ todo_wine {
     IDWriteFactory_Release(factory);
 }
 
+static void test_relayout(void)
+{
+    DWRITE_CLUSTER_METRICS clusters[7], clusters2[7], clusters3[7];
+    IDWriteTextLayout *layout, *layout2;
+    IDWriteTextFormat *format;
+    IDWriteFactory *factory;
+    DWRITE_TEXT_RANGE range;
+    UINT32 count, i;
+    HRESULT hr;
+
+    factory = create_factory();
+
+    hr = IDWriteFactory_CreateTextFormat(factory, L"Tahoma", NULL, DWRITE_FONT_WEIGHT_NORMAL,
+            DWRITE_FONT_STYLE_NORMAL, DWRITE_FONT_STRETCH_NORMAL, 10.0f, L"en-us", &format);
+    ok(hr == S_OK, "Failed to create text format, hr %#x.\n", hr);
+
+    hr = IDWriteFactory_CreateTextLayout(factory, L"abc def", 7, format, 1000.0f, 1000.0f, &layout);
+    ok(hr == S_OK, "Failed to create text layout, hr %#x.\n", hr);
+
+    hr = IDWriteFactory_CreateTextLayout(factory, L"abc def", 7, format, 1000.0f, 1000.0f, &layout2);
+    ok(hr == S_OK, "Failed to create text layout, hr %#x.\n", hr);
+
+    /* Layouts with the same text and format produce same clusters. */
+    hr = IDWriteTextLayout_GetClusterMetrics(layout, clusters, ARRAY_SIZE(clusters), &count);
+    ok(hr == S_OK, "Failed to get cluster metrics, hr %#x.\n", hr);
+    ok(count == 7, "Unexpected cluster count %u.\n", count);
+
+    hr = IDWriteTextLayout_GetClusterMetrics(layout2, clusters2, ARRAY_SIZE(clusters2), &count);
+    ok(hr == S_OK, "Failed to get cluster metrics, hr %#x.\n", hr);
+    ok(count == 7, "Unexpected cluster count %u.\n", count);
+    ok(!memcmp(clusters, clusters2, sizeof(clusters)), "Unexpected cluster metrics.\n");
+
+    /* Changing font size of a range only affects its clusters. */
+    range.startPosition = 4;
+    range.length = 3;
+    hr = IDWriteTextLayout_SetFontSize(layout2, 20.0f, range);
+    ok(hr == S_OK, "Failed to set font size, hr %#x.\n", hr);
+
+    hr = IDWriteTextLayout_GetClusterMetrics(layout2, clusters2, ARRAY_SIZE(clusters2), &count);
+    ok(hr == S_OK, "Failed to get cluster metrics, hr %#x.\n", hr);
+    ok(count == 7, "Unexpected cluster count %u.\n", count);
+    for (i = 0; i < count; ++i)
+    {
+        if (i < 4)
+            ok(clusters2[i].width == clusters[i].width, "%u: unexpected width %f.\n", i, clusters2[i].width);
+        else
+            ok(clusters2[i].width > clusters[i].width, "%u: unexpected width %f.\n", i, clusters2[i].width);
+    }
+
+    /* Underline does not change clusters. */
+    range.startPosition = 0;
+    range.length = 2;
+    hr = IDWriteTextLayout_SetUnderline(layout2, TRUE, range);
+    ok(hr == S_OK, "Failed to set underline, hr %#x.\n", hr);
+
+    hr = IDWriteTextLayout_GetClusterMetrics(layout2, clusters3, ARRAY_SIZE(clusters3), &count);
+    ok(hr == S_OK, "Failed to get cluster metrics, hr %#x.\n", hr);
+    ok(count == 7, "Unexpected cluster count %u.\n", count);
+    ok(!memcmp(clusters2, clusters3, sizeof(clusters2)), "Unexpected cluster metrics.\n");
+
+    /* Restoring original size gives original clusters. */
+    range.startPosition = 4;
+    range.length = 3;
+    hr = IDWriteTextLayout_SetFontSize(layout2, 10.0f, range);
+    ok(hr == S_OK, "Failed to set font size, hr %#x.\n", hr);
+
+    hr = IDWriteTextLayout_GetClusterMetrics(layout2, clusters2, ARRAY_SIZE(clusters2), &count);
+    ok(hr == S_OK, "Failed to get cluster metrics, hr %#x.\n", hr);
+    ok(count == 7, "Unexpected cluster count %u.\n", count);
+    ok(!memcmp(clusters, clusters2, sizeof(clusters)), "Unexpected cluster metrics.\n");
+
+    IDWriteTextLayout_Release(layout2);
+    IDWriteTextLayout_Release(layout);
+    IDWriteTextFormat_Release(format);
+    IDWriteFactory_Release(factory);
+}
+
 START_TEST(layout)
 {
     IDWriteFactory *factory;
@@ -5783,6 +5860,7 @@ START_TEST(layout)
     test_line_spacing();
     test_GetOverhangMetrics();
     test_tab_stops();
+    test_relayout();
 
     IDWriteFactory_Release(factory);
 }
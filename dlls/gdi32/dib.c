@@ -1728,6 +1728,7 @@ static HGDIOBJ DIB_SelectObject( HGDIOBJ handle, HDC hdc )
     BITMAPOBJ *bitmap;
     DC *dc;
     PHYSDEV physdev;
+    SIZE size;
 
     if (!(dc = get_dc_ptr( hdc ))) return 0;
 
@@ -1753,23 +1754,28 @@ static HGDIOBJ DIB_SelectObject( HGDIOBJ handle, HDC hdc )
         goto done;
     }
 
+    /* take the selection reference before dropping the lock, so that the bitmap
+     * can't be deleted or selected elsewhere while the driver is called */
+    GDI_inc_ref_count( handle );
+    size.cx = bitmap->dib.dsBm.bmWidth;
+    size.cy = bitmap->dib.dsBm.bmHeight;
+    GDI_ReleaseObj( handle );
+
     physdev = GET_DC_PHYSDEV( dc, pSelectBitmap );
     if (!physdev->funcs->pSelectBitmap( physdev, handle ))
     {
-        GDI_ReleaseObj( handle );
+        GDI_dec_ref_count( handle );
         ret = 0;
     }
     else
     {
         dc->hBitmap = handle;
-        GDI_inc_ref_count( handle );
         dc->dirty = 0;
         dc->vis_rect.left   = 0;
         dc->vis_rect.top    = 0;
-        dc->vis_rect.right  = bitmap->dib.dsBm.bmWidth;
-        dc->vis_rect.bottom = bitmap->dib.dsBm.bmHeight;
+        dc->vis_rect.right  = size.cx;
+        dc->vis_rect.bottom = size.cy;
         dc->device_rect = dc->vis_rect;
-        GDI_ReleaseObj( handle );
         DC_InitDC( dc );
         GDI_dec_ref_count( ret );
     }
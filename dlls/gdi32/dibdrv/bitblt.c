@@ -492,7 +492,7 @@ static void copy_rect( dib_info *dst, const RECT *dst_rect, const dib_info *src,
     case R2_WHITE: xor = ~0u;
         /* fall through */
     case R2_BLACK:
-        dst->funcs->solid_rects( dst, count, rects, and, xor );
+        solid_rects_bands( dst, count, rects, and, xor );
         /* fall through */
     case R2_NOP:
         return;
@@ -581,19 +581,48 @@ static void mask_rect( dib_info *dst, const RECT *dst_rect, const dib_info *src,
     }
 }
 
+struct blend_band
+{
+    dib_info        *dst;
+    const RECT      *rect;
+    const dib_info  *src;
+    POINT            origin;
+    BLENDFUNCTION    blend;
+};
+
+static void blend_rect_rows( void *arg, int start, int end )
+{
+    struct blend_band *band = arg;
+    RECT rect = *band->rect;
+    POINT origin = band->origin;
+
+    rect.top = band->rect->top + start;
+    rect.bottom = band->rect->top + end;
+    origin.y += start;
+    band->dst->funcs->blend_rect( band->dst, &rect, band->src, &origin, band->blend );
+}
+
 static DWORD blend_rect( dib_info *dst, const RECT *dst_rect, const dib_info *src, const RECT *src_rect,
                          HRGN clip, BLENDFUNCTION blend )
 {
-    POINT origin;
+    struct blend_band band;
     struct clipped_rects clipped_rects;
+    BOOL overlap;
     int i;
 
     if (!get_clipped_rects( dst, dst_rect, clip, &clipped_rects )) return ERROR_SUCCESS;
+    overlap = dib_bits_overlap( dst, src );
+    band.dst = dst;
+    band.src = src;
+    band.blend = blend;
     for (i = 0; i < clipped_rects.count; i++)
     {
-        origin.x = src_rect->left + clipped_rects.rects[i].left - dst_rect->left;
-        origin.y = src_rect->top  + clipped_rects.rects[i].top  - dst_rect->top;
-        dst->funcs->blend_rect( dst, &clipped_rects.rects[i], src, &origin, blend );
+        band.rect = &clipped_rects.rects[i];
+        band.origin.x = src_rect->left + clipped_rects.rects[i].left - dst_rect->left;
+        band.origin.y = src_rect->top  + clipped_rects.rects[i].top  - dst_rect->top;
+        if (overlap) dst->funcs->blend_rect( dst, band.rect, src, &band.origin, blend );
+        else run_bands( band.rect->bottom - band.rect->top, band.rect->right - band.rect->left,
+                        blend_rect_rows, &band );
     }
     free_clipped_rects( &clipped_rects );
     return ERROR_SUCCESS;
@@ -678,16 +707,44 @@ static void get_gradient_triangle_vertices( const GRADIENT_TRIANGLE *tri, const
     bounds->bottom = v[2].y;
 }
 
+struct gradient_band
+{
+    dib_info        *dib;
+    const RECT      *rect;
+    const TRIVERTEX *v;
+    int              mode;
+    LONG             failed;
+};
+
+static void gradient_rect_rows( void *arg, int start, int end )
+{
+    struct gradient_band *band = arg;
+    RECT rect = *band->rect;
+
+    rect.top = band->rect->top + start;
+    rect.bottom = band->rect->top + end;
+    if (!band->dib->funcs->gradient_rect( band->dib, &rect, band->v, band->mode ))
+        InterlockedExchange( &band->failed, TRUE );
+}
+
 static BOOL gradient_rect( dib_info *dib, TRIVERTEX *v, int mode, HRGN clip, const RECT *bounds )
 {
     int i;
     struct clipped_rects clipped_rects;
+    struct gradient_band band;
     BOOL ret = TRUE;
 
     if (!get_clipped_rects( dib, bounds, clip, &clipped_rects )) return TRUE;
+    band.dib = dib;
+    band.v = v;
+    band.mode = mode;
+    band.failed = FALSE;
     for (i = 0; i < clipped_rects.count; i++)
     {
-        if (!(ret = dib->funcs->gradient_rect( dib, &clipped_rects.rects[i], v, mode ))) break;
+        band.rect = &clipped_rects.rects[i];
+        run_bands( band.rect->bottom - band.rect->top, band.rect->right - band.rect->left,
+                   gradient_rect_rows, &band );
+        if (!(ret = !band.failed)) break;
     }
     free_clipped_rects( &clipped_rects );
     return ret;
@@ -1196,6 +1253,98 @@ static DWORD calc_1d_stretch_params( INT dst_start, INT dst_length, INT dst_vis_
 }
 
 
+struct stretch_band
+{
+    dib_info                    *dst_dib;
+    const dib_info              *src_dib;
+    POINT                        dst_start;
+    POINT                        src_start;
+    const struct stretch_params *v_params;
+    const struct stretch_params *h_params;
+    void (* row_fn)(const dib_info *dst_dib, const POINT *dst_start,
+                    const dib_info *src_dib, const POINT *src_start,
+                    const struct stretch_params *params, int mode, BOOL keep_dst);
+    int                          mode;
+    BOOL                         vstretch;
+    int                          width;
+};
+
+/* process the source rows (when shrinking) or destination rows (when stretching) in [start, end) */
+static void stretch_rows( void *arg, int start, int end )
+{
+    struct stretch_band *band = arg;
+    const struct stretch_params *v_params = band->v_params;
+    POINT dst_start = band->dst_start, src_start = band->src_start;
+    int i, err = v_params->err_start;
+
+    if (band->vstretch)
+    {
+        BOOL need_row = TRUE;
+        RECT last_row, this_row;
+        last_row.left = 0;
+        last_row.right = band->width;
+
+        for (i = 0; i < end; i++)
+        {
+            if (i >= start)
+            {
+                /* the previous row may belong to another band, don't copy it */
+                if (need_row || i == start)
+                {
+                    band->row_fn( band->dst_dib, &dst_start, band->src_dib, &src_start,
+                                  band->h_params, band->mode, FALSE );
+                    need_row = FALSE;
+                }
+                else
+                {
+                    last_row.top = dst_start.y - v_params->dst_inc;
+                    last_row.bottom = last_row.top + 1;
+                    this_row = last_row;
+                    offset_rect( &this_row, 0, v_params->dst_inc );
+                    copy_rect( band->dst_dib, &this_row, band->dst_dib, &last_row, NULL, R2_COPYPEN );
+                }
+            }
+
+            if (err > 0)
+            {
+                src_start.y += v_params->src_inc;
+                need_row = TRUE;
+                err += v_params->err_add_1;
+            }
+            else err += v_params->err_add_2;
+            dst_start.y += v_params->dst_inc;
+        }
+    }
+    else
+    {
+        int merged_rows = 0;
+        BOOL active = FALSE;
+
+        for (i = 0; i < v_params->length; i++)
+        {
+            /* a band owns the destination rows whose first source row lies in it */
+            if (!merged_rows && i >= start)
+            {
+                if (i >= end) break;
+                active = TRUE;
+            }
+            if (active && (band->mode != STRETCH_DELETESCANS || !merged_rows))
+                band->row_fn( band->dst_dib, &dst_start, band->src_dib, &src_start,
+                              band->h_params, band->mode, merged_rows != 0 );
+            merged_rows++;
+
+            if (err > 0)
+            {
+                dst_start.y += v_params->dst_inc;
+                merged_rows = 0;
+                err += v_params->err_add_1;
+            }
+            else err += v_params->err_add_2;
+            src_start.y += v_params->src_inc;
+        }
+    }
+}
+
 DWORD stretch_bitmapinfo( const BITMAPINFO *src_info, void *src_bits, struct bitblt_coords *src,
                           const BITMAPINFO *dst_info, void *dst_bits, struct bitblt_coords *dst,
                           INT mode )
@@ -1205,11 +1354,8 @@ DWORD stretch_bitmapinfo( const BITMAPINFO *src_info, void *src_bits, struct bit
     RECT rect;
     BOOL hstretch, vstretch;
     struct stretch_params v_params, h_params;
-    int err;
+    struct stretch_band band;
     DWORD ret;
-    void (* row_fn)(const dib_info *dst_dib, const POINT *dst_start,
-                    const dib_info *src_dib, const POINT *src_start,
-                    const struct stretch_params *params, int mode, BOOL keep_dst);
 
     TRACE("dst %d, %d - %d x %d visrect %s src %d, %d - %d x %d visrect %s\n",
           dst->x, dst->y, dst->width, dst->height, wine_dbgstr_rect(&dst->visrect),
@@ -1243,64 +1389,19 @@ DWORD stretch_bitmapinfo( const BITMAPINFO *src_info, void *src_bits, struct bit
     dst_start.x -= dst->visrect.left;
     dst_start.y -= dst->visrect.top;
 
-    err = v_params.err_start;
-
-    row_fn = hstretch ? dst_dib.funcs->stretch_row : dst_dib.funcs->shrink_row;
-
-    if (vstretch)
-    {
-        BOOL need_row = TRUE;
-        RECT last_row, this_row;
-        if (hstretch) mode = STRETCH_DELETESCANS;
-        last_row.left = 0;
-        last_row.right = dst->visrect.right - dst->visrect.left;
-
-        while (v_params.length--)
-        {
-            if (need_row)
-            {
-                row_fn( &dst_dib, &dst_start, &src_dib, &src_start, &h_params, mode, FALSE );
-                need_row = FALSE;
-            }
-            else
-            {
-                last_row.top = dst_start.y - v_params.dst_inc;
-                last_row.bottom = last_row.top + 1;
-                this_row = last_row;
-                offset_rect( &this_row, 0, v_params.dst_inc );
-                copy_rect( &dst_dib, &this_row, &dst_dib, &last_row, NULL, R2_COPYPEN );
-            }
-
-            if (err > 0)
-            {
-                src_start.y += v_params.src_inc;
-                need_row = TRUE;
-                err += v_params.err_add_1;
-            }
-            else err += v_params.err_add_2;
-            dst_start.y += v_params.dst_inc;
-        }
-    }
-    else
-    {
-        int merged_rows = 0;
-
-        while (v_params.length--)
-        {
-            if (mode != STRETCH_DELETESCANS || !merged_rows)
-                row_fn( &dst_dib, &dst_start, &src_dib, &src_start, &h_params, mode, merged_rows != 0 );
-            merged_rows++;
-
-            if (err > 0)
-            {
-                dst_start.y += v_params.dst_inc;
-                merged_rows = 0;
-                err += v_params.err_add_1;
-            }
-            else err += v_params.err_add_2;
-            src_start.y += v_params.src_inc;
-        }
-    }
+    band.dst_dib   = &dst_dib;
+    band.src_dib   = &src_dib;
+    band.dst_start = dst_start;
+    band.src_start = src_start;
+    band.v_params  = &v_params;
+    band.h_params  = &h_params;
+    band.row_fn    = hstretch ? dst_dib.funcs->stretch_row : dst_dib.funcs->shrink_row;
+    band.mode      = (vstretch && hstretch) ? STRETCH_DELETESCANS : mode;
+    band.vstretch  = vstretch;
+    band.width     = dst->visrect.right - dst->visrect.left;
+
+    if (dib_bits_overlap( &dst_dib, &src_dib )) stretch_rows( &band, 0, v_params.length );
+    else run_bands( v_params.length, h_params.length, stretch_rows, &band );
 
     /* update coordinates, the destination rectangle is always stored at 0,0 */
     *src = *dst;
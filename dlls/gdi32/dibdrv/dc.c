@@ -22,6 +22,7 @@
 
 #include "gdi_private.h"
 #include "dibdrv.h"
+#include "winreg.h"
 
 #include "wine/exception.h"
 #include "wine/debug.h"
@@ -210,6 +211,25 @@ void copy_dib_color_info(dib_info *dst, const dib_info *src)
     dst->color_table      = src->color_table;
 }
 
+/**********************************************************************
+ *      get_dibdrv_option
+ *
+ * Retrieve a tuning value from HKCU\Software\Wine\Gdi.
+ */
+DWORD get_dibdrv_option( const WCHAR *name, DWORD def )
+{
+    static const WCHAR keyW[] = {'S','o','f','t','w','a','r','e','\\','W','i','n','e','\\','G','d','i',0};
+    DWORD type, value, size = sizeof(value);
+    HKEY key;
+
+    if (RegOpenKeyExW( HKEY_CURRENT_USER, keyW, 0, KEY_READ, &key )) return def;
+    if (RegQueryValueExW( key, name, NULL, &type, (BYTE *)&value, &size ) || type != REG_DWORD)
+        value = def;
+    RegCloseKey( key );
+    TRACE( "%s = %u\n", debugstr_w(name), value );
+    return value;
+}
+
 DWORD convert_bitmapinfo( const BITMAPINFO *src_info, void *src_bits, struct bitblt_coords *src,
                           const BITMAPINFO *dst_info, void *dst_bits )
 {
@@ -284,7 +304,11 @@ int get_clipped_rects( const dib_info *dib, const RECT *rc, HRGN clip, struct cl
         if (out == &clip_rects->buffer[ARRAY_SIZE( clip_rects->buffer )])
         {
             clip_rects->rects = HeapAlloc( GetProcessHeap(), 0, region->numRects * sizeof(RECT) );
-            if (!clip_rects->rects) return 0;
+            if (!clip_rects->rects)
+            {
+                release_wine_region( clip );
+                return 0;
+            }
             memcpy( clip_rects->rects, clip_rects->buffer, (out - clip_rects->buffer) * sizeof(RECT) );
             out = clip_rects->rects + (out - clip_rects->buffer);
         }
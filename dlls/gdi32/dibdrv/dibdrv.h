@@ -266,6 +266,13 @@ extern int clip_line(const POINT *start, const POINT *end, const RECT *clip,
 extern void release_cached_font( struct cached_font *font ) DECLSPEC_HIDDEN;
 extern BOOL fill_with_pixel( DC *dc, dib_info *dib, DWORD pixel, int num, const RECT *rects, INT rop ) DECLSPEC_HIDDEN;
 
+extern DWORD get_dibdrv_option( const WCHAR *name, DWORD def ) DECLSPEC_HIDDEN;
+
+typedef void (*band_func)( void *ctx, int start, int end );
+extern void run_bands( int rows, int row_pixels, band_func func, void *ctx ) DECLSPEC_HIDDEN;
+extern BOOL dib_bits_overlap( const dib_info *dib1, const dib_info *dib2 ) DECLSPEC_HIDDEN;
+extern void solid_rects_bands( const dib_info *dib, int num, const RECT *rects, DWORD and, DWORD xor ) DECLSPEC_HIDDEN;
+
 static inline void init_clipped_rects( struct clipped_rects *clip_rects )
 {
     clip_rects->count = 0;
@@ -30,18 +30,28 @@ WINE_DEFAULT_DEBUG_CHANNEL(dib);
 struct cached_glyph
 {
     GLYPHMETRICS metrics;
+    UINT         key;      /* glyph index or character, see glyph_key() */
     BYTE         bits[1];
 };
 
-enum glyph_type
+/* open addressing hash table of the cached glyphs, which can be searched without locking */
+struct glyph_index
 {
-    GLYPH_INDEX,
-    GLYPH_WCHAR,
-    GLYPH_NBTYPES
+    struct glyph_index  *prev;   /* smaller table it replaced, kept for concurrent lookups */
+    UINT                 mask;
+    struct cached_glyph *glyphs[1];
 };
 
-#define GLYPH_CACHE_PAGE_SIZE  0x100
-#define GLYPH_CACHE_PAGES      (0x10000 / GLYPH_CACHE_PAGE_SIZE)
+/* the glyphs of a font are packed in a few large pages instead of one allocation per glyph */
+struct glyph_atlas
+{
+    struct glyph_atlas  *next;
+    SIZE_T               size;
+    SIZE_T               used;
+    BYTE                 data[1];
+};
+
+#define GLYPH_ATLAS_SIZE  (64 * 1024)
 
 struct cached_font
 {
@@ -51,10 +61,18 @@ struct cached_font
     LOGFONTW              lf;
     XFORM                 xform;
     UINT                  aa_flags;
-    struct cached_glyph **glyphs[GLYPH_NBTYPES][GLYPH_CACHE_PAGES];
+    struct glyph_index   *index;
+    UINT                  glyph_count;
+    struct glyph_atlas   *atlas;
+    SIZE_T                atlas_size;
+    LONG                  readers;        /* threads using glyphs of this font */
+    struct glyph_index   *retired_index;  /* trimmed glyphs, freed once there are no readers */
+    struct glyph_atlas   *retired_atlas;
 };
 
 static struct list font_cache = LIST_INIT( font_cache );
+static SIZE_T max_atlas_size;   /* glyph cache size per font, GlyphCacheSize option in KB */
+static UINT max_unused_fonts;   /* unused fonts kept around, GlyphCacheFonts option */
 
 static CRITICAL_SECTION font_cache_cs;
 static CRITICAL_SECTION_DEBUG critsect_debug =
@@ -554,10 +572,49 @@ static int font_cache_cmp( const struct cached_font *p1, const struct cached_fon
     return ret;
 }
 
+static void free_glyphs( struct glyph_index *index, struct glyph_atlas *atlas )
+{
+    struct glyph_index *prev;
+    struct glyph_atlas *next;
+
+    for ( ; index; index = prev)
+    {
+        prev = index->prev;
+        HeapFree( GetProcessHeap(), 0, index );
+    }
+    for ( ; atlas; atlas = next)
+    {
+        next = atlas->next;
+        HeapFree( GetProcessHeap(), 0, atlas );
+    }
+}
+
+static void free_font_glyphs( struct cached_font *font )
+{
+    free_glyphs( font->index, font->atlas );
+    free_glyphs( font->retired_index, font->retired_atlas );
+    font->index = NULL;
+    font->glyph_count = 0;
+    font->atlas = NULL;
+    font->atlas_size = 0;
+    font->retired_index = NULL;
+    font->retired_atlas = NULL;
+}
+
+static void init_font_cache_options(void)
+{
+    static const WCHAR sizeW[] = {'G','l','y','p','h','C','a','c','h','e','S','i','z','e',0};
+    static const WCHAR fontsW[] = {'G','l','y','p','h','C','a','c','h','e','F','o','n','t','s',0};
+
+    if (max_atlas_size) return;
+    max_unused_fonts = get_dibdrv_option( fontsW, 5 );
+    max_atlas_size = max( get_dibdrv_option( sizeW, 4096 ), 64 ) * 1024;
+}
+
 static struct cached_font *add_cached_font( DC *dc, HFONT hfont, UINT aa_flags )
 {
     struct cached_font font, *ptr, *last_unused = NULL;
-    UINT i = 0, j, k;
+    UINT i = 0;
 
     GetObjectW( hfont, sizeof(font.lf), &font.lf );
     font.xform = dc->xformWorld2Vport;
@@ -573,6 +630,7 @@ static struct cached_font *add_cached_font( DC *dc, HFONT hfont, UINT aa_flags )
     font.hash = font_cache_hash( &font );
 
     EnterCriticalSection( &font_cache_cs );
+    init_font_cache_options();
     LIST_FOR_EACH_ENTRY( ptr, &font_cache, struct cached_font, entry )
     {
         if (!font_cache_cmp( &font, ptr ))
@@ -588,19 +646,10 @@ static struct cached_font *add_cached_font( DC *dc, HFONT hfont, UINT aa_flags )
         }
     }
 
-    if (i > 5)  /* keep at least 5 of the most-recently used fonts around */
+    if (i > max_unused_fonts)  /* keep some of the most-recently used fonts around */
     {
         ptr = last_unused;
-        for (i = 0; i < GLYPH_NBTYPES; i++)
-        {
-            for (j = 0; j < GLYPH_CACHE_PAGES; j++)
-            {
-                if (!ptr->glyphs[i][j]) continue;
-                for (k = 0; k < GLYPH_CACHE_PAGE_SIZE; k++)
-                    HeapFree( GetProcessHeap(), 0, ptr->glyphs[i][j][k] );
-                HeapFree( GetProcessHeap(), 0, ptr->glyphs[i][j] );
-            }
-        }
+        free_font_glyphs( ptr );
         list_remove( &ptr->entry );
     }
     else if (!(ptr = HeapAlloc( GetProcessHeap(), 0, sizeof(*ptr) )))
@@ -611,7 +660,13 @@ static struct cached_font *add_cached_font( DC *dc, HFONT hfont, UINT aa_flags )
 
     *ptr = font;
     ptr->ref = 1;
-    memset( ptr->glyphs, 0, sizeof(ptr->glyphs) );
+    ptr->index = NULL;
+    ptr->glyph_count = 0;
+    ptr->atlas = NULL;
+    ptr->atlas_size = 0;
+    ptr->readers = 0;
+    ptr->retired_index = NULL;
+    ptr->retired_atlas = NULL;
 done:
     list_add_head( &font_cache, &ptr->entry );
     LeaveCriticalSection( &font_cache_cs );
@@ -624,40 +679,174 @@ void release_cached_font( struct cached_font *font )
     if (font) InterlockedDecrement( &font->ref );
 }
 
-static struct cached_glyph *add_cached_glyph( struct cached_font *font, UINT index, UINT flags,
-                                              struct cached_glyph *glyph )
+/* free the retired glyphs if nobody can still be using them, font_cache_cs must be held */
+static void free_retired_glyphs( struct cached_font *font )
+{
+    if (font->readers) return;
+    free_glyphs( font->retired_index, font->retired_atlas );
+    font->retired_index = NULL;
+    font->retired_atlas = NULL;
+}
+
+/* Empty the glyph cache of a font that has grown too large. Other threads may
+ * be drawing with the same font, so the glyphs are only retired and freed once
+ * the font has no readers. Readers that start afterwards see the new index. */
+static void trim_cached_font( struct cached_font *font )
 {
-    struct cached_glyph *ret;
-    enum glyph_type type = (flags & ETO_GLYPH_INDEX) ? GLYPH_INDEX : GLYPH_WCHAR;
-    UINT page = index / GLYPH_CACHE_PAGE_SIZE;
-    UINT entry = index % GLYPH_CACHE_PAGE_SIZE;
+    struct glyph_index *index;
+    struct glyph_atlas *atlas;
 
-    if (!font->glyphs[type][page])
+    if (font->atlas_size <= max_atlas_size) return;
+    EnterCriticalSection( &font_cache_cs );
+    if (font->atlas_size > max_atlas_size)
     {
-        struct cached_glyph **ptr;
+        TRACE( "%p: freeing %u glyphs\n", font, font->glyph_count );
+        if ((index = InterlockedExchangePointer( (void **)&font->index, NULL )))
+        {
+            struct glyph_index *last = index;
 
-        ptr = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, GLYPH_CACHE_PAGE_SIZE * sizeof(*ptr) );
-        if (!ptr)
+            while (last->prev) last = last->prev;
+            last->prev = font->retired_index;
+            font->retired_index = index;
+        }
+        if ((atlas = font->atlas))
         {
-            HeapFree( GetProcessHeap(), 0, glyph );
-            return NULL;
+            while (atlas->next) atlas = atlas->next;
+            atlas->next = font->retired_atlas;
+            font->retired_atlas = font->atlas;
         }
-        if (InterlockedCompareExchangePointer( (void **)&font->glyphs[type][page], ptr, NULL ))
-            HeapFree( GetProcessHeap(), 0, ptr );
+        font->glyph_count = 0;
+        font->atlas = NULL;
+        font->atlas_size = 0;
     }
-    ret = InterlockedCompareExchangePointer( (void **)&font->glyphs[type][page][entry], glyph, NULL );
-    if (!ret) ret = glyph;
-    else HeapFree( GetProcessHeap(), 0, glyph );
-    return ret;
+    free_retired_glyphs( font );
+    LeaveCriticalSection( &font_cache_cs );
+}
+
+/* the glyphs returned by get_cached_glyph stay valid until end_glyph_reads */
+static void begin_glyph_reads( struct cached_font *font )
+{
+    InterlockedIncrement( &font->readers );
+}
+
+static void end_glyph_reads( struct cached_font *font )
+{
+    if (InterlockedDecrement( &font->readers ) || (!font->retired_index && !font->retired_atlas)) return;
+    EnterCriticalSection( &font_cache_cs );
+    free_retired_glyphs( font );
+    LeaveCriticalSection( &font_cache_cs );
+}
+
+static inline UINT glyph_key( UINT index, UINT flags )
+{
+    return (index << 1) | !(flags & ETO_GLYPH_INDEX);
+}
+
+static inline UINT glyph_hash( UINT key )
+{
+    key *= 0x9e3779b1;
+    return key ^ (key >> 16);
 }
 
 static struct cached_glyph *get_cached_glyph( struct cached_font *font, UINT index, UINT flags )
 {
-    enum glyph_type type = (flags & ETO_GLYPH_INDEX) ? GLYPH_INDEX : GLYPH_WCHAR;
-    UINT page = index / GLYPH_CACHE_PAGE_SIZE;
+    struct glyph_index *table = *(struct glyph_index * volatile *)&font->index;
+    struct cached_glyph *glyph;
+    UINT key = glyph_key( index, flags ), i;
+
+    if (!table) return NULL;
+    for (i = glyph_hash( key ) & table->mask; (glyph = table->glyphs[i]); i = (i + 1) & table->mask)
+        if (glyph->key == key) return glyph;
+    return NULL;
+}
+
+/* allocate space for a glyph in the font atlas, font_cache_cs must be held */
+static struct cached_glyph *alloc_atlas_glyph( struct cached_font *font, SIZE_T size )
+{
+    struct glyph_atlas *atlas = font->atlas;
+    struct cached_glyph *glyph;
+
+    size = (FIELD_OFFSET( struct cached_glyph, bits[size] ) + 7) & ~7;
+    if (!atlas || atlas->used + size > atlas->size)
+    {
+        SIZE_T atlas_size = max( GLYPH_ATLAS_SIZE, size );
+
+        if (!(atlas = HeapAlloc( GetProcessHeap(), 0, FIELD_OFFSET( struct glyph_atlas, data[atlas_size] ))))
+            return NULL;
+        atlas->size = atlas_size;
+        atlas->used = 0;
+        /* glyphs too large for a regular page don't take the place of the current one */
+        if (atlas_size > GLYPH_ATLAS_SIZE && font->atlas)
+        {
+            atlas->next = font->atlas->next;
+            font->atlas->next = atlas;
+        }
+        else
+        {
+            atlas->next = font->atlas;
+            font->atlas = atlas;
+        }
+        font->atlas_size += atlas_size;
+    }
+    glyph = (struct cached_glyph *)(atlas->data + atlas->used);
+    atlas->used += size;
+    return glyph;
+}
+
+/* add a glyph to the hashed index, font_cache_cs must be held */
+static BOOL index_glyph( struct cached_font *font, struct cached_glyph *glyph )
+{
+    struct glyph_index *table = font->index, *new_table;
+    UINT i, size;
+
+    if (!table || (font->glyph_count + 1) * 2 > table->mask + 1)
+    {
+        size = table ? (table->mask + 1) * 2 : 256;
+        new_table = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY,
+                               FIELD_OFFSET( struct glyph_index, glyphs[size] ));
+        if (!new_table) return FALSE;
+        new_table->prev = table;
+        new_table->mask = size - 1;
+        if (table)
+        {
+            for (i = 0; i <= table->mask; i++)
+            {
+                struct cached_glyph *old = table->glyphs[i];
+                UINT pos;
+
+                if (!old) continue;
+                for (pos = glyph_hash( old->key ) & new_table->mask; new_table->glyphs[pos];
+                     pos = (pos + 1) & new_table->mask) ;
+                new_table->glyphs[pos] = old;
+            }
+        }
+        InterlockedExchangePointer( (void **)&font->index, new_table );
+        table = new_table;
+    }
+
+    for (i = glyph_hash( glyph->key ) & table->mask; table->glyphs[i]; i = (i + 1) & table->mask) ;
+    InterlockedExchangePointer( (void **)&table->glyphs[i], glyph );
+    font->glyph_count++;
+    return TRUE;
+}
+
+static struct cached_glyph *add_cached_glyph( struct cached_font *font, UINT index, UINT flags,
+                                              const GLYPHMETRICS *metrics, const BYTE *bits, SIZE_T size )
+{
+    struct cached_glyph *glyph;
 
-    if (!font->glyphs[type][page]) return NULL;
-    return font->glyphs[type][page][index % GLYPH_CACHE_PAGE_SIZE];
+    EnterCriticalSection( &font_cache_cs );
+    /* another thread may have added it in the meantime */
+    if (!(glyph = get_cached_glyph( font, index, flags )) &&
+        (glyph = alloc_atlas_glyph( font, size )))
+    {
+        glyph->metrics = *metrics;
+        glyph->key = glyph_key( index, flags );
+        memcpy( glyph->bits, bits, size );
+        if (!index_glyph( font, glyph )) glyph = NULL;
+    }
+    LeaveCriticalSection( &font_cache_cs );
+    return glyph;
 }
 
 /**********************************************************************
@@ -681,38 +870,6 @@ static inline void get_text_bkgnd_masks( DC *dc, const dib_info *dib, rop_mask *
     }
 }
 
-static void draw_glyph( dib_info *dib, int x, int y, const GLYPHMETRICS *metrics,
-                        const dib_info *glyph_dib, DWORD text_color,
-                        const struct font_intensities *intensity,
-                        const struct clipped_rects *clipped_rects, RECT *bounds )
-{
-    int i;
-    RECT rect, clipped_rect;
-    POINT src_origin;
-
-    rect.left   = x          + metrics->gmptGlyphOrigin.x;
-    rect.top    = y          - metrics->gmptGlyphOrigin.y;
-    rect.right  = rect.left  + metrics->gmBlackBoxX;
-    rect.bottom = rect.top   + metrics->gmBlackBoxY;
-    if (bounds) add_bounds_rect( bounds, &rect );
-
-    for (i = 0; i < clipped_rects->count; i++)
-    {
-        if (intersect_rect( &clipped_rect, &rect, clipped_rects->rects + i ))
-        {
-            src_origin.x = clipped_rect.left - rect.left;
-            src_origin.y = clipped_rect.top  - rect.top;
-
-            if (glyph_dib->bit_count == 32)
-                dib->funcs->draw_subpixel_glyph( dib, &clipped_rect, glyph_dib, &src_origin,
-                                                 text_color, intensity->gamma_ramp );
-            else
-                dib->funcs->draw_glyph( dib, &clipped_rect, glyph_dib, &src_origin,
-                                        text_color, intensity->ranges );
-        }
-    }
-}
-
 static int get_glyph_depth( UINT aa_flags )
 {
     switch (aa_flags)
@@ -756,6 +913,7 @@ static struct cached_glyph *cache_glyph_bitmap( DC *dc, struct cached_font *font
     int pad = 0, stride, bit_count;
     GLYPHMETRICS metrics;
     struct cached_glyph *glyph;
+    BYTE *bits = NULL;
 
     if (flags & ETO_GLYPH_INDEX) ggo_flags |= GGO_GLYPH_INDEX;
     indices[0] = index;
@@ -771,16 +929,15 @@ static struct cached_glyph *cache_glyph_bitmap( DC *dc, struct cached_font *font
     bit_count = get_glyph_depth( font->aa_flags );
     stride = get_dib_stride( metrics.gmBlackBoxX, bit_count );
     size = metrics.gmBlackBoxY * stride;
-    glyph = HeapAlloc( GetProcessHeap(), 0, FIELD_OFFSET( struct cached_glyph, bits[size] ));
-    if (!glyph) return NULL;
     if (!size) goto done;  /* empty glyph */
+    if (!(bits = HeapAlloc( GetProcessHeap(), 0, size ))) return NULL;
 
     if (bit_count == 8) pad = padding[ metrics.gmBlackBoxX % 4 ];
 
-    ret = GetGlyphOutlineW( dc->hSelf, index, ggo_flags, &metrics, size, glyph->bits, &identity );
+    ret = GetGlyphOutlineW( dc->hSelf, index, ggo_flags, &metrics, size, bits, &identity );
     if (ret == GDI_ERROR)
     {
-        HeapFree( GetProcessHeap(), 0, glyph );
+        HeapFree( GetProcessHeap(), 0, bits );
         return NULL;
     }
     assert( ret <= size );
@@ -788,8 +945,8 @@ static struct cached_glyph *cache_glyph_bitmap( DC *dc, struct cached_font *font
     {
         for (y = metrics.gmBlackBoxY - 1; y >= 0; y--)
         {
-            src = glyph->bits + y * get_dib_stride( metrics.gmBlackBoxX, 1 );
-            dst = glyph->bits + y * stride;
+            src = bits + y * get_dib_stride( metrics.gmBlackBoxX, 1 );
+            dst = bits + y * stride;
 
             if (pad) memset( dst + metrics.gmBlackBoxX, 0, pad );
 
@@ -799,51 +956,110 @@ static struct cached_glyph *cache_glyph_bitmap( DC *dc, struct cached_font *font
     }
     else if (pad)
     {
-        for (y = 0, dst = glyph->bits; y < metrics.gmBlackBoxY; y++, dst += stride)
+        for (y = 0, dst = bits; y < metrics.gmBlackBoxY; y++, dst += stride)
             memset( dst + metrics.gmBlackBoxX, 0, pad );
     }
 
 done:
-    glyph->metrics = metrics;
-    return add_cached_glyph( font, index, flags, glyph );
+    glyph = add_cached_glyph( font, index, flags, &metrics, bits, size );
+    HeapFree( GetProcessHeap(), 0, bits );
+    return glyph;
+}
+
+struct glyph_pos
+{
+    const struct cached_glyph *glyph;
+    RECT                       rect;
+};
+
+static void draw_glyph_run( dib_info *dib, const struct glyph_pos *run, UINT count, const RECT *run_rect,
+                            int bit_count, DWORD text_color, const struct font_intensities *intensity,
+                            const struct clipped_rects *clipped_rects )
+{
+    dib_info glyph_dib;
+    RECT clip, rect;
+    POINT src_origin;
+    UINT i;
+    int j;
+
+    glyph_dib.bit_count    = bit_count;
+    glyph_dib.rect.left    = 0;
+    glyph_dib.rect.top     = 0;
+    glyph_dib.bits.is_copy = FALSE;
+    glyph_dib.bits.free    = NULL;
+
+    /* the clip rectangles don't overlap, so this draws each pixel in the same order as going
+     * through the glyphs first, while skipping the rectangles that the run doesn't touch */
+    for (j = 0; j < clipped_rects->count; j++)
+    {
+        if (!intersect_rect( &clip, run_rect, clipped_rects->rects + j )) continue;
+
+        for (i = 0; i < count; i++)
+        {
+            if (!intersect_rect( &rect, &run[i].rect, &clip )) continue;
+
+            glyph_dib.width       = run[i].glyph->metrics.gmBlackBoxX;
+            glyph_dib.height      = run[i].glyph->metrics.gmBlackBoxY;
+            glyph_dib.rect.right  = glyph_dib.width;
+            glyph_dib.rect.bottom = glyph_dib.height;
+            glyph_dib.stride      = get_dib_stride( glyph_dib.width, bit_count );
+            glyph_dib.bits.ptr    = (void *)run[i].glyph->bits;
+
+            src_origin.x = rect.left - run[i].rect.left;
+            src_origin.y = rect.top  - run[i].rect.top;
+
+            if (bit_count == 32)
+                dib->funcs->draw_subpixel_glyph( dib, &rect, &glyph_dib, &src_origin,
+                                                 text_color, intensity->gamma_ramp );
+            else
+                dib->funcs->draw_glyph( dib, &rect, &glyph_dib, &src_origin,
+                                        text_color, intensity->ranges );
+        }
+    }
 }
 
 static void render_string( DC *dc, dib_info *dib, struct cached_font *font, INT x, INT y,
                            UINT flags, const WCHAR *str, UINT count, const INT *dx,
                            const struct clipped_rects *clipped_rects, RECT *bounds )
 {
-    UINT i;
+    UINT i, pos = 0;
     struct cached_glyph *glyph;
-    dib_info glyph_dib;
+    struct glyph_pos run_buffer[64], *run = run_buffer;
     DWORD text_color;
     struct font_intensities intensity;
+    int bit_count = get_glyph_depth( font->aa_flags );
+    RECT run_rect;
 
-    glyph_dib.bit_count    = get_glyph_depth( font->aa_flags );
-    glyph_dib.rect.left    = 0;
-    glyph_dib.rect.top     = 0;
-    glyph_dib.bits.is_copy = FALSE;
-    glyph_dib.bits.free    = NULL;
+    trim_cached_font( font );
+
+    if (count > ARRAY_SIZE( run_buffer ) &&
+        !(run = HeapAlloc( GetProcessHeap(), 0, count * sizeof(*run) )))
+        return;
+
+    begin_glyph_reads( font );
 
     text_color = get_pixel_color( dc, dib, dc->textColor, TRUE );
 
-    if (glyph_dib.bit_count == 32)
+    if (bit_count == 32)
         intensity.gamma_ramp = dc->font_gamma_ramp;
     else
         get_aa_ranges( dib->funcs->pixel_to_colorref( dib, text_color ), intensity.ranges );
 
+    /* lay out the whole string first, then draw it in one pass */
+    reset_bounds( &run_rect );
     for (i = 0; i < count; i++)
     {
         if (!(glyph = get_cached_glyph( font, str[i], flags )) &&
             !(glyph = cache_glyph_bitmap( dc, font, str[i], flags ))) continue;
 
-        glyph_dib.width       = glyph->metrics.gmBlackBoxX;
-        glyph_dib.height      = glyph->metrics.gmBlackBoxY;
-        glyph_dib.rect.right  = glyph->metrics.gmBlackBoxX;
-        glyph_dib.rect.bottom = glyph->metrics.gmBlackBoxY;
-        glyph_dib.stride      = get_dib_stride( glyph->metrics.gmBlackBoxX, glyph_dib.bit_count );
-        glyph_dib.bits.ptr    = glyph->bits;
-
-        draw_glyph( dib, x, y, &glyph->metrics, &glyph_dib, text_color, &intensity, clipped_rects, bounds );
+        run[pos].glyph       = glyph;
+        run[pos].rect.left   = x + glyph->metrics.gmptGlyphOrigin.x;
+        run[pos].rect.top    = y - glyph->metrics.gmptGlyphOrigin.y;
+        run[pos].rect.right  = run[pos].rect.left + glyph->metrics.gmBlackBoxX;
+        run[pos].rect.bottom = run[pos].rect.top  + glyph->metrics.gmBlackBoxY;
+        if (bounds) add_bounds_rect( bounds, &run[pos].rect );
+        add_bounds_rect( &run_rect, &run[pos].rect );
+        pos++;
 
         if (dx)
         {
@@ -861,6 +1077,10 @@ static void render_string( DC *dc, dib_info *dib, struct cached_font *font, INT
             y += glyph->metrics.gmCellIncY;
         }
     }
+
+    draw_glyph_run( dib, run, pos, &run_rect, bit_count, text_color, &intensity, clipped_rects );
+    end_glyph_reads( font );
+    if (run != run_buffer) HeapFree( GetProcessHeap(), 0, run );
 }
 
 BOOL render_aa_text_bitmapinfo( DC *dc, BITMAPINFO *info, struct gdi_image_bits *bits,
@@ -1198,7 +1418,7 @@ BOOL CDECL dibdrv_PatBlt( PHYSDEV dev, struct bitblt_coords *dst, DWORD rop )
     case R2_WHITE: xor = ~0u;
         /* fall through */
     case R2_BLACK:
-        pdev->dib.funcs->solid_rects( &pdev->dib, clipped_rects.count, clipped_rects.rects, and, xor );
+        solid_rects_bands( &pdev->dib, clipped_rects.count, clipped_rects.rects, and, xor );
         /* fall through */
     case R2_NOP:
         break;
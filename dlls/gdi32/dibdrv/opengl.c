@@ -252,7 +252,9 @@ static BOOL WINAPI dibdrv_wglMakeCurrent( HDC hdc, struct wgl_context *context )
     BITMAPOBJ *bmp;
     dib_info dib;
     GLenum type;
-    BOOL ret = FALSE;
+    char *bits;
+    int width, height;
+    BOOL ret;
 
     if (!context)
     {
@@ -268,33 +270,35 @@ static BOOL WINAPI dibdrv_wglMakeCurrent( HDC hdc, struct wgl_context *context )
     bmp = GDI_GetObjPtr( bitmap, OBJ_BITMAP );
     if (!bmp) return FALSE;
 
-    if (init_dib_info_from_bitmapobj( &dib, bmp ))
+    /* the bits stay valid while the bitmap is selected into the DC */
+    if (!init_dib_info_from_bitmapobj( &dib, bmp ))
     {
-        char *bits;
-        int width = dib.rect.right - dib.rect.left;
-        int height = dib.rect.bottom - dib.rect.top;
+        GDI_ReleaseObj( bitmap );
+        return FALSE;
+    }
+    GDI_ReleaseObj( bitmap );
 
-        if (dib.stride < 0)
-            bits = (char *)dib.bits.ptr + (dib.rect.bottom - 1) * dib.stride;
-        else
-            bits = (char *)dib.bits.ptr + dib.rect.top * dib.stride;
-        bits += dib.rect.left * dib.bit_count / 8;
+    width = dib.rect.right - dib.rect.left;
+    height = dib.rect.bottom - dib.rect.top;
+    if (dib.stride < 0)
+        bits = (char *)dib.bits.ptr + (dib.rect.bottom - 1) * dib.stride;
+    else
+        bits = (char *)dib.bits.ptr + dib.rect.top * dib.stride;
+    bits += dib.rect.left * dib.bit_count / 8;
 
-        TRACE( "context %p bits %p size %ux%u\n", context, bits, width, height );
+    TRACE( "context %p bits %p size %ux%u\n", context, bits, width, height );
 
-        if (pixel_formats[context->format - 1].mesa == OSMESA_RGB_565)
-            type = GL_UNSIGNED_SHORT_5_6_5;
-        else
-            type = GL_UNSIGNED_BYTE;
+    if (pixel_formats[context->format - 1].mesa == OSMESA_RGB_565)
+        type = GL_UNSIGNED_SHORT_5_6_5;
+    else
+        type = GL_UNSIGNED_BYTE;
 
-        ret = pOSMesaMakeCurrent( context->context, bits, type, width, height );
-        if (ret)
-        {
-            pOSMesaPixelStore( OSMESA_ROW_LENGTH, abs( dib.stride ) * 8 / dib.bit_count );
-            pOSMesaPixelStore( OSMESA_Y_UP, 1 );  /* Windows seems to assume bottom-up */
-        }
+    ret = pOSMesaMakeCurrent( context->context, bits, type, width, height );
+    if (ret)
+    {
+        pOSMesaPixelStore( OSMESA_ROW_LENGTH, abs( dib.stride ) * 8 / dib.bit_count );
+        pOSMesaPixelStore( OSMESA_Y_UP, 1 );  /* Windows seems to assume bottom-up */
     }
-    GDI_ReleaseObj( bitmap );
     return ret;
 }
 
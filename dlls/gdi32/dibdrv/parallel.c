@@ -0,0 +1,175 @@
+/*
+ * DIB driver parallel execution of large operations
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301, USA
+ */
+
+#include <stdarg.h>
+
+#include "gdi_private.h"
+#include "dibdrv.h"
+
+#include "wine/debug.h"
+
+WINE_DEFAULT_DEBUG_CHANNEL(dib);
+
+/* operations touching fewer pixels are not worth waking up the worker threads */
+#define MIN_PARALLEL_PIXELS (256 * 1024)
+/* bands per thread, so that threads finishing early can pick up more work */
+#define BANDS_PER_THREAD 4
+#define MAX_THREADS 64
+
+static LONG band_threads = -1;
+
+struct band_work
+{
+    band_func    func;
+    void        *ctx;
+    int          rows;
+    int          count;  /* number of bands */
+    LONG         next;   /* next band to process */
+};
+
+/* the worker count is set by the DibThreads option, parallel execution is off by default */
+static int get_band_threads(void)
+{
+    static const WCHAR threadsW[] = {'D','i','b','T','h','r','e','a','d','s',0};
+    SYSTEM_INFO info;
+    DWORD value;
+
+    if (band_threads != -1) return band_threads;
+
+    value = get_dibdrv_option( threadsW, 1 );
+    if (value == ~0u)  /* use all the processors */
+    {
+        GetSystemInfo( &info );
+        value = info.dwNumberOfProcessors;
+    }
+    value = max( 1, min( value, MAX_THREADS ));
+    TRACE( "using %u threads\n", value );
+    InterlockedCompareExchange( &band_threads, value, -1 );
+    return band_threads;
+}
+
+static void process_bands( struct band_work *work )
+{
+    LONG band;
+
+    while ((band = InterlockedIncrement( &work->next ) - 1) < work->count)
+        work->func( work->ctx, (LONGLONG)band * work->rows / work->count,
+                    (LONGLONG)(band + 1) * work->rows / work->count );
+}
+
+static void CALLBACK band_callback( TP_CALLBACK_INSTANCE *instance, void *context, TP_WORK *tp_work )
+{
+    process_bands( context );
+}
+
+/***********************************************************************
+ *           run_bands
+ *
+ * Call func for consecutive row ranges covering [0, rows). The ranges can be
+ * processed concurrently, so they must not depend on each other's output.
+ */
+void run_bands( int rows, int row_pixels, band_func func, void *ctx )
+{
+    struct band_work work;
+    TP_WORK *tp_work;
+    int i, threads;
+
+    if (rows < 2 || row_pixels <= 0 || (LONGLONG)rows * row_pixels < MIN_PARALLEL_PIXELS ||
+        (threads = get_band_threads()) < 2 ||
+        !(tp_work = CreateThreadpoolWork( band_callback, &work, NULL )))
+    {
+        func( ctx, 0, rows );
+        return;
+    }
+
+    work.func  = func;
+    work.ctx   = ctx;
+    work.rows  = rows;
+    work.count = min( rows, threads * BANDS_PER_THREAD );
+    work.next  = 0;
+
+    for (i = 1; i < threads; i++) SubmitThreadpoolWork( tp_work );
+    process_bands( &work );
+    WaitForThreadpoolWorkCallbacks( tp_work, FALSE );
+    CloseThreadpoolWork( tp_work );
+}
+
+/***********************************************************************
+ *           dib_bits_overlap
+ */
+BOOL dib_bits_overlap( const dib_info *dib1, const dib_info *dib2 )
+{
+    const BYTE *start1 = dib1->bits.ptr, *end1, *start2 = dib2->bits.ptr, *end2;
+
+    if (dib1->stride > 0) end1 = start1 + dib1->stride * dib1->height;
+    else
+    {
+        end1 = start1 - dib1->stride;
+        start1 += dib1->stride * (dib1->height - 1);
+    }
+    if (dib2->stride > 0) end2 = start2 + dib2->stride * dib2->height;
+    else
+    {
+        end2 = start2 - dib2->stride;
+        start2 += dib2->stride * (dib2->height - 1);
+    }
+    return start1 < end2 && start2 < end1;
+}
+
+struct solid_rects_band
+{
+    const dib_info *dib;
+    const RECT     *rect;
+    DWORD           and;
+    DWORD           xor;
+};
+
+static void solid_rects_rows( void *arg, int start, int end )
+{
+    struct solid_rects_band *band = arg;
+    RECT rect = *band->rect;
+
+    rect.top = band->rect->top + start;
+    rect.bottom = band->rect->top + end;
+    band->dib->funcs->solid_rects( band->dib, 1, &rect, band->and, band->xor );
+}
+
+/***********************************************************************
+ *           solid_rects_bands
+ *
+ * Same as the solid_rects primitive, splitting large rectangles in bands.
+ */
+void solid_rects_bands( const dib_info *dib, int num, const RECT *rects, DWORD and, DWORD xor )
+{
+    struct solid_rects_band band;
+    int i, start;
+
+    band.dib = dib;
+    band.and = and;
+    band.xor = xor;
+    for (i = start = 0; i < num; i++)
+    {
+        if ((rects[i].bottom - rects[i].top) * (rects[i].right - rects[i].left) < MIN_PARALLEL_PIXELS)
+            continue;
+        if (i > start) dib->funcs->solid_rects( dib, i - start, rects + start, and, xor );
+        band.rect = &rects[i];
+        run_bands( rects[i].bottom - rects[i].top, rects[i].right - rects[i].left, solid_rects_rows, &band );
+        start = i + 1;
+    }
+    if (num > start) dib->funcs->solid_rects( dib, num - start, rects + start, and, xor );
+}
@@ -19,6 +19,9 @@
  */
 
 #include <assert.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #include "gdi_private.h"
 #include "dibdrv.h"
@@ -264,10 +267,26 @@ static inline void memset_16( WORD *start, WORD val, DWORD size )
 #endif
 }
 
+static inline void rop_row_32( DWORD *ptr, int len, DWORD and, DWORD xor )
+{
+    int x = 0;
+
+#ifdef __SSE2__
+    __m128i and_vec = _mm_set1_epi32( and ), xor_vec = _mm_set1_epi32( xor );
+
+    for ( ; x + 4 <= len; x += 4)
+    {
+        __m128i val = _mm_loadu_si128( (__m128i *)(ptr + x) );
+        _mm_storeu_si128( (__m128i *)(ptr + x), _mm_xor_si128( _mm_and_si128( val, and_vec ), xor_vec ));
+    }
+#endif
+    for ( ; x < len; x++) do_rop_32( ptr + x, and, xor );
+}
+
 static void solid_rects_32(const dib_info *dib, int num, const RECT *rc, DWORD and, DWORD xor)
 {
-    DWORD *ptr, *start;
-    int x, y, i;
+    DWORD *start;
+    int y, i;
 
     for(i = 0; i < num; i++, rc++)
     {
@@ -276,8 +295,7 @@ static void solid_rects_32(const dib_info *dib, int num, const RECT *rc, DWORD a
         start = get_pixel_ptr_32(dib, rc->left, rc->top);
         if (and)
             for(y = rc->top; y < rc->bottom; y++, start += dib->stride / 4)
-                for(x = rc->left, ptr = start; x < rc->right; x++)
-                    do_rop_32(ptr++, and, xor);
+                rop_row_32( start, rc->right - rc->left, and, xor );
         else
             for(y = rc->top; y < rc->bottom; y++, start += dib->stride / 4)
                 memset_32( start, xor, rc->right - rc->left );
@@ -4601,14 +4619,6 @@ static inline DWORD blend_argb_constant_alpha( DWORD dst, DWORD src, DWORD alpha
             blend_color( dst >> 24, src >> 24, alpha ) << 24);
 }
 
-static inline DWORD blend_argb_no_src_alpha( DWORD dst, DWORD src, DWORD alpha )
-{
-    return (blend_color( dst, src, alpha ) |
-            blend_color( dst >> 8, src >> 8, alpha ) << 8 |
-            blend_color( dst >> 16, src >> 16, alpha ) << 16 |
-            blend_color( dst >> 24, 255, alpha ) << 24);
-}
-
 static inline DWORD blend_argb( DWORD dst, DWORD src )
 {
     BYTE b = (BYTE)src;
@@ -4651,32 +4661,114 @@ static inline DWORD blend_rgb( BYTE dst_r, BYTE dst_g, BYTE dst_b, DWORD src, BL
             blend_color( dst_r, src >> 16, blend.SourceConstantAlpha ) << 16);
 }
 
+/* The vector paths are only built when the compiler targets SSE2, that is
+ * always on x86-64 and never in default 32-bit x86 builds, which keep the
+ * scalar code. There is no runtime CPU detection, and only the 32-bpp
+ * formats are vectorized; 24-bpp and 16-bpp destinations use the scalar
+ * per-pixel code. */
+#ifdef __SSE2__
+
+/* (x + 127) / 255 for 16-bit lanes, x being at most 255 * 255 */
+static inline __m128i div255_epu16( __m128i x )
+{
+    x = _mm_add_epi16( x, _mm_set1_epi16( 127 ));
+    return _mm_srli_epi16( _mm_add_epi16( _mm_add_epi16( x, _mm_set1_epi16( 1 )), _mm_srli_epi16( x, 8 )), 8 );
+}
+
+static inline __m128i broadcast_alpha_epu16( __m128i x )
+{
+    x = _mm_shufflelo_epi16( x, _MM_SHUFFLE( 3, 3, 3, 3 ));
+    return _mm_shufflehi_epi16( x, _MM_SHUFFLE( 3, 3, 3, 3 ));
+}
+
+/* dst * (255 - src alpha) + src for two premultiplied pixels in 16-bit lanes */
+static inline __m128i blend_argb_epu16( __m128i dst, __m128i src )
+{
+    __m128i inv = _mm_sub_epi16( _mm_set1_epi16( 255 ), broadcast_alpha_epu16( src ));
+    return _mm_add_epi16( src, div255_epu16( _mm_mullo_epi16( dst, inv )));
+}
+
+/* pack 9-bit channels the same way as blend_argb, a carry is or'ed into the next channel */
+static inline __m128i pack_argb_epu16( __m128i lo, __m128i hi )
+{
+    __m128i mask = _mm_set1_epi16( 0xff );
+    __m128i val = _mm_packus_epi16( _mm_and_si128( lo, mask ), _mm_and_si128( hi, mask ));
+    __m128i carry = _mm_packus_epi16( _mm_srli_epi16( lo, 8 ), _mm_srli_epi16( hi, 8 ));
+    return _mm_or_si128( val, _mm_slli_epi32( carry, 8 ));
+}
+
+#endif  /* __SSE2__ */
+
+static inline void blend_row_argb( DWORD *dst, const DWORD *src, int len, DWORD alpha )
+{
+    int x = 0;
+
+#ifdef __SSE2__
+    __m128i zero = _mm_setzero_si128(), alpha_vec = _mm_set1_epi16( alpha );
+
+    for ( ; x + 4 <= len; x += 4)
+    {
+        __m128i s = _mm_loadu_si128( (const __m128i *)(src + x) );
+        __m128i d = _mm_loadu_si128( (const __m128i *)(dst + x) );
+        __m128i s_lo = _mm_unpacklo_epi8( s, zero ), s_hi = _mm_unpackhi_epi8( s, zero );
+
+        if (alpha != 255)
+        {
+            s_lo = div255_epu16( _mm_mullo_epi16( s_lo, alpha_vec ));
+            s_hi = div255_epu16( _mm_mullo_epi16( s_hi, alpha_vec ));
+        }
+        s_lo = blend_argb_epu16( _mm_unpacklo_epi8( d, zero ), s_lo );
+        s_hi = blend_argb_epu16( _mm_unpackhi_epi8( d, zero ), s_hi );
+        _mm_storeu_si128( (__m128i *)(dst + x), pack_argb_epu16( s_lo, s_hi ));
+    }
+#endif
+    if (alpha == 255)
+        for ( ; x < len; x++) dst[x] = blend_argb( dst[x], src[x] );
+    else
+        for ( ; x < len; x++) dst[x] = blend_argb_alpha( dst[x], src[x], alpha );
+}
+
+/* src_alpha is or'ed to the source pixels, to replace the alpha channel */
+static inline void blend_row_constant_alpha( DWORD *dst, const DWORD *src, int len,
+                                             DWORD alpha, DWORD src_alpha )
+{
+    int x = 0;
+
+#ifdef __SSE2__
+    __m128i zero = _mm_setzero_si128(), or_vec = _mm_set1_epi32( src_alpha );
+    __m128i alpha_vec = _mm_set1_epi16( alpha ), inv_vec = _mm_set1_epi16( 255 - alpha );
+
+    for ( ; x + 4 <= len; x += 4)
+    {
+        __m128i s = _mm_or_si128( _mm_loadu_si128( (const __m128i *)(src + x) ), or_vec );
+        __m128i d = _mm_loadu_si128( (const __m128i *)(dst + x) );
+        __m128i lo = _mm_add_epi16( _mm_mullo_epi16( _mm_unpacklo_epi8( s, zero ), alpha_vec ),
+                                    _mm_mullo_epi16( _mm_unpacklo_epi8( d, zero ), inv_vec ));
+        __m128i hi = _mm_add_epi16( _mm_mullo_epi16( _mm_unpackhi_epi8( s, zero ), alpha_vec ),
+                                    _mm_mullo_epi16( _mm_unpackhi_epi8( d, zero ), inv_vec ));
+        _mm_storeu_si128( (__m128i *)(dst + x), _mm_packus_epi16( div255_epu16( lo ), div255_epu16( hi )));
+    }
+#endif
+    for ( ; x < len; x++) dst[x] = blend_argb_constant_alpha( dst[x], src[x] | src_alpha, alpha );
+}
+
 static void blend_rect_8888(const dib_info *dst, const RECT *rc,
                             const dib_info *src, const POINT *origin, BLENDFUNCTION blend)
 {
     DWORD *src_ptr = get_pixel_ptr_32( src, origin->x, origin->y );
     DWORD *dst_ptr = get_pixel_ptr_32( dst, rc->left, rc->top );
-    int x, y;
+    int y;
 
     if (blend.AlphaFormat & AC_SRC_ALPHA)
-    {
-	if (blend.SourceConstantAlpha == 255)
-	    for (y = rc->top; y < rc->bottom; y++, dst_ptr += dst->stride / 4, src_ptr += src->stride / 4)
-		for (x = 0; x < rc->right - rc->left; x++)
-		    dst_ptr[x] = blend_argb( dst_ptr[x], src_ptr[x] );
-        else
-	    for (y = rc->top; y < rc->bottom; y++, dst_ptr += dst->stride / 4, src_ptr += src->stride / 4)
-		for (x = 0; x < rc->right - rc->left; x++)
-		    dst_ptr[x] = blend_argb_alpha( dst_ptr[x], src_ptr[x], blend.SourceConstantAlpha );
-    }
+	for (y = rc->top; y < rc->bottom; y++, dst_ptr += dst->stride / 4, src_ptr += src->stride / 4)
+	    blend_row_argb( dst_ptr, src_ptr, rc->right - rc->left, blend.SourceConstantAlpha );
     else if (src->compression == BI_RGB)
 	for (y = rc->top; y < rc->bottom; y++, dst_ptr += dst->stride / 4, src_ptr += src->stride / 4)
-	    for (x = 0; x < rc->right - rc->left; x++)
-		dst_ptr[x] = blend_argb_constant_alpha( dst_ptr[x], src_ptr[x], blend.SourceConstantAlpha );
+	    blend_row_constant_alpha( dst_ptr, src_ptr, rc->right - rc->left, blend.SourceConstantAlpha, 0 );
     else
 	for (y = rc->top; y < rc->bottom; y++, dst_ptr += dst->stride / 4, src_ptr += src->stride / 4)
-	    for (x = 0; x < rc->right - rc->left; x++)
-		dst_ptr[x] = blend_argb_no_src_alpha( dst_ptr[x], src_ptr[x], blend.SourceConstantAlpha );
+	    blend_row_constant_alpha( dst_ptr, src_ptr, rc->right - rc->left,
+                                      blend.SourceConstantAlpha, 0xff000000 );
 }
 
 static void blend_rect_32(const dib_info *dst, const RECT *rc,
@@ -6071,12 +6163,30 @@ static void draw_glyph_8888( const dib_info *dib, const RECT *rect, const dib_in
 {
     DWORD *dst_ptr = get_pixel_ptr_32( dib, rect->left, rect->top );
     const BYTE *glyph_ptr = get_pixel_ptr_8( glyph, origin->x, origin->y );
-    int x, y;
+    int x, y, width = rect->right - rect->left;
+    DWORD val;
 
     for (y = rect->top; y < rect->bottom; y++)
     {
-        for (x = 0; x < rect->right - rect->left; x++)
+        for (x = 0; x < width; x++)
         {
+            /* glyph values are between 0 and 16, so check four of them at once for the
+             * transparent and opaque runs that make up most of a glyph */
+            if (x + 4 <= width)
+            {
+                memcpy( &val, glyph_ptr + x, sizeof(val) );
+                if (!(val & 0xfefefefe))
+                {
+                    x += 3;
+                    continue;
+                }
+                if (val == 0x10101010)
+                {
+                    dst_ptr[x] = dst_ptr[x + 1] = dst_ptr[x + 2] = dst_ptr[x + 3] = text_pixel;
+                    x += 3;
+                    continue;
+                }
+            }
             if (glyph_ptr[x] <= 1) continue;
             if (glyph_ptr[x] >= 16) { dst_ptr[x] = text_pixel; continue; }
             dst_ptr[x] = aa_rgb( dst_ptr[x] >> 16, dst_ptr[x] >> 8, dst_ptr[x], text_pixel, ranges + glyph_ptr[x] );
@@ -269,6 +269,7 @@ struct enum_data
 typedef struct tagFace {
     struct list entry;
     unsigned int refcount;
+    DWORD id;             /* unique id, used as key in the glyph cache */
     WCHAR *style_name;
     WCHAR *full_name;
     WCHAR *file;
@@ -302,6 +303,8 @@ typedef struct tagFamily {
     WCHAR second_name[LF_FACESIZE];
     struct list faces;
     struct list *replacement;
+    struct tagFamily *name_next;   /* next family in the same family_name_hash bucket */
+    struct tagFamily *second_next; /* next family in the same second_name_hash bucket */
 } Family;
 
 typedef struct {
@@ -435,6 +438,7 @@ struct tagGdiFont {
     ULONG ttc_item_offset; /* 0 if font is not a part of TrueType collection */
     DWORD cache_num;
     DWORD instance_id;
+    DWORD face_id;
     struct font_fileinfo *fileinfo;
 };
 
@@ -468,6 +472,11 @@ static struct list system_links = LIST_INIT(system_links);
 static struct list font_subst_list = LIST_INIT(font_subst_list);
 
 static struct list font_list = LIST_INIT(font_list);
+static DWORD next_face_id = 1;
+
+#define FAMILY_HASH_SIZE 512
+static Family *family_name_hash[FAMILY_HASH_SIZE];
+static Family *second_name_hash[FAMILY_HASH_SIZE];
 
 struct freetype_physdev
 {
@@ -1042,10 +1051,61 @@ static Face *find_face_from_filename(const WCHAR *file_name, const WCHAR *face_n
     return NULL;
 }
 
+/* family names are compared on their first LF_FACESIZE - 1 characters, ignoring case */
+static unsigned int hash_family_name( const WCHAR *name )
+{
+    unsigned int i, hash = 0;
+
+    for (i = 0; i < LF_FACESIZE - 1 && name[i]; i++) hash = hash * 31 + tolowerW( name[i] );
+    return hash % FAMILY_HASH_SIZE;
+}
+
+static void add_family_to_hash( Family *family )
+{
+    unsigned int hash = hash_family_name( family->family_name );
+
+    family->name_next = family_name_hash[hash];
+    family_name_hash[hash] = family;
+    if (!family->second_name[0]) return;
+    hash = hash_family_name( family->second_name );
+    family->second_next = second_name_hash[hash];
+    second_name_hash[hash] = family;
+}
+
+static void remove_family_from_hash( Family *family )
+{
+    Family **ptr;
+
+    for (ptr = &family_name_hash[hash_family_name( family->family_name )]; *ptr; ptr = &(*ptr)->name_next)
+    {
+        if (*ptr != family) continue;
+        *ptr = family->name_next;
+        break;
+    }
+    if (!family->second_name[0]) return;
+    for (ptr = &second_name_hash[hash_family_name( family->second_name )]; *ptr; ptr = &(*ptr)->second_next)
+    {
+        if (*ptr != family) continue;
+        *ptr = family->second_next;
+        break;
+    }
+}
+
+/* The hash tables only tell which families match. When several of them do, the
+ * first one in font_list order is returned, as with a walk of the whole list. */
 static Family *find_family_from_name(const WCHAR *name)
 {
-    Family *family;
+    Family *family, *found = NULL;
 
+    for (family = family_name_hash[hash_family_name( name )]; family; family = family->name_next)
+    {
+        if (strncmpiW( family->family_name, name, LF_FACESIZE - 1 )) continue;
+        if (found) goto walk_list;
+        found = family;
+    }
+    return found;
+
+walk_list:
     LIST_FOR_EACH_ENTRY(family, &font_list, Family, entry)
         if (!strncmpiW( family->family_name, name, LF_FACESIZE - 1 )) return family;
 
@@ -1054,8 +1114,24 @@ static Family *find_family_from_name(const WCHAR *name)
 
 static Family *find_family_from_any_name(const WCHAR *name)
 {
-    Family *family;
+    unsigned int hash = hash_family_name( name );
+    Family *family, *found = NULL;
 
+    for (family = family_name_hash[hash]; family; family = family->name_next)
+    {
+        if (strncmpiW( family->family_name, name, LF_FACESIZE - 1 )) continue;
+        if (found) goto walk_list;
+        found = family;
+    }
+    for (family = second_name_hash[hash]; family; family = family->second_next)
+    {
+        if (strncmpiW( family->second_name, name, LF_FACESIZE - 1 )) continue;
+        if (found && found != family) goto walk_list;
+        found = family;
+    }
+    return found;
+
+walk_list:
     LIST_FOR_EACH_ENTRY(family, &font_list, Family, entry)
     {
         if (!strncmpiW( family->family_name, name, LF_FACESIZE - 1 )) return family;
@@ -1508,6 +1584,7 @@ static void release_family( Family *family )
     if (--family->refcount) return;
     assert( list_empty( &family->faces ));
     list_remove( &family->entry );
+    remove_family_from_hash( family );
     HeapFree( GetProcessHeap(), 0, family );
 }
 
@@ -1599,7 +1676,7 @@ static BOOL insert_face_in_family_list( Face *face, Family *family )
  * NB This function stores the ptrs to the strings to save copying.
  * Don't free them after calling.
  */
-static Family *create_family( WCHAR *family_name, WCHAR *second_name )
+static Family *create_family( const WCHAR *family_name, const WCHAR *second_name )
 {
     Family * const family = HeapAlloc( GetProcessHeap(), 0, sizeof(*family) );
     family->refcount = 1;
@@ -1609,6 +1686,7 @@ static Family *create_family( WCHAR *family_name, WCHAR *second_name )
     list_init( &family->faces );
     family->replacement = &family->faces;
     list_add_tail( &font_list, &family->entry );
+    add_family_to_hash( family );
 
     return family;
 }
@@ -1650,6 +1728,7 @@ static void load_face(HKEY hkey_family, Family *family, void *buffer, DWORD buff
             face->cached_enum_data = NULL;
             face->family = NULL;
             face->refcount = 1;
+            face->id = next_face_id++;
             face->style_name = strdupW( name );
             face->face_index = cached->index;
             face->flags = cached->flags;
@@ -1878,6 +1957,23 @@ static WCHAR *get_vertical_name( WCHAR *name )
     return name;
 }
 
+static Family *get_family_by_name( const WCHAR *family_name, const WCHAR *second_name )
+{
+    Family *family;
+
+    if ((family = find_family_from_name( family_name ))) family->refcount++;
+    else if ((family = create_family( family_name, second_name )) && second_name)
+    {
+        FontSubst *subst = HeapAlloc( GetProcessHeap(), 0, sizeof(*subst) );
+        subst->from.name = strdupW( second_name );
+        subst->from.charset = -1;
+        subst->to.name = strdupW( family_name );
+        subst->to.charset = -1;
+        add_font_subst( &font_subst_list, subst, 0 );
+    }
+    return family;
+}
+
 static Family *get_family( FT_Face ft_face, BOOL vertical )
 {
     Family *family;
@@ -1905,16 +2001,7 @@ static Family *get_family( FT_Face ft_face, BOOL vertical )
         second_name = get_vertical_name( second_name );
     }
 
-    if ((family = find_family_from_name( family_name ))) family->refcount++;
-    else if ((family = create_family( family_name, second_name )) && second_name)
-    {
-        FontSubst *subst = HeapAlloc( GetProcessHeap(), 0, sizeof(*subst) );
-        subst->from.name = strdupW( second_name );
-        subst->from.charset = -1;
-        subst->to.name = strdupW( family_name );
-        subst->to.charset = -1;
-        add_font_subst( &font_subst_list, subst, 0 );
-    }
+    family = get_family_by_name( family_name, second_name );
 
     HeapFree( GetProcessHeap(), 0, family_name );
     HeapFree( GetProcessHeap(), 0, second_name );
@@ -2048,6 +2135,7 @@ static Face *create_face( FT_Face ft_face, FT_Long face_index, const WCHAR *file
     Face *face = HeapAlloc( GetProcessHeap(), 0, sizeof(*face) );
 
     face->refcount = 1;
+    face->id = next_face_id++;
     face->style_name = ft_face_get_style_name( ft_face, GetSystemDefaultLangID() );
     face->full_name = ft_face_get_full_name( ft_face, GetSystemDefaultLangID() );
     if (flags & ADDFONT_VERTICAL_FONT) face->full_name = get_vertical_name( face->full_name );
@@ -2094,18 +2182,11 @@ static Face *create_face( FT_Face ft_face, FT_Long face_index, const WCHAR *file
     return face;
 }
 
-static void AddFaceToList(FT_Face ft_face, const WCHAR *file, void *font_data_ptr, DWORD font_data_size,
-                          FT_Long face_index, DWORD flags )
+static void add_face_to_family( Face *face, Family *family )
 {
-    Face *face;
-    Family *family;
-
-    face = create_face( ft_face, face_index, file, font_data_ptr, font_data_size, flags );
-    family = get_family( ft_face, flags & ADDFONT_VERTICAL_FONT );
-
     if (insert_face_in_family_list( face, family ))
     {
-        if (flags & ADDFONT_ADD_TO_CACHE)
+        if (face->flags & ADDFONT_ADD_TO_CACHE)
             add_face_to_cache( face );
         TRACE( "Added face %s to family %s\n", debugstr_w(face->full_name), debugstr_w(family->family_name) );
     }
@@ -2113,6 +2194,427 @@ static void AddFaceToList(FT_Face ft_face, const WCHAR *file, void *font_data_pt
     release_family( family );
 }
 
+/* On-disk index of the faces found in each font file, so that the font files don't
+ * need to be opened again to build the font list. The index is mapped read-only and
+ * looked up in place; entries are revalidated against the file modification time and size. */
+
+#define FONT_INDEX_MAGIC     0x78646e69  /* "indx" */
+#define FONT_INDEX_VERSION   2
+#define FONT_INDEX_HASH_SIZE 1024
+
+struct font_index_header
+{
+    DWORD magic;
+    DWORD version;
+    DWORD lcid;        /* the names depend on the system locale */
+    DWORD ft_version;
+    DWORD size;        /* total size of the index */
+    DWORD count;       /* number of files */
+    DWORD hash[FONT_INDEX_HASH_SIZE];  /* offset of the first file in each bucket */
+};
+
+struct font_index_file
+{
+    DWORD     next;          /* offset of the next file in the same bucket, always larger */
+    DWORD     size;          /* size of the entry, including the faces */
+    DWORD     faces;         /* number of faces */
+    DWORD     allow_bitmap;
+    ULONGLONG mtime;
+    ULONGLONG file_size;
+    char      name[1];       /* followed by the faces, DWORD aligned */
+};
+
+struct font_index_face
+{
+    DWORD         size;
+    DWORD         index;
+    DWORD         flags;     /* ADDFONT_VERTICAL_FONT */
+    DWORD         ntmflags;
+    DWORD         version;
+    DWORD         scalable;
+    DWORD         width;
+    DWORD         height;
+    DWORD         bitmap_size;
+    DWORD         x_ppem;
+    DWORD         y_ppem;
+    DWORD         internal_leading;
+    FONTSIGNATURE fs;
+    WCHAR         names[1];  /* family, second, style and full names */
+};
+
+static const struct font_index_header *font_index;
+
+/* the index being built while loading the font list */
+static struct
+{
+    BYTE *data;
+    DWORD size;
+    DWORD alloc;
+    DWORD count;
+    DWORD current;  /* offset of the file being recorded */
+    BOOL  changed;
+} index_builder;
+
+static inline const struct font_index_face *get_index_faces( const struct font_index_file *file )
+{
+    return (const struct font_index_face *)((const BYTE *)file +
+            ((offsetof( struct font_index_file, name[strlen( file->name ) + 1] ) + 7) & ~7));
+}
+
+static inline const struct font_index_face *next_index_face( const struct font_index_face *face )
+{
+    return (const struct font_index_face *)((const BYTE *)face + face->size);
+}
+
+static DWORD hash_index_name( const char *name )
+{
+    DWORD hash = 0;
+
+    while (*name) hash = hash * 31 + (unsigned char)*name++;
+    return hash % FONT_INDEX_HASH_SIZE;
+}
+
+static char *get_font_index_name(void)
+{
+    static const WCHAR configdirW[] = {'W','I','N','E','C','O','N','F','I','G','D','I','R',0};
+    static const WCHAR fontindexW[] = {'\\','f','o','n','t','i','n','d','e','x',0};
+    WCHAR path[MAX_PATH];
+    DWORD len = GetEnvironmentVariableW( configdirW, path, MAX_PATH );
+
+    if (!len || len + ARRAY_SIZE(fontindexW) > MAX_PATH) return NULL;
+    strcatW( path, fontindexW );
+    if (path[5] == ':') memmove( path, path + 4, (strlenW(path) - 3) * sizeof(WCHAR) );
+    else path[1] = '\\';  /* change \??\ to \\?\ */
+    return wine_get_unix_file_name( path );
+}
+
+/* Check the whole index before using it. The bucket chains must link the files
+ * of each bucket in the order they are stored, so that lookups only ever reach
+ * validated entries and can't loop. */
+static BOOL check_font_index( const struct font_index_header *header, SIZE_T size )
+{
+    const struct font_index_file *file;
+    const struct font_index_face *face;
+    const BYTE *end;
+    DWORD tail[FONT_INDEX_HASH_SIZE];
+    DWORD i, j, k, pos, nulls, hash;
+
+    if (size < sizeof(*header) || header->magic != FONT_INDEX_MAGIC ||
+        header->version != FONT_INDEX_VERSION || header->size != size ||
+        header->lcid != GetSystemDefaultLCID() || header->ft_version != FT_SimpleVersion)
+        return FALSE;
+
+    memset( tail, 0, sizeof(tail) );
+    for (pos = sizeof(*header), i = 0; i < header->count; i++, pos += file->size)
+    {
+        if (size - pos < offsetof( struct font_index_file, name[1] )) return FALSE;
+        file = (const struct font_index_file *)((const BYTE *)header + pos);
+        if (file->size > size - pos || file->size <= offsetof( struct font_index_file, name[1] ) ||
+            file->size % 8) return FALSE;
+        if (!memchr( file->name, 0, file->size - offsetof( struct font_index_file, name ))) return FALSE;
+
+        hash = hash_index_name( file->name );
+        if (tail[hash])
+        {
+            if (((const struct font_index_file *)((const BYTE *)header + tail[hash]))->next != pos)
+                return FALSE;
+        }
+        else if (header->hash[hash] != pos) return FALSE;
+
+        end = (const BYTE *)file + file->size;
+        for (j = 0, face = get_index_faces( file ); j < file->faces; j++, face = next_index_face( face ))
+        {
+            if ((const BYTE *)face > end - offsetof( struct font_index_face, names[4] ) ||
+                face->size > end - (const BYTE *)face || face->size < offsetof( struct font_index_face, names[4] ) ||
+                face->size % sizeof(DWORD))
+                return FALSE;
+            /* there must be a terminator for each of the names */
+            for (k = nulls = 0; k < (face->size - offsetof( struct font_index_face, names )) / sizeof(WCHAR); k++)
+                if (!face->names[k]) nulls++;
+            if (nulls < 4) return FALSE;
+        }
+        tail[hash] = pos;
+    }
+    if (pos != size) return FALSE;
+    /* the last file of each bucket ends the chain, empty buckets have none */
+    for (i = 0; i < FONT_INDEX_HASH_SIZE; i++)
+    {
+        if (tail[i])
+        {
+            if (((const struct font_index_file *)((const BYTE *)header + tail[i]))->next) return FALSE;
+        }
+        else if (header->hash[i]) return FALSE;
+    }
+    return TRUE;
+}
+
+static void open_font_index(void)
+{
+    char *name = get_font_index_name();
+    struct stat st;
+    void *data;
+    int fd;
+
+    index_builder.alloc = 65536;
+    index_builder.size = sizeof(struct font_index_header);
+    index_builder.count = 0;
+    index_builder.current = 0;
+    index_builder.changed = FALSE;
+    if (!(index_builder.data = HeapAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, index_builder.alloc ))) return;
+
+    if (!name) return;
+    fd = open( name, O_RDONLY );
+    HeapFree( GetProcessHeap(), 0, name );
+    if (fd == -1) return;
+    if (!fstat( fd, &st ) && st.st_size >= sizeof(*font_index) && st.st_size < 0x7fffffff)
+    {
+        data = mmap( NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+        if (data != MAP_FAILED)
+        {
+            if (check_font_index( data, st.st_size )) font_index = data;
+            else
+            {
+                WARN( "ignoring invalid or outdated font index\n" );
+                munmap( data, st.st_size );
+            }
+        }
+    }
+    close( fd );
+}
+
+static const struct font_index_file *find_index_file( const char *unix_name, const struct stat *st,
+                                                      DWORD allow_bitmap )
+{
+    const struct font_index_file *file;
+    DWORD pos;
+
+    if (!font_index) return NULL;
+
+    /* check_font_index made sure that the chain only goes forward through valid entries */
+    for (pos = font_index->hash[hash_index_name( unix_name )]; pos; pos = file->next)
+    {
+        file = (const struct font_index_file *)((const BYTE *)font_index + pos);
+        if (strcmp( file->name, unix_name )) continue;
+        if (file->mtime != st->st_mtime || file->file_size != st->st_size ||
+            file->allow_bitmap != !!allow_bitmap)
+            return NULL;
+        return file;
+    }
+    return NULL;
+}
+
+static void *grow_index( DWORD size )
+{
+    BYTE *data;
+    DWORD alloc;
+
+    if (!index_builder.data) return NULL;
+    if (index_builder.size + size > index_builder.alloc)
+    {
+        alloc = max( index_builder.alloc * 2, index_builder.size + size );
+        if (!(data = HeapReAlloc( GetProcessHeap(), HEAP_ZERO_MEMORY, index_builder.data, alloc )))
+        {
+            HeapFree( GetProcessHeap(), 0, index_builder.data );
+            index_builder.data = NULL;
+            return NULL;
+        }
+        index_builder.data = data;
+        index_builder.alloc = alloc;
+    }
+    data = index_builder.data + index_builder.size;
+    index_builder.size += size;
+    return data;
+}
+
+static void index_begin_file( const char *unix_name, const struct stat *st, DWORD allow_bitmap )
+{
+    DWORD size = (offsetof( struct font_index_file, name[strlen( unix_name ) + 1] ) + 7) & ~7;
+    struct font_index_file *file;
+
+    index_builder.changed = TRUE;
+    if (!(file = grow_index( size ))) return;
+    file->size = size;
+    file->faces = 0;
+    file->allow_bitmap = !!allow_bitmap;
+    file->mtime = st->st_mtime;
+    file->file_size = st->st_size;
+    strcpy( file->name, unix_name );
+    index_builder.current = (BYTE *)file - index_builder.data;
+}
+
+static void index_end_file(void)
+{
+    struct font_index_file *file;
+    DWORD pad;
+
+    if (!index_builder.current || !index_builder.data) return;
+    /* keep the entries 8-byte aligned */
+    pad = (8 - index_builder.size % 8) % 8;
+    if (pad && !grow_index( pad )) return;
+    file = (struct font_index_file *)(index_builder.data + index_builder.current);
+    file->size = index_builder.size - index_builder.current;
+    index_builder.count++;
+    index_builder.current = 0;
+}
+
+static void index_add_face( const Face *face, const Family *family )
+{
+    const WCHAR *names[4] = { family->family_name, family->second_name, face->style_name, face->full_name };
+    struct font_index_face *entry;
+    DWORD i, size, len[4];
+    WCHAR *ptr;
+
+    if (!index_builder.current) return;
+
+    size = offsetof( struct font_index_face, names );
+    for (i = 0; i < ARRAY_SIZE(names); i++) size += (len[i] = strlenW( names[i] ) + 1) * sizeof(WCHAR);
+    size = (size + 3) & ~3;
+
+    if (!(entry = grow_index( size ))) return;
+    entry->size = size;
+    entry->index = face->face_index;
+    entry->flags = face->flags & ADDFONT_VERTICAL_FONT;
+    entry->ntmflags = face->ntmFlags;
+    entry->version = face->font_version;
+    entry->scalable = face->scalable;
+    entry->width = face->size.width;
+    entry->height = face->size.height;
+    entry->bitmap_size = face->size.size;
+    entry->x_ppem = face->size.x_ppem;
+    entry->y_ppem = face->size.y_ppem;
+    entry->internal_leading = face->size.internal_leading;
+    entry->fs = face->fs;
+    for (i = 0, ptr = entry->names; i < ARRAY_SIZE(names); ptr += len[i++])
+        memcpy( ptr, names[i], len[i] * sizeof(WCHAR) );
+
+    ((struct font_index_file *)(index_builder.data + index_builder.current))->faces++;
+}
+
+static void write_font_index(void)
+{
+    struct font_index_header *header = (struct font_index_header *)index_builder.data;
+    struct font_index_file *file;
+    char *name, *tmp_name = NULL;
+    DWORD tail[FONT_INDEX_HASH_SIZE];
+    DWORD i, pos, hash;
+    int fd = -1;
+
+    if (!header) goto done;
+    if (!index_builder.changed && font_index && font_index->count == index_builder.count) goto done;
+
+    header->magic = FONT_INDEX_MAGIC;
+    header->version = FONT_INDEX_VERSION;
+    header->lcid = GetSystemDefaultLCID();
+    header->ft_version = FT_SimpleVersion;
+    header->size = index_builder.size;
+    header->count = index_builder.count;
+    memset( header->hash, 0, sizeof(header->hash) );
+    memset( tail, 0, sizeof(tail) );
+    for (pos = sizeof(*header), i = 0; i < index_builder.count; i++, pos += file->size)
+    {
+        file = (struct font_index_file *)(index_builder.data + pos);
+        hash = hash_index_name( file->name );
+        file->next = 0;
+        if (tail[hash]) ((struct font_index_file *)(index_builder.data + tail[hash]))->next = pos;
+        else header->hash[hash] = pos;
+        tail[hash] = pos;
+    }
+
+    if (!(name = get_font_index_name())) goto done;
+    if ((tmp_name = HeapAlloc( GetProcessHeap(), 0, strlen( name ) + sizeof(".tmp") )))
+    {
+        strcpy( tmp_name, name );
+        strcat( tmp_name, ".tmp" );
+        fd = open( tmp_name, O_WRONLY | O_CREAT | O_TRUNC, 0666 );
+    }
+    if (fd != -1)
+    {
+        BOOL ret = write( fd, header, header->size ) == header->size;
+        if (close( fd ) || !ret || rename( tmp_name, name ))
+        {
+            WARN( "failed to write the font index %s\n", debugstr_a(name) );
+            unlink( tmp_name );
+        }
+        else TRACE( "wrote %u files to %s\n", header->count, debugstr_a(name) );
+    }
+    HeapFree( GetProcessHeap(), 0, tmp_name );
+    HeapFree( GetProcessHeap(), 0, name );
+
+done:
+    if (font_index) munmap( (void *)font_index, font_index->size );
+    font_index = NULL;
+    HeapFree( GetProcessHeap(), 0, index_builder.data );
+    index_builder.data = NULL;
+}
+
+static int add_faces_from_index( const struct font_index_file *file, const WCHAR *dos_name, DWORD flags )
+{
+    const struct font_index_face *entry;
+    const WCHAR *family_name, *second_name, *style_name, *full_name;
+    Family *family;
+    Face *face;
+    DWORD i;
+    int ret = 0;
+    void *copy;
+
+    TRACE( "using the index for %s\n", debugstr_a(file->name) );
+
+    if ((copy = grow_index( file->size )))
+    {
+        memcpy( copy, file, file->size );
+        index_builder.count++;
+    }
+
+    for (i = 0, entry = get_index_faces( file ); i < file->faces; i++, entry = next_index_face( entry ))
+    {
+        family_name = entry->names;
+        second_name = family_name + strlenW( family_name ) + 1;
+        style_name = second_name + strlenW( second_name ) + 1;
+        full_name = style_name + strlenW( style_name ) + 1;
+
+        if (!(face = HeapAlloc( GetProcessHeap(), 0, sizeof(*face) ))) break;
+        face->refcount = 1;
+        face->id = next_face_id++;
+        face->style_name = strdupW( style_name );
+        face->full_name = strdupW( full_name );
+        face->file = strdupW( dos_name );
+        face->font_data_ptr = NULL;
+        face->font_data_size = 0;
+        face->face_index = entry->index;
+        face->fs = entry->fs;
+        face->ntmFlags = entry->ntmflags;
+        face->font_version = entry->version;
+        face->scalable = entry->scalable;
+        face->size.width = entry->width;
+        face->size.height = entry->height;
+        face->size.size = entry->bitmap_size;
+        face->size.x_ppem = entry->x_ppem;
+        face->size.y_ppem = entry->y_ppem;
+        face->size.internal_leading = entry->internal_leading;
+        face->flags = flags | (entry->flags & ADDFONT_VERTICAL_FONT);
+        if (!HIWORD( face->flags )) face->flags |= ADDFONT_AA_FLAGS( default_aa_flags );
+        face->family = NULL;
+        face->cached_enum_data = NULL;
+
+        family = get_family_by_name( family_name, second_name[0] ? second_name : NULL );
+        add_face_to_family( face, family );
+        ret++;
+    }
+    return ret;
+}
+
+static void AddFaceToList(FT_Face ft_face, const WCHAR *file, void *font_data_ptr, DWORD font_data_size,
+                          FT_Long face_index, DWORD flags )
+{
+    Face *face;
+    Family *family;
+
+    face = create_face( ft_face, face_index, file, font_data_ptr, font_data_size, flags );
+    family = get_family( ft_face, flags & ADDFONT_VERTICAL_FONT );
+    index_add_face( face, family );
+    add_face_to_family( face, family );
+}
+
 static FT_Face new_ft_face( const char *file, void *font_data_ptr, DWORD font_data_size,
                             FT_Long face_index, BOOL allow_bitmap )
 {
@@ -2196,6 +2698,7 @@ static INT AddFontToList(const WCHAR *dos_name, const char *unix_name, void *fon
     FT_Long face_index = 0, num_faces;
     INT ret = 0;
     WCHAR *filename = NULL;
+    struct stat st;
 
     /* we always load external fonts from files - otherwise we would get a crash in update_reg_entries */
     assert(unix_name || !(flags & ADDFONT_EXTERNAL_FONT));
@@ -2223,6 +2726,20 @@ static INT AddFontToList(const WCHAR *dos_name, const char *unix_name, void *fon
 
     if (!dos_name && unix_name) dos_name = filename = wine_get_dos_file_name( unix_name );
 
+    /* only the fonts loaded while building the font list are indexed */
+    if (index_builder.data && unix_name && (flags & ADDFONT_ADD_TO_CACHE) && !stat( unix_name, &st ))
+    {
+        const struct font_index_file *file = find_index_file( unix_name, &st, flags & ADDFONT_ALLOW_BITMAP );
+
+        if (file)
+        {
+            ret = add_faces_from_index( file, dos_name, flags );
+            HeapFree( GetProcessHeap(), 0, filename );
+            return ret;
+        }
+        index_begin_file( unix_name, &st, flags & ADDFONT_ALLOW_BITMAP );
+    }
+
     do {
         FONTSIGNATURE fs;
 
@@ -2250,6 +2767,7 @@ static INT AddFontToList(const WCHAR *dos_name, const char *unix_name, void *fon
 	num_faces = ft_face->num_faces;
 	pFT_Done_Face(ft_face);
     } while(num_faces > ++face_index);
+    index_end_file();
     HeapFree( GetProcessHeap(), 0, filename );
     return ret;
 }
@@ -2347,6 +2865,7 @@ static BOOL map_font_family(const WCHAR *orig, const WCHAR *repl)
             list_init(&new_family->faces);
             new_family->replacement = &family->faces;
             list_add_tail(&font_list, &new_family->entry);
+            add_family_to_hash( new_family );
 
             if (repl[0] != '@')
                 map_vertical_font_family(orig, repl, family);
@@ -3757,6 +4276,7 @@ static void init_font_list(void)
     char *unixname;
 
     delete_external_font_keys();
+    open_font_index();
 
     /* load the system bitmap fonts */
     load_system_fonts();
@@ -3867,6 +4387,8 @@ static void init_font_list(void)
         }
         RegCloseKey(hkey);
     }
+
+    write_font_index();
 }
 
 static BOOL move_to_front(const WCHAR *name)
@@ -4115,6 +4637,7 @@ static FT_Face OpenFontFace(GdiFont *font, Face *face, LONG width, LONG height)
 
     /* set it here, as load_VDMX needs it */
     font->ft_face = ft_face;
+    font->face_id = face->id;
 
     if(FT_IS_SCALABLE(ft_face)) {
         FT_ULong len;
@@ -7054,6 +7577,161 @@ static FT_Int get_load_flags( UINT format )
     return load_flags;
 }
 
+/* Process-wide cache of the glyph metrics, bitmaps and outlines. Font instances are
+ * frequently destroyed and created again by applications, so the cache is keyed by the
+ * face and the parameters that determine the glyph size and transform instead of by
+ * font instance. */
+
+#define GLYPH_CACHE_HASH_SIZE 4096
+#define GLYPH_CACHE_MAX_SIZE  (4 * 1024 * 1024)
+
+struct glyph_cache_key
+{
+    DWORD face_id;         /* face of the selected font */
+    DWORD linked_face_id;  /* face the glyph is loaded from, for linked fonts */
+    LONG  height;
+    LONG  width;
+    LONG  escapement;
+    LONG  orientation;
+    LONG  weight;
+    BYTE  italic;
+    BYTE  tategaki;
+    FMAT2 matrix;
+    UINT  glyph_index;
+    UINT  format;          /* including GGO_UNHINTED */
+};
+
+struct glyph_cache_entry
+{
+    struct list               entry;  /* entry in the LRU list */
+    struct glyph_cache_entry *next;   /* next entry in the same hash bucket */
+    struct glyph_cache_key    key;
+    GLYPHMETRICS              gm;
+    ABC                       abc;
+    DWORD                     needed;
+    DWORD                     size;
+    BOOL                      has_data;
+    BYTE                      data[1];
+};
+
+static struct glyph_cache_entry *glyph_cache_hash[GLYPH_CACHE_HASH_SIZE];
+static struct list glyph_cache_lru = LIST_INIT(glyph_cache_lru);
+static DWORD glyph_cache_size;
+static ULONG glyph_cache_hits, glyph_cache_misses;
+
+static void init_glyph_cache_key( struct glyph_cache_key *key, const GdiFont *incoming_font,
+                                  const GdiFont *font, UINT glyph_index, UINT format, BOOL tategaki )
+{
+    const LOGFONTW *lf = &incoming_font->font_desc.lf;
+
+    memset( key, 0, sizeof(*key) );
+    key->face_id = incoming_font->face_id;
+    key->linked_face_id = font->face_id;
+    key->height = lf->lfHeight;
+    key->width = lf->lfWidth;
+    key->escapement = lf->lfEscapement;
+    key->orientation = lf->lfOrientation;
+    key->weight = lf->lfWeight;
+    key->italic = lf->lfItalic;
+    key->tategaki = tategaki;
+    key->matrix = incoming_font->font_desc.matrix;
+    key->glyph_index = glyph_index;
+    key->format = format;
+}
+
+static unsigned int hash_glyph_key( const struct glyph_cache_key *key )
+{
+    const DWORD *ptr = (const DWORD *)key;
+    unsigned int i, hash = 0;
+
+    for (i = 0; i < sizeof(*key) / sizeof(DWORD); i++) hash = hash * 31 + ptr[i];
+    return hash % GLYPH_CACHE_HASH_SIZE;
+}
+
+static struct glyph_cache_entry *find_cached_glyph( const struct glyph_cache_key *key )
+{
+    struct glyph_cache_entry *entry;
+
+    for (entry = glyph_cache_hash[hash_glyph_key( key )]; entry; entry = entry->next)
+    {
+        if (memcmp( &entry->key, key, sizeof(*key) )) continue;
+        list_remove( &entry->entry );
+        list_add_head( &glyph_cache_lru, &entry->entry );
+        return entry;
+    }
+    return NULL;
+}
+
+static void remove_cached_glyph( struct glyph_cache_entry *entry )
+{
+    struct glyph_cache_entry **ptr = &glyph_cache_hash[hash_glyph_key( &entry->key )];
+
+    while (*ptr != entry) ptr = &(*ptr)->next;
+    *ptr = entry->next;
+    list_remove( &entry->entry );
+    glyph_cache_size -= entry->size;
+    HeapFree( GetProcessHeap(), 0, entry );
+}
+
+/* returns FALSE if the entry doesn't contain the requested data */
+static BOOL get_cached_glyph( const struct glyph_cache_entry *entry, UINT format, GLYPHMETRICS *gm,
+                              ABC *abc, DWORD buflen, void *buf, DWORD *needed )
+{
+    if (format != GGO_METRICS && buf && buflen)
+    {
+        if (!entry->has_data) return FALSE;
+        if (entry->needed > buflen)
+        {
+            *needed = GDI_ERROR;
+            return TRUE;
+        }
+        memcpy( buf, entry->data, entry->needed );
+        /* the bitmap functions clear the whole buffer */
+        if (format != GGO_NATIVE && format != GGO_BEZIER)
+            memset( (BYTE *)buf + entry->needed, 0, buflen - entry->needed );
+    }
+    *gm = entry->gm;
+    *abc = entry->abc;
+    *needed = entry->needed;
+    return TRUE;
+}
+
+static void add_cached_glyph( const struct glyph_cache_key *key, const GLYPHMETRICS *gm, const ABC *abc,
+                              DWORD needed, const void *data )
+{
+    struct glyph_cache_entry *entry;
+    DWORD size = offsetof( struct glyph_cache_entry, data[data ? needed : 0] );
+
+    if (size > GLYPH_CACHE_MAX_SIZE / 16) return;
+
+    if ((entry = find_cached_glyph( key ))) remove_cached_glyph( entry );
+    while (glyph_cache_size + size > GLYPH_CACHE_MAX_SIZE && !list_empty( &glyph_cache_lru ))
+        remove_cached_glyph( LIST_ENTRY( list_tail( &glyph_cache_lru ), struct glyph_cache_entry, entry ));
+
+    if (!(entry = HeapAlloc( GetProcessHeap(), 0, size ))) return;
+    entry->key = *key;
+    entry->gm = *gm;
+    entry->abc = *abc;
+    entry->needed = needed;
+    entry->size = size;
+    entry->has_data = data != NULL;
+    if (data) memcpy( entry->data, data, needed );
+
+    entry->next = glyph_cache_hash[hash_glyph_key( key )];
+    glyph_cache_hash[hash_glyph_key( key )] = entry;
+    list_add_head( &glyph_cache_lru, &entry->entry );
+    glyph_cache_size += size;
+}
+
+static void update_glyph_cache_stats( BOOL hit )
+{
+    if (hit) glyph_cache_hits++;
+    else glyph_cache_misses++;
+    if (!((glyph_cache_hits + glyph_cache_misses) % 4096))
+        TRACE( "glyph cache: %u hits, %u misses, %u bytes\n",
+               glyph_cache_hits, glyph_cache_misses, glyph_cache_size );
+}
+
 static DWORD get_glyph_outline(GdiFont *incoming_font, UINT glyph, UINT format,
                                LPGLYPHMETRICS lpgm, ABC *abc, DWORD buflen, LPVOID buf,
                                const MAT2* lpmat)
@@ -7071,6 +7749,10 @@ static DWORD get_glyph_outline(GdiFont *incoming_font, UINT glyph, UINT format,
     BOOL needsTransform = FALSE;
     BOOL tategaki = (font->name[0] == '@');
     BOOL vertical_metrics;
+    struct glyph_cache_entry *cached;
+    struct glyph_cache_key key;
+    UINT cache_format = format & ~GGO_GLYPH_INDEX;
+    BOOL use_cache = is_identity_MAT2(lpmat); /* don't cache custom transforms */
 
     TRACE("%p, %04x, %08x, %p, %08x, %p, %p\n", font, glyph, format, lpgm,
 	  buflen, buf, lpmat);
@@ -7105,6 +7787,18 @@ static DWORD get_glyph_outline(GdiFont *incoming_font, UINT glyph, UINT format,
         get_cached_metrics( font, glyph_index, lpgm, abc ))
         return 1; /* FIXME */
 
+    if (use_cache)
+    {
+        init_glyph_cache_key( &key, incoming_font, font, glyph_index, cache_format, tategaki );
+        if ((cached = find_cached_glyph( &key )) &&
+            get_cached_glyph( cached, format, lpgm, abc, buflen, buf, &needed ))
+        {
+            update_glyph_cache_stats( TRUE );
+            return needed;
+        }
+        update_glyph_cache_stats( FALSE );
+    }
+
     needsTransform = get_transform_matrices( font, tategaki, lpmat, matrices );
 
     vertical_metrics = (tategaki && FT_HAS_VERTICAL(ft_face));
@@ -7162,6 +7856,7 @@ static DWORD get_glyph_outline(GdiFont *incoming_font, UINT glyph, UINT format,
     if(format == GGO_METRICS)
     {
         *lpgm = gm;
+        if (use_cache) add_cached_glyph( &key, &gm, abc, 1, NULL );
         return 1; /* FIXME */
     }
 
@@ -7238,7 +7933,10 @@ static DWORD get_glyph_outline(GdiFont *incoming_font, UINT glyph, UINT format,
 	return GDI_ERROR;
     }
     if (needed != GDI_ERROR)
+    {
         *lpgm = gm;
+        if (use_cache) add_cached_glyph( &key, &gm, abc, needed, buf && buflen ? buf : NULL );
+    }
 
     return needed;
 }
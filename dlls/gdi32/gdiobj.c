@@ -52,6 +52,10 @@ struct gdi_handle_entry
     void                       *obj;         /* pointer to the object-specific data */
     const struct gdi_obj_funcs *funcs;       /* type-specific functions */
     struct hdc_list            *hdcs;        /* list of HDCs interested in this object */
+    LONG                        handle;      /* full handle value, 0 if the entry is free */
+    LONG                        lock;        /* object lock: 0 free, 1 held, 2 held with waiters */
+    DWORD                       owner;       /* thread holding the object lock */
+    WORD                        recursion;   /* recursion count of the object lock */
     WORD                        generation;  /* generation count for reusing handle values */
     WORD                        type;        /* object type (one of the OBJ_* constants) */
     WORD                        selcount;    /* number of times the object is selected in a DC */
@@ -63,6 +67,7 @@ static struct gdi_handle_entry gdi_handles[MAX_GDI_HANDLES];
 static struct gdi_handle_entry *next_free;
 static struct gdi_handle_entry *next_unused = gdi_handles;
 static LONG debug_count;
+static DWORD held_locks_tls = TLS_OUT_OF_INDEXES;
 HMODULE gdi32_module = 0;
 
 static inline HGDIOBJ entry_to_handle( struct gdi_handle_entry *entry )
@@ -71,19 +76,99 @@ static inline HGDIOBJ entry_to_handle( struct gdi_handle_entry *entry )
     return LongToHandle( idx | (entry->generation << 16) );
 }
 
+static inline BOOL entry_matches( LONG full, HGDIOBJ handle )
+{
+    return full && (!HIWORD( handle ) || HIWORD( handle ) == HIWORD( full ));
+}
+
+/* Find the entry of a handle. This only takes a snapshot of the entry state, its
+ * contents are only stable when it's locked, see lock_handle_entry(). */
 static inline struct gdi_handle_entry *handle_entry( HGDIOBJ handle )
 {
     unsigned int idx = LOWORD(handle) - FIRST_GDI_HANDLE;
 
-    if (idx < MAX_GDI_HANDLES && gdi_handles[idx].type)
+    if (idx < MAX_GDI_HANDLES && entry_matches( *(volatile LONG *)&gdi_handles[idx].handle, handle ))
+        return &gdi_handles[idx];
+    if (handle) WARN( "invalid handle %p\n", handle );
+    return NULL;
+}
+
+/* the number of object locks held by the current thread, for GDI_CheckNotLock */
+static void add_held_locks( LONG_PTR count )
+{
+    DWORD err;
+
+    if (held_locks_tls == TLS_OUT_OF_INDEXES) return;
+    err = GetLastError();  /* TlsGetValue clears it */
+    TlsSetValue( held_locks_tls, (void *)((LONG_PTR)TlsGetValue( held_locks_tls ) + count) );
+    SetLastError( err );
+}
+
+static void lock_entry( struct gdi_handle_entry *entry )
+{
+    static const LONG held_with_waiters = 2;
+    DWORD tid = GetCurrentThreadId();
+
+    /* only the current thread can have stored its own id */
+    if (entry->owner == tid)
     {
-        if (!HIWORD( handle ) || HIWORD( handle ) == gdi_handles[idx].generation)
-            return &gdi_handles[idx];
+        entry->recursion++;
+        return;
     }
-    if (handle) WARN( "invalid handle %p\n", handle );
+    if (InterlockedCompareExchange( &entry->lock, 1, 0 ))
+    {
+        while (InterlockedExchange( &entry->lock, 2 ))
+            RtlWaitOnAddress( &entry->lock, &held_with_waiters, sizeof(entry->lock), NULL );
+    }
+    entry->owner = tid;
+    entry->recursion = 1;
+    add_held_locks( 1 );
+}
+
+static void unlock_entry( struct gdi_handle_entry *entry )
+{
+    if (--entry->recursion) return;
+    entry->owner = 0;
+    if (InterlockedExchange( &entry->lock, 0 ) == 2) RtlWakeAddressSingle( &entry->lock );
+    add_held_locks( -1 );
+}
+
+/* lock the entry of a handle, the entry is only returned if it's still valid once locked */
+static struct gdi_handle_entry *lock_handle_entry( HGDIOBJ handle )
+{
+    struct gdi_handle_entry *entry;
+
+    if (!(entry = handle_entry( handle ))) return NULL;
+    lock_entry( entry );
+    if (entry_matches( entry->handle, handle )) return entry;
+    unlock_entry( entry );
+    WARN( "invalid handle %p\n", handle );
     return NULL;
 }
 
+/* Retrieve the functions, type and full handle of an object without locking it.
+ * The fields are read again if the entry is freed or reused in the meantime. */
+static const struct gdi_obj_funcs *get_object_funcs( HGDIOBJ *handle, WORD *type )
+{
+    struct gdi_handle_entry *entry;
+    const struct gdi_obj_funcs *funcs;
+    LONG full;
+    WORD obj_type;
+
+    if (!(entry = handle_entry( *handle ))) return NULL;
+    for (;;)
+    {
+        full = *(volatile LONG *)&entry->handle;
+        if (!entry_matches( full, *handle )) return NULL;
+        funcs = *(const struct gdi_obj_funcs * volatile *)&entry->funcs;
+        obj_type = *(volatile WORD *)&entry->type;
+        if (full == *(volatile LONG *)&entry->handle) break;
+    }
+    *handle = LongToHandle( full );
+    if (type) *type = obj_type;
+    return funcs;
+}
+
 /***********************************************************************
  *          GDI stock objects
  */
@@ -110,6 +195,7 @@ static const LOGPEN DCPen     = { PS_SOLID, { 0, 0 }, RGB(0,0,0) };
 static HGDIOBJ stock_objects[NB_STOCK_OBJECTS];
 static HGDIOBJ scaled_stock_objects[NB_STOCK_OBJECTS];
 
+/* protects the list of free handle entries, objects are protected by their own lock */
 static CRITICAL_SECTION gdi_section;
 static CRITICAL_SECTION_DEBUG critsect_debug =
 {
@@ -491,9 +577,9 @@ void CDECL __wine_make_gdi_object_system( HGDIOBJ handle, BOOL set)
 {
     struct gdi_handle_entry *entry;
 
-    EnterCriticalSection( &gdi_section );
-    if ((entry = handle_entry( handle ))) entry->system = !!set;
-    LeaveCriticalSection( &gdi_section );
+    if (!(entry = lock_handle_entry( handle ))) return;
+    entry->system = !!set;
+    unlock_entry( entry );
 }
 
 /******************************************************************************
@@ -547,9 +633,11 @@ UINT GDI_get_ref_count( HGDIOBJ handle )
     struct gdi_handle_entry *entry;
     UINT ret = 0;
 
-    EnterCriticalSection( &gdi_section );
-    if ((entry = handle_entry( handle ))) ret = entry->selcount;
-    LeaveCriticalSection( &gdi_section );
+    if ((entry = lock_handle_entry( handle )))
+    {
+        ret = entry->selcount;
+        unlock_entry( entry );
+    }
     return ret;
 }
 
@@ -563,10 +651,9 @@ HGDIOBJ GDI_inc_ref_count( HGDIOBJ handle )
 {
     struct gdi_handle_entry *entry;
 
-    EnterCriticalSection( &gdi_section );
-    if ((entry = handle_entry( handle ))) entry->selcount++;
-    else handle = 0;
-    LeaveCriticalSection( &gdi_section );
+    if (!(entry = lock_handle_entry( handle ))) return 0;
+    entry->selcount++;
+    unlock_entry( entry );
     return handle;
 }
 
@@ -580,22 +667,19 @@ BOOL GDI_dec_ref_count( HGDIOBJ handle )
 {
     struct gdi_handle_entry *entry;
 
-    EnterCriticalSection( &gdi_section );
-    if ((entry = handle_entry( handle )))
+    if (!(entry = lock_handle_entry( handle ))) return FALSE;
+    assert( entry->selcount );
+    if (!--entry->selcount && entry->deleted)
     {
-        assert( entry->selcount );
-        if (!--entry->selcount && entry->deleted)
-        {
-            /* handle delayed DeleteObject*/
-            entry->deleted = 0;
-            LeaveCriticalSection( &gdi_section );
-            TRACE( "executing delayed DeleteObject for %p\n", handle );
-            DeleteObject( handle );
-            return TRUE;
-        }
+        /* handle delayed DeleteObject*/
+        entry->deleted = 0;
+        unlock_entry( entry );
+        TRACE( "executing delayed DeleteObject for %p\n", handle );
+        DeleteObject( handle );
+        return TRUE;
     }
-    LeaveCriticalSection( &gdi_section );
-    return entry != NULL;
+    unlock_entry( entry );
+    return TRUE;
 }
 
 static const WCHAR dpi_key_name[] = {'C','o','n','t','r','o','l',' ','P','a','n','e','l','\\','D','e','s','k','t','o','p','\0'};
@@ -690,6 +774,7 @@ BOOL WINAPI DllMain( HINSTANCE inst, DWORD reason, LPVOID reserved )
 
     gdi32_module = inst;
     DisableThreadLibraryCalls( inst );
+    held_locks_tls = TlsAlloc();
     font_init();
 
     /* create stock objects */
@@ -812,6 +897,8 @@ HGDIOBJ alloc_gdi_handle( void *obj, WORD type, const struct gdi_obj_funcs *func
     entry->deleted  = 0;
     if (++entry->generation == 0xffff) entry->generation = 1;
     ret = entry_to_handle( entry );
+    /* the entry becomes visible to lookups once the handle is set */
+    InterlockedExchange( &entry->handle, HandleToLong( ret ));
     LeaveCriticalSection( &gdi_section );
     TRACE( "allocated %s %p %u/%u\n", gdi_obj_type(type), ret,
            InterlockedIncrement( &debug_count ), MAX_GDI_HANDLES );
@@ -829,16 +916,18 @@ void *free_gdi_handle( HGDIOBJ handle )
     void *object = NULL;
     struct gdi_handle_entry *entry;
 
+    /* wait for the threads using the object to release it */
+    if (!(entry = lock_handle_entry( handle ))) return NULL;
+    TRACE( "freed %s %p %u/%u\n", gdi_obj_type( entry->type ), handle,
+           InterlockedDecrement( &debug_count ) + 1, MAX_GDI_HANDLES );
+    object = entry->obj;
+    InterlockedExchange( &entry->handle, 0 );
+    entry->type = 0;
+    unlock_entry( entry );
+
     EnterCriticalSection( &gdi_section );
-    if ((entry = handle_entry( handle )))
-    {
-        TRACE( "freed %s %p %u/%u\n", gdi_obj_type( entry->type ), handle,
-               InterlockedDecrement( &debug_count ) + 1, MAX_GDI_HANDLES );
-        object = entry->obj;
-        entry->type = 0;
-        entry->obj = next_free;
-        next_free = entry;
-    }
+    entry->obj = next_free;
+    next_free = entry;
     LeaveCriticalSection( &gdi_section );
     return object;
 }
@@ -851,14 +940,7 @@ void *free_gdi_handle( HGDIOBJ handle )
  */
 HGDIOBJ get_full_gdi_handle( HGDIOBJ handle )
 {
-    struct gdi_handle_entry *entry;
-
-    if (!HIWORD( handle ))
-    {
-        EnterCriticalSection( &gdi_section );
-        if ((entry = handle_entry( handle ))) handle = entry_to_handle( entry );
-        LeaveCriticalSection( &gdi_section );
-    }
+    if (!HIWORD( handle )) get_object_funcs( &handle, NULL );
     return handle;
 }
 
@@ -871,19 +953,11 @@ HGDIOBJ get_full_gdi_handle( HGDIOBJ handle )
  */
 void *get_any_obj_ptr( HGDIOBJ handle, WORD *type )
 {
-    void *ptr = NULL;
     struct gdi_handle_entry *entry;
 
-    EnterCriticalSection( &gdi_section );
-
-    if ((entry = handle_entry( handle )))
-    {
-        ptr = entry->obj;
-        *type = entry->type;
-    }
-
-    if (!ptr) LeaveCriticalSection( &gdi_section );
-    return ptr;
+    if (!(entry = lock_handle_entry( handle ))) return NULL;
+    *type = entry->type;
+    return entry->obj;
 }
 
 /***********************************************************************
@@ -905,13 +979,54 @@ void *GDI_GetObjPtr( HGDIOBJ handle, WORD type )
     return ptr;
 }
 
+/***********************************************************************
+ *           GDI_GetObjPtrs
+ *
+ * Return pointers to several GDI objects of the same type. The objects are
+ * locked in handle order, so that threads using the same objects can't deadlock.
+ * Each object must be released with GDI_ReleaseObj, nothing is locked on failure.
+ *
+ * Objects of different types are locked in this order: DC, then bitmap, then
+ * palette. Nothing else may be locked while a palette is held. No object lock
+ * may be held when calling into the driver or into external libraries; callers
+ * that need the object to stay alive take a selection reference instead.
+ */
+BOOL GDI_GetObjPtrs( const HGDIOBJ *handles, void **ptrs, UINT count, WORD type )
+{
+    UINT order[4], i, j, tmp;
+
+    assert( count <= ARRAY_SIZE( order ));
+    for (i = 0; i < count; i++) order[i] = i;
+    for (i = 1; i < count; i++)
+        for (j = i; j && LOWORD( handles[order[j]] ) < LOWORD( handles[order[j - 1]] ); j--)
+        {
+            tmp = order[j];
+            order[j] = order[j - 1];
+            order[j - 1] = tmp;
+        }
+
+    for (i = 0; i < count; i++)
+    {
+        if ((ptrs[order[i]] = GDI_GetObjPtr( handles[order[i]], type ))) continue;
+        while (i--) GDI_ReleaseObj( handles[order[i]] );
+        return FALSE;
+    }
+    return TRUE;
+}
+
 /***********************************************************************
  *           GDI_ReleaseObj
  *
  */
 void GDI_ReleaseObj( HGDIOBJ handle )
 {
-    LeaveCriticalSection( &gdi_section );
+    unsigned int idx = LOWORD(handle) - FIRST_GDI_HANDLE;
+
+    /* the entry may have been freed while locked, so don't check the generation */
+    if (idx < MAX_GDI_HANDLES && gdi_handles[idx].owner == GetCurrentThreadId())
+        unlock_entry( &gdi_handles[idx] );
+    else
+        ERR( "BUG: releasing %p which is not locked\n", handle );
 }
 
 
@@ -920,7 +1035,14 @@ void GDI_ReleaseObj( HGDIOBJ handle )
  */
 void GDI_CheckNotLock(void)
 {
-    if (RtlIsCriticalSectionLockedByThread(&gdi_section))
+    DWORD err;
+    LONG_PTR count;
+
+    if (held_locks_tls == TLS_OUT_OF_INDEXES) return;
+    err = GetLastError();
+    count = (LONG_PTR)TlsGetValue( held_locks_tls );
+    SetLastError( err );
+    if (count)
     {
         ERR( "BUG: holding GDI lock\n" );
         DebugBreak();
@@ -948,17 +1070,12 @@ BOOL WINAPI DeleteObject( HGDIOBJ obj )
     struct hdc_list *hdcs_head;
     const struct gdi_obj_funcs *funcs = NULL;
 
-    EnterCriticalSection( &gdi_section );
-    if (!(entry = handle_entry( obj )))
-    {
-        LeaveCriticalSection( &gdi_section );
-        return FALSE;
-    }
+    if (!(entry = lock_handle_entry( obj ))) return FALSE;
 
     if (entry->system)
     {
 	TRACE("Preserving system object %p\n", obj);
-        LeaveCriticalSection( &gdi_section );
+        unlock_entry( entry );
 	return TRUE;
     }
 
@@ -974,7 +1091,7 @@ BOOL WINAPI DeleteObject( HGDIOBJ obj )
     }
     else funcs = entry->funcs;
 
-    LeaveCriticalSection( &gdi_section );
+    unlock_entry( entry );
 
     while (hdcs_head)
     {
@@ -1010,8 +1127,8 @@ void GDI_hdc_using_object(HGDIOBJ obj, HDC hdc)
 
     TRACE("obj %p hdc %p\n", obj, hdc);
 
-    EnterCriticalSection( &gdi_section );
-    if ((entry = handle_entry( obj )) && !entry->system)
+    if (!(entry = lock_handle_entry( obj ))) return;
+    if (!entry->system)
     {
         for (phdc = entry->hdcs; phdc; phdc = phdc->next)
             if (phdc->hdc == hdc) break;
@@ -1024,7 +1141,7 @@ void GDI_hdc_using_object(HGDIOBJ obj, HDC hdc)
             entry->hdcs = phdc;
         }
     }
-    LeaveCriticalSection( &gdi_section );
+    unlock_entry( entry );
 }
 
 /***********************************************************************
@@ -1038,8 +1155,8 @@ void GDI_hdc_not_using_object(HGDIOBJ obj, HDC hdc)
 
     TRACE("obj %p hdc %p\n", obj, hdc);
 
-    EnterCriticalSection( &gdi_section );
-    if ((entry = handle_entry( obj )) && !entry->system)
+    if (!(entry = lock_handle_entry( obj ))) return;
+    if (!entry->system)
     {
         for (pphdc = &entry->hdcs; *pphdc; pphdc = &(*pphdc)->next)
             if ((*pphdc)->hdc == hdc)
@@ -1050,7 +1167,7 @@ void GDI_hdc_not_using_object(HGDIOBJ obj, HDC hdc)
                 break;
             }
     }
-    LeaveCriticalSection( &gdi_section );
+    unlock_entry( entry );
 }
 
 /***********************************************************************
@@ -1077,19 +1194,12 @@ HGDIOBJ WINAPI GetStockObject( INT obj )
  */
 INT WINAPI GetObjectA( HGDIOBJ handle, INT count, LPVOID buffer )
 {
-    struct gdi_handle_entry *entry;
     const struct gdi_obj_funcs *funcs = NULL;
     INT result = 0;
 
     TRACE("%p %d %p\n", handle, count, buffer );
 
-    EnterCriticalSection( &gdi_section );
-    if ((entry = handle_entry( handle )))
-    {
-        funcs = entry->funcs;
-        handle = entry_to_handle( entry );  /* make it a full handle */
-    }
-    LeaveCriticalSection( &gdi_section );
+    funcs = get_object_funcs( &handle, NULL );  /* make it a full handle */
 
     if (funcs)
     {
@@ -1108,19 +1218,12 @@ INT WINAPI GetObjectA( HGDIOBJ handle, INT count, LPVOID buffer )
  */
 INT WINAPI GetObjectW( HGDIOBJ handle, INT count, LPVOID buffer )
 {
-    struct gdi_handle_entry *entry;
     const struct gdi_obj_funcs *funcs = NULL;
     INT result = 0;
 
     TRACE("%p %d %p\n", handle, count, buffer );
 
-    EnterCriticalSection( &gdi_section );
-    if ((entry = handle_entry( handle )))
-    {
-        funcs = entry->funcs;
-        handle = entry_to_handle( entry );  /* make it a full handle */
-    }
-    LeaveCriticalSection( &gdi_section );
+    funcs = get_object_funcs( &handle, NULL );  /* make it a full handle */
 
     if (funcs)
     {
@@ -1139,16 +1242,13 @@ INT WINAPI GetObjectW( HGDIOBJ handle, INT count, LPVOID buffer )
  */
 DWORD WINAPI GetObjectType( HGDIOBJ handle )
 {
-    struct gdi_handle_entry *entry;
-    DWORD result = 0;
+    WORD type = 0;
 
-    EnterCriticalSection( &gdi_section );
-    if ((entry = handle_entry( handle ))) result = entry->type;
-    LeaveCriticalSection( &gdi_section );
+    get_object_funcs( &handle, &type );
 
-    TRACE("%p -> %u\n", handle, result );
-    if (!result) SetLastError( ERROR_INVALID_HANDLE );
-    return result;
+    TRACE("%p -> %u\n", handle, type );
+    if (!type) SetLastError( ERROR_INVALID_HANDLE );
+    return type;
 }
 
 /***********************************************************************
@@ -1217,18 +1317,11 @@ HGDIOBJ WINAPI GetCurrentObject(HDC hdc,UINT type)
  */
 HGDIOBJ WINAPI SelectObject( HDC hdc, HGDIOBJ hObj )
 {
-    struct gdi_handle_entry *entry;
     const struct gdi_obj_funcs *funcs = NULL;
 
     TRACE( "(%p,%p)\n", hdc, hObj );
 
-    EnterCriticalSection( &gdi_section );
-    if ((entry = handle_entry( hObj )))
-    {
-        funcs = entry->funcs;
-        hObj = entry_to_handle( entry );  /* make it a full handle */
-    }
-    LeaveCriticalSection( &gdi_section );
+    funcs = get_object_funcs( &hObj, NULL );  /* make it a full handle */
 
     if (funcs && funcs->pSelectObject) return funcs->pSelectObject( hObj, hdc );
     return 0;
@@ -1241,15 +1334,8 @@ HGDIOBJ WINAPI SelectObject( HDC hdc, HGDIOBJ hObj )
 BOOL WINAPI UnrealizeObject( HGDIOBJ obj )
 {
     const struct gdi_obj_funcs *funcs = NULL;
-    struct gdi_handle_entry *entry;
 
-    EnterCriticalSection( &gdi_section );
-    if ((entry = handle_entry( obj )))
-    {
-        funcs = entry->funcs;
-        obj = entry_to_handle( entry );  /* make it a full handle */
-    }
-    LeaveCriticalSection( &gdi_section );
+    funcs = get_object_funcs( &obj, NULL );  /* make it a full handle */
 
     if (funcs && funcs->pUnrealizeObject) return funcs->pUnrealizeObject( obj );
     return funcs != NULL;
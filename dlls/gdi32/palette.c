@@ -670,10 +670,11 @@ UINT WINAPI GDIRealizePalette( HDC hdc )
         PALETTEOBJ *palPtr = GDI_GetObjPtr( dc->hPalette, OBJ_PAL );
         if (palPtr)
         {
-            realized = physdev->funcs->pRealizePalette( physdev, dc->hPalette,
-                                                        (dc->hPalette == hPrimaryPalette) );
+            /* palette locks are taken last, don't hold it across the driver call */
             palPtr->unrealize = physdev->funcs->pUnrealizePalette;
             GDI_ReleaseObj( dc->hPalette );
+            realized = physdev->funcs->pRealizePalette( physdev, dc->hPalette,
+                                                        (dc->hPalette == hPrimaryPalette) );
         }
     }
     else TRACE("  skipping (hLastRealizedPalette = %p)\n", hLastRealizedPalette);
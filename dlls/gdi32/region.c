@@ -370,6 +370,10 @@ static BOOL REGION_UnionRegion(WINEREGION *d, WINEREGION *s1, WINEREGION *s2);
 static BOOL REGION_SubtractRegion(WINEREGION *d, WINEREGION *s1, WINEREGION *s2);
 static BOOL REGION_XorRegion(WINEREGION *d, WINEREGION *s1, WINEREGION *s2);
 static BOOL REGION_UnionRectWithRegion(const RECT *rect, WINEREGION *rgn);
+static INT REGION_Coalesce(WINEREGION *pReg, INT prevStart, INT curStart);
+static void REGION_SetExtents(WINEREGION *pReg);
+static WINEREGION *create_polypolygon_obj( const POINT *Pts, const INT *Count, INT nbpolygons, INT mode,
+                                           const RECT *clip_rect );
 
 /***********************************************************************
  *            get_region_type
@@ -929,6 +933,142 @@ static void translate( POINT *pt, UINT count, const XFORM *xform )
     }
 }
 
+/* builds one of the regions combined by union_regions */
+typedef BOOL (*init_region_func)( WINEREGION *rgn, UINT index, const void *ctx );
+
+/***********************************************************************
+ *           union_regions
+ *
+ * Union of the regions built by func for the indices in [start, end). The
+ * regions are combined pairwise, so that building a region from n pieces
+ * costs O(n log n) instead of the O(n^2) of adding them one at a time.
+ */
+static BOOL union_regions( WINEREGION *dst, UINT start, UINT end, init_region_func func, const void *ctx )
+{
+    WINEREGION tmp;
+    UINT middle;
+    BOOL ret;
+
+    if (end - start == 1) return func( dst, start, ctx );
+
+    middle = start + (end - start) / 2;
+    if (!union_regions( dst, start, middle, func, ctx )) return FALSE;
+    if (!init_region( &tmp, 0 )) return FALSE;
+    ret = union_regions( &tmp, middle, end, func, ctx ) && REGION_UnionRegion( dst, dst, &tmp );
+    destroy_region( &tmp );
+    return ret;
+}
+
+static BOOL init_rect_region( WINEREGION *rgn, UINT index, const void *ctx )
+{
+    const RECT *rects = ctx;
+
+    rgn->numRects = 1;
+    rgn->extents = rgn->rects[0] = rects[index];
+    return TRUE;
+}
+
+static int compare_rects( const void *a, const void *b )
+{
+    const RECT *r1 = a, *r2 = b;
+
+    if (r1->top != r2->top) return r1->top < r2->top ? -1 : 1;
+    if (r1->left != r2->left) return r1->left < r2->left ? -1 : 1;
+    return 0;
+}
+
+/* check whether the rectangles are already in the y-x banded form of a region */
+static BOOL is_banded( const RECT *rects, UINT count )
+{
+    UINT i;
+
+    for (i = 0; i < count; i++)
+    {
+        if (rects[i].left >= rects[i].right || rects[i].top >= rects[i].bottom) return FALSE;
+        if (!i) continue;
+        if (rects[i].top == rects[i - 1].top)
+        {
+            if (rects[i].bottom != rects[i - 1].bottom) return FALSE;
+            if (rects[i].left <= rects[i - 1].right) return FALSE;
+        }
+        else if (rects[i].top < rects[i - 1].bottom) return FALSE;
+    }
+    return TRUE;
+}
+
+/***********************************************************************
+ *           REGION_UnionRects
+ *
+ * Set the region to the union of an array of rectangles. Rectangles that are
+ * already banded, like the ones returned by GetRegionData, are copied as is.
+ */
+static BOOL REGION_UnionRects( WINEREGION *rgn, const RECT *rects, UINT count )
+{
+    UINT i, band, valid;
+    INT prev_band = 0;
+    RECT *sorted;
+    BOOL ret;
+
+    empty_region( rgn );
+    if (!count) return TRUE;
+
+    if (is_banded( rects, count ))
+    {
+        if (!grow_region( rgn, count )) return FALSE;
+        /* the bands still need to be coalesced with the ones above them */
+        for (i = 0; i < count; i = band)
+        {
+            for (band = i + 1; band < count && rects[band].top == rects[i].top; band++) ;
+            memcpy( rgn->rects + rgn->numRects, rects + i, (band - i) * sizeof(RECT) );
+            valid = rgn->numRects;
+            rgn->numRects += band - i;
+            prev_band = REGION_Coalesce( rgn, prev_band, valid );
+        }
+        REGION_SetExtents( rgn );
+        return TRUE;
+    }
+
+    if (!(sorted = HeapAlloc( GetProcessHeap(), 0, count * sizeof(RECT) ))) return FALSE;
+    for (i = valid = 0; i < count; i++)
+        if (rects[i].left < rects[i].right && rects[i].top < rects[i].bottom) sorted[valid++] = rects[i];
+    qsort( sorted, valid, sizeof(RECT), compare_rects );
+
+    ret = !valid || union_regions( rgn, 0, valid, init_rect_region, sorted );
+    HeapFree( GetProcessHeap(), 0, sorted );
+    return ret;
+}
+
+struct xform_rects
+{
+    const RECT  *rects;
+    const XFORM *xform;
+};
+
+static BOOL init_xform_rect_region( WINEREGION *rgn, UINT index, const void *ctx )
+{
+    const struct xform_rects *params = ctx;
+    const RECT *rect = &params->rects[index];
+    static const INT count = 4;
+    WINEREGION *obj;
+    POINT pt[4];
+
+    pt[0].x = rect->left;
+    pt[0].y = rect->top;
+    pt[1].x = rect->right;
+    pt[1].y = rect->top;
+    pt[2].x = rect->right;
+    pt[2].y = rect->bottom;
+    pt[3].x = rect->left;
+    pt[3].y = rect->bottom;
+
+    translate( pt, 4, params->xform );
+    if (!(obj = create_polypolygon_obj( pt, &count, 1, WINDING, NULL ))) return FALSE;
+    move_rects( rgn, obj );
+    rgn->extents = obj->extents;
+    free_region( obj );
+    return TRUE;
+}
+
 
 /***********************************************************************
  *           ExtCreateRegion   (GDI32.@)
@@ -951,7 +1091,6 @@ HRGN WINAPI ExtCreateRegion( const XFORM* lpXform, DWORD dwCount, const RGNDATA*
 {
     HRGN hrgn = 0;
     WINEREGION *obj;
-    const RECT *pCurRect, *pEndRect;
 
     if (!rgndata)
     {
@@ -968,45 +1107,21 @@ HRGN WINAPI ExtCreateRegion( const XFORM* lpXform, DWORD dwCount, const RGNDATA*
 
     if (lpXform)
     {
-        const RECT *pCurRect, *pEndRect;
-
-        hrgn = CreateRectRgn( 0, 0, 0, 0 );
+        struct xform_rects params;
 
-        pEndRect = (const RECT *)rgndata->Buffer + rgndata->rdh.nCount;
-        for (pCurRect = (const RECT *)rgndata->Buffer; pCurRect < pEndRect; pCurRect++)
-        {
-            static const INT count = 4;
-            HRGN poly_hrgn;
-            POINT pt[4];
-
-            pt[0].x = pCurRect->left;
-            pt[0].y = pCurRect->top;
-            pt[1].x = pCurRect->right;
-            pt[1].y = pCurRect->top;
-            pt[2].x = pCurRect->right;
-            pt[2].y = pCurRect->bottom;
-            pt[3].x = pCurRect->left;
-            pt[3].y = pCurRect->bottom;
-
-            translate( pt, 4, lpXform );
-            poly_hrgn = CreatePolyPolygonRgn( pt, &count, 1, WINDING );
-            CombineRgn( hrgn, hrgn, poly_hrgn, RGN_OR );
-            DeleteObject( poly_hrgn );
-        }
-        return hrgn;
+        if (!(obj = alloc_region( 0 ))) return 0;
+        params.rects = (const RECT *)rgndata->Buffer;
+        params.xform = lpXform;
+        if (!rgndata->rdh.nCount ||
+            union_regions( obj, 0, rgndata->rdh.nCount, init_xform_rect_region, &params ))
+            hrgn = alloc_gdi_handle( obj, OBJ_REGION, &region_funcs );
+        goto done;
     }
 
     if (!(obj = alloc_region( rgndata->rdh.nCount ))) return 0;
 
-    pEndRect = (const RECT *)rgndata->Buffer + rgndata->rdh.nCount;
-    for(pCurRect = (const RECT *)rgndata->Buffer; pCurRect < pEndRect; pCurRect++)
-    {
-        if (pCurRect->left < pCurRect->right && pCurRect->top < pCurRect->bottom)
-        {
-            if (!REGION_UnionRectWithRegion( pCurRect, obj )) goto done;
-        }
-    }
-    hrgn = alloc_gdi_handle( obj, OBJ_REGION, &region_funcs );
+    if (REGION_UnionRects( obj, (const RECT *)rgndata->Buffer, rgndata->rdh.nCount ))
+        hrgn = alloc_gdi_handle( obj, OBJ_REGION, &region_funcs );
 
 done:
     if (!hrgn) free_region( obj );
@@ -1062,33 +1177,32 @@ BOOL WINAPI RectInRegion( HRGN hrgn, const RECT *rect )
     WINEREGION *obj;
     BOOL ret = FALSE;
     RECT rc;
-    int i;
+    int i, y;
 
     /* swap the coordinates to make right >= left and bottom >= top */
     /* (region building rectangles are normalized the same way) */
     rc = *rect;
     order_rect( &rc );
 
+    /* an empty rectangle is not rejected: it is reported as inside when its
+     * top-left corner is strictly inside the extents and lies in the region */
     if ((obj = GDI_GetObjPtr( hrgn, OBJ_REGION )))
     {
 	if ((obj->numRects > 0) && overlapping(&obj->extents, &rc))
 	{
-	    for (i = region_find_pt( obj, rc.left, rc.top, &ret ); !ret && i < obj->numRects; i++ )
-	    {
-	        if (obj->rects[i].bottom <= rc.top)
-		    continue;             /* not far enough down yet */
-
-		if (obj->rects[i].top >= rc.bottom)
-		    break;                /* too far down */
-
-		if (obj->rects[i].right <= rc.left)
-		    continue;              /* not far enough over yet */
-
-		if (obj->rects[i].left >= rc.right)
-		    continue;
-
-		ret = TRUE;
-	    }
+            /* look up the first rectangle right of rc.left in each band crossed by the rectangle */
+            y = rc.top;
+            i = region_find_pt( obj, rc.left, y, &ret );
+            while (!ret && i < obj->numRects && obj->rects[i].top < rc.bottom)
+            {
+                if (obj->rects[i].top > y)
+                    y = obj->rects[i].top;  /* first band below y */
+                else if (obj->rects[i].left < rc.right)
+                    ret = TRUE;
+                else
+                    y = obj->rects[i].bottom;  /* nothing in this band */
+                if (!ret) i = region_find_pt( obj, rc.left, y, NULL );
+            }
 	}
 	GDI_ReleaseObj(hrgn);
     }
@@ -1109,39 +1223,37 @@ BOOL WINAPI RectInRegion( HRGN hrgn, const RECT *rect )
  */
 BOOL WINAPI EqualRgn( HRGN hrgn1, HRGN hrgn2 )
 {
+    HGDIOBJ handles[2] = { hrgn1, hrgn2 };
     WINEREGION *obj1, *obj2;
+    void *objs[2];
     BOOL ret = FALSE;
+    int i;
 
-    if ((obj1 = GDI_GetObjPtr( hrgn1, OBJ_REGION )))
-    {
-        if ((obj2 = GDI_GetObjPtr( hrgn2, OBJ_REGION )))
-	{
-	    int i;
-
-	    if ( obj1->numRects != obj2->numRects ) goto done;
-            if ( obj1->numRects == 0 )
-            {
-                ret = TRUE;
-                goto done;
+    if (!GDI_GetObjPtrs( handles, objs, 2, OBJ_REGION )) return FALSE;
+    obj1 = objs[0];
+    obj2 = objs[1];
 
-            }
-            if (obj1->extents.left   != obj2->extents.left) goto done;
-            if (obj1->extents.right  != obj2->extents.right) goto done;
-            if (obj1->extents.top    != obj2->extents.top) goto done;
-            if (obj1->extents.bottom != obj2->extents.bottom) goto done;
-            for( i = 0; i < obj1->numRects; i++ )
-            {
-                if (obj1->rects[i].left   != obj2->rects[i].left) goto done;
-                if (obj1->rects[i].right  != obj2->rects[i].right) goto done;
-                if (obj1->rects[i].top    != obj2->rects[i].top) goto done;
-                if (obj1->rects[i].bottom != obj2->rects[i].bottom) goto done;
-	    }
-            ret = TRUE;
-        done:
-	    GDI_ReleaseObj(hrgn2);
-	}
-	GDI_ReleaseObj(hrgn1);
+    if ( obj1->numRects != obj2->numRects ) goto done;
+    if ( obj1->numRects == 0 )
+    {
+        ret = TRUE;
+        goto done;
+    }
+    if (obj1->extents.left   != obj2->extents.left) goto done;
+    if (obj1->extents.right  != obj2->extents.right) goto done;
+    if (obj1->extents.top    != obj2->extents.top) goto done;
+    if (obj1->extents.bottom != obj2->extents.bottom) goto done;
+    for( i = 0; i < obj1->numRects; i++ )
+    {
+        if (obj1->rects[i].left   != obj2->rects[i].left) goto done;
+        if (obj1->rects[i].right  != obj2->rects[i].right) goto done;
+        if (obj1->rects[i].top    != obj2->rects[i].top) goto done;
+        if (obj1->rects[i].bottom != obj2->rects[i].bottom) goto done;
     }
+    ret = TRUE;
+done:
+    GDI_ReleaseObj(hrgn2);
+    GDI_ReleaseObj(hrgn1);
     return ret;
 }
 
@@ -1181,16 +1293,19 @@ BOOL add_rect_to_region( HRGN rgn, const RECT *rect )
  */
 BOOL REGION_FrameRgn( HRGN hDest, HRGN hSrc, INT x, INT y )
 {
+    HGDIOBJ handles[2] = { hDest, hSrc };
     WINEREGION tmprgn;
     BOOL bRet = FALSE;
-    WINEREGION* destObj = NULL;
-    WINEREGION *srcObj = GDI_GetObjPtr( hSrc, OBJ_REGION );
+    WINEREGION *destObj, *srcObj;
+    void *objs[2];
+
+    if (!GDI_GetObjPtrs( handles, objs, 2, OBJ_REGION )) return FALSE;
+    destObj = objs[0];
+    srcObj = objs[1];
 
     tmprgn.rects = NULL;
-    if (!srcObj) return FALSE;
     if (srcObj->numRects != 0)
     {
-        if (!(destObj = GDI_GetObjPtr( hDest, OBJ_REGION ))) goto done;
         if (!init_region( &tmprgn, srcObj->numRects )) goto done;
 
         if (!REGION_OffsetRegion( destObj, srcObj, -x, 0)) goto done;
@@ -1205,7 +1320,7 @@ BOOL REGION_FrameRgn( HRGN hDest, HRGN hSrc, INT x, INT y )
     }
 done:
     destroy_region( &tmprgn );
-    if (destObj) GDI_ReleaseObj ( hDest );
+    GDI_ReleaseObj( hDest );
     GDI_ReleaseObj( hSrc );
     return bRet;
 }
@@ -1241,63 +1356,59 @@ done:
  */
 INT WINAPI CombineRgn(HRGN hDest, HRGN hSrc1, HRGN hSrc2, INT mode)
 {
-    WINEREGION *destObj = GDI_GetObjPtr( hDest, OBJ_REGION );
+    HGDIOBJ handles[3] = { hDest, hSrc1, hSrc2 };
+    WINEREGION *destObj, *src1Obj, *src2Obj = NULL;
+    void *objs[3];
     INT result = ERROR;
 
     TRACE(" %p,%p -> %p mode=%x\n", hSrc1, hSrc2, hDest, mode );
-    if (destObj)
-    {
-        WINEREGION *src1Obj = GDI_GetObjPtr( hSrc1, OBJ_REGION );
-
-	if (src1Obj)
-	{
-	    TRACE("dump src1Obj:\n");
-	    if(TRACE_ON(region))
-	      REGION_DumpRegion(src1Obj);
-	    if (mode == RGN_COPY)
-	    {
-		if (REGION_CopyRegion( destObj, src1Obj ))
-                    result = get_region_type( destObj );
-	    }
-	    else
-	    {
-                WINEREGION *src2Obj = GDI_GetObjPtr( hSrc2, OBJ_REGION );
 
-		if (src2Obj)
-		{
-		    TRACE("dump src2Obj:\n");
-		    if(TRACE_ON(region))
-		        REGION_DumpRegion(src2Obj);
-		    switch (mode)
-		    {
-		    case RGN_AND:
-			if (REGION_IntersectRegion( destObj, src1Obj, src2Obj ))
-                            result = get_region_type( destObj );
-			break;
-		    case RGN_OR:
-			if (REGION_UnionRegion( destObj, src1Obj, src2Obj ))
-                            result = get_region_type( destObj );
-			break;
-		    case RGN_XOR:
-			if (REGION_XorRegion( destObj, src1Obj, src2Obj ))
-                            result = get_region_type( destObj );
-			break;
-		    case RGN_DIFF:
-			if (REGION_SubtractRegion( destObj, src1Obj, src2Obj ))
-                            result = get_region_type( destObj );
-			break;
-		    }
-		    GDI_ReleaseObj( hSrc2 );
-		}
-	    }
-	    GDI_ReleaseObj( hSrc1 );
-	}
-	TRACE("dump destObj:\n");
-	if(TRACE_ON(region))
-	  REGION_DumpRegion(destObj);
+    if (!GDI_GetObjPtrs( handles, objs, mode == RGN_COPY ? 2 : 3, OBJ_REGION )) return ERROR;
+    destObj = objs[0];
+    src1Obj = objs[1];
 
-	GDI_ReleaseObj( hDest );
+    TRACE("dump src1Obj:\n");
+    if(TRACE_ON(region))
+        REGION_DumpRegion(src1Obj);
+    if (mode == RGN_COPY)
+    {
+        if (REGION_CopyRegion( destObj, src1Obj ))
+            result = get_region_type( destObj );
+    }
+    else
+    {
+        src2Obj = objs[2];
+        TRACE("dump src2Obj:\n");
+        if(TRACE_ON(region))
+            REGION_DumpRegion(src2Obj);
+        switch (mode)
+        {
+        case RGN_AND:
+            if (REGION_IntersectRegion( destObj, src1Obj, src2Obj ))
+                result = get_region_type( destObj );
+            break;
+        case RGN_OR:
+            if (REGION_UnionRegion( destObj, src1Obj, src2Obj ))
+                result = get_region_type( destObj );
+            break;
+        case RGN_XOR:
+            if (REGION_XorRegion( destObj, src1Obj, src2Obj ))
+                result = get_region_type( destObj );
+            break;
+        case RGN_DIFF:
+            if (REGION_SubtractRegion( destObj, src1Obj, src2Obj ))
+                result = get_region_type( destObj );
+            break;
+        }
+        GDI_ReleaseObj( hSrc2 );
     }
+    GDI_ReleaseObj( hSrc1 );
+
+    TRACE("dump destObj:\n");
+    if(TRACE_ON(region))
+        REGION_DumpRegion(destObj);
+
+    GDI_ReleaseObj( hDest );
     return result;
 }
 
@@ -1419,16 +1530,14 @@ static BOOL REGION_MirrorRegion( WINEREGION *dst, WINEREGION *src, int width )
  */
 INT mirror_region( HRGN dst, HRGN src, INT width )
 {
-    WINEREGION *src_rgn, *dst_rgn;
+    HGDIOBJ handles[2] = { dst, src };
+    void *rgns[2];
     INT ret = ERROR;
 
-    if (!(src_rgn = GDI_GetObjPtr( src, OBJ_REGION ))) return ERROR;
-    if ((dst_rgn = GDI_GetObjPtr( dst, OBJ_REGION )))
-    {
-        if (REGION_MirrorRegion( dst_rgn, src_rgn, width )) ret = get_region_type( dst_rgn );
-        GDI_ReleaseObj( dst_rgn );
-    }
-    GDI_ReleaseObj( src_rgn );
+    if (!GDI_GetObjPtrs( handles, rgns, 2, OBJ_REGION )) return ERROR;
+    if (REGION_MirrorRegion( rgns[0], rgns[1], width )) ret = get_region_type( rgns[0] );
+    GDI_ReleaseObj( dst );
+    GDI_ReleaseObj( src );
     return ret;
 }
 
@@ -1660,6 +1769,7 @@ static BOOL REGION_RegionOp(
     RECT *r2BandEnd;                  /* End of current band in r2 */
     INT top;                          /* Top of non-overlapping band */
     INT bot;                          /* Bottom of non-overlapping band */
+    INT size;                         /* Initial size of the new region */
 
     /*
      * Initialization:
@@ -1679,8 +1789,18 @@ static BOOL REGION_RegionOp(
      * reallocate and copy the array, which is time consuming, yet we don't
      * have to worry about using too much memory. I hope to be able to
      * nuke the Xrealloc() at the end of this function eventually.
+     * When the destination is not one of the sources, its rectangles can be
+     * reused instead.
      */
-    if (!init_region( &newReg, max(reg1->numRects,reg2->numRects) * 2 )) return FALSE;
+    size = max(reg1->numRects,reg2->numRects) * 2;
+    if (destReg != reg1 && destReg != reg2 && destReg->rects != destReg->rects_buf && destReg->size >= size)
+    {
+        newReg.rects = destReg->rects;
+        newReg.size = destReg->size;
+        empty_region( &newReg );
+        init_region( destReg, 0 );
+    }
+    else if (!init_region( &newReg, size )) return FALSE;
 
     /*
      * Initialize ybot and ytop.
@@ -1749,7 +1869,7 @@ static BOOL REGION_RegionOp(
 
             if ((top != bot) && (nonOverlap1Func != NULL))
 	    {
-		if (!nonOverlap1Func(&newReg, r1, r1BandEnd, top, bot)) return FALSE;
+		if (!nonOverlap1Func(&newReg, r1, r1BandEnd, top, bot)) goto error;
 	    }
 
 	    ytop = r2->top;
@@ -1761,7 +1881,7 @@ static BOOL REGION_RegionOp(
 
             if ((top != bot) && (nonOverlap2Func != NULL))
 	    {
-		if (!nonOverlap2Func(&newReg, r2, r2BandEnd, top, bot)) return FALSE;
+		if (!nonOverlap2Func(&newReg, r2, r2BandEnd, top, bot)) goto error;
 	    }
 
 	    ytop = r1->top;
@@ -1790,7 +1910,7 @@ static BOOL REGION_RegionOp(
 	curBand = newReg.numRects;
 	if (ybot > ytop)
 	{
-	    if (!overlapFunc(&newReg, r1, r1BandEnd, r2, r2BandEnd, ytop, ybot)) return FALSE;
+	    if (!overlapFunc(&newReg, r1, r1BandEnd, r2, r2BandEnd, ytop, ybot)) goto error;
 	}
 
 	if (newReg.numRects != curBand)
@@ -1828,7 +1948,7 @@ static BOOL REGION_RegionOp(
 		    r1BandEnd++;
 		}
 		if (!nonOverlap1Func(&newReg, r1, r1BandEnd, max(r1->top,ybot), r1->bottom))
-                    return FALSE;
+                    goto error;
 		r1 = r1BandEnd;
 	    } while (r1 != r1End);
 	}
@@ -1843,7 +1963,7 @@ static BOOL REGION_RegionOp(
 		 r2BandEnd++;
 	    }
 	    if (!nonOverlap2Func(&newReg, r2, r2BandEnd, max(r2->top,ybot), r2->bottom))
-                return FALSE;
+                goto error;
 	    r2 = r2BandEnd;
 	} while (r2 != r2End);
     }
@@ -1856,6 +1976,10 @@ static BOOL REGION_RegionOp(
     REGION_compact( &newReg );
     move_rects( destReg, &newReg );
     return TRUE;
+
+error:
+    destroy_region( &newReg );
+    return FALSE;
 }
 
 /***********************************************************************
@@ -2702,14 +2826,11 @@ static void scan_convert( WINEREGION *obj, EdgeTable *ET, INT mode, const RECT *
 }
 
 /***********************************************************************
- *           create_polypolygon_region
- *
- * Helper for CreatePolyPolygonRgn.
+ *           create_polypolygon_obj
  */
-HRGN create_polypolygon_region( const POINT *Pts, const INT *Count, INT nbpolygons, INT mode,
-                                const RECT *clip_rect )
+static WINEREGION *create_polypolygon_obj( const POINT *Pts, const INT *Count, INT nbpolygons, INT mode,
+                                           const RECT *clip_rect )
 {
-    HRGN hrgn = 0;
     WINEREGION *obj = NULL;
     EdgeTable ET;                    /* header node for ET      */
     EdgeTableEntry *pETEs;           /* EdgeTableEntries pool   */
@@ -2731,25 +2852,49 @@ HRGN create_polypolygon_region( const POINT *Pts, const INT *Count, INT nbpolygo
 	  (Pts[1].y == Pts[2].y) &&
 	  (Pts[2].x == Pts[3].x) &&
 	  (Pts[3].y == Pts[0].y))))
-        return CreateRectRgn( min(Pts[0].x, Pts[2].x), min(Pts[0].y, Pts[2].y),
-                              max(Pts[0].x, Pts[2].x), max(Pts[0].y, Pts[2].y) );
+    {
+        if (!(obj = alloc_region( 1 ))) return NULL;
+        if (Pts[0].x != Pts[2].x && Pts[0].y != Pts[2].y)
+        {
+            obj->extents.left = min( Pts[0].x, Pts[2].x );
+            obj->extents.top = min( Pts[0].y, Pts[2].y );
+            obj->extents.right = max( Pts[0].x, Pts[2].x );
+            obj->extents.bottom = max( Pts[0].y, Pts[2].y );
+            obj->rects[0] = obj->extents;
+            obj->numRects = 1;
+        }
+        return obj;
+    }
 
     for(poly = total = 0; poly < nbpolygons; poly++)
         total += Count[poly];
     if (! (pETEs = HeapAlloc( GetProcessHeap(), 0, sizeof(EdgeTableEntry) * total )))
-	return 0;
+	return NULL;
 
     nb_points = REGION_CreateEdgeTable( Count, nbpolygons, Pts, &ET, pETEs, &SLLBlock, clip_rect );
     if ((obj = alloc_region( nb_points / 2 )))
     {
         if (nb_points) scan_convert( obj, &ET, mode, clip_rect );
-
-        if (!(hrgn = alloc_gdi_handle( obj, OBJ_REGION, &region_funcs )))
-            free_region( obj );
     }
 
     REGION_FreeStorage(SLLBlock.next);
     HeapFree( GetProcessHeap(), 0, pETEs );
+    return obj;
+}
+
+/***********************************************************************
+ *           create_polypolygon_region
+ *
+ * Helper for CreatePolyPolygonRgn.
+ */
+HRGN create_polypolygon_region( const POINT *Pts, const INT *Count, INT nbpolygons, INT mode,
+                                const RECT *clip_rect )
+{
+    WINEREGION *obj;
+    HRGN hrgn;
+
+    if (!(obj = create_polypolygon_obj( Pts, Count, nbpolygons, mode, clip_rect ))) return 0;
+    if (!(hrgn = alloc_gdi_handle( obj, OBJ_REGION, &region_funcs ))) free_region( obj );
     return hrgn;
 }
 
@@ -3620,6 +3620,116 @@ static void test_StretchDIBits(void)
     DeleteDC(hdcScreen);
 }
 
+static BYTE blend_channel( BYTE dst, BYTE src, DWORD alpha )
+{
+    return (src * alpha + dst * (255 - alpha) + 127) / 255;
+}
+
+static DWORD expected_blend( DWORD dst, DWORD src, BLENDFUNCTION blend )
+{
+    DWORD i, alpha = blend.SourceConstantAlpha, ret = 0;
+
+    if (!(blend.AlphaFormat & AC_SRC_ALPHA))
+    {
+        for (i = 0; i < 32; i += 8) ret |= blend_channel( dst >> i, src >> i, alpha ) << i;
+        return ret;
+    }
+    for (i = 0; i < 32; i += 8) ret |= (((src >> i) & 0xff) * alpha + 127) / 255 << i;
+    alpha = ret >> 24;
+    for (i = 0; i < 32; i += 8) ret += (((dst >> i) & 0xff) * (255 - alpha) + 127) / 255 << i;
+    return ret;
+}
+
+static void test_GdiAlphaBlend_pixels(void)
+{
+    static const BYTE alphas[] = { 255, 200, 128, 1, 0 };
+    static const BYTE formats[] = { AC_SRC_ALPHA, 0 };
+    BITMAPINFO bmi = {{ sizeof(bmi.bmiHeader), 37, -4, 1, 32, BI_RGB }};
+    DWORD *src_bits, *dst_bits, *orig, seed = 12345, max_diff;
+    LARGE_INTEGER freq, start, end;
+    HBITMAP src_bmp, dst_bmp;
+    BLENDFUNCTION blend = { AC_SRC_OVER, 0, 255, AC_SRC_ALPHA };
+    HDC src_dc, dst_dc;
+    int i, j, k, width, count = 37 * 4;
+
+    src_dc = CreateCompatibleDC( 0 );
+    dst_dc = CreateCompatibleDC( 0 );
+    src_bmp = CreateDIBSection( src_dc, &bmi, DIB_RGB_COLORS, (void **)&src_bits, NULL, 0 );
+    dst_bmp = CreateDIBSection( dst_dc, &bmi, DIB_RGB_COLORS, (void **)&dst_bits, NULL, 0 );
+    SelectObject( src_dc, src_bmp );
+    SelectObject( dst_dc, dst_bmp );
+    orig = HeapAlloc( GetProcessHeap(), 0, count * sizeof(*orig) );
+
+    for (i = 0; i < count; i++)
+    {
+        DWORD alpha;
+
+        seed = seed * 1103515245 + 12345;
+        orig[i] = seed ^ (seed << 16);
+        seed = seed * 1103515245 + 12345;
+        alpha = (seed >> 16) & 0xff;
+        if (i % 5 == 0) alpha = 0xff;
+        if (i % 7 == 0) alpha = 0;
+        src_bits[i] = alpha << 24 | ((seed & 0xff) * alpha / 255) << 16 |
+                      (((seed >> 8) & 0xff) * alpha / 255) << 8 | ((seed >> 24) * alpha / 255);
+    }
+
+    /* every row width to exercise the vectorized paths and their tails */
+    for (i = 0; i < ARRAY_SIZE(formats); i++)
+    {
+        for (j = 0; j < ARRAY_SIZE(alphas); j++)
+        {
+            blend.AlphaFormat = formats[i];
+            blend.SourceConstantAlpha = alphas[j];
+            for (width = 1; width <= 37; width += (width < 20) ? 1 : 5)
+            {
+                memcpy( dst_bits, orig, count * sizeof(*orig) );
+                GdiAlphaBlend( dst_dc, 37 - width, 0, width, 4, src_dc, 0, 0, width, 4, blend );
+                max_diff = 0;
+                for (k = 0; k < count; k++)
+                {
+                    DWORD expect = orig[k];
+                    int c;
+
+                    if (k % 37 >= 37 - width) expect = expected_blend( orig[k], src_bits[k / 37 * 37 + k % 37 - (37 - width)], blend );
+                    for (c = 0; c < 32; c += 8)
+                        max_diff = max( max_diff, abs( (int)((dst_bits[k] >> c) & 0xff) - (int)((expect >> c) & 0xff) ));
+                }
+                ok( !max_diff || broken( max_diff <= 1 ),
+                    "format %x alpha %u width %u: max difference %u\n", formats[i], alphas[j], width, max_diff );
+            }
+        }
+    }
+
+    if (winetest_debug > 1)
+    {
+        bmi.bmiHeader.biWidth = 1024;
+        bmi.bmiHeader.biHeight = -1024;
+        src_bmp = CreateDIBSection( src_dc, &bmi, DIB_RGB_COLORS, NULL, NULL, 0 );
+        dst_bmp = CreateDIBSection( dst_dc, &bmi, DIB_RGB_COLORS, NULL, NULL, 0 );
+        DeleteObject( SelectObject( src_dc, src_bmp ));
+        DeleteObject( SelectObject( dst_dc, dst_bmp ));
+        QueryPerformanceFrequency( &freq );
+        for (i = 0; i < ARRAY_SIZE(formats); i++)
+        {
+            blend.AlphaFormat = formats[i];
+            blend.SourceConstantAlpha = 200;
+            QueryPerformanceCounter( &start );
+            for (j = 0; j < 20; j++)
+                GdiAlphaBlend( dst_dc, 0, 0, 1024, 1024, src_dc, 0, 0, 1024, 1024, blend );
+            QueryPerformanceCounter( &end );
+            trace( "format %x: %.2f ms per 1024x1024 blend\n", formats[i],
+                   (end.QuadPart - start.QuadPart) * 1000.0 / freq.QuadPart / 20 );
+        }
+    }
+
+    HeapFree( GetProcessHeap(), 0, orig );
+    DeleteDC( src_dc );
+    DeleteDC( dst_dc );
+    DeleteObject( src_bmp );
+    DeleteObject( dst_bmp );
+}
+
 static void test_GdiAlphaBlend(void)
 {
     HDC hdcNull;
@@ -5965,6 +6075,7 @@ START_TEST(bitmap)
     test_StretchBlt();
     test_StretchDIBits();
     test_GdiAlphaBlend();
+    test_GdiAlphaBlend_pixels();
     test_GdiGradientFill();
     test_32bit_ddb();
     test_bitmapinfoheadersize();
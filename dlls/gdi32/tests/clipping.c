@@ -554,6 +554,156 @@ static void test_CreatePolyPolygonRgn(void)
     DeleteObject(region);
 }
 
+static void get_test_rects(RECT *rects, int count, int columns, unsigned int seed)
+{
+    int i, j;
+    RECT tmp;
+
+    /* overlapping grids of window-like rectangles */
+    for (i = 0; i < count; i++)
+    {
+        int x = (i % columns) * 12 + (i / (columns * columns)) * 5;
+        int y = ((i / columns) % columns) * 9 + (i / (columns * columns)) * 3;
+        SetRect(&rects[i], x, y, x + 10 + i % 3, y + 7 + i % 5);
+    }
+    /* shuffle them */
+    for (i = count - 1; i > 0; i--)
+    {
+        seed = seed * 1103515245 + 12345;
+        j = (seed >> 8) % (i + 1);
+        tmp = rects[i];
+        rects[i] = rects[j];
+        rects[j] = tmp;
+    }
+}
+
+static HRGN create_region_from_rects(const RECT *rects, int count, const XFORM *xform)
+{
+    RGNDATA *data = HeapAlloc(GetProcessHeap(), 0, FIELD_OFFSET(RGNDATA, Buffer[count * sizeof(RECT)]));
+    HRGN hrgn;
+
+    data->rdh.dwSize = sizeof(data->rdh);
+    data->rdh.iType = RDH_RECTANGLES;
+    data->rdh.nCount = count;
+    data->rdh.nRgnSize = count * sizeof(RECT);
+    SetRectEmpty(&data->rdh.rcBound);
+    memcpy(data->Buffer, rects, count * sizeof(RECT));
+    hrgn = ExtCreateRegion(xform, FIELD_OFFSET(RGNDATA, Buffer[count * sizeof(RECT)]), data);
+    HeapFree(GetProcessHeap(), 0, data);
+    return hrgn;
+}
+
+static void test_complex_regions(void)
+{
+    static const int counts[] = { 400, 1600, 12000 };
+    HRGN hrgn, ref, copy, tmp;
+    RGNDATA *data;
+    DWORD size, start;
+    RECT *rects, rc;
+    XFORM xform;
+    int i, j, k, count;
+    BOOL ret, expect;
+
+    for (i = 0; i < ARRAY_SIZE(counts); i++)
+    {
+        count = counts[i];
+        rects = HeapAlloc(GetProcessHeap(), 0, count * sizeof(*rects));
+        get_test_rects(rects, count, 40, count);
+
+        start = GetTickCount();
+        hrgn = create_region_from_rects(rects, count, NULL);
+        ok(hrgn != 0, "%d: ExtCreateRegion failed\n", count);
+        if (winetest_debug > 1)
+            trace("%d rects: ExtCreateRegion %u ms\n", count, GetTickCount() - start);
+
+        if (count <= 1600)
+        {
+            /* build the same region one rectangle at a time */
+            ref = CreateRectRgn(0, 0, 0, 0);
+            tmp = CreateRectRgn(0, 0, 0, 0);
+            for (j = 0; j < count; j++)
+            {
+                SetRectRgn(tmp, rects[j].left, rects[j].top, rects[j].right, rects[j].bottom);
+                CombineRgn(ref, ref, tmp, RGN_OR);
+            }
+            ok(EqualRgn(hrgn, ref), "%d: regions differ\n", count);
+            DeleteObject(tmp);
+            DeleteObject(ref);
+        }
+
+        /* the data of a region is already banded */
+        size = GetRegionData(hrgn, 0, NULL);
+        data = HeapAlloc(GetProcessHeap(), 0, size);
+        ok(GetRegionData(hrgn, size, data) == size, "%d: GetRegionData failed\n", count);
+        start = GetTickCount();
+        copy = ExtCreateRegion(NULL, size, data);
+        ok(copy != 0, "%d: ExtCreateRegion failed\n", count);
+        ok(EqualRgn(hrgn, copy), "%d: regions differ\n", count);
+        if (winetest_debug > 1)
+            trace("%d rects: ExtCreateRegion from %u banded rects %u ms\n", count,
+                  data->rdh.nCount, GetTickCount() - start);
+        HeapFree(GetProcessHeap(), 0, data);
+
+        /* typical clip operations */
+        start = GetTickCount();
+        tmp = CreateRectRgn(0, 0, 0, 0);
+        OffsetRgn(copy, 3, 2);
+        CombineRgn(tmp, hrgn, copy, RGN_AND);
+        CombineRgn(tmp, hrgn, copy, RGN_DIFF);
+        CombineRgn(tmp, tmp, copy, RGN_XOR);
+        CombineRgn(tmp, tmp, hrgn, RGN_OR);
+        if (winetest_debug > 1)
+            trace("%d rects: CombineRgn %u ms\n", count, GetTickCount() - start);
+        DeleteObject(tmp);
+        DeleteObject(copy);
+
+        start = GetTickCount();
+        for (j = 0; j < 2000; j++)
+        {
+            int x = (j * 37) % 500 - 10, y = (j * 53) % 400 - 10;
+
+            for (k = 0, expect = FALSE; k < count && !expect; k++)
+                expect = (x >= rects[k].left && x < rects[k].right && y >= rects[k].top && y < rects[k].bottom);
+            ret = PtInRegion(hrgn, x, y);
+            ok(ret == expect, "%d: wrong result %d for %d,%d\n", count, ret, x, y);
+
+            /* an empty rectangle hits the region when its corner lies strictly inside
+             * the extents and inside a region rectangle, which a plain overlap test
+             * doesn't model, so only test non-empty ones */
+            SetRect(&rc, x, y, x + 1 + j % 7, y + 1 + j % 40);
+            for (k = 0, expect = FALSE; k < count && !expect; k++)
+                expect = (rc.left < rects[k].right && rc.right > rects[k].left &&
+                          rc.top < rects[k].bottom && rc.bottom > rects[k].top);
+            ret = RectInRegion(hrgn, &rc);
+            ok(ret == expect, "%d: wrong result %d for %s\n", count, ret, wine_dbgstr_rect(&rc));
+        }
+        if (winetest_debug > 1)
+            trace("%d rects: hit tests %u ms\n", count, GetTickCount() - start);
+
+        /* scaled rectangles are still rectangles */
+        if (count <= 1600)
+        {
+            memset(&xform, 0, sizeof(xform));
+            xform.eM11 = 2.0;
+            xform.eM22 = 2.0;
+            xform.eDx = 10.0;
+            xform.eDy = -4.0;
+            ref = create_region_from_rects(rects, count, &xform);
+            ok(ref != 0, "%d: ExtCreateRegion failed\n", count);
+            for (j = 0; j < count; j++)
+                SetRect(&rects[j], rects[j].left * 2 + 10, rects[j].top * 2 - 4,
+                        rects[j].right * 2 + 10, rects[j].bottom * 2 - 4);
+            copy = create_region_from_rects(rects, count, NULL);
+            ok(EqualRgn(ref, copy), "%d: regions differ\n", count);
+            DeleteObject(copy);
+            DeleteObject(ref);
+        }
+
+        DeleteObject(hrgn);
+        HeapFree(GetProcessHeap(), 0, rects);
+    }
+}
+
 START_TEST(clipping)
 {
     test_GetRandomRgn();
@@ -562,4 +712,5 @@ START_TEST(clipping)
     test_memory_dc_clipping();
     test_window_dc_clipping();
     test_CreatePolyPolygonRgn();
+    test_complex_regions();
 }
@@ -26,6 +26,7 @@
 #include "winbase.h"
 #include "wingdi.h"
 #include "winuser.h"
+#include "winreg.h"
 #include "wincrypt.h"
 #include "mmsystem.h" /* DIBINDEX */
 
@@ -3123,9 +3124,68 @@ static void draw_text_2( HDC hdc, const BITMAPINFO *bmi, BYTE *bits, BOOL aa )
     DeleteObject( font );
 }
 
+/* a long string drawn in one call must match the glyphs drawn one by one, including with a complex clip region */
+static void draw_text_run( HDC hdc, const BITMAPINFO *bmi, BYTE *bits, BOOL aa )
+{
+    DWORD dib_size = get_dib_size(bmi);
+    static const char str[] = "The quick brown fox jumps over the lazy dog, "
+                              "THE QUICK BROWN FOX JUMPS OVER THE LAZY DOG 0123456789";
+    INT dx[ARRAY_SIZE(str)];
+    char *run_hash, *glyph_hash;
+    HRGN clip, rgn;
+    LOGFONTA lf;
+    HFONT font;
+    SIZE size;
+    int i, x;
+
+    memset( &lf, 0, sizeof(lf) );
+    strcpy( lf.lfFaceName, "Tahoma" );
+    lf.lfHeight = 14;
+    lf.lfQuality = aa ? ANTIALIASED_QUALITY : NONANTIALIASED_QUALITY;
+    font = SelectObject( hdc, CreateFontIndirectA( &lf ));
+
+    clip = CreateRectRgn( 0, 0, 0, 0 );
+    for (i = 0; i < 8; i++)
+    {
+        rgn = CreateRectRgn( i * 70, 90 + (i % 3) * 3, i * 70 + 50, 120 - (i % 2) * 4 );
+        CombineRgn( clip, clip, rgn, RGN_OR );
+        DeleteObject( rgn );
+    }
+    ExtSelectClipRgn( hdc, clip, RGN_COPY );
+
+    SetTextColor( hdc, RGB(0x20, 0x80, 0xc0) );
+    SetTextAlign( hdc, TA_BASELINE );
+    SetBkMode( hdc, TRANSPARENT );
+
+    /* overlap the glyphs a bit to check the drawing order */
+    for (i = 0; i < strlen(str); i++)
+    {
+        GetTextExtentPoint32A( hdc, str + i, 1, &size );
+        dx[i] = size.cx - 1;
+    }
+
+    memset( bits, 0x55, dib_size );
+    ExtTextOutA( hdc, 5, 110, 0, NULL, str, strlen(str), dx );
+    run_hash = hash_dib( hdc, bmi, bits );
+
+    memset( bits, 0x55, dib_size );
+    for (i = 0, x = 5; i < strlen(str); x += dx[i++])
+        ExtTextOutA( hdc, x, 110, 0, NULL, str + i, 1, NULL );
+    glyph_hash = hash_dib( hdc, bmi, bits );
+
+    ok( !strcmp( run_hash, glyph_hash ), "hash mismatch - aa %d\n", aa );
+
+    HeapFree( GetProcessHeap(), 0, run_hash );
+    HeapFree( GetProcessHeap(), 0, glyph_hash );
+    ExtSelectClipRgn( hdc, NULL, RGN_COPY );
+    DeleteObject( clip );
+    DeleteObject( SelectObject( hdc, font ));
+}
+
 static void draw_text( HDC hdc, const BITMAPINFO *bmi, BYTE *bits )
 {
     draw_text_2( hdc, bmi, bits, FALSE );
+    draw_text_run( hdc, bmi, bits, FALSE );
 
     /* Rounding errors make these cases hard to test */
     if ((bmi->bmiHeader.biCompression == BI_BITFIELDS && ((DWORD*)bmi->bmiColors)[0] == 0x3f000) ||
@@ -3133,6 +3193,7 @@ static void draw_text( HDC hdc, const BITMAPINFO *bmi, BYTE *bits )
         return;
 
     draw_text_2( hdc, bmi, bits, TRUE );
+    draw_text_run( hdc, bmi, bits, TRUE );
 }
 
 static void test_simple_graphics(void)
@@ -3516,11 +3577,187 @@ static void test_simple_graphics(void)
     DeleteDC(mem_dc);
 }
 
+#define BANDS_WIDTH  1024
+#define BANDS_HEIGHT 1024
+
+static HBITMAP create_bands_dib( HDC hdc, int width, int height, DWORD **bits )
+{
+    BITMAPINFO bmi;
+
+    memset( &bmi, 0, sizeof(bmi) );
+    bmi.bmiHeader.biSize        = sizeof(bmi.bmiHeader);
+    bmi.bmiHeader.biWidth       = width;
+    bmi.bmiHeader.biHeight      = -height;
+    bmi.bmiHeader.biPlanes      = 1;
+    bmi.bmiHeader.biBitCount    = 32;
+    bmi.bmiHeader.biCompression = BI_RGB;
+    return CreateDIBSection( hdc, &bmi, DIB_RGB_COLORS, (void **)bits, NULL, 0 );
+}
+
+/* draw operations large enough to be split in bands, each in its own quarter of the bitmap */
+static void draw_bands( DWORD *dst_bits )
+{
+    static const BLENDFUNCTION blend = { AC_SRC_OVER, 0, 0xc0, AC_SRC_ALPHA };
+    TRIVERTEX vert[2] = { { 0, 512, 0xff00, 0x8000, 0x1200, 0 },
+                          { BANDS_WIDTH, 768, 0x0800, 0x7700, 0xfe00, 0 } };
+    GRADIENT_RECT rect = { 0, 1 };
+    HDC hdc, src_dc;
+    HBITMAP dib, src_dib, old_bm, old_src_bm;
+    HBRUSH brush, old_brush;
+    DWORD *bits, *src_bits;
+    int x, y;
+
+    hdc = CreateCompatibleDC( NULL );
+    src_dc = CreateCompatibleDC( NULL );
+    dib = create_bands_dib( hdc, BANDS_WIDTH, BANDS_HEIGHT, &bits );
+    old_bm = SelectObject( hdc, dib );
+
+    /* enlarged, with rows duplicated across bands */
+    src_dib = create_bands_dib( src_dc, 100, 37, &src_bits );
+    for (y = 0; y < 37; y++)
+        for (x = 0; x < 100; x++) src_bits[y * 100 + x] = (x * 0x030507) ^ (y * 0x110d0b);
+    old_src_bm = SelectObject( src_dc, src_dib );
+    StretchBlt( hdc, 0, 0, BANDS_WIDTH, 256, src_dc, 0, 0, 100, 37, SRCCOPY );
+    SelectObject( src_dc, old_src_bm );
+    DeleteObject( src_dib );
+
+    /* shrunk, with source rows merged */
+    src_dib = create_bands_dib( src_dc, 1500, 700, &src_bits );
+    for (y = 0; y < 700; y++)
+        for (x = 0; x < 1500; x++) src_bits[y * 1500 + x] = ((x * 7 + y * 3) % 11) ? 0xffffff : 0x000000;
+    old_src_bm = SelectObject( src_dc, src_dib );
+    SetStretchBltMode( hdc, BLACKONWHITE );
+    StretchBlt( hdc, 0, 256, BANDS_WIDTH, 256, src_dc, 0, 0, 1500, 700, SRCCOPY );
+    SelectObject( src_dc, old_src_bm );
+    DeleteObject( src_dib );
+
+    /* gradient, then premultiplied alpha blended over it */
+    GdiGradientFill( hdc, vert, 2, &rect, 1, GRADIENT_FILL_RECT_H );
+    src_dib = create_bands_dib( src_dc, BANDS_WIDTH, 256, &src_bits );
+    for (y = 0; y < 256; y++)
+        for (x = 0; x < BANDS_WIDTH; x++)
+        {
+            BYTE alpha = x + y;
+            src_bits[y * BANDS_WIDTH + x] = alpha << 24 | (alpha / 2) << 16 | (alpha / 3) << 8 | (y & alpha);
+        }
+    old_src_bm = SelectObject( src_dc, src_dib );
+    GdiAlphaBlend( hdc, 0, 512, BANDS_WIDTH, 256, src_dc, 0, 0, BANDS_WIDTH, 256, blend );
+    SelectObject( src_dc, old_src_bm );
+    DeleteObject( src_dib );
+
+    /* solid fill and inversion */
+    brush = CreateSolidBrush( RGB( 0x12, 0x34, 0x56 ));
+    old_brush = SelectObject( hdc, brush );
+    PatBlt( hdc, 0, 768, BANDS_WIDTH, 256, PATCOPY );
+    SelectObject( hdc, old_brush );
+    DeleteObject( brush );
+    brush = CreateSolidBrush( RGB( 0xf0, 0x0f, 0x5a ));
+    old_brush = SelectObject( hdc, brush );
+    PatBlt( hdc, 0, 768, BANDS_WIDTH, 256, PATINVERT );
+    SelectObject( hdc, old_brush );
+    DeleteObject( brush );
+
+    GdiFlush();
+    memcpy( dst_bits, bits, BANDS_WIDTH * BANDS_HEIGHT * sizeof(*bits) );
+
+    SelectObject( hdc, old_bm );
+    DeleteObject( dib );
+    DeleteDC( src_dc );
+    DeleteDC( hdc );
+}
+
+static void test_bands_child( const char *filename )
+{
+    DWORD *bits, size;
+    HANDLE file;
+    BOOL ret;
+
+    bits = HeapAlloc( GetProcessHeap(), 0, BANDS_WIDTH * BANDS_HEIGHT * sizeof(*bits) );
+    draw_bands( bits );
+    file = CreateFileA( filename, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, NULL );
+    ok( file != INVALID_HANDLE_VALUE, "CreateFile failed, error %u\n", GetLastError() );
+    ret = WriteFile( file, bits, BANDS_WIDTH * BANDS_HEIGHT * sizeof(*bits), &size, NULL );
+    ok( ret, "WriteFile failed, error %u\n", GetLastError() );
+    CloseHandle( file );
+    HeapFree( GetProcessHeap(), 0, bits );
+}
+
+static void test_bands(void)
+{
+    static const char keyA[] = "Software\\Wine\\Gdi";
+    char cmdline[MAX_PATH * 2], path[MAX_PATH], filename[MAX_PATH], **argv;
+    DWORD *serial, *banded, threads = 4, size, old_threads, disposition;
+    PROCESS_INFORMATION info;
+    STARTUPINFOA startup;
+    BOOL restore;
+    HANDLE file;
+    HKEY key;
+    int i;
+
+    /* DibThreads is read once per process, so the banded output is produced in a child */
+    serial = HeapAlloc( GetProcessHeap(), 0, BANDS_WIDTH * BANDS_HEIGHT * sizeof(*serial) );
+    banded = HeapAlloc( GetProcessHeap(), 0, BANDS_WIDTH * BANDS_HEIGHT * sizeof(*banded) );
+    draw_bands( serial );
+
+    if (RegCreateKeyExA( HKEY_CURRENT_USER, keyA, 0, NULL, 0, KEY_ALL_ACCESS, NULL, &key, &disposition ))
+    {
+        skip( "can't create the Gdi key\n" );
+        goto done;
+    }
+    size = sizeof(old_threads);
+    restore = !RegQueryValueExA( key, "DibThreads", NULL, NULL, (BYTE *)&old_threads, &size );
+    RegSetValueExA( key, "DibThreads", 0, REG_DWORD, (BYTE *)&threads, sizeof(threads) );
+
+    GetTempPathA( sizeof(path), path );
+    GetTempFileNameA( path, "dib", 0, filename );
+    winetest_get_mainargs( &argv );
+    sprintf( cmdline, "\"%s\" dib bands \"%s\"", argv[0], filename );
+    memset( &startup, 0, sizeof(startup) );
+    startup.cb = sizeof(startup);
+    ok( CreateProcessA( NULL, cmdline, NULL, NULL, FALSE, 0, NULL, NULL, &startup, &info ),
+        "CreateProcess failed, error %u\n", GetLastError() );
+    wait_child_process( info.hProcess );
+    CloseHandle( info.hProcess );
+    CloseHandle( info.hThread );
+
+    if (restore) RegSetValueExA( key, "DibThreads", 0, REG_DWORD, (BYTE *)&old_threads, sizeof(old_threads) );
+    else RegDeleteValueA( key, "DibThreads" );
+    RegCloseKey( key );
+    if (disposition == REG_CREATED_NEW_KEY) RegDeleteKeyA( HKEY_CURRENT_USER, keyA );
+
+    file = CreateFileA( filename, GENERIC_READ, 0, NULL, OPEN_EXISTING, 0, NULL );
+    ok( file != INVALID_HANDLE_VALUE, "CreateFile failed, error %u\n", GetLastError() );
+    memset( banded, 0, BANDS_WIDTH * BANDS_HEIGHT * sizeof(*banded) );
+    ReadFile( file, banded, BANDS_WIDTH * BANDS_HEIGHT * sizeof(*banded), &size, NULL );
+    CloseHandle( file );
+    DeleteFileA( filename );
+    ok( size == BANDS_WIDTH * BANDS_HEIGHT * sizeof(*banded), "got size %u\n", size );
+
+    for (i = 0; i < BANDS_WIDTH * BANDS_HEIGHT; i++) if (serial[i] != banded[i]) break;
+    if (i < BANDS_WIDTH * BANDS_HEIGHT)
+        ok( 0, "row %u col %u: got %08x, expected %08x\n",
+            i / BANDS_WIDTH, i % BANDS_WIDTH, banded[i], serial[i] );
+
+done:
+    HeapFree( GetProcessHeap(), 0, serial );
+    HeapFree( GetProcessHeap(), 0, banded );
+}
+
 START_TEST(dib)
 {
+    char **argv;
+
+    if (winetest_get_mainargs( &argv ) >= 4 && !strcmp( argv[2], "bands" ))
+    {
+        test_bands_child( argv[3] );
+        return;
+    }
+
     CryptAcquireContextW(&crypt_prov, NULL, NULL, PROV_RSA_FULL, CRYPT_VERIFYCONTEXT);
 
     test_simple_graphics();
 
     CryptReleaseContext(crypt_prov, 0);
+
+    test_bands();
 }
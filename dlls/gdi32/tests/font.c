@@ -28,6 +28,7 @@
 #include "wingdi.h"
 #include "winuser.h"
 #include "winnls.h"
+#include "winreg.h"
 
 #include "wine/heap.h"
 #include "wine/test.h"
@@ -5874,6 +5875,65 @@ static void test_GetGlyphOutline_character(void)
     ReleaseDC(NULL, hdc);
 }
 
+/* glyphs must be the same when the font is created again with different non-glyph attributes */
+static void test_GetGlyphOutline_recreated_font(void)
+{
+    static const UINT formats[] = { GGO_BITMAP, GGO_GRAY8_BITMAP, GGO_NATIVE, GGO_BEZIER };
+    GLYPHMETRICS gm1, gm2;
+    HFONT hfont, hfont_old;
+    BYTE *buf1, *buf2;
+    DWORD size1, size2;
+    LOGFONTA lf;
+    HDC hdc;
+    int i;
+
+    if (!is_truetype_font_installed("Tahoma"))
+    {
+        skip("Tahoma is not installed\n");
+        return;
+    }
+
+    hdc = CreateCompatibleDC(0);
+    memset(&lf, 0, sizeof(lf));
+    lf.lfHeight = -27;
+    lstrcpyA(lf.lfFaceName, "Tahoma");
+
+    for (i = 0; i < ARRAY_SIZE(formats); i++)
+    {
+        lf.lfUnderline = FALSE;
+        hfont = CreateFontIndirectA(&lf);
+        hfont_old = SelectObject(hdc, hfont);
+        size1 = GetGlyphOutlineA(hdc, 'g', formats[i], &gm1, 0, NULL, &mat);
+        ok(size1 != GDI_ERROR && size1, "%u: GetGlyphOutlineA failed\n", formats[i]);
+        buf1 = HeapAlloc(GetProcessHeap(), 0, size1);
+        memset(&gm1, 0xcc, sizeof(gm1));
+        size2 = GetGlyphOutlineA(hdc, 'g', formats[i], &gm1, size1, buf1, &mat);
+        ok(size2 == size1, "%u: got size %u, expected %u\n", formats[i], size2, size1);
+        DeleteObject(SelectObject(hdc, hfont_old));
+
+        lf.lfUnderline = TRUE;
+        hfont = CreateFontIndirectA(&lf);
+        hfont_old = SelectObject(hdc, hfont);
+        buf2 = HeapAlloc(GetProcessHeap(), HEAP_ZERO_MEMORY, size1);
+        memset(&gm2, 0xcc, sizeof(gm2));
+        size2 = GetGlyphOutlineA(hdc, 'g', formats[i], &gm2, size1, buf2, &mat);
+        ok(size2 == size1, "%u: got size %u, expected %u\n", formats[i], size2, size1);
+        ok(!memcmp(&gm1, &gm2, sizeof(gm1)), "%u: glyph metrics differ\n", formats[i]);
+        ok(!memcmp(buf1, buf2, size1), "%u: glyph data differs\n", formats[i]);
+
+        memset(&gm2, 0xcc, sizeof(gm2));
+        size2 = GetGlyphOutlineA(hdc, 'g', formats[i], &gm2, 0, NULL, &mat);
+        ok(size2 == size1, "%u: got size %u, expected %u\n", formats[i], size2, size1);
+        ok(!memcmp(&gm1, &gm2, sizeof(gm1)), "%u: glyph metrics differ\n", formats[i]);
+
+        DeleteObject(SelectObject(hdc, hfont_old));
+        HeapFree(GetProcessHeap(), 0, buf1);
+        HeapFree(GetProcessHeap(), 0, buf2);
+    }
+
+    DeleteDC(hdc);
+}
+
 static void test_fstype_fixup(void)
 {
     HDC hdc;
@@ -7651,6 +7711,122 @@ done:
     ReleaseDC(0, hdc);
 }
 
+static INT CALLBACK count_families_proc( const LOGFONTA *lf, const TEXTMETRICA *tm, DWORD type, LPARAM lparam )
+{
+    (*(DWORD *)lparam)++;
+    return 1;
+}
+
+static DWORD count_font_families(void)
+{
+    LOGFONTA lf;
+    DWORD count = 0;
+    HDC hdc = GetDC( 0 );
+
+    memset( &lf, 0, sizeof(lf) );
+    lf.lfCharSet = DEFAULT_CHARSET;
+    EnumFontFamiliesExA( hdc, &lf, count_families_proc, (LPARAM)&count, 0 );
+    ReleaseDC( 0, hdc );
+    return count;
+}
+
+/* the font list is only built from the font files, and the index, when the volatile cache is missing */
+static DWORD count_font_families_uncached(void)
+{
+    PROCESS_INFORMATION info;
+    STARTUPINFOA startup;
+    char cmdline[MAX_PATH + 32], **argv;
+    DWORD count = 0;
+
+    RegDeleteTreeA( HKEY_CURRENT_USER, "Software\\Wine\\Fonts\\Cache" );
+
+    winetest_get_mainargs( &argv );
+    sprintf( cmdline, "\"%s\" font count_families", argv[0] );
+    memset( &startup, 0, sizeof(startup) );
+    startup.cb = sizeof(startup);
+    if (!CreateProcessA( NULL, cmdline, NULL, NULL, FALSE, 0, NULL, NULL, &startup, &info ))
+    {
+        ok( 0, "CreateProcess failed, error %u\n", GetLastError() );
+        return 0;
+    }
+    wait_child_process( info.hProcess );
+    GetExitCodeProcess( info.hProcess, &count );
+    CloseHandle( info.hProcess );
+    CloseHandle( info.hThread );
+    return count;
+}
+
+static HANDLE open_font_index(void)
+{
+    char path[MAX_PATH], *name = path;
+    DWORD len = GetEnvironmentVariableA( "WINECONFIGDIR", path, MAX_PATH - 16 );
+
+    if (!len || len >= MAX_PATH - 16) return INVALID_HANDLE_VALUE;
+    strcat( path, "\\fontindex" );
+    if (path[5] == ':') name += 4;  /* \??\C:\ */
+    else path[1] = '\\';            /* \??\unix\ to \\?\unix\ */
+    return CreateFileA( name, GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_EXISTING, 0, NULL );
+}
+
+static void test_font_index(void)
+{
+    struct
+    {
+        DWORD magic;
+        DWORD version;
+        DWORD lcid;
+        DWORD ft_version;
+        DWORD size;
+        DWORD count;
+        DWORD hash[1024];
+    } header;
+    DWORD count, size, bucket, value;
+    HANDLE file;
+
+    /* Wine keeps the faces of the font files in an index in the prefix */
+    if (strcmp( winetest_platform, "wine" ))
+    {
+        skip( "no font index\n" );
+        return;
+    }
+    if ((file = open_font_index()) == INVALID_HANDLE_VALUE)
+    {
+        skip( "no font index, error %u\n", GetLastError() );
+        return;
+    }
+    ok( ReadFile( file, &header, sizeof(header), &size, NULL ) && size == sizeof(header),
+        "ReadFile failed, error %u\n", GetLastError() );
+    ok( header.magic == 0x78646e69, "got magic %#x\n", header.magic );
+    for (bucket = 0; bucket < ARRAY_SIZE(header.hash); bucket++) if (header.hash[bucket]) break;
+    if (bucket == ARRAY_SIZE(header.hash))
+    {
+        CloseHandle( file );
+        skip( "empty font index\n" );
+        return;
+    }
+
+    count = count_font_families();
+    ok( count > 0, "no font families\n" );
+    ok( count_font_families_uncached() == count, "font list built from the index differs\n" );
+
+    /* point a bucket in the middle of an entry, the index must be ignored and rewritten */
+    value = header.hash[bucket] + 4;
+    SetFilePointer( file, (char *)&header.hash[bucket] - (char *)&header, NULL, FILE_BEGIN );
+    ok( WriteFile( file, &value, sizeof(value), &size, NULL ), "WriteFile failed, error %u\n", GetLastError() );
+    CloseHandle( file );
+
+    ok( count_font_families_uncached() == count, "font list built with a corrupt index differs\n" );
+
+    file = open_font_index();
+    ok( file != INVALID_HANDLE_VALUE, "font index not rewritten, error %u\n", GetLastError() );
+    if (file == INVALID_HANDLE_VALUE) return;
+    memset( &header, 0, sizeof(header) );
+    ReadFile( file, &header, sizeof(header), &size, NULL );
+    ok( header.magic == 0x78646e69, "got magic %#x\n", header.magic );
+    ok( header.hash[bucket] != value, "corrupt font index not rewritten\n" );
+    CloseHandle( file );
+}
+
 START_TEST(font)
 {
     static const char *test_names[] =
@@ -7669,6 +7845,8 @@ START_TEST(font)
     {
         if (!strcmp(argv[2], "AddFontMemResource"))
             test_AddFontMemResource();
+        else if (!strcmp(argv[2], "count_families"))
+            ExitProcess( count_font_families() );
         return;
     }
 
@@ -7692,6 +7870,7 @@ START_TEST(font)
     test_height_selection();
     test_EnumFonts();
     test_EnumFonts_subst();
+    test_font_index();
 
     /* On Windows Arial has a lot of default charset aliases such as Arial Cyr,
      * I'd like to avoid them in this test.
@@ -7712,6 +7891,7 @@ START_TEST(font)
     test_RealizationInfo();
     test_GetTextFace();
     test_GetGlyphOutline();
+    test_GetGlyphOutline_recreated_font();
     test_GetTextMetrics2("Tahoma", -11);
     test_GetTextMetrics2("Tahoma", -55);
     test_GetTextMetrics2("Tahoma", -110);
@@ -362,6 +362,99 @@ static void test_handles_on_win64(void)
     }
 }
 
+struct drawing_thread
+{
+    HRGN shared[2];
+    unsigned int index;
+    unsigned int iterations;
+    LONG failures;
+};
+
+static DWORD WINAPI drawing_thread_proc(void *param)
+{
+    struct drawing_thread *info = param;
+    HRGN first = info->shared[info->index % 2], second = info->shared[(info->index + 1) % 2];
+    COLORREF color = RGB(info->index, 0x80, 0x40);
+    BITMAPINFO bmi = {{ sizeof(bmi.bmiHeader), 16, 16, 1, 32, BI_RGB }};
+    HBITMAP bitmap, old_bitmap;
+    HBRUSH brush, old_brush;
+    HRGN rgn;
+    void *bits;
+    LOGBRUSH lb;
+    LOGPEN lp;
+    unsigned int i;
+    HDC hdc;
+
+    hdc = CreateCompatibleDC(NULL);
+    bitmap = CreateDIBSection(NULL, &bmi, DIB_RGB_COLORS, &bits, NULL, 0);
+    old_bitmap = SelectObject(hdc, bitmap);
+    rgn = CreateRectRgn(0, 0, 0, 0);
+
+    for (i = 0; i < info->iterations; i++)
+    {
+        brush = CreateSolidBrush(color);
+        old_brush = SelectObject(hdc, brush);
+        if (!old_brush || !PatBlt(hdc, 0, 0, 16, 16, PATCOPY)) InterlockedIncrement(&info->failures);
+        if (GetObjectA(GetStockObject(BLACK_PEN), sizeof(lp), &lp) != sizeof(lp) ||
+            GetObjectA(brush, sizeof(lb), &lb) != sizeof(lb) || lb.lbColor != color)
+            InterlockedIncrement(&info->failures);
+        /* threads lock the shared regions in opposite orders */
+        if (CombineRgn(rgn, first, second, RGN_OR) != SIMPLEREGION || EqualRgn(first, second))
+            InterlockedIncrement(&info->failures);
+        SelectObject(hdc, old_brush);
+        if (!DeleteObject(brush)) InterlockedIncrement(&info->failures);
+    }
+    if (GetPixel(hdc, 8, 8) != color) InterlockedIncrement(&info->failures);
+
+    DeleteObject(rgn);
+    SelectObject(hdc, old_bitmap);
+    DeleteObject(bitmap);
+    DeleteDC(hdc);
+    return 0;
+}
+
+static void test_concurrent_drawing(void)
+{
+    struct drawing_thread info[8];
+    HANDLE threads[ARRAY_SIZE(info)];
+    unsigned int i, count;
+    HRGN shared[2];
+    DWORD start;
+    RECT rect;
+
+    shared[0] = CreateRectRgn(0, 0, 10, 10);
+    shared[1] = CreateRectRgn(0, 0, 10, 20);
+
+    for (count = 1; count <= ARRAY_SIZE(info); count *= 2)
+    {
+        start = GetTickCount();
+        for (i = 0; i < count; i++)
+        {
+            info[i].shared[0] = shared[0];
+            info[i].shared[1] = shared[1];
+            info[i].index = i;
+            info[i].iterations = winetest_interactive ? 100000 : 1000;
+            info[i].failures = 0;
+            threads[i] = CreateThread(NULL, 0, drawing_thread_proc, &info[i], 0, NULL);
+            ok(threads[i] != NULL, "CreateThread error %u\n", GetLastError());
+        }
+        WaitForMultipleObjects(count, threads, TRUE, INFINITE);
+        if (winetest_debug > 1)
+            trace("%u threads: %u ms for %u iterations per thread\n", count,
+                  GetTickCount() - start, info[0].iterations);
+        for (i = 0; i < count; i++)
+        {
+            ok(!info[i].failures, "%u threads: thread %u got %u failures\n", count, i, info[i].failures);
+            CloseHandle(threads[i]);
+        }
+    }
+
+    GetRgnBox(shared[0], &rect);
+    ok(rect.right == 10 && rect.bottom == 10, "got %s\n", wine_dbgstr_rect(&rect));
+    DeleteObject(shared[0]);
+    DeleteObject(shared[1]);
+}
+
 START_TEST(gdiobj)
 {
     test_gdi_objects();
@@ -369,4 +462,5 @@ START_TEST(gdiobj)
     test_GetCurrentObject();
     test_region();
     test_handles_on_win64();
+    test_concurrent_drawing();
 }
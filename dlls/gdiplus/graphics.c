@@ -895,7 +895,7 @@ PixelFormat apply_image_attributes(const GpImageAttributes *attributes, LPBYTE d
  * bitmap that contains all the pixels we may need to draw it. */
 static void get_bitmap_sample_size(InterpolationMode interpolation, WrapMode wrap,
     GpBitmap* bitmap, REAL srcx, REAL srcy, REAL srcwidth, REAL srcheight,
-    GpRect *rect)
+    REAL margin_x, REAL margin_y, GpRect *rect)
 {
     INT left, top, right, bottom;
 
@@ -903,13 +903,12 @@ static void get_bitmap_sample_size(InterpolationMode interpolation, WrapMode wra
     {
     case InterpolationModeHighQualityBilinear:
     case InterpolationModeHighQualityBicubic:
-    /* FIXME: Include a greater range for the prefilter? */
     case InterpolationModeBicubic:
     case InterpolationModeBilinear:
-        left = (INT)(floorf(srcx));
-        top = (INT)(floorf(srcy));
-        right = (INT)(ceilf(srcx+srcwidth));
-        bottom = (INT)(ceilf(srcy+srcheight));
+        left = (INT)(floorf(srcx - margin_x));
+        top = (INT)(floorf(srcy - margin_y));
+        right = (INT)(ceilf(srcx + srcwidth + margin_x));
+        bottom = (INT)(ceilf(srcy + srcheight + margin_y));
         break;
     case InterpolationModeNearestNeighbor:
     default:
@@ -1074,6 +1073,441 @@ static ARGB resample_bitmap_pixel(GDIPCONST GpRect *src_rect, LPBYTE bits, UINT
     }
 }
 
+/* operations with fewer pixels are not worth waking up worker threads */
+#define MIN_PARALLEL_PIXELS (256 * 1024)
+#define ROW_BANDS_PER_THREAD 4
+#define MAX_THREADS 16
+
+typedef GpStatus (*row_band_func)(void *ctx, INT start, INT end);
+
+struct row_bands
+{
+    row_band_func func;
+    void *ctx;
+    INT rows;
+    INT count;
+    LONG next;
+    LONG pending;     /* threads still processing bands, including the caller */
+    LONG status;
+    HANDLE done;
+};
+
+static void process_row_bands(struct row_bands *bands)
+{
+    GpStatus stat;
+    LONG band;
+
+    while ((band = InterlockedIncrement(&bands->next) - 1) < bands->count)
+    {
+        stat = bands->func(bands->ctx, (LONGLONG)band * bands->rows / bands->count,
+                           (LONGLONG)(band + 1) * bands->rows / bands->count);
+        if (stat != Ok) InterlockedCompareExchange(&bands->status, stat, Ok);
+    }
+    if (!InterlockedDecrement(&bands->pending)) SetEvent(bands->done);
+}
+
+static void CALLBACK row_bands_callback(TP_CALLBACK_INSTANCE *instance, void *context)
+{
+    process_row_bands(context);
+}
+
+/* Call func for consecutive ranges covering [0, rows), concurrently on the
+ * thread pool when there is enough work. The ranges must not depend on each
+ * other. */
+static GpStatus run_row_bands(INT rows, INT row_pixels, row_band_func func, void *ctx)
+{
+    static LONG threads;
+    struct row_bands bands;
+    SYSTEM_INFO info;
+    INT i;
+
+    if (!threads)
+    {
+        GetSystemInfo(&info);
+        InterlockedCompareExchange(&threads, min(max(info.dwNumberOfProcessors, 1), MAX_THREADS), 0);
+    }
+
+    if (rows < 2 || threads < 2 || (LONGLONG)rows * row_pixels < MIN_PARALLEL_PIXELS ||
+        !(bands.done = CreateEventW(NULL, TRUE, FALSE, NULL)))
+        return func(ctx, 0, rows);
+
+    bands.func = func;
+    bands.ctx = ctx;
+    bands.rows = rows;
+    bands.count = min(rows, threads * ROW_BANDS_PER_THREAD);
+    bands.next = 0;
+    bands.pending = 1;
+    bands.status = Ok;
+
+    for (i = 1; i < threads; i++)
+    {
+        InterlockedIncrement(&bands.pending);
+        if (!TrySubmitThreadpoolCallback(row_bands_callback, &bands, NULL))
+        {
+            InterlockedDecrement(&bands.pending);
+            break;
+        }
+    }
+    process_row_bands(&bands);
+    WaitForSingleObject(bands.done, INFINITE);
+    CloseHandle(bands.done);
+    return bands.status;
+}
+
+/* Source pixels and weights contributing to each destination column or row. */
+struct resample_axis
+{
+    INT *first;      /* first tap of each destination pixel, with one extra entry */
+    INT *pixels;     /* source pixel of each tap in the sample area, -1 outside of the bitmap */
+    float *weights;
+};
+
+static float linear_filter(float x)
+{
+    x = fabsf(x);
+    return x < 1.0f ? 1.0f - x : 0.0f;
+}
+
+/* Catmull-Rom spline */
+static float cubic_filter(float x)
+{
+    x = fabsf(x);
+    if (x < 1.0f) return (1.5f * x - 2.5f) * x * x + 1.0f;
+    if (x < 2.0f) return ((-0.5f * x + 2.5f) * x - 4.0f) * x + 2.0f;
+    return 0.0f;
+}
+
+/* Get the filter of an interpolation mode, and how far it reaches in the
+ * source. High quality modes stretch the filter when shrinking the image. */
+static float (*get_resample_filter(InterpolationMode interpolation, REAL delta,
+    REAL *radius, REAL *stretch))(float)
+{
+    *stretch = 1.0f;
+
+    switch (interpolation)
+    {
+    case InterpolationModeNearestNeighbor:
+        *radius = 0.0f;
+        return NULL;
+    case InterpolationModeHighQualityBicubic:
+        *stretch = max(fabsf(delta), 1.0f);
+        /* fall through */
+    case InterpolationModeBicubic:
+        *radius = 2.0f * *stretch;
+        return cubic_filter;
+    case InterpolationModeHighQualityBilinear:
+        *stretch = max(fabsf(delta), 1.0f);
+        /* fall through */
+    default:
+        *radius = *stretch;
+        return linear_filter;
+    }
+}
+
+static INT wrap_sample_coordinate(INT x, INT size, WrapMode wrap, BOOL flip)
+{
+    if (wrap == WrapModeClamp)
+        return (x < 0 || x >= size) ? -1 : x;
+
+    /* same as sample_bitmap_pixel */
+    if (x < 0)
+        x = size * 2 + x % (size * 2);
+    if (flip && (x / size) % 2)
+        return size - 1 - x % size;
+    return x % size;
+}
+
+static void free_resample_axis(struct resample_axis *axis)
+{
+    heap_free(axis->first);
+    heap_free(axis->pixels);
+    heap_free(axis->weights);
+    memset(axis, 0, sizeof(*axis));
+}
+
+/* Compute the taps of count destination pixels starting at dst, which map to
+ * origin + dst * delta in the source. Pixels mapping outside of the source
+ * [src, src + src_size) get no taps and are left transparent. The axis must
+ * be freed by the caller, even on failure. */
+static GpStatus init_resample_axis(struct resample_axis *axis, INT dst, INT count, REAL origin,
+    REAL delta, REAL src, REAL src_size, INT area_start, INT area_size, INT bitmap_size,
+    WrapMode wrap, BOOL flip, InterpolationMode interpolation, PixelOffsetMode offset_mode)
+{
+    float (*filter)(float);
+    REAL radius, stretch, pos, sum;
+    INT i, j, n, first, last, pixel, max_taps, taps = 0;
+
+    filter = get_resample_filter(interpolation, delta, &radius, &stretch);
+    max_taps = filter ? (INT)ceilf(radius * 2.0f) + 1 : 1;
+
+    axis->first = heap_alloc((count + 1) * sizeof(*axis->first));
+    axis->pixels = heap_alloc(count * max_taps * sizeof(*axis->pixels));
+    axis->weights = heap_alloc(count * max_taps * sizeof(*axis->weights));
+    if (!axis->first || !axis->pixels || !axis->weights)
+        return OutOfMemory;
+
+    for (i = 0; i < count; i++)
+    {
+        pos = origin + (dst + i) * delta;
+        axis->first[i] = taps;
+
+        if (pos < src || pos >= src + src_size)
+            continue;
+
+        if (!filter)
+        {
+            if (offset_mode == PixelOffsetModeHalf || offset_mode == PixelOffsetModeHighQuality)
+                first = floorf(pos);
+            else
+                first = floorf(pos + 0.5f);
+            last = first;
+        }
+        else
+        {
+            first = ceilf(pos - radius);
+            last = floorf(pos + radius);
+        }
+
+        for (j = first, n = taps, sum = 0.0f; j <= last && taps < n + max_taps; j++)
+        {
+            float weight = filter ? filter((j - pos) / stretch) : 1.0f;
+
+            if (weight == 0.0f) continue;
+
+            pixel = wrap_sample_coordinate(j, bitmap_size, wrap, flip);
+            if (pixel != -1)
+            {
+                pixel -= area_start;
+                if (pixel < 0 || pixel >= area_size)
+                {
+                    ERR("out of range pixel requested\n");
+                    pixel = -1;
+                }
+            }
+
+            axis->pixels[taps] = pixel;
+            axis->weights[taps++] = weight;
+            sum += weight;
+        }
+
+        if (sum != 0.0f)
+            for (j = n; j < taps; j++) axis->weights[j] /= sum;
+    }
+    axis->first[count] = taps;
+
+    return Ok;
+}
+
+struct resample_context
+{
+    const ARGB *src;
+    INT src_stride;           /* in pixels */
+    ARGB outside_color;
+    ARGB *dst;
+    INT dst_stride;           /* in pixels */
+    INT width;
+    const struct resample_axis *x_axis;
+    const struct resample_axis *y_axis;
+    const INT *rows;          /* source rows filtered horizontally, -1 for the outside color */
+    const INT *row_index;     /* index in rows of each source row + 1, 0 is the outside color */
+    float *columns;           /* horizontally filtered rows, premultiplied ARGB */
+};
+
+static GpStatus resample_rows_horizontal(void *arg, INT start, INT end)
+{
+    const struct resample_context *ctx = arg;
+    const struct resample_axis *axis = ctx->x_axis;
+    INT i, x, tap;
+
+    for (i = start; i < end; i++)
+    {
+        const ARGB *src = ctx->rows[i] == -1 ? NULL : ctx->src + ctx->rows[i] * ctx->src_stride;
+        float *out = ctx->columns + i * ctx->width * 4;
+
+        for (x = 0; x < ctx->width; x++, out += 4)
+        {
+            float a = 0.0f, r = 0.0f, g = 0.0f, b = 0.0f;
+
+            for (tap = axis->first[x]; tap < axis->first[x + 1]; tap++)
+            {
+                ARGB color = (src && axis->pixels[tap] != -1) ? src[axis->pixels[tap]] : ctx->outside_color;
+                float weight = axis->weights[tap] * (color >> 24);
+
+                a += weight;
+                r += weight * ((color >> 16) & 0xff);
+                g += weight * ((color >> 8) & 0xff);
+                b += weight * (color & 0xff);
+            }
+            out[0] = a;
+            out[1] = r;
+            out[2] = g;
+            out[3] = b;
+        }
+    }
+    return Ok;
+}
+
+static inline BYTE clamp_channel(float value)
+{
+    if (value <= 0.0f) return 0;
+    if (value >= 255.0f) return 255;
+    return value + 0.5f;
+}
+
+static GpStatus resample_rows_vertical(void *arg, INT start, INT end)
+{
+    const struct resample_context *ctx = arg;
+    const struct resample_axis *axis = ctx->y_axis;
+    float *acc = heap_alloc(ctx->width * 4 * sizeof(*acc));
+    INT x, y, tap;
+
+    if (!acc) return OutOfMemory;
+
+    for (y = start; y < end; y++)
+    {
+        ARGB *dst = ctx->dst + y * ctx->dst_stride;
+
+        memset(acc, 0, ctx->width * 4 * sizeof(*acc));
+        for (tap = axis->first[y]; tap < axis->first[y + 1]; tap++)
+        {
+            const float *in = ctx->columns + ctx->row_index[axis->pixels[tap] + 1] * ctx->width * 4;
+            float weight = axis->weights[tap];
+
+            for (x = 0; x < ctx->width * 4; x++)
+                acc[x] += weight * in[x];
+        }
+
+        for (x = 0; x < ctx->width; x++)
+        {
+            const float *pixel = acc + x * 4;
+
+            if (ctx->x_axis->first[x] == ctx->x_axis->first[x + 1] || pixel[0] < 0.5f)
+                dst[x] = 0;
+            else
+                dst[x] = (ARGB)clamp_channel(pixel[0]) << 24 | clamp_channel(pixel[1] / pixel[0]) << 16 |
+                         clamp_channel(pixel[2] / pixel[0]) << 8 | clamp_channel(pixel[3] / pixel[0]);
+        }
+    }
+
+    heap_free(acc);
+    return Ok;
+}
+
+static GpStatus resample_rows_nearest(void *arg, INT start, INT end)
+{
+    const struct resample_context *ctx = arg;
+    const struct resample_axis *x_axis = ctx->x_axis, *y_axis = ctx->y_axis;
+    INT x, y, row, col;
+
+    for (y = start; y < end; y++)
+    {
+        ARGB *dst = ctx->dst + y * ctx->dst_stride;
+
+        if (y_axis->first[y] == y_axis->first[y + 1])
+        {
+            memset(dst, 0, ctx->width * sizeof(*dst));
+            continue;
+        }
+
+        row = y_axis->pixels[y_axis->first[y]];
+        for (x = 0; x < ctx->width; x++)
+        {
+            if (x_axis->first[x] == x_axis->first[x + 1])
+                dst[x] = 0;
+            else if (row == -1 || (col = x_axis->pixels[x_axis->first[x]]) == -1)
+                dst[x] = ctx->outside_color;
+            else
+                dst[x] = ctx->src[row * ctx->src_stride + col];
+        }
+    }
+    return Ok;
+}
+
+/* Resample a bitmap without rotation or shear. The rows are filtered
+ * horizontally once, then the destination rows combine them vertically. */
+static GpStatus resample_bitmap_separable(ARGB *dst, const RECT *dst_area, const ARGB *src,
+    const GpRect *src_area, INT width, INT height, const GpPointF *origin, REAL x_dx, REAL y_dy,
+    REAL srcx, REAL srcy, REAL srcwidth, REAL srcheight, const GpImageAttributes *attributes,
+    InterpolationMode interpolation, PixelOffsetMode offset_mode)
+{
+    struct resample_context ctx;
+    struct resample_axis x_axis = {0}, y_axis = {0};
+    INT i, count = 0, *rows = NULL, *row_index = NULL;
+    INT dst_width = dst_area->right - dst_area->left, dst_height = dst_area->bottom - dst_area->top;
+    GpStatus stat;
+
+    stat = init_resample_axis(&x_axis, dst_area->left, dst_width, origin->X, x_dx, srcx, srcwidth,
+            src_area->X, src_area->Width, width, attributes->wrap, attributes->wrap & WrapModeTileFlipX,
+            interpolation, offset_mode);
+    if (stat == Ok)
+        stat = init_resample_axis(&y_axis, dst_area->top, dst_height, origin->Y, y_dy, srcy, srcheight,
+                src_area->Y, src_area->Height, height, attributes->wrap, attributes->wrap & WrapModeTileFlipY,
+                interpolation, offset_mode);
+    if (stat != Ok)
+    {
+        free_resample_axis(&x_axis);
+        free_resample_axis(&y_axis);
+        return stat;
+    }
+
+    ctx.src = src;
+    ctx.src_stride = src_area->Width;
+    ctx.outside_color = attributes->outside_color;
+    ctx.dst = dst;
+    ctx.dst_stride = dst_width;
+    ctx.width = dst_width;
+    ctx.x_axis = &x_axis;
+    ctx.y_axis = &y_axis;
+
+    if (interpolation == InterpolationModeNearestNeighbor)
+    {
+        stat = run_row_bands(dst_height, dst_width, resample_rows_nearest, &ctx);
+        goto done;
+    }
+
+    /* only filter the source rows that are used, the outside color is index 0 */
+    row_index = heap_alloc_zero((src_area->Height + 1) * sizeof(*row_index));
+    rows = heap_alloc((src_area->Height + 1) * sizeof(*rows));
+    if (!row_index || !rows)
+    {
+        stat = OutOfMemory;
+        goto done;
+    }
+
+    for (i = 0; i < y_axis.first[dst_height]; i++)
+        row_index[y_axis.pixels[i] + 1] = 1;
+    for (i = 0; i <= src_area->Height; i++)
+    {
+        if (!row_index[i]) continue;
+        rows[count] = i - 1;
+        row_index[i] = count++;
+    }
+
+    ctx.rows = rows;
+    ctx.row_index = row_index;
+    ctx.columns = heap_alloc(count * dst_width * 4 * sizeof(float));
+    if (!ctx.columns)
+    {
+        stat = OutOfMemory;
+        goto done;
+    }
+
+    stat = run_row_bands(count, dst_width * (x_axis.first[dst_width] / max(dst_width, 1) + 1),
+            resample_rows_horizontal, &ctx);
+    if (stat == Ok)
+        stat = run_row_bands(dst_height, dst_width * (y_axis.first[dst_height] / max(dst_height, 1) + 1),
+                resample_rows_vertical, &ctx);
+
+    heap_free(ctx.columns);
+
+done:
+    heap_free(rows);
+    heap_free(row_index);
+    free_resample_axis(&x_axis);
+    free_resample_axis(&y_axis);
+    return stat;
+}
+
 static REAL intersect_line_scanline(const GpPointF *p1, const GpPointF *p2, REAL y)
 {
     return (p1->X - p2->X) * (p2->Y - y) / (p2->Y - p1->Y) + p2->X;
@@ -1173,6 +1607,12 @@ static GpStatus brush_fill_path(GpGraphics *graphics, GpBrush *brush)
     return status;
 }
 
+static BOOL is_antialiased(const GpGraphics *graphics)
+{
+    return graphics->smoothing != SmoothingModeDefault && graphics->smoothing != SmoothingModeNone &&
+           graphics->smoothing != SmoothingModeHighSpeed;
+}
+
 static BOOL brush_can_fill_pixels(GpBrush *brush)
 {
     switch (brush->bt)
@@ -1197,8 +1637,8 @@ static GpStatus brush_fill_pixels(GpGraphics *graphics, GpBrush *brush,
     {
         int x, y;
         GpSolidFill *fill = (GpSolidFill*)brush;
-        for (x=0; x<fill_area->Width; x++)
-            for (y=0; y<fill_area->Height; y++)
+        for (y=0; y<fill_area->Height; y++)
+            for (x=0; x<fill_area->Width; x++)
                 argb_pixels[x + y*cdwStride] = fill->color;
         return Ok;
     }
@@ -3182,8 +3622,24 @@ GpStatus WINGDIPAPI GdipDrawImagePointsRect(GpGraphics *graphics, GpImage *image
 
             if (do_resampling)
             {
+                REAL radius_x, radius_y, stretch;
+
+                GdipTransformMatrixPoints(&dst_to_src, dst_to_src_points, 3);
+
+                x_dx = dst_to_src_points[1].X - dst_to_src_points[0].X;
+                x_dy = dst_to_src_points[1].Y - dst_to_src_points[0].Y;
+                y_dx = dst_to_src_points[2].X - dst_to_src_points[0].X;
+                y_dy = dst_to_src_points[2].Y - dst_to_src_points[0].Y;
+
+                /* filters wider than bilinear need pixels around the source rectangle */
+                get_resample_filter(interpolation, x_dx, &radius_x, &stretch);
+                get_resample_filter(interpolation, y_dy, &radius_y, &stretch);
+                if (x_dy != 0.0 || y_dx != 0.0)
+                    radius_x = radius_y = 1.0;
+
                 get_bitmap_sample_size(interpolation, imageAttributes->wrap,
-                    bitmap, srcx, srcy, srcwidth, srcheight, &src_area);
+                    bitmap, srcx, srcy, srcwidth, srcheight,
+                    max(radius_x - 1.0, 0.0), max(radius_y - 1.0, 0.0), &src_area);
             }
             else
             {
@@ -3239,30 +3695,38 @@ GpStatus WINGDIPAPI GdipDrawImagePointsRect(GpGraphics *graphics, GpImage *image
 
                 dst_stride = sizeof(ARGB) * (dst_area.right - dst_area.left);
 
-                GdipTransformMatrixPoints(&dst_to_src, dst_to_src_points, 3);
-
-                x_dx = dst_to_src_points[1].X - dst_to_src_points[0].X;
-                x_dy = dst_to_src_points[1].Y - dst_to_src_points[0].Y;
-                y_dx = dst_to_src_points[2].X - dst_to_src_points[0].X;
-                y_dy = dst_to_src_points[2].Y - dst_to_src_points[0].Y;
-
-                for (x=dst_area.left; x<dst_area.right; x++)
+                if (x_dy == 0.0 && y_dx == 0.0)
+                {
+                    stat = resample_bitmap_separable((ARGB *)dst_data, &dst_area, (ARGB *)src_data,
+                        &src_area, bitmap->width, bitmap->height, &dst_to_src_points[0], x_dx, y_dy,
+                        srcx, srcy, srcwidth, srcheight, imageAttributes, interpolation, offset_mode);
+                    if (stat != Ok)
+                    {
+                        heap_free(src_data);
+                        heap_free(dst_dyn_data);
+                        return stat;
+                    }
+                }
+                else
                 {
                     for (y=dst_area.top; y<dst_area.bottom; y++)
                     {
-                        GpPointF src_pointf;
-                        ARGB *dst_color;
+                        for (x=dst_area.left; x<dst_area.right; x++)
+                        {
+                            GpPointF src_pointf;
+                            ARGB *dst_color;
 
-                        src_pointf.X = dst_to_src_points[0].X + x * x_dx + y * y_dx;
-                        src_pointf.Y = dst_to_src_points[0].Y + x * x_dy + y * y_dy;
+                            src_pointf.X = dst_to_src_points[0].X + x * x_dx + y * y_dx;
+                            src_pointf.Y = dst_to_src_points[0].Y + x * x_dy + y * y_dy;
 
-                        dst_color = (ARGB*)(dst_data + dst_stride * (y - dst_area.top) + sizeof(ARGB) * (x - dst_area.left));
+                            dst_color = (ARGB*)(dst_data + dst_stride * (y - dst_area.top) + sizeof(ARGB) * (x - dst_area.left));
 
-                        if (src_pointf.X >= srcx && src_pointf.X < srcx + srcwidth && src_pointf.Y >= srcy && src_pointf.Y < srcy+srcheight)
-                            *dst_color = resample_bitmap_pixel(&src_area, src_data, bitmap->width, bitmap->height, &src_pointf,
-                                                               imageAttributes, interpolation, offset_mode);
-                        else
-                            *dst_color = 0;
+                            if (src_pointf.X >= srcx && src_pointf.X < srcx + srcwidth && src_pointf.Y >= srcy && src_pointf.Y < srcy+srcheight)
+                                *dst_color = resample_bitmap_pixel(&src_area, src_data, bitmap->width, bitmap->height, &src_pointf,
+                                                                   imageAttributes, interpolation, offset_mode);
+                            else
+                                *dst_color = 0;
+                        }
                     }
                 }
             }
@@ -3927,14 +4391,19 @@ static GpStatus SOFTWARE_GdipDrawPath(GpGraphics *graphics, GpPen *pen, GpPath *
     GpPath *wide_path;
     GpMatrix *transform=NULL;
     REAL flatness=1.0;
+    BOOL antialias = is_antialiased(graphics);
 
-    /* Check if the final pen thickness in pixels is too thin. */
-    if (pen->unit == UnitPixel)
+    /* Check if the final pen thickness in pixels is too thin. Antialiased
+     * lines are widened, so that their edges get partial coverage, except
+     * for zero width pens which would have no area. */
+    if (antialias && pen->width <= 0.0)
+        return SOFTWARE_GdipDrawThinPath(graphics, pen, path);
+    else if (pen->unit == UnitPixel && !antialias)
     {
         if (pen->width < 1.415)
             return SOFTWARE_GdipDrawThinPath(graphics, pen, path);
     }
-    else
+    else if (!antialias)
     {
         GpPointF points[3] = {{0,0}, {1,0}, {0,1}};
 
@@ -4025,7 +4494,8 @@ GpStatus WINGDIPAPI GdipDrawPath(GpGraphics *graphics, GpPen *pen, GpPath *path)
 
     if (graphics->image && graphics->image->type == ImageTypeMetafile)
         retval = METAFILE_DrawPath((GpMetafile*)graphics->image, pen, path);
-    else if (!graphics->hdc || graphics->alpha_hdc || !brush_can_fill_path(pen->brush, FALSE))
+    else if (!graphics->hdc || graphics->alpha_hdc || !brush_can_fill_path(pen->brush, FALSE) ||
+             (is_antialiased(graphics) && brush_can_fill_pixels(pen->brush)))
         retval = SOFTWARE_GdipDrawPath(graphics, pen, path);
     else
         retval = GDI32_GdipDrawPath(graphics, pen, path);
@@ -4311,6 +4781,294 @@ end:
     return retval;
 }
 
+struct coverage_buffer
+{
+    float *cells;   /* signed area added by the edges, summed along the rows */
+    INT *spans;     /* first and last touched cell of each row */
+    INT width;
+    INT height;
+    INT stride;
+};
+
+/* Accumulate the area covered by a line, with y0 != y1 and 0 <= x <= width. */
+static void accumulate_line(struct coverage_buffer *cov, REAL x0, REAL y0, REAL x1, REAL y1)
+{
+    REAL dir = 1.0f, dxdy, x, xnext, dy, d, left, right, tmp;
+    INT y, y_end, xi0, xi1, i;
+    float *row;
+
+    if (y0 > y1)
+    {
+        tmp = x0; x0 = x1; x1 = tmp;
+        tmp = y0; y0 = y1; y1 = tmp;
+        dir = -1.0f;
+    }
+
+    dxdy = (x1 - x0) / (y1 - y0);
+    x = x0;
+    y = floorf(y0);
+    if (y < 0)
+    {
+        x = min(max(x - y0 * dxdy, 0.0f), cov->width);
+        y = 0;
+    }
+    y_end = min(cov->height, (INT)ceilf(y1));
+
+    for (; y < y_end; y++, x = xnext)
+    {
+        dy = min(y + 1.0f, y1) - max((REAL)y, y0);
+        xnext = min(max(x + dxdy * dy, 0.0f), cov->width);
+        d = dy * dir;
+        left = min(x, xnext);
+        right = max(x, xnext);
+        xi0 = floorf(left);
+        xi1 = ceilf(right);
+        row = cov->cells + y * cov->stride;
+
+        cov->spans[y * 2] = min(cov->spans[y * 2], xi0);
+        cov->spans[y * 2 + 1] = max(cov->spans[y * 2 + 1], max(xi0 + 1, xi1));
+
+        if (xi1 <= xi0 + 1)
+        {
+            REAL mid = 0.5f * (x + xnext) - xi0;
+
+            row[xi0] += d - d * mid;
+            row[xi0 + 1] += d * mid;
+        }
+        else
+        {
+            REAL s = 1.0f / (right - left);
+            REAL f0 = left - xi0, f1 = right - xi1 + 1.0f;
+            REAL a0 = 0.5f * s * (1.0f - f0) * (1.0f - f0);
+            REAL am = 0.5f * s * f1 * f1;
+
+            row[xi0] += d * a0;
+            if (xi1 == xi0 + 2)
+                row[xi0 + 1] += d * (1.0f - a0 - am);
+            else
+            {
+                REAL a1 = s * (1.5f - f0);
+
+                row[xi0 + 1] += d * (a1 - a0);
+                for (i = xi0 + 2; i < xi1 - 1; i++)
+                    row[i] += d * s;
+                row[xi1 - 1] += d * (1.0f - (a1 + (xi1 - xi0 - 3) * s) - am);
+            }
+            row[xi1] += d * am;
+        }
+    }
+}
+
+/* Parts of a line left of the buffer still cover all the pixels on their
+ * right, so they are moved to the left edge. Parts right of it only touch
+ * the extra cell past the end of the rows. */
+static void add_line_coverage(struct coverage_buffer *cov, REAL x0, REAL y0, REAL x1, REAL y1)
+{
+    REAL y;
+
+    if (y0 == y1 || (y0 < 0.0f && y1 < 0.0f) || (y0 >= cov->height && y1 >= cov->height))
+        return;
+
+    if ((x0 < 0.0f && x1 > 0.0f) || (x0 > 0.0f && x1 < 0.0f))
+    {
+        y = y0 + (y1 - y0) * -x0 / (x1 - x0);
+        add_line_coverage(cov, x0, y0, 0.0f, y);
+        add_line_coverage(cov, 0.0f, y, x1, y1);
+        return;
+    }
+
+    if ((x0 < cov->width && x1 > cov->width) || (x0 > cov->width && x1 < cov->width))
+    {
+        y = y0 + (y1 - y0) * (cov->width - x0) / (x1 - x0);
+        add_line_coverage(cov, x0, y0, cov->width, y);
+        add_line_coverage(cov, cov->width, y, x1, y1);
+        return;
+    }
+
+    x0 = min(max(x0, 0.0f), cov->width);
+    x1 = min(max(x1, 0.0f), cov->width);
+    accumulate_line(cov, x0, y0, x1, y1);
+}
+
+/* Turn the accumulated area of a row into 8-bit coverage values. */
+static void get_row_coverage(const struct coverage_buffer *cov, INT y, GpFillMode fill, BYTE *mask)
+{
+    const float *row = cov->cells + y * cov->stride;
+    INT x, start = max(cov->spans[y * 2], 0), end = min(cov->spans[y * 2 + 1] + 1, cov->width);
+    float acc = 0.0f, c;
+
+    memset(mask, 0, cov->width);
+    for (x = start; x < end; x++)
+    {
+        acc += row[x];
+        c = fabsf(acc);
+        if (fill == FillModeAlternate)
+        {
+            c = fmodf(c, 2.0f);
+            if (c > 1.0f) c = 2.0f - c;
+        }
+        else if (c > 1.0f) c = 1.0f;
+        mask[x] = c * 255.0f + 0.5f;
+    }
+}
+
+/* Fill a path with analytic coverage antialiasing. The exact area covered in
+ * each pixel is accumulated from the edges of the flattened path, so the cost
+ * only depends on the length of the edges and the size of the filled area. */
+static GpStatus SOFTWARE_GdipFillPathAntialiased(GpGraphics *graphics, GpBrush *brush, GpPath *path)
+{
+    struct coverage_buffer cov = {0};
+    GpPath *flat_path;
+    GpMatrix world_to_device;
+    GpRectF bounds;
+    GpRect area;
+    RECT rect;
+    DWORD *pixels = NULL;
+    BYTE *mask = NULL;
+    const GpPointF *points;
+    const BYTE *types;
+    INT i, x, y, end, figure_start = 0;
+    GpStatus stat;
+
+    stat = GdipClonePath(path, &flat_path);
+    if (stat != Ok)
+        return stat;
+
+    stat = get_graphics_transform(graphics, WineCoordinateSpaceGdiDevice,
+            CoordinateSpaceWorld, &world_to_device);
+
+    /* the cells cover [x, x + 1), shift them to have pixel centers on integers */
+    if (stat == Ok && graphics->pixeloffset != PixelOffsetModeHalf &&
+        graphics->pixeloffset != PixelOffsetModeHighQuality)
+        stat = GdipTranslateMatrix(&world_to_device, 0.5, 0.5, MatrixOrderAppend);
+
+    if (stat == Ok)
+        stat = GdipFlattenPath(flat_path, &world_to_device, 0.25);
+
+    if (stat == Ok)
+        stat = get_graphics_device_bounds(graphics, &bounds);
+
+    if (stat != Ok || !flat_path->pathdata.Count)
+    {
+        GdipDeletePath(flat_path);
+        return stat;
+    }
+
+    points = flat_path->pathdata.Points;
+    types = flat_path->pathdata.Types;
+
+    rect.left = rect.right = floorf(points[0].X);
+    rect.top = rect.bottom = floorf(points[0].Y);
+    for (i = 0; i < flat_path->pathdata.Count; i++)
+    {
+        rect.left = min(rect.left, floorf(points[i].X));
+        rect.top = min(rect.top, floorf(points[i].Y));
+        rect.right = max(rect.right, ceilf(points[i].X));
+        rect.bottom = max(rect.bottom, ceilf(points[i].Y));
+    }
+    rect.left = max(rect.left, floorf(bounds.X));
+    rect.top = max(rect.top, floorf(bounds.Y));
+    rect.right = min(rect.right, ceilf(bounds.X + bounds.Width));
+    rect.bottom = min(rect.bottom, ceilf(bounds.Y + bounds.Height));
+
+    if (rect.right <= rect.left || rect.bottom <= rect.top)
+    {
+        GdipDeletePath(flat_path);
+        return Ok;
+    }
+
+    area.X = rect.left;
+    area.Y = rect.top;
+    area.Width = rect.right - rect.left;
+    area.Height = rect.bottom - rect.top;
+
+    cov.width = area.Width;
+    cov.height = area.Height;
+    cov.stride = area.Width + 2;
+    cov.cells = heap_alloc_zero(cov.stride * cov.height * sizeof(*cov.cells));
+    cov.spans = heap_alloc(cov.height * 2 * sizeof(*cov.spans));
+    pixels = heap_alloc_zero(area.Width * area.Height * sizeof(*pixels));
+    mask = heap_alloc(area.Width);
+
+    if (!cov.cells || !cov.spans || !pixels || !mask)
+        stat = OutOfMemory;
+
+    if (stat == Ok)
+    {
+        for (y = 0; y < cov.height; y++)
+        {
+            cov.spans[y * 2] = cov.width;
+            cov.spans[y * 2 + 1] = -1;
+        }
+
+        for (i = 0; i < flat_path->pathdata.Count; i++)
+        {
+            if ((types[i] & PathPointTypePathTypeMask) == PathPointTypeStart)
+                figure_start = i;
+
+            /* figures are implicitly closed when filling */
+            if (i + 1 == flat_path->pathdata.Count ||
+                (types[i + 1] & PathPointTypePathTypeMask) == PathPointTypeStart)
+                end = figure_start;
+            else
+                end = i + 1;
+
+            add_line_coverage(&cov, points[i].X - area.X, points[i].Y - area.Y,
+                    points[end].X - area.X, points[end].Y - area.Y);
+        }
+
+        if (brush->bt != BrushTypeSolidColor)
+            stat = brush_fill_pixels(graphics, brush, pixels, &area, area.Width);
+    }
+
+    if (stat == Ok)
+    {
+        for (y = 0; y < area.Height; y++)
+        {
+            DWORD *dst = pixels + y * area.Width;
+
+            if (cov.spans[y * 2 + 1] < 0)
+            {
+                if (brush->bt != BrushTypeSolidColor)
+                    memset(dst, 0, area.Width * sizeof(*dst));
+                continue;
+            }
+
+            get_row_coverage(&cov, y, flat_path->fill, mask);
+
+            if (brush->bt == BrushTypeSolidColor)
+            {
+                ARGB color = ((GpSolidFill *)brush)->color;
+                DWORD alpha = color >> 24;
+
+                color &= 0xffffff;
+                for (x = 0; x < area.Width; x++)
+                    dst[x] = color | ((alpha * mask[x] + 127) / 255) << 24;
+            }
+            else
+            {
+                for (x = 0; x < area.Width; x++)
+                    dst[x] = (dst[x] & 0xffffff) | (((dst[x] >> 24) * mask[x] + 127) / 255) << 24;
+            }
+        }
+
+        gdi_transform_acquire(graphics);
+
+        stat = alpha_blend_pixels(graphics, area.X, area.Y, (BYTE *)pixels,
+                area.Width, area.Height, area.Width * 4, PixelFormat32bppARGB);
+
+        gdi_transform_release(graphics);
+    }
+
+    heap_free(mask);
+    heap_free(pixels);
+    heap_free(cov.spans);
+    heap_free(cov.cells);
+    GdipDeletePath(flat_path);
+
+    return stat;
+}
+
 static GpStatus SOFTWARE_GdipFillPath(GpGraphics *graphics, GpBrush *brush, GpPath *path)
 {
     GpStatus stat;
@@ -4319,6 +5077,9 @@ static GpStatus SOFTWARE_GdipFillPath(GpGraphics *graphics, GpBrush *brush, GpPa
     if (!brush_can_fill_pixels(brush))
         return NotImplemented;
 
+    if (is_antialiased(graphics))
+        return SOFTWARE_GdipFillPathAntialiased(graphics, brush, path);
+
     /* FIXME: This could probably be done more efficiently without regions. */
 
     stat = GdipCreateRegionPath(path, &rgn);
@@ -4351,7 +5112,8 @@ GpStatus WINGDIPAPI GdipFillPath(GpGraphics *graphics, GpBrush *brush, GpPath *p
     if (graphics->image && graphics->image->type == ImageTypeMetafile)
         return METAFILE_FillPath((GpMetafile*)graphics->image, brush, path);
 
-    if (!graphics->image && !graphics->alpha_hdc)
+    if (!graphics->image && !graphics->alpha_hdc &&
+        !(is_antialiased(graphics) && brush_can_fill_pixels(brush)))
         stat = GDI32_GdipFillPath(graphics, brush, path);
 
     if (stat == NotImplemented)
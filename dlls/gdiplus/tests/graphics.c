@@ -1360,6 +1360,125 @@ static void test_GdipDrawImagePointsRect(void)
     ReleaseDC(hwnd, hdc);
 }
 
+static void test_GdipDrawImagePointsRect_interpolation(void)
+{
+    static const InterpolationMode modes[] =
+    {
+        InterpolationModeNearestNeighbor, InterpolationModeBilinear, InterpolationModeBicubic,
+        InterpolationModeHighQualityBilinear, InterpolationModeHighQualityBicubic
+    };
+    static const struct
+    {
+        INT src_size, dst_size;
+        INT x, y;
+        ARGB color;
+    } td[] =
+    {
+        { 8, 64, 8, 8, 0xffff0000 },
+        { 8, 64, 48, 40, 0xff0000ff },
+        { 64, 16, 3, 3, 0xffff0000 },
+        { 64, 16, 12, 10, 0xff0000ff },
+    };
+    GpStatus status;
+    GpGraphics *graphics;
+    GpBitmap *src, *dst;
+    GpPointF points[3];
+    DWORD *bits;
+    ARGB color;
+    int i, j, x, y;
+
+    for (i = 0; i < ARRAY_SIZE(td); i++)
+    {
+        /* left half red, right half blue */
+        bits = HeapAlloc(GetProcessHeap(), 0, td[i].src_size * td[i].src_size * sizeof(*bits));
+        for (y = 0; y < td[i].src_size; y++)
+            for (x = 0; x < td[i].src_size; x++)
+                bits[y * td[i].src_size + x] = x < td[i].src_size / 2 ? 0xffff0000 : 0xff0000ff;
+
+        status = GdipCreateBitmapFromScan0(td[i].src_size, td[i].src_size, td[i].src_size * 4,
+                PixelFormat32bppARGB, (BYTE *)bits, &src);
+        expect(Ok, status);
+
+        for (j = 0; j < ARRAY_SIZE(modes); j++)
+        {
+            status = GdipCreateBitmapFromScan0(td[i].dst_size, td[i].dst_size, 0, PixelFormat32bppARGB, NULL, &dst);
+            expect(Ok, status);
+            status = GdipGetImageGraphicsContext((GpImage *)dst, &graphics);
+            expect(Ok, status);
+            status = GdipSetInterpolationMode(graphics, modes[j]);
+            expect(Ok, status);
+
+            points[0].X = 0.0;
+            points[0].Y = 0.0;
+            points[1].X = td[i].dst_size;
+            points[1].Y = 0.0;
+            points[2].X = 0.0;
+            points[2].Y = td[i].dst_size;
+            status = GdipDrawImagePointsRect(graphics, (GpImage *)src, points, 3, 0.0, 0.0,
+                    td[i].src_size, td[i].src_size, UnitPixel, NULL, NULL, NULL);
+            expect(Ok, status);
+
+            status = GdipBitmapGetPixel(dst, td[i].x, td[i].y, &color);
+            expect(Ok, status);
+            ok(color == td[i].color, "%d, mode %d: expected %08x, got %08x\n", i, modes[j], td[i].color, color);
+
+            GdipDeleteGraphics(graphics);
+            GdipDisposeImage((GpImage *)dst);
+        }
+
+        GdipDisposeImage((GpImage *)src);
+        HeapFree(GetProcessHeap(), 0, bits);
+    }
+
+    /* horizontal ramp enlarged 8 times, sampled halfway between the centers of
+     * source pixels 3 and 4, whose red values are 96 and 128 */
+    bits = HeapAlloc(GetProcessHeap(), 0, 8 * 8 * sizeof(*bits));
+    for (y = 0; y < 8; y++)
+        for (x = 0; x < 8; x++)
+            bits[y * 8 + x] = 0xff000000 | (x * 32) << 16;
+    status = GdipCreateBitmapFromScan0(8, 8, 8 * 4, PixelFormat32bppARGB, (BYTE *)bits, &src);
+    expect(Ok, status);
+
+    for (j = 0; j < ARRAY_SIZE(modes); j++)
+    {
+        status = GdipCreateBitmapFromScan0(64, 64, 0, PixelFormat32bppARGB, NULL, &dst);
+        expect(Ok, status);
+        status = GdipGetImageGraphicsContext((GpImage *)dst, &graphics);
+        expect(Ok, status);
+        status = GdipSetInterpolationMode(graphics, modes[j]);
+        expect(Ok, status);
+
+        points[0].X = 0.0;
+        points[0].Y = 0.0;
+        points[1].X = 64.0;
+        points[1].Y = 0.0;
+        points[2].X = 0.0;
+        points[2].Y = 64.0;
+        status = GdipDrawImagePointsRect(graphics, (GpImage *)src, points, 3, 0.0, 0.0, 8.0, 8.0,
+                UnitPixel, NULL, NULL, NULL);
+        expect(Ok, status);
+
+        for (x = 31; x <= 32; x++)
+        {
+            status = GdipBitmapGetPixel(dst, x, 32, &color);
+            expect(Ok, status);
+            ok((color & 0xff00ffff) == 0xff000000, "mode %d, x %d: got %08x\n", modes[j], x, color);
+            if (modes[j] == InterpolationModeNearestNeighbor)
+                ok(((color >> 16) & 0xff) == 96 || ((color >> 16) & 0xff) == 128,
+                   "mode %d, x %d: got %08x\n", modes[j], x, color);
+            else
+                ok(((color >> 16) & 0xff) >= 104 && ((color >> 16) & 0xff) <= 120,
+                   "mode %d, x %d: got %08x\n", modes[j], x, color);
+        }
+
+        GdipDeleteGraphics(graphics);
+        GdipDisposeImage((GpImage *)dst);
+    }
+
+    GdipDisposeImage((GpImage *)src);
+    HeapFree(GetProcessHeap(), 0, bits);
+}
+
 static void test_GdipDrawLinesI(void)
 {
     GpStatus status;
@@ -1591,6 +1710,112 @@ static void test_GdipFillPath(void)
     ReleaseDC(hwnd, hdc);
 }
 
+static void test_GdipFillPath_antialias(void)
+{
+    static const struct
+    {
+        INT x, y;
+        ARGB min, max;
+    } td[] =
+    {
+        { 1, 3, 0, 0 },
+        { 2, 3, 0xff0000ff, 0xff0000ff },
+        { 5, 5, 0xff0000ff, 0xff0000ff },
+        { 6, 5, 0, 0 },
+        { 8, 3, 0x700000ff, 0x900000ff },
+        { 9, 3, 0xff0000ff, 0xff0000ff },
+        { 11, 3, 0x700000ff, 0x900000ff },
+        { 12, 3, 0, 0 },
+        /* overlapping figures */
+        { 3, 9, 0xff0000ff, 0xff0000ff },
+        { 5, 11, 0, 0 },
+        { 11, 11, 0xff0000ff, 0xff0000ff },
+        /* line */
+        { 8, 13, 0, 0 },
+        { 8, 14, 0xff0000ff, 0xff0000ff },
+        { 8, 15, 0, 0 },
+    };
+    GpStatus status;
+    GpGraphics *graphics;
+    GpBitmap *bitmap;
+    GpSolidFill *brush;
+    GpPen *pen;
+    GpPath *path;
+    ARGB color;
+    int i;
+
+    status = GdipCreateBitmapFromScan0(16, 16, 0, PixelFormat32bppARGB, NULL, &bitmap);
+    expect(Ok, status);
+    status = GdipGetImageGraphicsContext((GpImage *)bitmap, &graphics);
+    expect(Ok, status);
+    status = GdipSetSmoothingMode(graphics, SmoothingModeAntiAlias);
+    expect(Ok, status);
+    status = GdipSetPixelOffsetMode(graphics, PixelOffsetModeHalf);
+    expect(Ok, status);
+    status = GdipCreateSolidFill(0xff0000ff, &brush);
+    expect(Ok, status);
+    status = GdipCreatePath(FillModeAlternate, &path);
+    expect(Ok, status);
+
+    status = GdipAddPathRectangle(path, 2.0, 2.0, 4.0, 4.0);
+    expect(Ok, status);
+    status = GdipAddPathRectangle(path, 8.5, 2.0, 3.0, 3.0);
+    expect(Ok, status);
+    status = GdipFillPath(graphics, (GpBrush *)brush, path);
+    expect(Ok, status);
+
+    GdipResetPath(path);
+    status = GdipSetPathFillMode(path, FillModeAlternate);
+    expect(Ok, status);
+    status = GdipAddPathRectangle(path, 2.0, 8.0, 4.0, 4.0);
+    expect(Ok, status);
+    status = GdipAddPathRectangle(path, 4.0, 10.0, 4.0, 2.0);
+    expect(Ok, status);
+    status = GdipFillPath(graphics, (GpBrush *)brush, path);
+    expect(Ok, status);
+
+    GdipResetPath(path);
+    status = GdipSetPathFillMode(path, FillModeWinding);
+    expect(Ok, status);
+    status = GdipAddPathRectangle(path, 10.0, 8.0, 4.0, 4.0);
+    expect(Ok, status);
+    status = GdipAddPathRectangle(path, 10.0, 10.0, 4.0, 2.0);
+    expect(Ok, status);
+    status = GdipFillPath(graphics, (GpBrush *)brush, path);
+    expect(Ok, status);
+
+    status = GdipCreatePen1(0xff0000ff, 1.0, UnitPixel, &pen);
+    expect(Ok, status);
+    status = GdipDrawLine(graphics, pen, 2.0, 14.5, 14.0, 14.5);
+    expect(Ok, status);
+    GdipDeletePen(pen);
+
+    /* zero width pens still draw one pixel wide lines */
+    status = GdipCreatePen1(0xff0000ff, 0.0, UnitPixel, &pen);
+    expect(Ok, status);
+    status = GdipDrawLine(graphics, pen, 14.5, 2.0, 14.5, 7.0);
+    expect(Ok, status);
+    GdipDeletePen(pen);
+
+    for (i = 0; i < ARRAY_SIZE(td); i++)
+    {
+        status = GdipBitmapGetPixel(bitmap, td[i].x, td[i].y, &color);
+        expect(Ok, status);
+        ok(color >= td[i].min && color <= td[i].max && (color & 0xffffff) == (td[i].min & 0xffffff),
+           "%d: got %08x at %d,%d\n", i, color, td[i].x, td[i].y);
+    }
+
+    status = GdipBitmapGetPixel(bitmap, 14, 4, &color);
+    expect(Ok, status);
+    if (!color) GdipBitmapGetPixel(bitmap, 15, 4, &color);
+    ok(color == 0xff0000ff, "zero width line not drawn, got %08x\n", color);
+
+    GdipDeletePath(path);
+    GdipDeleteBrush((GpBrush *)brush);
+    GdipDeleteGraphics(graphics);
+    GdipDisposeImage((GpImage *)bitmap);
+}
+
 static void test_Get_Release_DC(void)
 {
     GpStatus status;
@@ -7089,9 +7314,11 @@ START_TEST(graphics)
     test_GdipDrawLineI();
     test_GdipDrawLinesI();
     test_GdipDrawImagePointsRect();
+    test_GdipDrawImagePointsRect_interpolation();
     test_GdipFillClosedCurve();
     test_GdipFillClosedCurveI();
     test_GdipFillPath();
+    test_GdipFillPath_antialias();
     test_GdipDrawString();
     test_GdipGetNearestColor();
     test_GdipGetVisibleClipBounds();
@@ -2724,8 +2724,14 @@ static INT LCMapStringEx_wrapper(DWORD flags, LPCWSTR src, INT srclen, LPWSTR ds
 
 static void test_LCMapStringEx(void)
 {
-    int ret;
+    static const WCHAR *sortkey_strings[] =
+    {
+        L"abc", L"ABC", L"a-b'c", L"caf\x00e9", L"cafe\x0301", L"\x0100\x0200x", L"a b,c"
+    };
+    static const DWORD sortkey_flags[] = { 0, NORM_IGNORECASE, NORM_IGNORESYMBOLS, SORT_STRINGSORT };
+    int ret, ret2, i, j;
     WCHAR buf[256];
+    char key[256], key2[256];
 
     if (!pLCMapStringEx)
     {
@@ -2761,6 +2767,36 @@ static void test_LCMapStringEx(void)
         ret = pLCMapStringEx(LOCALE_NAME_USER_DEFAULT, LCMAP_LOWERCASE,
                              upper_case, -1, buf, ARRAY_SIZE(buf), (void*)1, NULL, 0);
 
+    /* the returned length matches the generated key, and generating it again gives the same key */
+    for (i = 0; i < ARRAY_SIZE(sortkey_strings); i++)
+    {
+        for (j = 0; j < ARRAY_SIZE(sortkey_flags); j++)
+        {
+            DWORD flags = LCMAP_SORTKEY | sortkey_flags[j];
+
+            ret = pLCMapStringEx(LOCALE_NAME_USER_DEFAULT, flags, sortkey_strings[i], -1,
+                                 NULL, 0, NULL, NULL, 0);
+            memset(key, 0xcc, sizeof(key));
+            ret2 = pLCMapStringEx(LOCALE_NAME_USER_DEFAULT, flags, sortkey_strings[i], -1,
+                                  (WCHAR *)key, sizeof(key), NULL, NULL, 0);
+            ok(ret && ret == ret2, "%s %#x: got %d and %d\n", wine_dbgstr_w(sortkey_strings[i]), flags, ret, ret2);
+            ok(!key[ret2 - 1], "%s %#x: key not terminated\n", wine_dbgstr_w(sortkey_strings[i]), flags);
+
+            memset(key2, 0xcc, sizeof(key2));
+            ret2 = pLCMapStringEx(LOCALE_NAME_USER_DEFAULT, flags, sortkey_strings[i], -1,
+                                  (WCHAR *)key2, sizeof(key2), NULL, NULL, 0);
+            ok(ret == ret2, "%s %#x: got %d and %d\n", wine_dbgstr_w(sortkey_strings[i]), flags, ret, ret2);
+            ok(!memcmp(key, key2, ret), "%s %#x: keys differ\n", wine_dbgstr_w(sortkey_strings[i]), flags);
+
+            SetLastError(0xdeadbeef);
+            ret2 = pLCMapStringEx(LOCALE_NAME_USER_DEFAULT, flags, sortkey_strings[i], -1,
+                                  (WCHAR *)key2, ret - 1, NULL, NULL, 0);
+            ok(!ret2, "%s %#x: got %d\n", wine_dbgstr_w(sortkey_strings[i]), flags, ret2);
+            ok(GetLastError() == ERROR_INSUFFICIENT_BUFFER, "%s %#x: got error %u\n",
+               wine_dbgstr_w(sortkey_strings[i]), flags, GetLastError());
+        }
+    }
+
     test_lcmapstring_unicode(LCMapStringEx_wrapper, "LCMapStringEx:");
 }
 
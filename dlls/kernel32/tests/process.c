@@ -4139,6 +4139,92 @@ static void test_handle_list_attribute(BOOL child, HANDLE handle1, HANDLE handle
     CloseHandle(pipe[1]);
 }
 
+static void test_startup_time(void)
+{
+    LARGE_INTEGER freq, start, end;
+    PROCESS_INFORMATION info;
+    STARTUPINFOA si = {0};
+    char buffer[MAX_PATH + 26];
+    DWORD exit_code;
+    unsigned int i, count = winetest_interactive ? 50 : 5;
+    BOOL ret;
+
+    si.cb = sizeof(si);
+    sprintf(buffer, "\"%s\" process exit", selfname);
+
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&start);
+    for (i = 0; i < count; i++)
+    {
+        ret = CreateProcessA(NULL, buffer, NULL, NULL, FALSE, 0, NULL, NULL, &si, &info);
+        ok(ret, "CreateProcessA failed, error %u\n", GetLastError());
+        if (!ret) return;
+        wait_child_process(info.hProcess);
+        ret = GetExitCodeProcess(info.hProcess, &exit_code);
+        ok(ret && !exit_code, "got ret %d, exit code %u\n", ret, exit_code);
+        CloseHandle(info.hThread);
+        CloseHandle(info.hProcess);
+    }
+    QueryPerformanceCounter(&end);
+
+    trace("%u processes, %.2f ms per process startup and exit\n", count,
+          (end.QuadPart - start.QuadPart) * 1000.0 / freq.QuadPart / count);
+}
+
+static void test_spawn_state(void)
+{
+    SECURITY_ATTRIBUTES sa = { sizeof(sa), NULL, TRUE };
+    char buffer[MAX_PATH + 26], path[MAX_PATH], expect[MAX_PATH + 16], output[MAX_PATH + 16];
+    PROCESS_INFORMATION info;
+    STARTUPINFOA si = {0};
+    HANDLE read_pipe, write_pipe;
+    DWORD exit_code, size;
+    unsigned int i;
+    BOOL ret;
+
+    /* the environment, directory and standard handles must reach every new process */
+    GetTempPathA(sizeof(path), path);
+    sprintf(buffer, "\"%s\" process state", selfname);
+    for (i = 0; i < 10; i++)
+    {
+        ret = CreatePipe(&read_pipe, &write_pipe, &sa, 0);
+        ok(ret, "CreatePipe failed, error %u\n", GetLastError());
+        SetHandleInformation(read_pipe, HANDLE_FLAG_INHERIT, 0);
+
+        sprintf(output, "%u", i);
+        SetEnvironmentVariableA("WINETEST_SPAWN", output);
+
+        memset(&si, 0, sizeof(si));
+        si.cb = sizeof(si);
+        si.dwFlags = STARTF_USESTDHANDLES;
+        si.hStdInput = GetStdHandle(STD_INPUT_HANDLE);
+        si.hStdOutput = write_pipe;
+        si.hStdError = write_pipe;
+        ret = CreateProcessA(NULL, buffer, NULL, NULL, TRUE, 0, NULL, path, &si, &info);
+        ok(ret, "CreateProcessA failed, error %u\n", GetLastError());
+        CloseHandle(write_pipe);
+        if (!ret)
+        {
+            CloseHandle(read_pipe);
+            break;
+        }
+
+        memset(output, 0, sizeof(output));
+        ret = ReadFile(read_pipe, output, sizeof(output) - 1, &size, NULL);
+        ok(ret, "ReadFile failed, error %u\n", GetLastError());
+        sprintf(expect, "%s %u", path, i);
+        ok(!strcmp(output, expect), "%u: got %s, expected %s\n", i, output, expect);
+
+        wait_child_process(info.hProcess);
+        ret = GetExitCodeProcess(info.hProcess, &exit_code);
+        ok(ret && !exit_code, "got ret %d, exit code %u\n", ret, exit_code);
+        CloseHandle(info.hThread);
+        CloseHandle(info.hProcess);
+        CloseHandle(read_pipe);
+    }
+    SetEnvironmentVariableA("WINETEST_SPAWN", NULL);
+}
+
 START_TEST(process)
 {
     HANDLE job, hproc, h, h2;
@@ -4175,6 +4261,19 @@ START_TEST(process)
         {
             return;
         }
+        else if (!strcmp(myARGV[2], "state"))
+        {
+            char buffer[MAX_PATH + 16], *p;
+            DWORD size;
+
+            GetCurrentDirectoryA(MAX_PATH, buffer);
+            p = buffer + strlen(buffer);
+            if (p[-1] != '\\') *p++ = '\\';
+            *p++ = ' ';
+            GetEnvironmentVariableA("WINETEST_SPAWN", p, 16);
+            WriteFile(GetStdHandle(STD_OUTPUT_HANDLE), buffer, strlen(buffer), &size, NULL);
+            return;
+        }
         else if (!strcmp(myARGV[2], "nested") && myARGC >= 4)
         {
             char                buffer[MAX_PATH + 26];
@@ -4258,6 +4357,8 @@ START_TEST(process)
     test_ProcThreadAttributeList();
     test_SuspendProcessState();
     test_SuspendProcessNewThread();
+    test_spawn_state();
+    test_startup_time();
 
     /* things that can be tested:
      *  lookup:         check the way program to be executed is searched
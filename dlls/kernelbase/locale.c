@@ -35,6 +35,7 @@
 #include "winuser.h"
 #include "winternl.h"
 #include "kernelbase.h"
+#include "wine/list.h"
 #include "wine/debug.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(nls);
@@ -616,6 +617,7 @@ static CRITICAL_SECTION_DEBUG critsect_debug =
 };
 static CRITICAL_SECTION locale_section = { &critsect_debug, -1, 0, 0, 0, 0 };
 
+static void init_collation_tables(void);
 
 static void init_sortkeys( DWORD *ptr )
 {
@@ -743,6 +745,7 @@ void init_locale(void)
                      0, NULL, REG_OPTION_NON_VOLATILE, KEY_ALL_ACCESS, NULL, &intl_key, NULL );
 
     current_locale_sort = get_language_sort( LOCALE_NAME_USER_DEFAULT );
+    init_collation_tables();
 
     if (GetDynamicTimeZoneInformation( &timezone ) != TIME_ZONE_ID_INVALID &&
         !RegCreateKeyExW( HKEY_LOCAL_MACHINE, L"System\\CurrentControlSet\\Control\\TimeZoneInformation",
@@ -2130,121 +2133,120 @@ static int wcstombs_codepage( UINT codepage, DWORD flags, const WCHAR *src, int
 
 static int get_sortkey( DWORD flags, const WCHAR *src, int srclen, char *dst, int dstlen )
 {
-    WCHAR dummy[4]; /* no decomposition is larger than 4 chars */
-    int key_len[4];
-    char *key_ptr[4];
-    const WCHAR *src_save = src;
-    int srclen_save = srclen;
+    char buffer[512], *levels = buffer, *key_ptr[4], *level_start[4];
+    int i, key_len[4], ret;
 
     key_len[0] = key_len[1] = key_len[2] = key_len[3] = 0;
+
+    /* The keys are built in a single pass: the primary key is stored directly in the destination,
+     * the other ones can't be longer than 4 bytes per char in total and are accumulated in a
+     * temporary buffer until the primary key length is known. */
+    if (dstlen)
+    {
+        if (srclen > sizeof(buffer) / 4 &&
+            !(levels = RtlAllocateHeap( GetProcessHeap(), 0, srclen * 4 ))) return 0;
+        level_start[0] = key_ptr[0] = dst;
+        level_start[1] = key_ptr[1] = levels;
+        level_start[2] = key_ptr[2] = levels + srclen;
+        level_start[3] = key_ptr[3] = levels + 2 * srclen;
+    }
+
     for (; srclen; srclen--, src++)
     {
-        unsigned int i, decomposed_len = 1;/*wine_decompose(*src, dummy, 4);*/
-        dummy[0] = *src;
-        if (decomposed_len)
-        {
-            for (i = 0; i < decomposed_len; i++)
-            {
-                WCHAR wch = dummy[i];
-                unsigned int ce;
+        WCHAR wch = *src;
+        unsigned int ce;
 
-                if ((flags & NORM_IGNORESYMBOLS) &&
-                    (get_char_type( CT_CTYPE1, wch ) & (C1_PUNCT | C1_SPACE)))
-                    continue;
+        if ((flags & NORM_IGNORESYMBOLS) &&
+            (get_char_type( CT_CTYPE1, wch ) & (C1_PUNCT | C1_SPACE)))
+            continue;
+
+        if (flags & NORM_IGNORECASE) wch = casemap( nls_info.LowerCaseTable, wch );
 
-                if (flags & NORM_IGNORECASE) wch = casemap( nls_info.LowerCaseTable, wch );
+        ce = collation_table[collation_table[collation_table[wch >> 8] + ((wch >> 4) & 0x0f)] + (wch & 0xf)];
 
-                ce = collation_table[collation_table[collation_table[wch >> 8] + ((wch >> 4) & 0x0f)] + (wch & 0xf)];
-                if (ce != (unsigned int)-1)
+        if (!dstlen) /* compute length */
+        {
+            if (ce != (unsigned int)-1)
+            {
+                if (ce >> 16) key_len[0] += 2;
+                if ((ce >> 8) & 0xff) key_len[1]++;
+                if ((ce >> 4) & 0x0f) key_len[2]++;
+                if (ce & 1)
                 {
-                    if (ce >> 16) key_len[0] += 2;
-                    if ((ce >> 8) & 0xff) key_len[1]++;
-                    if ((ce >> 4) & 0x0f) key_len[2]++;
-                    if (ce & 1)
-                    {
-                        if (wch >> 8) key_len[3]++;
-                        key_len[3]++;
-                    }
+                    if (wch >> 8) key_len[3]++;
+                    if (wch & 0xff) key_len[3]++;
                 }
-                else
-                {
-                    key_len[0] += 2;
-                    if (wch >> 8) key_len[0]++;
-                    if (wch & 0xff) key_len[0]++;
-		}
             }
+            else
+            {
+                key_len[0] += 2;
+                if (wch >> 8) key_len[0]++;
+                if (wch & 0xff) key_len[0]++;
+            }
+            continue;
+        }
+
+        /* a char stores at most 4 bytes of primary key, if they don't fit the full key won't either */
+        if (key_ptr[0] - dst + 4 > dstlen)
+        {
+            ret = 0;
+            goto done;
+        }
+
+        if (ce != (unsigned int)-1)
+        {
+            WCHAR key;
+            if ((key = ce >> 16))
+            {
+                *key_ptr[0]++ = key >> 8;
+                *key_ptr[0]++ = key & 0xff;
+            }
+            /* make key 1 start from 2 */
+            if ((key = (ce >> 8) & 0xff)) *key_ptr[1]++ = key + 1;
+            /* make key 2 start from 2 */
+            if ((key = (ce >> 4) & 0x0f)) *key_ptr[2]++ = key + 1;
+            /* key 3 is always a character code */
+            if (ce & 1)
+            {
+                if (wch >> 8) *key_ptr[3]++ = wch >> 8;
+                if (wch & 0xff) *key_ptr[3]++ = wch & 0xff;
+            }
+        }
+        else
+        {
+            *key_ptr[0]++ = 0xff;
+            *key_ptr[0]++ = 0xfe;
+            if (wch >> 8) *key_ptr[0]++ = wch >> 8;
+            if (wch & 0xff) *key_ptr[0]++ = wch & 0xff;
         }
     }
 
-    if (!dstlen) /* compute length */
+    if (!dstlen)
         /* 4 * '\1' + key length */
         return key_len[0] + key_len[1] + key_len[2] + key_len[3] + 4;
 
-    if (dstlen < key_len[0] + key_len[1] + key_len[2] + key_len[3] + 4 + 1)
-        return 0; /* overflow */
-
-    src = src_save;
-    srclen = srclen_save;
-
-    key_ptr[0] = dst;
-    key_ptr[1] = key_ptr[0] + key_len[0] + 1;
-    key_ptr[2] = key_ptr[1] + key_len[1] + 1;
-    key_ptr[3] = key_ptr[2] + key_len[2] + 1;
+    for (i = 0; i < 4; i++) key_len[i] = key_ptr[i] - level_start[i];
 
-    for (; srclen; srclen--, src++)
+    if (dstlen < key_len[0] + key_len[1] + key_len[2] + key_len[3] + 4 + 1)
     {
-        unsigned int i, decomposed_len = 1;/*wine_decompose(*src, dummy, 4);*/
-        dummy[0] = *src;
-        if (decomposed_len)
-        {
-            for (i = 0; i < decomposed_len; i++)
-            {
-                WCHAR wch = dummy[i];
-                unsigned int ce;
-
-                if ((flags & NORM_IGNORESYMBOLS) &&
-                    (get_char_type( CT_CTYPE1, wch ) & (C1_PUNCT | C1_SPACE)))
-                    continue;
-
-                if (flags & NORM_IGNORECASE) wch = casemap( nls_info.LowerCaseTable, wch );
+        ret = 0; /* overflow */
+        goto done;
+    }
 
-                ce = collation_table[collation_table[collation_table[wch >> 8] + ((wch >> 4) & 0x0f)] + (wch & 0xf)];
-                if (ce != (unsigned int)-1)
-                {
-                    WCHAR key;
-                    if ((key = ce >> 16))
-                    {
-                        *key_ptr[0]++ = key >> 8;
-                        *key_ptr[0]++ = key & 0xff;
-                    }
-                    /* make key 1 start from 2 */
-                    if ((key = (ce >> 8) & 0xff)) *key_ptr[1]++ = key + 1;
-                    /* make key 2 start from 2 */
-                    if ((key = (ce >> 4) & 0x0f)) *key_ptr[2]++ = key + 1;
-                    /* key 3 is always a character code */
-                    if (ce & 1)
-                    {
-                        if (wch >> 8) *key_ptr[3]++ = wch >> 8;
-                        if (wch & 0xff) *key_ptr[3]++ = wch & 0xff;
-                    }
-                }
-                else
-                {
-                    *key_ptr[0]++ = 0xff;
-                    *key_ptr[0]++ = 0xfe;
-                    if (wch >> 8) *key_ptr[0]++ = wch >> 8;
-                    if (wch & 0xff) *key_ptr[0]++ = wch & 0xff;
-                }
-            }
-        }
+    key_ptr[0] = dst + key_len[0];
+    for (i = 1; i < 4; i++)
+    {
+        *key_ptr[0]++ = 1;
+        memcpy( key_ptr[0], level_start[i], key_len[i] );
+        key_ptr[0] += key_len[i];
     }
+    *key_ptr[0]++ = 1;
+    *key_ptr[0] = 0;
+    ret = key_ptr[0] - dst;
 
-    *key_ptr[0] = 1;
-    *key_ptr[1] = 1;
-    *key_ptr[2] = 1;
-    *key_ptr[3]++ = 1;
-    *key_ptr[3] = 0;
-    return key_ptr[3] - dst;
+done:
+    if (levels != buffer) RtlFreeHeap( GetProcessHeap(), 0, levels );
+    return ret;
 }
 
 
@@ -2576,6 +2578,275 @@ static int compare_weights(int flags, const WCHAR *str1, int len1,
 }
 
 
+/* Precomputed weights for the Latin-1 range, to avoid the collation table
+ * and decomposition lookups for the most common strings. */
+
+#define LATIN1_DECOMPOSED 0x01  /* char has a decomposition, not handled by the fast path */
+#define LATIN1_SYMBOL     0x02  /* char is punctuation or space */
+
+static struct latin1_weight
+{
+    WORD weight[3];  /* indexed by enum weight */
+    WORD flags;
+} latin1_weights[256];
+
+static inline const struct latin1_weight *get_latin1_weight( WCHAR ch )
+{
+    if (ch > 0xff || (latin1_weights[ch].flags & LATIN1_DECOMPOSED)) return NULL;
+    return &latin1_weights[ch];
+}
+
+
+/* same as compare_weights for strings that only contain chars of the Latin-1 table;
+ * returns FALSE if the string can't be handled this way */
+static BOOL compare_latin1_weights( int flags, const WCHAR *str1, int len1,
+                                    const WCHAR *str2, int len2, enum weight type, int *ret )
+{
+    const struct latin1_weight *w1, *w2;
+
+    while (len1 > 0 && len2 > 0)
+    {
+        if (!(w1 = get_latin1_weight( *str1 ))) return FALSE;
+        if (!(w2 = get_latin1_weight( *str2 ))) return FALSE;
+
+        if (flags & NORM_IGNORESYMBOLS)
+        {
+            int skip = 0;
+            if (w1->flags & LATIN1_SYMBOL)
+            {
+                str1++;
+                len1--;
+                skip = 1;
+            }
+            if (w2->flags & LATIN1_SYMBOL)
+            {
+                str2++;
+                len2--;
+                skip = 1;
+            }
+            if (skip) continue;
+        }
+
+        if (type == UNICODE_WEIGHT && !(flags & SORT_STRINGSORT))
+        {
+            if (*str1 == '-' || *str1 == '\'')
+            {
+                if (*str2 != '-' && *str2 != '\'')
+                {
+                    str1++;
+                    len1--;
+                    continue;
+                }
+            }
+            else if (*str2 == '-' || *str2 == '\'')
+            {
+                str2++;
+                len2--;
+                continue;
+            }
+        }
+
+        if (!w1->weight[type])
+        {
+            str1++;
+            len1--;
+            continue;
+        }
+        if (!w2->weight[type])
+        {
+            str2++;
+            len2--;
+            continue;
+        }
+
+        if (w1->weight[type] != w2->weight[type])
+        {
+            *ret = w1->weight[type] - w2->weight[type];
+            return TRUE;
+        }
+        str1++;
+        len1--;
+        str2++;
+        len2--;
+    }
+    for ( ; len1; str1++, len1--)
+    {
+        if (!(w1 = get_latin1_weight( *str1 ))) return FALSE;
+        if (w1->weight[type]) break;
+    }
+    for ( ; len2; str2++, len2--)
+    {
+        if (!(w2 = get_latin1_weight( *str2 ))) return FALSE;
+        if (w2->weight[type]) break;
+    }
+    *ret = len1 - len2;
+    return TRUE;
+}
+
+
+static int compare_string( int flags, const WCHAR *str1, int len1, const WCHAR *str2, int len2 )
+{
+    static const enum weight types[] = { UNICODE_WEIGHT, DIACRITIC_WEIGHT, CASE_WEIGHT };
+    unsigned int i;
+    int ret = 0;
+
+    for (i = 0; i < ARRAY_SIZE(types) && !ret; i++)
+    {
+        if (types[i] == DIACRITIC_WEIGHT && (flags & NORM_IGNORENONSPACE)) continue;
+        if (types[i] == CASE_WEIGHT && (flags & NORM_IGNORECASE)) continue;
+        if (!compare_latin1_weights( flags, str1, len1, str2, len2, types[i], &ret ))
+            ret = compare_weights( flags, str1, len1, str2, len2, types[i] );
+    }
+    return ret;
+}
+
+
+/* Optional cache of recently generated sort keys, enabled by setting the
+ * SortKeyCacheSize value of HKCU\Software\Wine\Nls to the number of entries. */
+
+#define SORTKEY_CACHE_MAX_LEN  32   /* max length of cached strings */
+#define SORTKEY_CACHE_MAX_SIZE 4096
+#define SORTKEY_CACHE_BUCKETS  64
+
+struct sortkey_cache_entry
+{
+    struct list entry;       /* entry in hash bucket */
+    struct list lru;         /* entry in LRU list */
+    DWORD       flags;
+    UINT        hash;
+    int         srclen;
+    int         keylen;
+    WCHAR       str[SORTKEY_CACHE_MAX_LEN];
+    char        key[SORTKEY_CACHE_MAX_LEN * 8 + 5];
+};
+
+static struct list sortkey_buckets[SORTKEY_CACHE_BUCKETS];
+static struct list sortkey_lru = LIST_INIT( sortkey_lru );
+static struct sortkey_cache_entry *sortkey_cache;
+
+static CRITICAL_SECTION sortkey_section;
+static CRITICAL_SECTION_DEBUG sortkey_critsect_debug =
+{
+    0, 0, &sortkey_section,
+    { &sortkey_critsect_debug.ProcessLocksList, &sortkey_critsect_debug.ProcessLocksList },
+      0, 0, { (DWORD_PTR)(__FILE__ ": sortkey_section") }
+};
+static CRITICAL_SECTION sortkey_section = { &sortkey_critsect_debug, -1, 0, 0, 0, 0 };
+
+static UINT hash_sortkey_string( DWORD flags, const WCHAR *str, int len )
+{
+    UINT hash = flags;
+    while (len--) hash = hash * 31 + *str++;
+    return hash;
+}
+
+static struct sortkey_cache_entry *find_cached_sortkey( DWORD flags, const WCHAR *src, int srclen, UINT hash )
+{
+    struct sortkey_cache_entry *cache;
+
+    LIST_FOR_EACH_ENTRY( cache, &sortkey_buckets[hash % SORTKEY_CACHE_BUCKETS], struct sortkey_cache_entry, entry )
+    {
+        if (cache->hash != hash || cache->flags != flags || cache->srclen != srclen) continue;
+        if (memcmp( cache->str, src, srclen * sizeof(WCHAR) )) continue;
+        list_remove( &cache->lru );
+        list_add_head( &sortkey_lru, &cache->lru );
+        return cache;
+    }
+    return NULL;
+}
+
+static int get_sortkey_cached( DWORD flags, const WCHAR *src, int srclen, char *dst, int dstlen )
+{
+    struct sortkey_cache_entry *cache;
+    char key[sizeof(cache->key)];
+    UINT hash;
+    int ret;
+
+    if (!sortkey_cache || srclen > SORTKEY_CACHE_MAX_LEN) return get_sortkey( flags, src, srclen, dst, dstlen );
+
+    hash = hash_sortkey_string( flags, src, srclen );
+
+    EnterCriticalSection( &sortkey_section );
+    if ((cache = find_cached_sortkey( flags, src, srclen, hash )))
+    {
+        if (!dstlen) ret = cache->keylen;
+        else if (dstlen <= cache->keylen) ret = 0;
+        else
+        {
+            memcpy( dst, cache->key, cache->keylen + 1 );
+            ret = cache->keylen;
+        }
+        LeaveCriticalSection( &sortkey_section );
+        return ret;
+    }
+    LeaveCriticalSection( &sortkey_section );
+
+    /* always generate the full key, so that it can be added to the cache */
+    if (!(ret = get_sortkey( flags, src, srclen, key, sizeof(key) ))) return 0;
+
+    EnterCriticalSection( &sortkey_section );
+    if (!find_cached_sortkey( flags, src, srclen, hash ))
+    {
+        /* recycle the least recently used entry */
+        cache = LIST_ENTRY( list_tail( &sortkey_lru ), struct sortkey_cache_entry, lru );
+        list_remove( &cache->entry );
+        list_remove( &cache->lru );
+        cache->flags  = flags;
+        cache->hash   = hash;
+        cache->srclen = srclen;
+        cache->keylen = ret;
+        memcpy( cache->str, src, srclen * sizeof(WCHAR) );
+        memcpy( cache->key, key, ret + 1 );
+        list_add_head( &sortkey_buckets[hash % SORTKEY_CACHE_BUCKETS], &cache->entry );
+        list_add_head( &sortkey_lru, &cache->lru );
+    }
+    LeaveCriticalSection( &sortkey_section );
+
+    if (!dstlen) return ret;
+    if (dstlen <= ret) return 0;
+    memcpy( dst, key, ret + 1 );
+    return ret;
+}
+
+
+static void init_collation_tables(void)
+{
+    DWORD i, size, type, count = 0;
+    unsigned int len;
+    HKEY key;
+
+    for (i = 0; i < ARRAY_SIZE(latin1_weights); i++)
+    {
+        latin1_weights[i].weight[UNICODE_WEIGHT]   = get_weight( i, UNICODE_WEIGHT );
+        latin1_weights[i].weight[DIACRITIC_WEIGHT] = get_weight( i, DIACRITIC_WEIGHT );
+        latin1_weights[i].weight[CASE_WEIGHT]      = get_weight( i, CASE_WEIGHT );
+        latin1_weights[i].flags = 0;
+        if (get_decomposition( i, &len )) latin1_weights[i].flags |= LATIN1_DECOMPOSED;
+        if (get_char_type( CT_CTYPE1, i ) & (C1_PUNCT | C1_SPACE)) latin1_weights[i].flags |= LATIN1_SYMBOL;
+    }
+
+    if (!RegOpenKeyExW( HKEY_CURRENT_USER, L"Software\\Wine\\Nls", 0, KEY_READ, &key ))
+    {
+        size = sizeof(count);
+        if (RegQueryValueExW( key, L"SortKeyCacheSize", NULL, &type, (BYTE *)&count, &size ) ||
+            type != REG_DWORD) count = 0;
+        RegCloseKey( key );
+    }
+    if (!count) return;
+    count = min( count, SORTKEY_CACHE_MAX_SIZE );
+    if (!(sortkey_cache = RtlAllocateHeap( GetProcessHeap(), HEAP_ZERO_MEMORY, count * sizeof(*sortkey_cache) )))
+        return;
+    TRACE( "using a sort key cache of %u entries\n", count );
+    for (i = 0; i < SORTKEY_CACHE_BUCKETS; i++) list_init( &sortkey_buckets[i] );
+    for (i = 0; i < count; i++)
+    {
+        sortkey_cache[i].srclen = -1;
+        list_add_tail( &sortkey_buckets[0], &sortkey_cache[i].entry );
+        list_add_tail( &sortkey_lru, &sortkey_cache[i].lru );
+    }
+}
+
+
 static const struct geoinfo *get_geoinfo_ptr( GEOID geoid )
 {
     int min = 0, max = ARRAY_SIZE( geoinfodata )-1;
@@ -3049,14 +3320,7 @@ INT WINAPI CompareStringEx( const WCHAR *locale, DWORD flags, const WCHAR *str1,
     if (len1 < 0) len1 = lstrlenW(str1);
     if (len2 < 0) len2 = lstrlenW(str2);
 
-    ret = compare_weights( flags, str1, len1, str2, len2, UNICODE_WEIGHT );
-    if (!ret)
-    {
-        if (!(flags & NORM_IGNORENONSPACE))
-            ret = compare_weights( flags, str1, len1, str2, len2, DIACRITIC_WEIGHT );
-        if (!ret && !(flags & NORM_IGNORECASE))
-            ret = compare_weights( flags, str1, len1, str2, len2, CASE_WEIGHT );
-    }
+    ret = compare_string( flags, str1, len1, str2, len2 );
     if (!ret) return CSTR_EQUAL;
     return (ret < 0) ? CSTR_LESS_THAN : CSTR_GREATER_THAN;
 }
@@ -5256,7 +5520,7 @@ INT WINAPI DECLSPEC_HOTPATCH LCMapStringEx( const WCHAR *locale, DWORD flags, co
         TRACE( "(%s,0x%08x,%s,%d,%p,%d)\n",
                debugstr_w(locale), flags, debugstr_wn(src, srclen), srclen, dst, dstlen );
 
-        if ((ret = get_sortkey( flags, src, srclen, (char *)dst, dstlen ))) ret++;
+        if ((ret = get_sortkey_cached( flags, src, srclen, (char *)dst, dstlen ))) ret++;
         else SetLastError( ERROR_INSUFFICIENT_BUFFER );
         return ret;
     }
@@ -45,11 +45,119 @@ static inline void small_pause(void)
 
 static void *no_debug_info_marker = (void *)(ULONG_PTR)-1;
 
+/* Table of the contended named critical sections, for the benefit of debuggers. Named sections
+ * usually have a static debug info living in the module that owns them, so they are only
+ * referenced from here and never linked together; entries are dropped when the section is
+ * deleted or the module unloaded. */
+#define MAX_CONTENDED_SECTIONS 256
+static struct
+{
+    ULONG count;
+    RTL_CRITICAL_SECTION_DEBUG *sections[MAX_CONTENDED_SECTIONS];
+} RtlContendedSections;
+static RTL_SRWLOCK contended_sections_lock = RTL_SRWLOCK_INIT;
+
+/* upper bound of the spin count for sections with RTL_CRITICAL_SECTION_FLAG_DYNAMIC_SPIN */
+#define MAX_ADAPTIVE_SPIN_COUNT 4000
+
 static BOOL crit_section_has_debuginfo(const RTL_CRITICAL_SECTION *crit)
 {
     return crit->DebugInfo != NULL && crit->DebugInfo != no_debug_info_marker;
 }
 
+static inline ULONG get_spin_count( const RTL_CRITICAL_SECTION *crit )
+{
+    return crit->SpinCount & ~RTL_CRITICAL_SECTION_ALL_FLAG_BITS;
+}
+
+static BOOL find_contended_section( const RTL_CRITICAL_SECTION_DEBUG *debug )
+{
+    ULONG i;
+
+    for (i = 0; i < RtlContendedSections.count; i++)
+        if (RtlContendedSections.sections[i] == debug) return TRUE;
+    return FALSE;
+}
+
+/***********************************************************************
+ *           record_contention
+ *
+ * Update the contention statistics of a section that was found busy on entry.
+ */
+static void record_contention( RTL_CRITICAL_SECTION *crit )
+{
+    RTL_CRITICAL_SECTION_DEBUG *debug;
+    BOOL found;
+
+    if (!crit_section_has_debuginfo( crit )) return;
+    debug = crit->DebugInfo;
+    InterlockedIncrement( (LONG *)&debug->EntryCount );
+
+    if (!debug->Spare[0]) return;
+
+    RtlAcquireSRWLockShared( &contended_sections_lock );
+    found = find_contended_section( debug );
+    RtlReleaseSRWLockShared( &contended_sections_lock );
+    if (found) return;
+
+    RtlAcquireSRWLockExclusive( &contended_sections_lock );
+    if (!find_contended_section( debug ) && RtlContendedSections.count < MAX_CONTENDED_SECTIONS)
+        RtlContendedSections.sections[RtlContendedSections.count++] = debug;
+    RtlReleaseSRWLockExclusive( &contended_sections_lock );
+}
+
+/***********************************************************************
+ *           remove_contended_sections
+ *
+ * Drop the table entries for the debug infos in the given address range, used
+ * when a section is deleted or its module unloaded. Entries are only compared
+ * by address, they may point to memory that is already gone.
+ */
+void remove_contended_sections( const void *start, SIZE_T size )
+{
+    ULONG i;
+
+    RtlAcquireSRWLockExclusive( &contended_sections_lock );
+    for (i = 0; i < RtlContendedSections.count;)
+    {
+        ULONG_PTR addr = (ULONG_PTR)RtlContendedSections.sections[i];
+
+        if (addr - (ULONG_PTR)start < size)
+            RtlContendedSections.sections[i] = RtlContendedSections.sections[--RtlContendedSections.count];
+        else
+            i++;
+    }
+    RtlReleaseSRWLockExclusive( &contended_sections_lock );
+}
+
+/***********************************************************************
+ *           spin_adaptive
+ *
+ * Spin on a section with RTL_CRITICAL_SECTION_FLAG_DYNAMIC_SPIN. The spin count
+ * follows the number of iterations needed to acquire the section on previous
+ * calls, so that it adapts to the time the section is usually held.
+ */
+static BOOL spin_adaptive( RTL_CRITICAL_SECTION *crit )
+{
+    ULONG spin = get_spin_count( crit );
+    ULONG count, max = min( spin * 2 + 10, MAX_ADAPTIVE_SPIN_COUNT );
+    BOOL ret = FALSE;
+
+    for (count = 0; count < max; count++)
+    {
+        if (crit->LockCount > 0) break;  /* more than one waiter, don't bother spinning */
+        if (crit->LockCount == -1 && InterlockedCompareExchange( &crit->LockCount, 0, -1 ) == -1)
+        {
+            ret = TRUE;
+            break;
+        }
+        small_pause();
+    }
+    spin += ((LONG)count - (LONG)spin) / 8;
+    crit->SpinCount = RTL_CRITICAL_SECTION_FLAG_DYNAMIC_SPIN | spin;
+    return ret;
+}
+
 /***********************************************************************
  *           get_semaphore
  */
@@ -159,7 +267,7 @@ NTSTATUS WINAPI RtlInitializeCriticalSectionAndSpinCount( RTL_CRITICAL_SECTION *
  */
 NTSTATUS WINAPI RtlInitializeCriticalSectionEx( RTL_CRITICAL_SECTION *crit, ULONG spincount, ULONG flags )
 {
-    if (flags & (RTL_CRITICAL_SECTION_FLAG_DYNAMIC_SPIN|RTL_CRITICAL_SECTION_FLAG_STATIC_INIT))
+    if (flags & RTL_CRITICAL_SECTION_FLAG_STATIC_INIT)
         FIXME("(%p,%u,0x%08x) semi-stub\n", crit, spincount, flags);
 
     /* FIXME: if RTL_CRITICAL_SECTION_FLAG_STATIC_INIT is given, we should use
@@ -189,8 +297,13 @@ NTSTATUS WINAPI RtlInitializeCriticalSectionEx( RTL_CRITICAL_SECTION *crit, ULON
     crit->RecursionCount = 0;
     crit->OwningThread   = 0;
     crit->LockSemaphore  = 0;
-    if (NtCurrentTeb()->Peb->NumberOfProcessors <= 1) spincount = 0;
-    crit->SpinCount = spincount & ~0x80000000;
+    if (NtCurrentTeb()->Peb->NumberOfProcessors <= 1)
+        crit->SpinCount = 0;
+    else if (flags & RTL_CRITICAL_SECTION_FLAG_DYNAMIC_SPIN)
+        crit->SpinCount = RTL_CRITICAL_SECTION_FLAG_DYNAMIC_SPIN |
+                          min( spincount & ~RTL_CRITICAL_SECTION_ALL_FLAG_BITS, MAX_ADAPTIVE_SPIN_COUNT );
+    else
+        crit->SpinCount = spincount & ~0x80000000;
     return STATUS_SUCCESS;
 }
 
@@ -208,6 +321,7 @@ NTSTATUS WINAPI RtlInitializeCriticalSectionEx( RTL_CRITICAL_SECTION *crit, ULON
  *
  * NOTES
  *  If the system is not SMP, spincount is ignored and set to 0.
+ *  For sections using dynamic spinning, spincount is only the new starting point.
  *
  * SEE
  *  RtlInitializeCriticalSectionEx(),
@@ -217,8 +331,11 @@ NTSTATUS WINAPI RtlInitializeCriticalSectionEx( RTL_CRITICAL_SECTION *crit, ULON
  */
 ULONG WINAPI RtlSetCriticalSectionSpinCount( RTL_CRITICAL_SECTION *crit, ULONG spincount )
 {
-    ULONG oldspincount = crit->SpinCount;
+    ULONG oldspincount = get_spin_count( crit );
     if (NtCurrentTeb()->Peb->NumberOfProcessors <= 1) spincount = 0;
+    else if (crit->SpinCount & RTL_CRITICAL_SECTION_FLAG_DYNAMIC_SPIN)
+        spincount = RTL_CRITICAL_SECTION_FLAG_DYNAMIC_SPIN |
+                    min( spincount & ~RTL_CRITICAL_SECTION_ALL_FLAG_BITS, MAX_ADAPTIVE_SPIN_COUNT );
     crit->SpinCount = spincount;
     return oldspincount;
 }
@@ -247,6 +364,9 @@ NTSTATUS WINAPI RtlDeleteCriticalSection( RTL_CRITICAL_SECTION *crit )
     crit->OwningThread   = 0;
     if (crit_section_has_debuginfo( crit ))
     {
+        /* dynamic sections have their name cleared before being deleted, don't check it */
+        if (RtlContendedSections.count)
+            remove_contended_sections( crit->DebugInfo, sizeof(*crit->DebugInfo) );
         /* only free the ones we made in here */
         if (!crit->DebugInfo->Spare[0])
         {
@@ -398,12 +518,20 @@ NTSTATUS WINAPI RtlpUnWaitCriticalSection( RTL_CRITICAL_SECTION *crit )
  */
 NTSTATUS WINAPI RtlEnterCriticalSection( RTL_CRITICAL_SECTION *crit )
 {
+    BOOL contended = FALSE;
+
     if (crit->SpinCount)
     {
         ULONG count;
 
         if (RtlTryEnterCriticalSection( crit )) return STATUS_SUCCESS;
-        for (count = crit->SpinCount; count > 0; count--)
+        record_contention( crit );
+        contended = TRUE;
+        if (crit->SpinCount & RTL_CRITICAL_SECTION_FLAG_DYNAMIC_SPIN)
+        {
+            if (spin_adaptive( crit )) goto done;
+        }
+        else for (count = get_spin_count( crit ); count > 0; count--)
         {
             if (crit->LockCount > 0) break;  /* more than one waiter, don't bother spinning */
             if (crit->LockCount == -1)       /* try again */
@@ -423,6 +551,7 @@ NTSTATUS WINAPI RtlEnterCriticalSection( RTL_CRITICAL_SECTION *crit )
         }
 
         /* Now wait for it */
+        if (!contended) record_contention( crit );
         RtlpWaitForCriticalSection( crit );
     }
 done:
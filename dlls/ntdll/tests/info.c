@@ -400,6 +400,86 @@ static void test_query_process(void)
     }
 }
 
+static BOOL snapshot_has_thread( DWORD tid, LARGE_INTEGER *user_time )
+{
+    SYSTEM_PROCESS_INFORMATION *spi, *buffer;
+    ULONG size = 0x4000, len;
+    NTSTATUS status;
+    BOOL found = FALSE;
+    DWORD i;
+
+    for (;;)
+    {
+        buffer = HeapAlloc( GetProcessHeap(), 0, size );
+        status = pNtQuerySystemInformation( SystemProcessInformation, buffer, size, &len );
+        if (status != STATUS_INFO_LENGTH_MISMATCH) break;
+        HeapFree( GetProcessHeap(), 0, buffer );
+        size *= 2;
+    }
+    ok( status == STATUS_SUCCESS, "got %08x\n", status );
+
+    for (spi = buffer; !status; spi = (SYSTEM_PROCESS_INFORMATION *)((char *)spi + spi->NextEntryOffset))
+    {
+        if (spi->UniqueProcessId == ULongToHandle(GetCurrentProcessId()))
+        {
+            ok( spi->dwThreadCount > 0, "got no threads\n" );
+            for (i = 0; i < spi->dwThreadCount; i++)
+                if (spi->ti[i].ClientId.UniqueThread == ULongToHandle(tid))
+                {
+                    if (user_time) *user_time = spi->ti[i].UserTime;
+                    found = TRUE;
+                }
+            break;
+        }
+        if (!spi->NextEntryOffset)
+        {
+            ok( 0, "current process not found\n" );
+            break;
+        }
+    }
+    HeapFree( GetProcessHeap(), 0, buffer );
+    return found;
+}
+
+static DWORD WINAPI snapshot_thread( void *arg )
+{
+    return 0;
+}
+
+static void test_query_process_changes(void)
+{
+    LARGE_INTEGER time1, time2;
+    HANDLE thread;
+    DWORD tid, start;
+    BOOL found;
+
+    /* repeated snapshots must reflect threads created and destroyed in between */
+    ok( snapshot_has_thread( GetCurrentThreadId(), NULL ), "current thread not found\n" );
+
+    thread = CreateThread( NULL, 0, snapshot_thread, NULL, CREATE_SUSPENDED, &tid );
+    ok( thread != NULL, "CreateThread failed, error %u\n", GetLastError() );
+    /* the new thread is only registered once it has started running its setup code,
+     * which happens asynchronously even for suspended threads */
+    start = GetTickCount();
+    while (!(found = snapshot_has_thread( tid, NULL )) && GetTickCount() - start < 5000) Sleep( 10 );
+    ok( found, "new thread not found\n" );
+    ok( snapshot_has_thread( GetCurrentThreadId(), NULL ), "current thread not found\n" );
+
+    ResumeThread( thread );
+    WaitForSingleObject( thread, INFINITE );
+    CloseHandle( thread );
+    ok( !snapshot_has_thread( tid, NULL ), "terminated thread still listed\n" );
+    ok( snapshot_has_thread( GetCurrentThreadId(), NULL ), "current thread not found\n" );
+
+    /* thread times must be current in every snapshot */
+    ok( snapshot_has_thread( GetCurrentThreadId(), &time1 ), "current thread not found\n" );
+    start = GetTickCount();
+    while (GetTickCount() - start < 200) ;
+    ok( snapshot_has_thread( GetCurrentThreadId(), &time2 ), "current thread not found\n" );
+    ok( time2.QuadPart > time1.QuadPart, "user time didn't increase, %s -> %s\n",
+        wine_dbgstr_longlong(time1.QuadPart), wine_dbgstr_longlong(time2.QuadPart) );
+}
+
 static void test_query_procperf(void)
 {
     NTSTATUS status;
@@ -2701,6 +2781,7 @@ START_TEST(info)
     test_query_performance();
     test_query_timeofday();
     test_query_process();
+    test_query_process_changes();
     test_query_procperf();
     test_query_module();
     test_query_handle();
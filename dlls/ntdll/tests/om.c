@@ -1627,6 +1627,41 @@ static DWORD WINAPI keyed_event_thread( void *arg )
     return 0;
 }
 
+static DWORD WINAPI default_keyed_event_thread( void *arg )
+{
+    NTSTATUS status;
+    ULONG_PTR i;
+
+    for (i = 0; i < 20; i++)
+    {
+        if (i & 1)
+            status = pNtWaitForKeyedEvent( NULL, (void *)(i * 2), 0, NULL );
+        else
+            status = pNtReleaseKeyedEvent( NULL, (void *)(i * 2), 0, NULL );
+        ok( status == STATUS_SUCCESS, "%li: failed %x\n", i, status );
+        Sleep( 20 - i );
+    }
+    return 0;
+}
+
+static LONG keyed_event_apc_count;
+
+static void CALLBACK keyed_event_apc( ULONG_PTR arg )
+{
+    InterlockedIncrement( &keyed_event_apc_count );
+}
+
+static DWORD WINAPI alertable_keyed_event_thread( void *arg )
+{
+    LARGE_INTEGER timeout;
+    NTSTATUS status;
+
+    timeout.QuadPart = -50000000;
+    status = pNtWaitForKeyedEvent( NULL, (void *)0x1234, TRUE, &timeout );
+    ok( status == STATUS_SUCCESS, "NtWaitForKeyedEvent %x\n", status );
+    return 0;
+}
+
 static void test_keyed_events(void)
 {
     OBJECT_ATTRIBUTES attr;
@@ -1707,9 +1742,54 @@ static void test_keyed_events(void)
     ok( status == STATUS_TIMEOUT, "NtReleaseKeyedEvent %x\n", status );
 
     ok( WaitForSingleObject( thread, 30000 ) == 0, "wait failed\n" );
+    CloseHandle( thread );
 
     NtClose( handle );
 
+    /* same thing with the default keyed event */
+
+    thread = CreateThread( NULL, 0, default_keyed_event_thread, 0, 0, NULL );
+    for (i = 0; i < 20; i++)
+    {
+        if (i & 1)
+            status = pNtReleaseKeyedEvent( NULL, (void *)(i * 2), 0, NULL );
+        else
+            status = pNtWaitForKeyedEvent( NULL, (void *)(i * 2), 0, NULL );
+        ok( status == STATUS_SUCCESS, "%li: failed %x\n", i, status );
+        Sleep( i );
+    }
+    ok( WaitForSingleObject( thread, 30000 ) == 0, "wait failed\n" );
+    CloseHandle( thread );
+
+    status = pNtWaitForKeyedEvent( NULL, (void *)0x5678, 0, &timeout );
+    ok( status == STATUS_TIMEOUT || broken(status == STATUS_INVALID_HANDLE), /* XP/2003 */
+        "NtWaitForKeyedEvent %x\n", status );
+    status = pNtReleaseKeyedEvent( NULL, (void *)0x9abc, 0, &timeout );
+    ok( status == STATUS_TIMEOUT || broken(status == STATUS_INVALID_HANDLE), /* XP/2003 */
+        "NtReleaseKeyedEvent %x\n", status );
+
+    if (status != STATUS_INVALID_HANDLE)
+    {
+        DWORD start;
+
+        /* alertable waits are interrupted by user APCs */
+        QueueUserAPC( keyed_event_apc, GetCurrentThread(), 0 );
+        timeout.QuadPart = -50000000;
+        start = GetTickCount();
+        status = pNtWaitForKeyedEvent( NULL, (void *)0x5678, TRUE, &timeout );
+        ok( status == STATUS_USER_APC, "NtWaitForKeyedEvent %x\n", status );
+        ok( keyed_event_apc_count == 1, "got %u APC calls\n", keyed_event_apc_count );
+        ok( GetTickCount() - start < 2500, "APC wasn't delivered promptly\n" );
+
+        /* and can still be paired with a release */
+        thread = CreateThread( NULL, 0, alertable_keyed_event_thread, 0, 0, NULL );
+        status = pNtReleaseKeyedEvent( NULL, (void *)0x1234, 0, &timeout );
+        ok( status == STATUS_SUCCESS, "NtReleaseKeyedEvent %x\n", status );
+        ok( WaitForSingleObject( thread, 30000 ) == 0, "wait failed\n" );
+        CloseHandle( thread );
+        timeout.QuadPart = -100000;
+    }
+
     /* test access rights */
 
     status = pNtCreateKeyedEvent( &handle, KEYEDEVENT_WAIT, &attr, 0 );
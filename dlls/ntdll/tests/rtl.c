@@ -3077,6 +3077,85 @@ static void test_RtlInitializeCriticalSectionEx(void)
     ok(cs.SpinCount == 0 || broken(cs.SpinCount != 0) /* >= Win 8 */,
        "expected SpinCount == 0, got %ld\n", cs.SpinCount);
     RtlDeleteCriticalSection(&cs);
+
+    memset(&cs, 0x11, sizeof(cs));
+    pRtlInitializeCriticalSectionEx(&cs, 1000, RTL_CRITICAL_SECTION_FLAG_DYNAMIC_SPIN);
+    ok(cs.DebugInfo != NULL, "expected DebugInfo != NULL\n");
+    ok(cs.LockCount == -1, "expected LockCount == -1, got %d\n", cs.LockCount);
+    ok(cs.RecursionCount == 0, "expected RecursionCount == 0, got %d\n", cs.RecursionCount);
+    RtlEnterCriticalSection(&cs);
+    ok(cs.RecursionCount == 1, "expected RecursionCount == 1, got %d\n", cs.RecursionCount);
+    RtlEnterCriticalSection(&cs);
+    ok(cs.RecursionCount == 2, "expected RecursionCount == 2, got %d\n", cs.RecursionCount);
+    RtlLeaveCriticalSection(&cs);
+    RtlLeaveCriticalSection(&cs);
+    ok(cs.LockCount == -1, "expected LockCount == -1, got %d\n", cs.LockCount);
+    ok(cs.RecursionCount == 0, "expected RecursionCount == 0, got %d\n", cs.RecursionCount);
+    RtlDeleteCriticalSection(&cs);
+}
+
+static DWORD WINAPI critsect_contention_thread(void *arg)
+{
+    RTL_CRITICAL_SECTION *cs = arg;
+
+    RtlEnterCriticalSection(cs);
+    RtlLeaveCriticalSection(cs);
+    return 0;
+}
+
+static void test_RtlCriticalSectionContention(void)
+{
+    static const CRITICAL_SECTION_DEBUG *no_debug = (void *)~(ULONG_PTR)0;
+    RTL_CRITICAL_SECTION cs;
+    LONG lock_count;
+    HANDLE thread;
+    DWORD ret, i;
+
+    if (!pRtlInitializeCriticalSectionEx)
+    {
+        win_skip("RtlInitializeCriticalSectionEx is not available\n");
+        return;
+    }
+
+    pRtlInitializeCriticalSectionEx(&cs, 1000, RTL_CRITICAL_SECTION_FLAG_DYNAMIC_SPIN);
+    if (!cs.DebugInfo || cs.DebugInfo == no_debug)
+    {
+        win_skip("critical section has no debug info\n");
+        RtlDeleteCriticalSection(&cs);
+        return;
+    }
+    ok(!cs.DebugInfo->EntryCount, "got EntryCount %u\n", cs.DebugInfo->EntryCount);
+    ok(!cs.DebugInfo->ContentionCount, "got ContentionCount %u\n", cs.DebugInfo->ContentionCount);
+
+    /* uncontended entries are not counted */
+    RtlEnterCriticalSection(&cs);
+    RtlLeaveCriticalSection(&cs);
+    ok(!cs.DebugInfo->EntryCount, "got EntryCount %u\n", cs.DebugInfo->EntryCount);
+    ok(!cs.DebugInfo->ContentionCount, "got ContentionCount %u\n", cs.DebugInfo->ContentionCount);
+
+    RtlEnterCriticalSection(&cs);
+    lock_count = cs.LockCount;
+    thread = CreateThread(NULL, 0, critsect_contention_thread, &cs, 0, NULL);
+    ok(thread != NULL, "CreateThread failed with %u\n", GetLastError());
+    /* wait for the thread to give up spinning and queue as a waiter */
+    for (i = 0; i < 500 && cs.LockCount == lock_count; i++) Sleep(10);
+    ok(cs.LockCount != lock_count, "thread didn't wait for the section\n");
+    RtlLeaveCriticalSection(&cs);
+    ret = WaitForSingleObject(thread, 1000);
+    ok(ret == WAIT_OBJECT_0, "expected WAIT_OBJECT_0, got %u\n", ret);
+    CloseHandle(thread);
+
+    ok(cs.LockCount == -1, "expected LockCount == -1, got %d\n", cs.LockCount);
+    ok(cs.DebugInfo->EntryCount == 1 || broken(!cs.DebugInfo->EntryCount),
+       "got EntryCount %u\n", cs.DebugInfo->EntryCount);
+    ok(cs.DebugInfo->ContentionCount == 1, "got ContentionCount %u\n", cs.DebugInfo->ContentionCount);
+    if (!strcmp(winetest_platform, "wine") && NtCurrentTeb()->Peb->NumberOfProcessors > 1)
+    {
+        /* the spin count follows the contention but stays bounded */
+        ok(cs.SpinCount & RTL_CRITICAL_SECTION_FLAG_DYNAMIC_SPIN, "got SpinCount %#lx\n", cs.SpinCount);
+        ok((cs.SpinCount & ~RTL_CRITICAL_SECTION_ALL_FLAG_BITS) <= 4000, "got SpinCount %#lx\n", cs.SpinCount);
+    }
+    RtlDeleteCriticalSection(&cs);
 }
 
 static void test_RtlLeaveCriticalSection(void)
@@ -3519,6 +3598,7 @@ START_TEST(rtl)
     test_RtlDecompressBuffer();
     test_RtlIsCriticalSectionLocked();
     test_RtlInitializeCriticalSectionEx();
+    test_RtlCriticalSectionContention();
     test_RtlLeaveCriticalSection();
     test_LdrEnumerateLoadedModules();
     test_RtlMakeSelfRelativeSD();
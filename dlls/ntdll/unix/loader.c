@@ -409,21 +409,99 @@ void CDECL wine_get_host_version( const char **sysname, const char **release )
 }
 
 
-static void preloader_exec( char **argv )
+/* return the path of the preloader to use with the given loader, or NULL if there is none */
+static char *get_preloader_path( const char *loader )
 {
-    if (use_preloader)
+    const char *preloader = "wine-preloader";
+    const char *p;
+    char *path;
+
+    if (!use_preloader) return NULL;
+
+    if (!(p = strrchr( loader, '/' ))) p = loader;
+    else p++;
+
+    if (strlen(p) > 2 && !strcmp( p + strlen(p) - 2, "64" )) preloader = "wine64-preloader";
+    if (!(path = malloc( p - loader + strlen(preloader) + 1 ))) return NULL;
+    memcpy( path, loader, p - loader );
+    strcpy( path + (p - loader), preloader );
+    return path;
+}
+
+/* call func for each path where the loader may be found, in search order */
+static void enum_loader_paths( const char *loader, const char *loader_env, client_cpu_t cpu,
+                               void (*func)( const char *path, void *arg ), void *arg )
+{
+    char *p, *path, *dir, *saveptr;
+
+    if (build_dir)
+    {
+        path = build_path( build_dir, (cpu == CPU_x86_64) ? "loader/wine64" : "loader/wine" );
+        func( path, arg );
+        free( path );
+        return;
+    }
+
+    if ((p = strrchr( loader, '/' ))) loader = p + 1;
+
+    path = build_path( bin_dir, loader );
+    func( path, arg );
+    free( path );
+
+    if (loader_env) func( loader_env, arg );
+
+    if ((p = getenv( "PATH" )) && (p = strdup( p )))
     {
-        static const char *preloader = "wine-preloader";
-        char *p;
+        for (dir = strtok_r( p, ":", &saveptr ); dir; dir = strtok_r( NULL, ":", &saveptr ))
+        {
+            path = build_path( dir, loader );
+            func( path, arg );
+            free( path );
+        }
+        free( p );
+    }
+
+    path = build_path( BINDIR, loader );
+    func( path, arg );
+    free( path );
+}
+
+/* remap WINELOADER to the alternate 32/64-bit version if necessary; the new
+ * environment string is returned in env, and becomes the loader name */
+static const char *get_wineloader( const pe_image_info_t *pe_info, char **env )
+{
+    int is_child_64bit = (pe_info->cpu == CPU_x86_64 || pe_info->cpu == CPU_ARM64);
+    const char *loader_env = getenv( "WINELOADER" );
+    int len;
 
-        if (!(p = strrchr( argv[1], '/' ))) p = argv[1];
-        else p++;
+    *env = NULL;
+    if (!is_win64 == !is_child_64bit) return argv0;
+    if (!loader_env) return is_child_64bit ? "wine64" : "wine";
 
-        if (strlen(p) > 2 && !strcmp( p + strlen(p) - 2, "64" )) preloader = "wine64-preloader";
-        argv[0] = malloc( p - argv[1] + strlen(preloader) + 1 );
-        memcpy( argv[0], argv[1], p - argv[1] );
-        strcpy( argv[0] + (p - argv[1]), preloader );
+    len = strlen( loader_env );
+    if (!(*env = malloc( sizeof("WINELOADER=") + len + 2 ))) return NULL;
+    strcpy( *env, "WINELOADER=" );
+    strcat( *env, loader_env );
+    if (is_child_64bit)
+    {
+        strcat( *env, "64" );
+    }
+    else
+    {
+        len += sizeof("WINELOADER=") - 1;
+        if (!strcmp( *env + len - 2, "64" )) (*env)[len - 2] = 0;
+    }
+    return *env;
+}
+
+/* argv[1] is the loader path, argv[0] is reserved for the preloader */
+static void preloader_exec( const char *path, void *arg )
+{
+    char **argv = arg;
 
+    argv[1] = (char *)path;
+    if ((argv[0] = get_preloader_path( path )))
+    {
 #ifdef __APPLE__
         {
             posix_spawnattr_t attr;
@@ -441,90 +519,170 @@ static void preloader_exec( char **argv )
 
 static NTSTATUS loader_exec( const char *loader, char **argv, client_cpu_t cpu )
 {
-    char *p, *path;
+    enum_loader_paths( loader, getenv( "WINELOADER" ), cpu, preloader_exec, argv );
+    return STATUS_INVALID_IMAGE_FORMAT;
+}
 
-    if (build_dir)
-    {
-        argv[1] = build_path( build_dir, (cpu == CPU_x86_64) ? "loader/wine64" : "loader/wine" );
-        preloader_exec( argv );
-        return STATUS_INVALID_IMAGE_FORMAT;
-    }
 
-    if ((p = strrchr( loader, '/' ))) loader = p + 1;
+/***********************************************************************
+ *           exec_wineloader
+ *
+ * argv[0] and argv[1] must be reserved for the preloader and loader respectively.
+ */
+NTSTATUS exec_wineloader( char **argv, int socketfd, const pe_image_info_t *pe_info )
+{
+    ULONGLONG res_start = pe_info->base;
+    ULONGLONG res_end = pe_info->base + pe_info->map_size;
+    const char *loader;
+    char preloader_reserve[64], socket_env[64], *env;
 
-    argv[1] = build_path( bin_dir, loader );
-    preloader_exec( argv );
+    if (!(loader = get_wineloader( pe_info, &env ))) return STATUS_NO_MEMORY;
+    if (env) putenv( env );
 
-    argv[1] = getenv( "WINELOADER" );
-    if (argv[1]) preloader_exec( argv );
+    signal( SIGPIPE, SIG_DFL );
 
-    if ((path = getenv( "PATH" )))
+    sprintf( socket_env, "WINESERVERSOCKET=%u", socketfd );
+    sprintf( preloader_reserve, "WINEPRELOADRESERVE=%x%08x-%x%08x",
+             (ULONG)(res_start >> 32), (ULONG)res_start, (ULONG)(res_end >> 32), (ULONG)res_end );
+
+    putenv( preloader_reserve );
+    putenv( socket_env );
+
+    return loader_exec( loader, argv, pe_info->cpu );
+}
+
+
+#ifdef __linux__
+
+extern char **environ;
+
+static BOOL add_spawn_path( struct wineloader_spawn *spawn, char *preloader, char *loader )
+{
+    char **paths;
+
+    if (!loader || !(paths = realloc( spawn->paths, (spawn->count + 1) * 2 * sizeof(*paths) )))
     {
-        for (p = strtok( strdup( path ), ":" ); p; p = strtok( NULL, ":" ))
-        {
-            argv[1] = build_path( p, loader );
-            preloader_exec( argv );
-        }
+        free( preloader );
+        free( loader );
+        return FALSE;
     }
+    spawn->paths = paths;
+    paths[2 * spawn->count] = preloader;
+    paths[2 * spawn->count + 1] = loader;
+    spawn->count++;
+    return TRUE;
+}
 
-    argv[1] = build_path( BINDIR, loader );
-    preloader_exec( argv );
-    return STATUS_INVALID_IMAGE_FORMAT;
+static void add_spawn_loader( const char *loader, void *arg )
+{
+    struct wineloader_spawn *spawn = arg;
+    char *preloader = get_preloader_path( loader );
+
+    if (preloader) add_spawn_path( spawn, preloader, strdup( loader ));
+    add_spawn_path( spawn, NULL, strdup( loader ));
 }
 
+static char *make_env_string( const char *name, const char *value )
+{
+    char *str = malloc( strlen(name) + strlen(value) + 2 );
+
+    if (str) sprintf( str, "%s=%s", name, value );
+    return str;
+}
 
 /***********************************************************************
- *           exec_wineloader
+ *           prepare_wineloader_spawn
  *
- * argv[0] and argv[1] must be reserved for the preloader and loader respectively.
+ * Compute the loader paths and environment that exec_wineloader would use, so
+ * that a child sharing our address space only has to call execve().
  */
-NTSTATUS exec_wineloader( char **argv, int socketfd, const pe_image_info_t *pe_info )
+NTSTATUS prepare_wineloader_spawn( struct wineloader_spawn *spawn, int socketfd,
+                                   const pe_image_info_t *pe_info, const char *winedebug )
 {
-    int is_child_64bit = (pe_info->cpu == CPU_x86_64 || pe_info->cpu == CPU_ARM64);
+    static const char * const overrides[] = { "WINELOADER=", "WINEDEBUG=", "WINESERVERSOCKET=", "WINEPRELOADRESERVE=" };
     ULONGLONG res_start = pe_info->base;
     ULONGLONG res_end = pe_info->base + pe_info->map_size;
-    const char *loader = argv0;
-    const char *loader_env = getenv( "WINELOADER" );
-    char preloader_reserve[64], socket_env[64];
+    const char *loader, *loader_env;
+    char buffer[64];
+    unsigned int i, j, count = 0;
+
+    memset( spawn, 0, sizeof(*spawn) );
+
+    if (!(loader = get_wineloader( pe_info, &spawn->strings[0] ))) return STATUS_NO_MEMORY;
+    if (spawn->strings[0]) loader_env = spawn->strings[0] + sizeof("WINELOADER=") - 1;
+    else loader_env = getenv( "WINELOADER" );
+
+    sprintf( buffer, "%u", socketfd );
+    spawn->strings[1] = make_env_string( "WINESERVERSOCKET", buffer );
+    sprintf( buffer, "%x%08x-%x%08x",
+             (ULONG)(res_start >> 32), (ULONG)res_start, (ULONG)(res_end >> 32), (ULONG)res_end );
+    spawn->strings[2] = make_env_string( "WINEPRELOADRESERVE", buffer );
+    if (!spawn->strings[1] || !spawn->strings[2]) goto failed;
 
-    if (!is_win64 ^ !is_child_64bit)
+    /* build the environment, replacing the variables set by exec_wineloader */
+    for (i = 0; environ[i]; i++) count++;
+    if (!(spawn->envp = malloc( (count + 5) * sizeof(*spawn->envp) ))) goto failed;
+    for (i = count = 0; environ[i]; i++)
     {
-        /* remap WINELOADER to the alternate 32/64-bit version if necessary */
-        if (loader_env)
+        for (j = 0; j < ARRAY_SIZE(overrides); j++)
         {
-            int len = strlen( loader_env );
-            char *env = malloc( sizeof("WINELOADER=") + len + 2 );
-
-            if (!env) return STATUS_NO_MEMORY;
-            strcpy( env, "WINELOADER=" );
-            strcat( env, loader_env );
-            if (is_child_64bit)
-            {
-                strcat( env, "64" );
-            }
-            else
-            {
-                len += sizeof("WINELOADER=") - 1;
-                if (!strcmp( env + len - 2, "64" )) env[len - 2] = 0;
-            }
-            loader = env;
-            putenv( env );
+            if (j == 0 && !spawn->strings[0]) continue;
+            if (j == 1 && !winedebug) continue;
+            if (!strncmp( environ[i], overrides[j], strlen(overrides[j]) )) break;
         }
-        else loader = is_child_64bit ? "wine64" : "wine";
+        if (j == ARRAY_SIZE(overrides)) spawn->envp[count++] = environ[i];
     }
+    if (spawn->strings[0]) spawn->envp[count++] = spawn->strings[0];
+    if (winedebug) spawn->envp[count++] = (char *)winedebug;
+    spawn->envp[count++] = spawn->strings[1];
+    spawn->envp[count++] = spawn->strings[2];
+    spawn->envp[count] = NULL;
+
+    enum_loader_paths( loader, loader_env, pe_info->cpu, add_spawn_loader, spawn );
+    if (spawn->count) return STATUS_SUCCESS;
+
+failed:
+    free_wineloader_spawn( spawn );
+    return STATUS_NO_MEMORY;
+}
 
-    signal( SIGPIPE, SIG_DFL );
 
-    sprintf( socket_env, "WINESERVERSOCKET=%u", socketfd );
-    sprintf( preloader_reserve, "WINEPRELOADRESERVE=%x%08x-%x%08x",
-             (ULONG)(res_start >> 32), (ULONG)res_start, (ULONG)(res_end >> 32), (ULONG)res_end );
+/***********************************************************************
+ *           exec_wineloader_spawn
+ *
+ * Exec the loader prepared by prepare_wineloader_spawn. Only makes system calls.
+ * argv[0] and argv[1] must be reserved for the preloader and loader respectively.
+ */
+void exec_wineloader_spawn( const struct wineloader_spawn *spawn, char **argv )
+{
+    unsigned int i;
 
-    putenv( preloader_reserve );
-    putenv( socket_env );
+    for (i = 0; i < spawn->count; i++)
+    {
+        argv[0] = spawn->paths[2 * i];
+        argv[1] = spawn->paths[2 * i + 1];
+        if (argv[0]) execve( argv[0], argv, spawn->envp );
+        else execve( argv[1], argv + 1, spawn->envp );
+    }
+}
 
-    return loader_exec( loader, argv, pe_info->cpu );
+
+/***********************************************************************
+ *           free_wineloader_spawn
+ */
+void free_wineloader_spawn( struct wineloader_spawn *spawn )
+{
+    unsigned int i;
+
+    for (i = 0; i < 2 * spawn->count; i++) free( spawn->paths[i] );
+    for (i = 0; i < ARRAY_SIZE(spawn->strings); i++) free( spawn->strings[i] );
+    free( spawn->paths );
+    free( spawn->envp );
+    memset( spawn, 0, sizeof(*spawn) );
 }
 
+#endif  /* __linux__ */
+
 
 /***********************************************************************
  *           exec_wineserver
@@ -23,6 +23,7 @@
 #pragma makedep unix
 #endif
 
+#define _GNU_SOURCE  /* for clone() */
 #include "config.h"
 #include "wine/port.h"
 
@@ -37,6 +38,9 @@
 #ifdef HAVE_SYS_SOCKET_H
 #include <sys/socket.h>
 #endif
+#ifdef HAVE_SYS_MMAN_H
+# include <sys/mman.h>
+#endif
 #ifdef HAVE_SYS_TIME_H
 # include <sys/time.h>
 #endif
@@ -50,6 +54,9 @@
 #ifdef HAVE_UNISTD_H
 # include <unistd.h>
 #endif
+#ifdef HAVE_SCHED_H
+# include <sched.h>
+#endif
 #ifdef __APPLE__
 # include <CoreFoundation/CoreFoundation.h>
 # include <pthread.h>
@@ -549,6 +556,116 @@ static void set_stdio_fd( int stdin_fd, int stdout_fd )
 }
 
 
+static BOOL use_new_session( const RTL_USER_PROCESS_PARAMETERS *params )
+{
+    return (params->ConsoleFlags ||
+            params->ConsoleHandle == (HANDLE)1 /* KERNEL32_CONSOLE_ALLOC */ ||
+            (params->hStdInput == INVALID_HANDLE_VALUE && params->hStdOutput == INVALID_HANDLE_VALUE));
+}
+
+
+#ifdef __linux__
+
+#define SPAWN_STACK_SIZE 0x10000
+
+struct spawn_context
+{
+    struct wineloader_spawn loader;
+    char                  **argv;
+    sigset_t                sigset;      /* signal mask to restore before exec */
+    int                     stdin_fd;
+    int                     stdout_fd;
+    int                     unixdir;
+    BOOL                    new_session;
+};
+
+/***********************************************************************
+ *           spawn_child
+ *
+ * Entry point of the new process. It shares our address space until it
+ * calls execve(), so it must only make system calls.
+ */
+static int spawn_child( void *arg )
+{
+    struct spawn_context *ctx = arg;
+    struct sigaction sa;
+    int sig;
+
+    /* our handlers must not run before the exec, the signal table is private to this process */
+    for (sig = 1; sig < _NSIG; sig++)
+    {
+        if (sigaction( sig, NULL, &sa ) || sa.sa_handler == SIG_DFL) continue;
+        if (sa.sa_handler == SIG_IGN && sig != SIGPIPE) continue;
+        memset( &sa, 0, sizeof(sa) );
+        sa.sa_handler = SIG_DFL;
+        sigaction( sig, &sa, NULL );
+    }
+
+    if (ctx->new_session)
+    {
+        setsid();
+        set_stdio_fd( -1, -1 );  /* close stdin and stdout */
+    }
+    else set_stdio_fd( ctx->stdin_fd, ctx->stdout_fd );
+
+    if (ctx->stdin_fd != -1) close( ctx->stdin_fd );
+    if (ctx->stdout_fd != -1) close( ctx->stdout_fd );
+    if (ctx->unixdir != -1)
+    {
+        fchdir( ctx->unixdir );
+        close( ctx->unixdir );
+    }
+
+    sigprocmask( SIG_SETMASK, &ctx->sigset, NULL );
+    exec_wineloader_spawn( &ctx->loader, ctx->argv );
+    _exit(1);
+}
+
+/***********************************************************************
+ *           spawn_loader
+ *
+ * Same as the double fork in spawn_process, but without copying our address
+ * space: the intermediate process is created with vfork() and the new process
+ * with clone() on a private stack. Everything is prepared beforehand.
+ * Returns the pid of the intermediate process.
+ */
+static pid_t spawn_loader( const RTL_USER_PROCESS_PARAMETERS *params, int socketfd, int unixdir,
+                           char *winedebug, const pe_image_info_t *pe_info, int stdin_fd, int stdout_fd )
+{
+    struct spawn_context ctx;
+    sigset_t all_signals;
+    char *stack;
+    pid_t pid = -1;
+
+    if (prepare_wineloader_spawn( &ctx.loader, socketfd, pe_info, winedebug )) return -1;
+    if (!(ctx.argv = build_argv( &params->CommandLine, 2 ))) goto done;
+    stack = mmap( NULL, SPAWN_STACK_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0 );
+    if (stack == MAP_FAILED) goto done;
+
+    ctx.stdin_fd    = stdin_fd;
+    ctx.stdout_fd   = stdout_fd;
+    ctx.unixdir     = unixdir;
+    ctx.new_session = use_new_session( params );
+
+    sigfillset( &all_signals );
+    pthread_sigmask( SIG_SETMASK, &all_signals, &ctx.sigset );
+    if (!(pid = vfork()))  /* child */
+    {
+        pid = clone( spawn_child, stack + SPAWN_STACK_SIZE, CLONE_VM | CLONE_VFORK | SIGCHLD, &ctx );
+        _exit(pid == -1);
+    }
+    pthread_sigmask( SIG_SETMASK, &ctx.sigset, NULL );
+    munmap( stack, SPAWN_STACK_SIZE );
+
+done:
+    free( ctx.argv );
+    free_wineloader_spawn( &ctx.loader );
+    return pid;
+}
+
+#endif  /* __linux__ */
+
+
 /***********************************************************************
  *           spawn_process
  */
@@ -563,13 +680,14 @@ static NTSTATUS spawn_process( const RTL_USER_PROCESS_PARAMETERS *params, int so
     wine_server_handle_to_fd( params->hStdInput, FILE_READ_DATA, &stdin_fd, NULL );
     wine_server_handle_to_fd( params->hStdOutput, FILE_WRITE_DATA, &stdout_fd, NULL );
 
+#ifdef __linux__
+    if ((pid = spawn_loader( params, socketfd, unixdir, winedebug, pe_info, stdin_fd, stdout_fd )) == -1)
+#endif
     if (!(pid = fork()))  /* child */
     {
         if (!(pid = fork()))  /* grandchild */
         {
-            if (params->ConsoleFlags ||
-                params->ConsoleHandle == (HANDLE)1 /* KERNEL32_CONSOLE_ALLOC */ ||
-                (params->hStdInput == INVALID_HANDLE_VALUE && params->hStdOutput == INVALID_HANDLE_VALUE))
+            if (use_new_session( params ))
             {
                 setsid();
                 set_stdio_fd( -1, -1 );  /* close stdin and stdout */
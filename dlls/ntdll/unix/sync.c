@@ -184,6 +184,251 @@ static void timespec_from_timeout( struct timespec *timespec, const LARGE_INTEGE
 #endif
 
 
+/* The process keyed event is implemented in the client: threads waiting or
+ * releasing a key are queued in buckets hashed by key address, and each wait
+ * is paired with exactly one release without going through the server.
+ *
+ * A blocked thread sleeps on a futex when they are available, and on a per-thread
+ * condition variable otherwise. Alertable waits need to be interrupted by user
+ * APCs, which are only delivered in server waits, so these threads block in the
+ * server instead, on the process keyed event with their own wait structure as
+ * the key, and the thread pairing with them releases that key. */
+
+struct keyed_event_bucket
+{
+    pthread_mutex_t mutex;
+    struct list     waiters;    /* threads blocked in NtWaitForKeyedEvent */
+    struct list     releasers;  /* threads blocked in NtReleaseKeyedEvent */
+};
+
+static struct keyed_event_bucket keyed_event_buckets[64];
+static pthread_once_t keyed_event_once = PTHREAD_ONCE_INIT;
+
+static void init_keyed_event_buckets(void)
+{
+    unsigned int i;
+
+    for (i = 0; i < ARRAY_SIZE(keyed_event_buckets); i++)
+    {
+        pthread_mutex_init( &keyed_event_buckets[i].mutex, NULL );
+        list_init( &keyed_event_buckets[i].waiters );
+        list_init( &keyed_event_buckets[i].releasers );
+    }
+}
+
+static inline struct keyed_event_bucket *hash_keyed_event( const void *key )
+{
+    ULONG_PTR val = (ULONG_PTR)key;
+
+    return &keyed_event_buckets[(val >> 2) % ARRAY_SIZE(keyed_event_buckets)];
+}
+
+static inline BOOL keyed_event_wait_queued( const struct keyed_event_wait *wait )
+{
+    return wait->entry.next && wait->entry.next != &wait->entry;
+}
+
+static inline BOOL keyed_event_use_futex(void)
+{
+#ifdef __linux__
+    return use_futexes();
+#else
+    return FALSE;
+#endif
+}
+
+static NTSTATUS server_keyed_event_op( HANDLE handle, const void *key, BOOLEAN alertable,
+                                       const LARGE_INTEGER *timeout, BOOL release )
+{
+    select_op_t select_op;
+    UINT flags = SELECT_INTERRUPTIBLE;
+
+    if (alertable) flags |= SELECT_ALERTABLE;
+    select_op.keyed_event.op     = release ? SELECT_KEYED_EVENT_RELEASE : SELECT_KEYED_EVENT_WAIT;
+    select_op.keyed_event.handle = wine_server_obj_handle( handle );
+    select_op.keyed_event.key    = wine_server_client_ptr( key );
+    return server_wait( &select_op, sizeof(select_op.keyed_event), flags, timeout );
+}
+
+/* wake up a thread that has been removed from its queue; called with the bucket lock held */
+static void wake_keyed_event_wait( struct keyed_event_wait *wait )
+{
+    if (wait->alertable) return;  /* woken through the server once the lock is dropped */
+
+    if (keyed_event_use_futex())
+    {
+#ifdef __linux__
+        InterlockedExchange( &wait->signaled, 1 );
+        futex_wake( &wait->signaled, 1 );
+#endif
+        return;
+    }
+    pthread_mutex_lock( &wait->mutex );
+    wait->signaled = 1;
+    pthread_cond_signal( &wait->cond );
+    pthread_mutex_unlock( &wait->mutex );
+}
+
+/* block until woken up by wake_keyed_event_wait(), or until the absolute time "end" */
+static NTSTATUS block_keyed_event_wait( struct keyed_event_wait *wait, BOOLEAN alertable,
+                                        const LARGE_INTEGER *end )
+{
+    NTSTATUS ret = STATUS_SUCCESS;
+
+    if (wait->alertable)
+        return server_keyed_event_op( keyed_event, wait, alertable, end, FALSE );
+
+    if (keyed_event_use_futex())
+    {
+#ifdef __linux__
+        struct timespec timespec, *ptr = NULL;
+        LARGE_INTEGER now;
+
+        while (!InterlockedCompareExchange( &wait->signaled, 0, 0 ))
+        {
+            if (end)
+            {
+                NtQuerySystemTime( &now );
+                if (now.QuadPart >= end->QuadPart) return STATUS_TIMEOUT;
+                timespec.tv_sec  = (end->QuadPart - now.QuadPart) / TICKSPERSEC;
+                timespec.tv_nsec = ((end->QuadPart - now.QuadPart) % TICKSPERSEC) * 100;
+                ptr = &timespec;
+            }
+            futex_wait( &wait->signaled, 0, ptr );
+        }
+#endif
+        return STATUS_SUCCESS;
+    }
+
+    pthread_mutex_lock( &wait->mutex );
+    while (!wait->signaled)
+    {
+        struct timespec abstime;
+
+        if (!end)
+        {
+            pthread_cond_wait( &wait->cond, &wait->mutex );
+            continue;
+        }
+        abstime.tv_sec  = (end->QuadPart - TICKS_1601_TO_1970) / TICKSPERSEC;
+        abstime.tv_nsec = ((end->QuadPart - TICKS_1601_TO_1970) % TICKSPERSEC) * 100;
+        if (pthread_cond_timedwait( &wait->cond, &wait->mutex, &abstime ) == ETIMEDOUT && !wait->signaled)
+        {
+            ret = STATUS_TIMEOUT;
+            break;
+        }
+    }
+    pthread_mutex_unlock( &wait->mutex );
+    return ret;
+}
+
+static NTSTATUS fast_keyed_event_op( const void *key, BOOLEAN alertable,
+                                     const LARGE_INTEGER *timeout, BOOL release )
+{
+    struct keyed_event_wait *wait = &ntdll_get_thread_data()->keyed_wait;
+    struct keyed_event_wait *peer;
+    struct keyed_event_bucket *bucket;
+    struct list *queue, *peers;
+    LARGE_INTEGER now, end;
+    NTSTATUS ret;
+    sigset_t sigset;
+
+    if (!keyed_event_use_futex() && !wait->cond_init)
+    {
+        pthread_mutex_init( &wait->mutex, NULL );
+        pthread_cond_init( &wait->cond, NULL );
+        wait->cond_init = TRUE;
+    }
+
+    pthread_once( &keyed_event_once, init_keyed_event_buckets );
+    bucket = hash_keyed_event( key );
+    queue = release ? &bucket->releasers : &bucket->waiters;
+    peers = release ? &bucket->waiters : &bucket->releasers;
+
+    server_enter_uninterrupted_section( &bucket->mutex, &sigset );
+    LIST_FOR_EACH_ENTRY( peer, peers, struct keyed_event_wait, entry )
+    {
+        BOOL server_wake;
+
+        if (peer->key != key) continue;
+        list_remove( &peer->entry );
+        list_init( &peer->entry );
+        server_wake = peer->alertable;
+        wake_keyed_event_wait( peer );
+        server_leave_uninterrupted_section( &bucket->mutex, &sigset );
+        /* the peer stays blocked in the server until this release, so it can't reuse its wait structure */
+        if (server_wake) server_keyed_event_op( keyed_event, peer, FALSE, NULL, TRUE );
+        return STATUS_SUCCESS;
+    }
+    if (timeout && !timeout->QuadPart)
+    {
+        server_leave_uninterrupted_section( &bucket->mutex, &sigset );
+        return STATUS_TIMEOUT;
+    }
+    wait->key = key;
+    wait->signaled = 0;
+    wait->alertable = alertable;
+    list_add_tail( queue, &wait->entry );
+    server_leave_uninterrupted_section( &bucket->mutex, &sigset );
+
+    if (timeout)
+    {
+        if (timeout->QuadPart < 0)
+        {
+            NtQuerySystemTime( &now );
+            end.QuadPart = now.QuadPart - timeout->QuadPart;
+        }
+        else end = *timeout;
+    }
+
+    if (!(ret = block_keyed_event_wait( wait, alertable, timeout ? &end : NULL ))) return ret;
+
+    /* timed out or interrupted by an APC, leave the queue unless we got paired in the meantime */
+    server_enter_uninterrupted_section( &bucket->mutex, &sigset );
+    if (keyed_event_wait_queued( wait ))
+    {
+        list_remove( &wait->entry );
+        list_init( &wait->entry );
+        server_leave_uninterrupted_section( &bucket->mutex, &sigset );
+        return ret;
+    }
+    server_leave_uninterrupted_section( &bucket->mutex, &sigset );
+
+    /* the thread that paired with us is about to wake us up, consume that wakeup */
+    block_keyed_event_wait( wait, FALSE, NULL );
+    return STATUS_SUCCESS;
+}
+
+/***********************************************************************
+ *           keyed_event_thread_exit
+ *
+ * Remove a terminated thread from the keyed event queues.
+ */
+void keyed_event_thread_exit(void)
+{
+    struct keyed_event_wait *wait = &ntdll_get_thread_data()->keyed_wait;
+    struct keyed_event_bucket *bucket;
+    sigset_t sigset;
+
+    if (keyed_event_wait_queued( wait ))
+    {
+        bucket = hash_keyed_event( wait->key );
+        server_enter_uninterrupted_section( &bucket->mutex, &sigset );
+        if (keyed_event_wait_queued( wait ))
+        {
+            list_remove( &wait->entry );
+            list_init( &wait->entry );
+        }
+        server_leave_uninterrupted_section( &bucket->mutex, &sigset );
+    }
+    if (wait->cond_init)
+    {
+        pthread_cond_destroy( &wait->cond );
+        pthread_mutex_destroy( &wait->mutex );
+    }
+}
+
+
 static BOOL compare_addr( const void *addr, const void *cmp, SIZE_T size )
 {
     switch (size)
@@ -1537,16 +1782,10 @@ NTSTATUS WINAPI NtOpenKeyedEvent( HANDLE *handle, ACCESS_MASK access, const OBJE
 NTSTATUS WINAPI NtWaitForKeyedEvent( HANDLE handle, const void *key,
                                      BOOLEAN alertable, const LARGE_INTEGER *timeout )
 {
-    select_op_t select_op;
-    UINT flags = SELECT_INTERRUPTIBLE;
-
     if (!handle) handle = keyed_event;
     if ((ULONG_PTR)key & 1) return STATUS_INVALID_PARAMETER_1;
-    if (alertable) flags |= SELECT_ALERTABLE;
-    select_op.keyed_event.op     = SELECT_KEYED_EVENT_WAIT;
-    select_op.keyed_event.handle = wine_server_obj_handle( handle );
-    select_op.keyed_event.key    = wine_server_client_ptr( key );
-    return server_wait( &select_op, sizeof(select_op.keyed_event), flags, timeout );
+    if (handle == keyed_event) return fast_keyed_event_op( key, alertable, timeout, FALSE );
+    return server_keyed_event_op( handle, key, alertable, timeout, FALSE );
 }
 
 
@@ -1556,16 +1795,10 @@ NTSTATUS WINAPI NtWaitForKeyedEvent( HANDLE handle, const void *key,
 NTSTATUS WINAPI NtReleaseKeyedEvent( HANDLE handle, const void *key,
                                      BOOLEAN alertable, const LARGE_INTEGER *timeout )
 {
-    select_op_t select_op;
-    UINT flags = SELECT_INTERRUPTIBLE;
-
     if (!handle) handle = keyed_event;
     if ((ULONG_PTR)key & 1) return STATUS_INVALID_PARAMETER_1;
-    if (alertable) flags |= SELECT_ALERTABLE;
-    select_op.keyed_event.op     = SELECT_KEYED_EVENT_RELEASE;
-    select_op.keyed_event.handle = wine_server_obj_handle( handle );
-    select_op.keyed_event.key    = wine_server_client_ptr( key );
-    return server_wait( &select_op, sizeof(select_op.keyed_event), flags, timeout );
+    if (handle == keyed_event) return fast_keyed_event_op( key, alertable, timeout, TRUE );
+    return server_keyed_event_op( handle, key, alertable, timeout, TRUE );
 }
 
 
@@ -2036,6 +2036,158 @@ static void get_timezone_info( RTL_DYNAMIC_TIME_ZONE_INFORMATION *tzi )
 }
 
 
+/* last process list returned by the server, used to only request the changed entries */
+static pthread_mutex_t process_snapshot_mutex = PTHREAD_MUTEX_INITIALIZER;
+static char *process_snapshot;
+static data_size_t process_snapshot_size;
+static unsigned int process_snapshot_count;
+static unsigned int process_snapshot_generation;
+
+/* return the offset following a process_info entry and its thread array */
+static data_size_t skip_process_info( const char *buffer, data_size_t pos )
+{
+    const struct process_info *info = (const struct process_info *)(buffer + pos);
+
+    pos = (pos + sizeof(*info) + info->name_len + 7) & ~7;
+    return pos + info->thread_count * sizeof(struct thread_info);
+}
+
+/* fill the omitted names and threads of a partial server reply from the cached snapshot */
+static BOOL merge_process_snapshot( char *dst, data_size_t *dst_size, const char *src,
+                                    unsigned int count, unsigned int generation )
+{
+    data_size_t src_pos = 0, dst_pos = 0, cache_pos = 0, data_pos, data_end;
+    unsigned int i, cache_index = 0;
+
+    for (i = 0; i < count; i++)
+    {
+        const struct process_info *info;
+        struct process_info *out;
+        const char *data;
+
+        src_pos = (src_pos + 7) & ~7;
+        dst_pos = (dst_pos + 7) & ~7;
+        info = (const struct process_info *)(src + src_pos);
+        out = (struct process_info *)(dst + dst_pos);
+        *out = *info;
+
+        if (info->generation > generation)
+        {
+            data = src;
+            data_pos = src_pos + sizeof(*info);
+            data_end = skip_process_info( src, src_pos );
+        }
+        else
+        {
+            const struct process_info *cached = NULL;
+
+            /* both lists are in server order, new processes are only appended */
+            while (!cached && cache_index < process_snapshot_count)
+            {
+                cache_pos = (cache_pos + 7) & ~7;
+                cached = (const struct process_info *)(process_snapshot + cache_pos);
+                data_pos = cache_pos + sizeof(*cached);
+                data_end = cache_pos = skip_process_info( process_snapshot, cache_pos );
+                cache_index++;
+                if (cached->pid != info->pid) cached = NULL;
+            }
+            if (!cached) return FALSE;
+            out->name_len = cached->name_len;
+            out->thread_count = cached->thread_count;
+            data = process_snapshot;
+        }
+        src_pos = skip_process_info( src, src_pos );
+        /* entry offsets are 8-byte aligned in both buffers, so the padding is preserved */
+        memcpy( dst + dst_pos + sizeof(*out), data + data_pos, data_end - data_pos );
+        dst_pos += sizeof(*out) + data_end - data_pos;
+    }
+    *dst_size = dst_pos;
+    return TRUE;
+}
+
+/* retrieve a private copy of the full server process list */
+static NTSTATUS get_process_snapshot( char **ret_buffer, data_size_t *ret_size, unsigned int *ret_count )
+{
+    unsigned int count = 0, generation, new_generation = 0;
+    data_size_t size, info_size = 0;
+    char *buffer = NULL;
+    NTSTATUS status;
+
+    mutex_lock( &process_snapshot_mutex );
+
+    generation = process_snapshot_generation;
+    size = max( process_snapshot_size, 4096 );
+    for (;;)
+    {
+        if (!(buffer = malloc( size )))
+        {
+            status = STATUS_NO_MEMORY;
+            break;
+        }
+        SERVER_START_REQ( list_processes )
+        {
+            req->generation = generation;
+            wine_server_set_reply( req, buffer, size );
+            status = wine_server_call( req );
+            info_size = reply->info_size;
+            count = reply->process_count;
+            new_generation = reply->generation;
+        }
+        SERVER_END_REQ;
+
+        if (status == STATUS_INFO_LENGTH_MISMATCH)
+        {
+            free( buffer );
+            buffer = NULL;
+            size = info_size;
+            continue;
+        }
+        if (status || !generation) break;
+
+        if (new_generation >= generation)
+        {
+            char *full;
+            data_size_t full_size;
+
+            if ((full = malloc( info_size + process_snapshot_size )) &&
+                merge_process_snapshot( full, &full_size, buffer, count, generation ))
+            {
+                free( buffer );
+                buffer = full;
+                info_size = full_size;
+                break;
+            }
+            free( full );
+        }
+        /* the cached snapshot can't be used, fall back to a full one */
+        free( buffer );
+        buffer = NULL;
+        generation = 0;
+    }
+
+    if (!status)
+    {
+        free( process_snapshot );
+        process_snapshot = buffer;
+        process_snapshot_size = info_size;
+        process_snapshot_count = count;
+        process_snapshot_generation = new_generation;
+
+        if ((*ret_buffer = malloc( max( info_size, 1 ) )))
+        {
+            memcpy( *ret_buffer, buffer, info_size );
+            *ret_size = info_size;
+            *ret_count = count;
+        }
+        else status = STATUS_NO_MEMORY;
+    }
+    else free( buffer );
+
+    mutex_unlock( &process_snapshot_mutex );
+    return status;
+}
+
+
 /******************************************************************************
  *              NtQuerySystemInformation  (NTDLL.@)
  */
@@ -2123,27 +2275,9 @@ NTSTATUS WINAPI NtQuerySystemInformation( SYSTEM_INFORMATION_CLASS class,
         unsigned int process_count, i, j;
         char *buffer = NULL;
         unsigned int pos = 0;
+        data_size_t buffer_size;
 
-        if (size && !(buffer = malloc( size )))
-        {
-            ret = STATUS_NO_MEMORY;
-            break;
-        }
-
-        SERVER_START_REQ( list_processes )
-        {
-            wine_server_set_reply( req, buffer, size );
-            ret = wine_server_call( req );
-            len = reply->info_size;
-            process_count = reply->process_count;
-        }
-        SERVER_END_REQ;
-
-        if (ret)
-        {
-            free( buffer );
-            break;
-        }
+        if ((ret = get_process_snapshot( &buffer, &buffer_size, &process_count ))) break;
 
         len = 0;
 
@@ -27,6 +27,7 @@
 
 #include <assert.h>
 #include <errno.h>
+#include <fcntl.h>
 #include <limits.h>
 #include <stdarg.h>
 #include <stdio.h>
@@ -75,6 +76,7 @@ static inline int get_unix_exit_code( NTSTATUS status )
  */
 static void pthread_exit_wrapper( int status )
 {
+    keyed_event_thread_exit();
     close( ntdll_get_thread_data()->wait_fd[0] );
     close( ntdll_get_thread_data()->wait_fd[1] );
     close( ntdll_get_thread_data()->reply_fd );
@@ -791,27 +793,18 @@ static void wow64_context_to_server( context_t *to, const WOW64_CONTEXT *from )
 #endif /* __x86_64__ */
 
 #ifdef linux
-BOOL get_thread_times(int unix_pid, int unix_tid, LARGE_INTEGER *kernel_time, LARGE_INTEGER *user_time)
+static BOOL parse_thread_times( char *buf, ssize_t count, LARGE_INTEGER *kernel_time, LARGE_INTEGER *user_time )
 {
-    unsigned long clocks_per_sec = sysconf( _SC_CLK_TCK );
+    static unsigned long clocks_per_sec;
     unsigned long usr, sys;
     const char *pos;
-    char buf[512];
-    FILE *f;
     int i;
 
-    if (unix_tid == -1)
-        sprintf( buf, "/proc/%u/stat", unix_pid );
-    else
-        sprintf( buf, "/proc/%u/task/%u/stat", unix_pid, unix_tid );
-    if (!(f = fopen( buf, "r" )))
-    {
-        WARN("Failed to open %s: %s\n", buf, strerror(errno));
-        return FALSE;
-    }
+    if (!clocks_per_sec) clocks_per_sec = sysconf( _SC_CLK_TCK );
 
-    pos = fgets( buf, sizeof(buf), f );
-    fclose( f );
+    if (count < 0) count = 0;
+    buf[count] = 0;
+    pos = count ? buf : NULL;
 
     /* the process name is printed unescaped, so we have to skip to the last ')'
      * to avoid misinterpreting the string */
@@ -838,6 +831,33 @@ BOOL get_thread_times(int unix_pid, int unix_tid, LARGE_INTEGER *kernel_time, LA
     ERR("Failed to parse %s\n", debugstr_a(buf));
     return FALSE;
 }
+
+static int open_thread_stat( int unix_pid, int unix_tid )
+{
+    char buf[64];
+    int fd;
+
+    if (unix_tid == -1)
+        sprintf( buf, "/proc/%u/stat", unix_pid );
+    else
+        sprintf( buf, "/proc/%u/task/%u/stat", unix_pid, unix_tid );
+    if ((fd = open( buf, O_RDONLY | O_CLOEXEC )) == -1)
+        WARN("Failed to open %s: %s\n", buf, strerror(errno));
+    return fd;
+}
+
+BOOL get_thread_times(int unix_pid, int unix_tid, LARGE_INTEGER *kernel_time, LARGE_INTEGER *user_time)
+{
+    char buf[512];
+    ssize_t count;
+    int fd;
+
+    if ((fd = open_thread_stat( unix_pid, unix_tid )) == -1) return FALSE;
+    /* a single read is enough, the stat file is generated at once by the kernel */
+    count = read( fd, buf, sizeof(buf) - 1 );
+    close( fd );
+    return parse_thread_times( buf, count, kernel_time, user_time );
+}
 #else
 BOOL get_thread_times(int unix_pid, int unix_tid, LARGE_INTEGER *kernel_time, LARGE_INTEGER *user_time)
 {
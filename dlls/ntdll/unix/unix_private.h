@@ -45,6 +45,18 @@ struct debug_info
 };
 
 /* thread private data, stored in NtCurrentTeb()->GdiTebBatch */
+/* thread blocked on the process keyed event */
+struct keyed_event_wait
+{
+    struct list        entry;         /* entry in keyed event bucket */
+    const void        *key;           /* key being waited on */
+    int                signaled;      /* set to 1 once paired with another thread */
+    BOOL               alertable;     /* blocked in an alertable server wait */
+    BOOL               cond_init;     /* mutex and cond are initialized */
+    pthread_mutex_t    mutex;         /* protects signaled when futexes are not available */
+    pthread_cond_t     cond;          /* signaled when futexes are not available */
+};
+
 struct ntdll_thread_data
 {
     void              *cpu_data[16];  /* reserved for CPU-specific data */
@@ -57,6 +69,7 @@ struct ntdll_thread_data
     struct list        entry;         /* entry in TEB list */
     PRTL_THREAD_START_ROUTINE start;  /* thread entry point */
     void              *param;         /* thread entry point parameter */
+    struct keyed_event_wait keyed_wait; /* keyed event wait state */
 };
 
 C_ASSERT( sizeof(struct ntdll_thread_data) <= sizeof(((TEB *)0)->GdiTebBatch) );
@@ -142,6 +155,19 @@ extern DWORD ntdll_umbstowcs( const char *src, DWORD srclen, WCHAR *dst, DWORD d
 extern int ntdll_wcstoumbs( const WCHAR *src, DWORD srclen, char *dst, DWORD dstlen, BOOL strict ) DECLSPEC_HIDDEN;
 extern char **build_envp( const WCHAR *envW ) DECLSPEC_HIDDEN;
 extern NTSTATUS exec_wineloader( char **argv, int socketfd, const pe_image_info_t *pe_info ) DECLSPEC_HIDDEN;
+#ifdef __linux__
+struct wineloader_spawn
+{
+    char       **envp;        /* environment of the new process */
+    char       **paths;       /* preloader and loader pairs to try in order, preloader can be NULL */
+    unsigned int count;       /* number of pairs */
+    char        *strings[3];  /* allocated environment strings */
+};
+extern NTSTATUS prepare_wineloader_spawn( struct wineloader_spawn *spawn, int socketfd,
+                                          const pe_image_info_t *pe_info, const char *winedebug ) DECLSPEC_HIDDEN;
+extern void exec_wineloader_spawn( const struct wineloader_spawn *spawn, char **argv ) DECLSPEC_HIDDEN;
+extern void free_wineloader_spawn( struct wineloader_spawn *spawn ) DECLSPEC_HIDDEN;
+#endif
 extern void start_server( BOOL debug ) DECLSPEC_HIDDEN;
 extern ULONG_PTR get_image_address(void) DECLSPEC_HIDDEN;
 
@@ -162,6 +188,8 @@ extern void server_init_process_done(void) DECLSPEC_HIDDEN;
 extern size_t server_init_thread( void *entry_point, BOOL *suspend ) DECLSPEC_HIDDEN;
 extern int server_pipe( int fd[2] ) DECLSPEC_HIDDEN;
 
+extern void keyed_event_thread_exit(void) DECLSPEC_HIDDEN;
+
 extern NTSTATUS context_to_server( context_t *to, const CONTEXT *from ) DECLSPEC_HIDDEN;
 extern NTSTATUS context_from_server( CONTEXT *to, const context_t *from ) DECLSPEC_HIDDEN;
 extern void DECLSPEC_NORETURN abort_thread( int status ) DECLSPEC_HIDDEN;
@@ -73,11 +73,14 @@ struct pixelformatinfo {
     copyfunc copy_function;
 };
 
+struct row_converter;
+
 typedef struct FormatConverter {
     IWICFormatConverter IWICFormatConverter_iface;
     LONG ref;
     IWICBitmapSource *source;
     const struct pixelformatinfo *dst_format, *src_format;
+    const struct row_converter *row_converter;
     WICBitmapDitherType dither;
     double alpha_threshold;
     IWICPalette *palette;
@@ -1484,6 +1487,409 @@ static HRESULT copypixels_to_8bppIndexed(struct FormatConverter *This, const WIC
     return hr;
 }
 
+/* Common conversions are done a row at a time by simple loops the compiler
+ * can vectorize, without going through the generic per format paths. */
+
+enum palette_usage
+{
+    palette_none,
+    palette_source,               /* palette of the source bitmap */
+    palette_source_premultiplied, /* same, with premultiplied alpha */
+    palette_gray,                 /* gray ramp */
+};
+
+struct convert_context
+{
+    WICColor colors[256];
+};
+
+typedef void (*convert_row_func)(const struct convert_context *ctx, const BYTE *src, BYTE *dst, UINT width);
+
+struct row_converter
+{
+    enum pixelformat src_format;
+    enum pixelformat dst_format;
+    UINT src_bpp;
+    UINT dst_bpp;
+    enum palette_usage palette;
+    convert_row_func convert_row;
+};
+
+/* source rows fetched at once for conversions that can't be done in place */
+#define CONVERT_CHUNK_SIZE (64 * 1024)
+
+static INIT_ONCE convert_init_once = INIT_ONCE_STATIC_INIT;
+/* smallest linear gray value giving each sRGB byte value */
+static float srgb_thresholds[256];
+/* 16.16 fixed point factors for unpremultiplying, exact for all channel values */
+static UINT unpremultiply_factors[256];
+
+static BYTE float_to_sRGB_byte(float f)
+{
+    return (BYTE)floorf(to_sRGB_component(f) * 255.0f + 0.51f);
+}
+
+static BOOL WINAPI init_convert_tables(INIT_ONCE *once, void *param, void **context)
+{
+    union { UINT i; float f; } lo, hi, mid;
+    UINT i;
+
+    for (i = 1; i < 256; i++)
+    {
+        /* non-negative floats are ordered like their bit patterns */
+        lo.f = 0.0f;
+        hi.f = 1.0f;
+        while (lo.i < hi.i)
+        {
+            mid.i = lo.i + (hi.i - lo.i) / 2;
+            if (float_to_sRGB_byte(mid.f) >= i) hi.i = mid.i;
+            else lo.i = mid.i + 1;
+        }
+        srgb_thresholds[i] = lo.f;
+    }
+
+    for (i = 1; i < 256; i++)
+        unpremultiply_factors[i] = (255 * 65536 + i - 1) / i;
+
+    return TRUE;
+}
+
+/* Same as float_to_sRGB_byte() for values in [0, 1], saturating outside. */
+static inline BYTE gray_to_sRGB_byte(float gray)
+{
+    UINT value = 0, step;
+
+    for (step = 128; step; step >>= 1)
+        if (gray >= srgb_thresholds[value + step]) value += step;
+
+    return value;
+}
+
+static inline BYTE rgb_to_sRGB_gray(BYTE r, BYTE g, BYTE b)
+{
+    return gray_to_sRGB_byte((r * 0.2126f + g * 0.7152f + b * 0.0722f) / 255.0f);
+}
+
+/* c * a / 255, rounded down */
+static inline BYTE premultiply_channel(BYTE c, BYTE a)
+{
+    UINT t = c * a;
+    return (t + 1 + (t >> 8)) >> 8;
+}
+
+static void convert_row_24_to_32(const struct convert_context *ctx, const BYTE *src, BYTE *dst, UINT width)
+{
+    UINT x;
+
+    for (x = 0; x < width; x++)
+    {
+        dst[4 * x] = src[3 * x];
+        dst[4 * x + 1] = src[3 * x + 1];
+        dst[4 * x + 2] = src[3 * x + 2];
+        dst[4 * x + 3] = 0xff;
+    }
+}
+
+static void convert_row_24_to_32_swap(const struct convert_context *ctx, const BYTE *src, BYTE *dst, UINT width)
+{
+    UINT x;
+
+    for (x = 0; x < width; x++)
+    {
+        dst[4 * x] = src[3 * x + 2];
+        dst[4 * x + 1] = src[3 * x + 1];
+        dst[4 * x + 2] = src[3 * x];
+        dst[4 * x + 3] = 0xff;
+    }
+}
+
+static void convert_row_32_to_24(const struct convert_context *ctx, const BYTE *src, BYTE *dst, UINT width)
+{
+    UINT x;
+
+    for (x = 0; x < width; x++)
+    {
+        dst[3 * x] = src[4 * x];
+        dst[3 * x + 1] = src[4 * x + 1];
+        dst[3 * x + 2] = src[4 * x + 2];
+    }
+}
+
+static void convert_row_32_to_24_swap(const struct convert_context *ctx, const BYTE *src, BYTE *dst, UINT width)
+{
+    UINT x;
+
+    for (x = 0; x < width; x++)
+    {
+        dst[3 * x] = src[4 * x + 2];
+        dst[3 * x + 1] = src[4 * x + 1];
+        dst[3 * x + 2] = src[4 * x];
+    }
+}
+
+static void convert_row_set_alpha(const struct convert_context *ctx, const BYTE *src, BYTE *dst, UINT width)
+{
+    UINT x;
+
+    for (x = 0; x < width; x++) dst[4 * x + 3] = 0xff;
+}
+
+static void convert_row_premultiply(const struct convert_context *ctx, const BYTE *src, BYTE *dst, UINT width)
+{
+    UINT x;
+
+    for (x = 0; x < width; x++)
+    {
+        BYTE alpha = src[4 * x + 3];
+
+        dst[4 * x] = premultiply_channel(src[4 * x], alpha);
+        dst[4 * x + 1] = premultiply_channel(src[4 * x + 1], alpha);
+        dst[4 * x + 2] = premultiply_channel(src[4 * x + 2], alpha);
+        dst[4 * x + 3] = alpha;
+    }
+}
+
+static void convert_row_unpremultiply(const struct convert_context *ctx, const BYTE *src, BYTE *dst, UINT width)
+{
+    UINT x;
+
+    for (x = 0; x < width; x++)
+    {
+        BYTE alpha = src[4 * x + 3];
+
+        if (alpha != 0 && alpha != 255)
+        {
+            UINT factor = unpremultiply_factors[alpha];
+
+            dst[4 * x] = (src[4 * x] * factor) >> 16;
+            dst[4 * x + 1] = (src[4 * x + 1] * factor) >> 16;
+            dst[4 * x + 2] = (src[4 * x + 2] * factor) >> 16;
+        }
+        else
+        {
+            dst[4 * x] = src[4 * x];
+            dst[4 * x + 1] = src[4 * x + 1];
+            dst[4 * x + 2] = src[4 * x + 2];
+        }
+        dst[4 * x + 3] = alpha;
+    }
+}
+
+static void convert_row_8_to_32(const struct convert_context *ctx, const BYTE *src, BYTE *dst, UINT width)
+{
+    DWORD *dstpixel = (DWORD *)dst;
+    UINT x;
+
+    for (x = 0; x < width; x++) dstpixel[x] = ctx->colors[src[x]];
+}
+
+static void convert_row_16bppGray_to_32(const struct convert_context *ctx, const BYTE *src, BYTE *dst, UINT width)
+{
+    DWORD *dstpixel = (DWORD *)dst;
+    UINT x;
+
+    /* only the most significant byte is kept */
+    for (x = 0; x < width; x++) dstpixel[x] = ctx->colors[src[2 * x + 1]];
+}
+
+static void convert_row_24bppBGR_to_8bppGray(const struct convert_context *ctx, const BYTE *src, BYTE *dst, UINT width)
+{
+    UINT x;
+
+    for (x = 0; x < width; x++) dst[x] = rgb_to_sRGB_gray(src[3 * x + 2], src[3 * x + 1], src[3 * x]);
+}
+
+static void convert_row_24bppRGB_to_8bppGray(const struct convert_context *ctx, const BYTE *src, BYTE *dst, UINT width)
+{
+    UINT x;
+
+    for (x = 0; x < width; x++) dst[x] = rgb_to_sRGB_gray(src[3 * x], src[3 * x + 1], src[3 * x + 2]);
+}
+
+static void convert_row_32bppBGR_to_8bppGray(const struct convert_context *ctx, const BYTE *src, BYTE *dst, UINT width)
+{
+    UINT x;
+
+    for (x = 0; x < width; x++) dst[x] = rgb_to_sRGB_gray(src[4 * x + 2], src[4 * x + 1], src[4 * x]);
+}
+
+static void convert_row_32bppRGB_to_8bppGray(const struct convert_context *ctx, const BYTE *src, BYTE *dst, UINT width)
+{
+    UINT x;
+
+    for (x = 0; x < width; x++) dst[x] = rgb_to_sRGB_gray(src[4 * x], src[4 * x + 1], src[4 * x + 2]);
+}
+
+static void convert_row_32bppGrayFloat_to_8bppGray(const struct convert_context *ctx, const BYTE *src, BYTE *dst, UINT width)
+{
+    const float *gray = (const float *)src;
+    UINT x;
+
+    for (x = 0; x < width; x++) dst[x] = gray_to_sRGB_byte(gray[x]);
+}
+
+static void convert_row_32bppGrayFloat_to_24bppBGR(const struct convert_context *ctx, const BYTE *src, BYTE *dst, UINT width)
+{
+    const float *gray = (const float *)src;
+    UINT x;
+
+    for (x = 0; x < width; x++) dst[3 * x] = dst[3 * x + 1] = dst[3 * x + 2] = gray_to_sRGB_byte(gray[x]);
+}
+
+static const struct row_converter row_converters[] =
+{
+    {format_24bppBGR, format_32bppBGRA, 24, 32, palette_none, convert_row_24_to_32},
+    {format_24bppBGR, format_32bppBGR, 24, 32, palette_none, convert_row_24_to_32},
+    {format_24bppBGR, format_32bppPBGRA, 24, 32, palette_none, convert_row_24_to_32},
+    {format_24bppBGR, format_32bppRGBA, 24, 32, palette_none, convert_row_24_to_32_swap},
+    {format_24bppBGR, format_32bppRGB, 24, 32, palette_none, convert_row_24_to_32_swap},
+    {format_24bppBGR, format_32bppPRGBA, 24, 32, palette_none, convert_row_24_to_32_swap},
+    {format_24bppRGB, format_32bppBGRA, 24, 32, palette_none, convert_row_24_to_32_swap},
+    {format_24bppRGB, format_32bppBGR, 24, 32, palette_none, convert_row_24_to_32_swap},
+    {format_24bppRGB, format_32bppPBGRA, 24, 32, palette_none, convert_row_24_to_32_swap},
+    {format_24bppRGB, format_32bppRGBA, 24, 32, palette_none, convert_row_24_to_32},
+    {format_24bppRGB, format_32bppRGB, 24, 32, palette_none, convert_row_24_to_32},
+    {format_24bppRGB, format_32bppPRGBA, 24, 32, palette_none, convert_row_24_to_32},
+    {format_32bppBGR, format_24bppBGR, 32, 24, palette_none, convert_row_32_to_24},
+    {format_32bppBGRA, format_24bppBGR, 32, 24, palette_none, convert_row_32_to_24},
+    {format_32bppPBGRA, format_24bppBGR, 32, 24, palette_none, convert_row_32_to_24},
+    {format_32bppRGBA, format_24bppBGR, 32, 24, palette_none, convert_row_32_to_24_swap},
+    {format_32bppBGR, format_24bppRGB, 32, 24, palette_none, convert_row_32_to_24_swap},
+    {format_32bppBGRA, format_24bppRGB, 32, 24, palette_none, convert_row_32_to_24_swap},
+    {format_32bppPBGRA, format_24bppRGB, 32, 24, palette_none, convert_row_32_to_24_swap},
+    {format_32bppBGR, format_32bppBGRA, 32, 32, palette_none, convert_row_set_alpha},
+    {format_32bppBGR, format_32bppPBGRA, 32, 32, palette_none, convert_row_set_alpha},
+    {format_32bppRGB, format_32bppRGBA, 32, 32, palette_none, convert_row_set_alpha},
+    {format_32bppRGB, format_32bppPRGBA, 32, 32, palette_none, convert_row_set_alpha},
+    {format_32bppBGRA, format_32bppPBGRA, 32, 32, palette_none, convert_row_premultiply},
+    {format_32bppRGBA, format_32bppPRGBA, 32, 32, palette_none, convert_row_premultiply},
+    {format_32bppPBGRA, format_32bppBGRA, 32, 32, palette_none, convert_row_unpremultiply},
+    {format_32bppPRGBA, format_32bppRGBA, 32, 32, palette_none, convert_row_unpremultiply},
+    {format_8bppIndexed, format_32bppBGRA, 8, 32, palette_source, convert_row_8_to_32},
+    {format_8bppIndexed, format_32bppBGR, 8, 32, palette_source, convert_row_8_to_32},
+    {format_8bppIndexed, format_32bppPBGRA, 8, 32, palette_source_premultiplied, convert_row_8_to_32},
+    {format_8bppGray, format_32bppBGRA, 8, 32, palette_gray, convert_row_8_to_32},
+    {format_8bppGray, format_32bppBGR, 8, 32, palette_gray, convert_row_8_to_32},
+    {format_8bppGray, format_32bppPBGRA, 8, 32, palette_gray, convert_row_8_to_32},
+    {format_16bppGray, format_32bppBGRA, 16, 32, palette_gray, convert_row_16bppGray_to_32},
+    {format_16bppGray, format_32bppBGR, 16, 32, palette_gray, convert_row_16bppGray_to_32},
+    {format_16bppGray, format_32bppPBGRA, 16, 32, palette_gray, convert_row_16bppGray_to_32},
+    {format_24bppBGR, format_8bppGray, 24, 8, palette_none, convert_row_24bppBGR_to_8bppGray},
+    {format_24bppRGB, format_8bppGray, 24, 8, palette_none, convert_row_24bppRGB_to_8bppGray},
+    {format_32bppBGR, format_8bppGray, 32, 8, palette_none, convert_row_32bppBGR_to_8bppGray},
+    {format_32bppBGRA, format_8bppGray, 32, 8, palette_none, convert_row_32bppBGR_to_8bppGray},
+    {format_32bppPBGRA, format_8bppGray, 32, 8, palette_none, convert_row_32bppBGR_to_8bppGray},
+    {format_32bppRGBA, format_8bppGray, 32, 8, palette_none, convert_row_32bppRGB_to_8bppGray},
+    {format_32bppGrayFloat, format_8bppGray, 32, 8, palette_none, convert_row_32bppGrayFloat_to_8bppGray},
+    {format_32bppGrayFloat, format_24bppBGR, 32, 24, palette_none, convert_row_32bppGrayFloat_to_24bppBGR},
+};
+
+static const struct row_converter *get_row_converter(enum pixelformat src_format, enum pixelformat dst_format)
+{
+    UINT i;
+
+    for (i = 0; i < ARRAY_SIZE(row_converters); i++)
+        if (row_converters[i].src_format == src_format && row_converters[i].dst_format == dst_format)
+            return &row_converters[i];
+
+    return NULL;
+}
+
+static HRESULT get_convert_palette(struct FormatConverter *This, enum palette_usage usage, WICColor *colors)
+{
+    IWICPalette *palette;
+    UINT i, count = 0;
+    HRESULT hr;
+
+    if (usage == palette_gray)
+    {
+        for (i = 0; i < 256; i++) colors[i] = 0xff000000 | (i << 16) | (i << 8) | i;
+        return S_OK;
+    }
+
+    hr = PaletteImpl_Create(&palette);
+    if (FAILED(hr)) return hr;
+
+    hr = IWICBitmapSource_CopyPalette(This->source, palette);
+    if (SUCCEEDED(hr))
+        hr = IWICPalette_GetColors(palette, 256, colors, &count);
+
+    IWICPalette_Release(palette);
+    if (FAILED(hr)) return hr;
+
+    for (i = count; i < 256; i++) colors[i] = 0;
+
+    if (usage == palette_source_premultiplied)
+    {
+        for (i = 0; i < count; i++)
+        {
+            BYTE alpha = colors[i] >> 24;
+
+            colors[i] = ((WICColor)alpha << 24) | (premultiply_channel(colors[i] >> 16, alpha) << 16) |
+                    (premultiply_channel(colors[i] >> 8, alpha) << 8) | premultiply_channel(colors[i], alpha);
+        }
+    }
+
+    return S_OK;
+}
+
+static HRESULT copypixels_convert_rows(struct FormatConverter *This, const WICRect *prc,
+    UINT cbStride, UINT cbBufferSize, BYTE *pbBuffer)
+{
+    const struct row_converter *converter = This->row_converter;
+    struct convert_context ctx;
+    UINT srcstride, dstrowsize, rows;
+    BYTE *srcdata;
+    HRESULT hr;
+    WICRect rc;
+    INT y, i;
+
+    if (prc->Width <= 0 || prc->Height <= 0)
+        return IWICBitmapSource_CopyPixels(This->source, prc, cbStride, cbBufferSize, pbBuffer);
+
+    dstrowsize = (converter->dst_bpp * prc->Width + 7) / 8;
+    if (cbStride < dstrowsize || (ULONGLONG)cbStride * (prc->Height - 1) + dstrowsize > cbBufferSize)
+        return E_INVALIDARG;
+
+    if (converter->palette != palette_none)
+    {
+        hr = get_convert_palette(This, converter->palette, ctx.colors);
+        if (FAILED(hr)) return hr;
+    }
+
+    if (converter->src_bpp == converter->dst_bpp)
+    {
+        hr = IWICBitmapSource_CopyPixels(This->source, prc, cbStride, cbBufferSize, pbBuffer);
+        if (FAILED(hr)) return hr;
+
+        for (y = 0; y < prc->Height; y++)
+            converter->convert_row(&ctx, pbBuffer + y * cbStride, pbBuffer + y * cbStride, prc->Width);
+        return S_OK;
+    }
+
+    srcstride = (converter->src_bpp * prc->Width + 7) / 8;
+    rows = min(max(CONVERT_CHUNK_SIZE / srcstride, 1), (UINT)prc->Height);
+
+    srcdata = heap_alloc(srcstride * rows);
+    if (!srcdata) return E_OUTOFMEMORY;
+
+    rc = *prc;
+    for (y = 0, hr = S_OK; y < prc->Height && SUCCEEDED(hr); y += rc.Height)
+    {
+        rc.Y = prc->Y + y;
+        rc.Height = min(rows, (UINT)(prc->Height - y));
+
+        hr = IWICBitmapSource_CopyPixels(This->source, &rc, srcstride, srcstride * rc.Height, srcdata);
+        if (FAILED(hr)) break;
+
+        for (i = 0; i < rc.Height; i++)
+            converter->convert_row(&ctx, srcdata + i * srcstride, pbBuffer + (y + i) * cbStride, prc->Width);
+    }
+
+    heap_free(srcdata);
+    return hr;
+}
+
 static const struct pixelformatinfo supported_formats[] = {
     {format_1bppIndexed, &GUID_WICPixelFormat1bppIndexed, NULL},
     {format_2bppIndexed, &GUID_WICPixelFormat2bppIndexed, NULL},
@@ -1662,6 +2068,9 @@ static HRESULT WINAPI FormatConverter_CopyPixels(IWICFormatConverter *iface,
             prc = &rc;
         }
 
+        if (This->row_converter)
+            return copypixels_convert_rows(This, prc, cbStride, cbBufferSize, pbBuffer);
+
         return This->dst_format->copy_function(This, prc, cbStride, cbBufferSize,
             pbBuffer, This->src_format->format);
     }
@@ -1755,6 +2164,9 @@ static HRESULT WINAPI FormatConverter_Initialize(IWICFormatConverter *iface,
         This->dither = dither;
         This->alpha_threshold = alpha_threshold;
         This->palette = palette;
+        This->row_converter = get_row_converter(srcinfo->format, dstinfo->format);
+        if (This->row_converter)
+            InitOnceExecuteOnce(&convert_init_once, init_convert_tables, NULL, NULL);
         This->source = source;
     }
     else
@@ -1838,6 +2250,7 @@ HRESULT FormatConverter_CreateInstance(REFIID iid, void** ppv)
     This->ref = 1;
     This->source = NULL;
     This->palette = NULL;
+    This->row_converter = NULL;
     InitializeCriticalSection(&This->lock);
     This->lock.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": FormatConverter.lock");
 
@@ -68,6 +68,7 @@ static const WCHAR wszJpegYCrCbSubsampling[] = {'J','p','e','g','Y','C','r','C',
 static const WCHAR wszSuppressApp0[] = {'S','u','p','p','r','e','s','s','A','p','p','0',0};
 
 #define MAKE_FUNCPTR(f) static typeof(f) * p##f
+MAKE_FUNCPTR(jpeg_abort_decompress);
 MAKE_FUNCPTR(jpeg_CreateCompress);
 MAKE_FUNCPTR(jpeg_CreateDecompress);
 MAKE_FUNCPTR(jpeg_destroy_compress);
@@ -77,6 +78,7 @@ MAKE_FUNCPTR(jpeg_read_header);
 MAKE_FUNCPTR(jpeg_read_scanlines);
 MAKE_FUNCPTR(jpeg_resync_to_restart);
 MAKE_FUNCPTR(jpeg_set_defaults);
+MAKE_FUNCPTR(jpeg_set_quality);
 MAKE_FUNCPTR(jpeg_start_compress);
 MAKE_FUNCPTR(jpeg_start_decompress);
 MAKE_FUNCPTR(jpeg_std_error);
@@ -93,6 +95,7 @@ static void *load_libjpeg(void)
         return NULL; \
     }
 
+        LOAD_FUNCPTR(jpeg_abort_decompress);
         LOAD_FUNCPTR(jpeg_CreateCompress);
         LOAD_FUNCPTR(jpeg_CreateDecompress);
         LOAD_FUNCPTR(jpeg_destroy_compress);
@@ -102,6 +105,7 @@ static void *load_libjpeg(void)
         LOAD_FUNCPTR(jpeg_read_scanlines);
         LOAD_FUNCPTR(jpeg_resync_to_restart);
         LOAD_FUNCPTR(jpeg_set_defaults);
+        LOAD_FUNCPTR(jpeg_set_quality);
         LOAD_FUNCPTR(jpeg_start_compress);
         LOAD_FUNCPTR(jpeg_start_decompress);
         LOAD_FUNCPTR(jpeg_std_error);
@@ -147,16 +151,22 @@ typedef struct {
     IWICBitmapDecoder IWICBitmapDecoder_iface;
     IWICBitmapFrameDecode IWICBitmapFrameDecode_iface;
     IWICMetadataBlockReader IWICMetadataBlockReader_iface;
+    IWICBitmapSourceTransform IWICBitmapSourceTransform_iface;
     LONG ref;
     BOOL initialized;
     BOOL cinfo_initialized;
     IStream *stream;
+    ULARGE_INTEGER stream_pos; /* where reading resumes when decoding more rows */
     struct jpeg_decompress_struct cinfo;
     struct jpeg_error_mgr jerr;
     struct jpeg_source_mgr source_mgr;
     BYTE source_buffer[1024];
     UINT bpp, stride;
-    BYTE *image_data;
+    UINT width, height;
+    UINT scale; /* the image is decoded at 1/scale of its size */
+    BYTE *image_data; /* holds the cinfo.output_scanline rows decoded so far */
+    UINT image_rows; /* number of rows image_data has room for */
+    BOOL decode_failed;
     CRITICAL_SECTION lock;
 } JpegDecoder;
 
@@ -180,6 +190,11 @@ static inline JpegDecoder *impl_from_IWICMetadataBlockReader(IWICMetadataBlockRe
     return CONTAINING_RECORD(iface, JpegDecoder, IWICMetadataBlockReader_iface);
 }
 
+static inline JpegDecoder *impl_from_IWICBitmapSourceTransform(IWICBitmapSourceTransform *iface)
+{
+    return CONTAINING_RECORD(iface, JpegDecoder, IWICBitmapSourceTransform_iface);
+}
+
 static HRESULT WINAPI JpegDecoder_QueryInterface(IWICBitmapDecoder *iface, REFIID iid,
     void **ppv)
 {
@@ -297,64 +312,16 @@ static void source_mgr_term_source(j_decompress_ptr cinfo)
 {
 }
 
-static HRESULT WINAPI JpegDecoder_Initialize(IWICBitmapDecoder *iface, IStream *pIStream,
-    WICDecodeOptions cacheOptions)
+/* Reads the header and starts decompressing at 1/scale of the image size.
+ * Errors from libjpeg jump to the caller's setjmp. */
+static HRESULT start_decompress(JpegDecoder *This, UINT scale)
 {
-    JpegDecoder *This = impl_from_IWICBitmapDecoder(iface);
     int ret;
-    LARGE_INTEGER seek;
-    jmp_buf jmpbuf;
-    UINT data_size, i;
-
-    TRACE("(%p,%p,%u)\n", iface, pIStream, cacheOptions);
-
-    EnterCriticalSection(&This->lock);
-
-    if (This->cinfo_initialized)
-    {
-        LeaveCriticalSection(&This->lock);
-        return WINCODEC_ERR_WRONGSTATE;
-    }
-
-    pjpeg_std_error(&This->jerr);
-
-    This->jerr.error_exit = error_exit_fn;
-    This->jerr.emit_message = emit_message_fn;
-
-    This->cinfo.err = &This->jerr;
-
-    This->cinfo.client_data = jmpbuf;
-
-    if (setjmp(jmpbuf))
-    {
-        LeaveCriticalSection(&This->lock);
-        return E_FAIL;
-    }
-
-    pjpeg_CreateDecompress(&This->cinfo, JPEG_LIB_VERSION, sizeof(struct jpeg_decompress_struct));
-
-    This->cinfo_initialized = TRUE;
-
-    This->stream = pIStream;
-    IStream_AddRef(pIStream);
-
-    seek.QuadPart = 0;
-    IStream_Seek(This->stream, seek, STREAM_SEEK_SET, NULL);
-
-    This->source_mgr.bytes_in_buffer = 0;
-    This->source_mgr.init_source = source_mgr_init_source;
-    This->source_mgr.fill_input_buffer = source_mgr_fill_input_buffer;
-    This->source_mgr.skip_input_data = source_mgr_skip_input_data;
-    This->source_mgr.resync_to_restart = pjpeg_resync_to_restart;
-    This->source_mgr.term_source = source_mgr_term_source;
-
-    This->cinfo.src = &This->source_mgr;
 
     ret = pjpeg_read_header(&This->cinfo, TRUE);
 
     if (ret != JPEG_HEADER_OK) {
         WARN("Jpeg image in stream has bad format, read header returned %d.\n",ret);
-        LeaveCriticalSection(&This->lock);
         return E_FAIL;
     }
 
@@ -373,14 +340,16 @@ static HRESULT WINAPI JpegDecoder_Initialize(IWICBitmapDecoder *iface, IStream *
         break;
     default:
         ERR("Unknown JPEG color space %i\n", This->cinfo.jpeg_color_space);
-        LeaveCriticalSection(&This->lock);
         return E_FAIL;
     }
 
+    /* scaling is done in the inverse DCT, without decoding the full size image */
+    This->cinfo.scale_num = 1;
+    This->cinfo.scale_denom = scale;
+
     if (!pjpeg_start_decompress(&This->cinfo))
     {
         ERR("jpeg_start_decompress failed\n");
-        LeaveCriticalSection(&This->lock);
         return E_FAIL;
     }
 
@@ -389,23 +358,87 @@ static HRESULT WINAPI JpegDecoder_Initialize(IWICBitmapDecoder *iface, IStream *
     else This->bpp = 24;
 
     This->stride = (This->bpp * This->cinfo.output_width + 7) / 8;
-    data_size = This->stride * This->cinfo.output_height;
+    This->scale = scale;
 
-    This->image_data = heap_alloc(data_size);
-    if (!This->image_data)
+    return S_OK;
+}
+
+static UINT scaled_size(UINT size, UINT scale)
+{
+    return (size + scale - 1) / scale;
+}
+
+/* Decodes the rows of the image at 1/scale of its size up to the end row, so
+ * that only the part of the image being read is decoded and stored. Decoded
+ * rows are kept, the decoder is only restarted when the scale changes. */
+static HRESULT decode_rows(JpegDecoder *This, UINT scale, UINT end)
+{
+    LARGE_INTEGER seek;
+    jmp_buf jmpbuf;
+    BYTE *new_data;
+    UINT i;
+
+    if (This->scale == scale)
     {
-        LeaveCriticalSection(&This->lock);
-        return E_OUTOFMEMORY;
+        if (This->image_data && end <= This->cinfo.output_scanline)
+            return S_OK;
+        if (This->decode_failed) return E_FAIL;
+    }
+
+    This->cinfo.client_data = jmpbuf;
+
+    if (setjmp(jmpbuf))
+    {
+        This->decode_failed = TRUE;
+        return E_FAIL;
+    }
+
+    if (This->scale != scale)
+    {
+        heap_free(This->image_data);
+        This->image_data = NULL;
+        This->image_rows = 0;
+        /* a failure at another scale says nothing about this one */
+        This->decode_failed = FALSE;
+        This->scale = 0;
+
+        pjpeg_abort_decompress(&This->cinfo);
+        This->source_mgr.bytes_in_buffer = 0;
+        This->stream_pos.QuadPart = 0;
+        seek.QuadPart = 0;
+        IStream_Seek(This->stream, seek, STREAM_SEEK_SET, NULL);
+
+        if (FAILED(start_decompress(This, scale)))
+        {
+            This->decode_failed = TRUE;
+            return E_FAIL;
+        }
+    }
+    else
+    {
+        /* the stream may have been used by someone else in the meantime */
+        seek.QuadPart = This->stream_pos.QuadPart;
+        IStream_Seek(This->stream, seek, STREAM_SEEK_SET, NULL);
     }
 
-    while (This->cinfo.output_scanline < This->cinfo.output_height)
+    end = max(min(end, This->cinfo.output_height), 1);
+    if (end > This->image_rows)
+    {
+        if (!(new_data = heap_realloc(This->image_data, This->stride * end)))
+            return E_OUTOFMEMORY;
+        This->image_data = new_data;
+        This->image_rows = end;
+    }
+
+    while (This->cinfo.output_scanline < end)
     {
         UINT first_scanline = This->cinfo.output_scanline;
         UINT max_rows;
         JSAMPROW out_rows[4];
+        BYTE *data;
         JDIMENSION ret;
 
-        max_rows = min(This->cinfo.output_height-first_scanline, 4);
+        max_rows = min(end-first_scanline, 4);
         for (i=0; i<max_rows; i++)
             out_rows[i] = This->image_data + This->stride * (first_scanline+i);
 
@@ -413,26 +446,98 @@ static HRESULT WINAPI JpegDecoder_Initialize(IWICBitmapDecoder *iface, IStream *
         if (ret == 0)
         {
             ERR("read_scanlines failed\n");
-            LeaveCriticalSection(&This->lock);
+            This->decode_failed = TRUE;
             return E_FAIL;
         }
+
+        data = out_rows[0];
+
+        if (This->bpp == 24)
+        {
+            /* libjpeg gives us RGB data and we want BGR, so byteswap the data */
+            reverse_bgr8(3, data, This->cinfo.output_width, ret, This->stride);
+        }
+
+        if (This->cinfo.out_color_space == JCS_CMYK && This->cinfo.saw_Adobe_marker)
+        {
+            /* Adobe JPEG's have inverted CMYK data. */
+            for (i=0; i<This->stride * ret; i++)
+                data[i] ^= 0xff;
+        }
+    }
+
+    seek.QuadPart = 0;
+    IStream_Seek(This->stream, seek, STREAM_SEEK_CUR, &This->stream_pos);
+
+    return S_OK;
+}
+
+static HRESULT WINAPI JpegDecoder_Initialize(IWICBitmapDecoder *iface, IStream *pIStream,
+    WICDecodeOptions cacheOptions)
+{
+    JpegDecoder *This = impl_from_IWICBitmapDecoder(iface);
+    LARGE_INTEGER seek;
+    jmp_buf jmpbuf;
+    HRESULT hr;
+
+    TRACE("(%p,%p,%u)\n", iface, pIStream, cacheOptions);
+
+    EnterCriticalSection(&This->lock);
+
+    if (This->cinfo_initialized)
+    {
+        LeaveCriticalSection(&This->lock);
+        return WINCODEC_ERR_WRONGSTATE;
     }
 
-    if (This->bpp == 24)
+    pjpeg_std_error(&This->jerr);
+
+    This->jerr.error_exit = error_exit_fn;
+    This->jerr.emit_message = emit_message_fn;
+
+    This->cinfo.err = &This->jerr;
+
+    This->cinfo.client_data = jmpbuf;
+
+    if (setjmp(jmpbuf))
     {
-        /* libjpeg gives us RGB data and we want BGR, so byteswap the data */
-        reverse_bgr8(3, This->image_data,
-            This->cinfo.output_width, This->cinfo.output_height,
-            This->stride);
+        LeaveCriticalSection(&This->lock);
+        return E_FAIL;
     }
 
-    if (This->cinfo.out_color_space == JCS_CMYK && This->cinfo.saw_Adobe_marker)
+    pjpeg_CreateDecompress(&This->cinfo, JPEG_LIB_VERSION, sizeof(struct jpeg_decompress_struct));
+
+    This->cinfo_initialized = TRUE;
+
+    This->stream = pIStream;
+    IStream_AddRef(pIStream);
+
+    seek.QuadPart = 0;
+    IStream_Seek(This->stream, seek, STREAM_SEEK_SET, NULL);
+
+    This->source_mgr.bytes_in_buffer = 0;
+    This->source_mgr.init_source = source_mgr_init_source;
+    This->source_mgr.fill_input_buffer = source_mgr_fill_input_buffer;
+    This->source_mgr.skip_input_data = source_mgr_skip_input_data;
+    This->source_mgr.resync_to_restart = pjpeg_resync_to_restart;
+    This->source_mgr.term_source = source_mgr_term_source;
+
+    This->cinfo.src = &This->source_mgr;
+
+    hr = start_decompress(This, 1);
+    if (FAILED(hr))
     {
-        /* Adobe JPEG's have inverted CMYK data. */
-        for (i=0; i<data_size; i++)
-            This->image_data[i] ^= 0xff;
+        LeaveCriticalSection(&This->lock);
+        return hr;
     }
 
+    This->width = This->cinfo.output_width;
+    This->height = This->cinfo.output_height;
+
+    /* the image data is decoded on demand */
+    seek.QuadPart = 0;
+    IStream_Seek(This->stream, seek, STREAM_SEEK_CUR, &This->stream_pos);
+
     This->initialized = TRUE;
 
     LeaveCriticalSection(&This->lock);
@@ -552,6 +657,10 @@ static HRESULT WINAPI JpegDecoder_Frame_QueryInterface(IWICBitmapFrameDecode *if
     {
         *ppv = &This->IWICBitmapFrameDecode_iface;
     }
+    else if (IsEqualIID(&IID_IWICBitmapSourceTransform, iid))
+    {
+        *ppv = &This->IWICBitmapSourceTransform_iface;
+    }
     else
     {
         *ppv = NULL;
@@ -578,8 +687,8 @@ static HRESULT WINAPI JpegDecoder_Frame_GetSize(IWICBitmapFrameDecode *iface,
     UINT *puiWidth, UINT *puiHeight)
 {
     JpegDecoder *This = impl_from_IWICBitmapFrameDecode(iface);
-    *puiWidth = This->cinfo.output_width;
-    *puiHeight = This->cinfo.output_height;
+    *puiWidth = This->width;
+    *puiHeight = This->height;
     TRACE("(%p)->(%u,%u)\n", iface, *puiWidth, *puiHeight);
     return S_OK;
 }
@@ -643,12 +752,21 @@ static HRESULT WINAPI JpegDecoder_Frame_CopyPixels(IWICBitmapFrameDecode *iface,
     const WICRect *prc, UINT cbStride, UINT cbBufferSize, BYTE *pbBuffer)
 {
     JpegDecoder *This = impl_from_IWICBitmapFrameDecode(iface);
+    HRESULT hr;
 
     TRACE("(%p,%s,%u,%u,%p)\n", iface, debug_wic_rect(prc), cbStride, cbBufferSize, pbBuffer);
 
-    return copy_pixels(This->bpp, This->image_data,
-        This->cinfo.output_width, This->cinfo.output_height, This->stride,
-        prc, cbStride, cbBufferSize, pbBuffer);
+    EnterCriticalSection(&This->lock);
+
+    hr = decode_rows(This, 1, prc && prc->Y >= 0 && prc->Height >= 0 ? prc->Y + prc->Height : This->height);
+    if (SUCCEEDED(hr))
+        hr = copy_pixels(This->bpp, This->image_data,
+            This->width, This->height, This->stride,
+            prc, cbStride, cbBufferSize, pbBuffer);
+
+    LeaveCriticalSection(&This->lock);
+
+    return hr;
 }
 
 static HRESULT WINAPI JpegDecoder_Frame_GetMetadataQueryReader(IWICBitmapFrameDecode *iface,
@@ -759,6 +877,127 @@ static const IWICMetadataBlockReaderVtbl JpegDecoder_Block_Vtbl = {
     JpegDecoder_Block_GetEnumerator,
 };
 
+static HRESULT WINAPI JpegDecoder_Transform_QueryInterface(IWICBitmapSourceTransform *iface, REFIID iid,
+    void **ppv)
+{
+    JpegDecoder *This = impl_from_IWICBitmapSourceTransform(iface);
+    return IWICBitmapFrameDecode_QueryInterface(&This->IWICBitmapFrameDecode_iface, iid, ppv);
+}
+
+static ULONG WINAPI JpegDecoder_Transform_AddRef(IWICBitmapSourceTransform *iface)
+{
+    JpegDecoder *This = impl_from_IWICBitmapSourceTransform(iface);
+    return IWICBitmapDecoder_AddRef(&This->IWICBitmapDecoder_iface);
+}
+
+static ULONG WINAPI JpegDecoder_Transform_Release(IWICBitmapSourceTransform *iface)
+{
+    JpegDecoder *This = impl_from_IWICBitmapSourceTransform(iface);
+    return IWICBitmapDecoder_Release(&This->IWICBitmapDecoder_iface);
+}
+
+/* the inverse DCT can scale by 1/2, 1/4 and 1/8 */
+static const UINT dct_scales[] = {8, 4, 2, 1};
+
+static HRESULT WINAPI JpegDecoder_Transform_CopyPixels(IWICBitmapSourceTransform *iface,
+    const WICRect *prc, UINT width, UINT height, WICPixelFormatGUID *format,
+    WICBitmapTransformOptions transform, UINT stride, UINT buffer_size, BYTE *buffer)
+{
+    JpegDecoder *This = impl_from_IWICBitmapSourceTransform(iface);
+    WICPixelFormatGUID native_format;
+    HRESULT hr;
+    UINT i;
+
+    TRACE("(%p,%s,%u,%u,%s,%u,%u,%u,%p)\n", iface, debug_wic_rect(prc), width, height,
+        debugstr_guid(format), transform, stride, buffer_size, buffer);
+
+    if (transform != WICBitmapTransformRotate0)
+    {
+        FIXME("unsupported transform %#x\n", transform);
+        return E_NOTIMPL;
+    }
+
+    IWICBitmapFrameDecode_GetPixelFormat(&This->IWICBitmapFrameDecode_iface, &native_format);
+    if (format && !IsEqualGUID(format, &native_format))
+    {
+        FIXME("unsupported pixel format %s\n", debugstr_guid(format));
+        return WINCODEC_ERR_UNSUPPORTEDPIXELFORMAT;
+    }
+
+    for (i = 0; i < ARRAY_SIZE(dct_scales); i++)
+        if (scaled_size(This->width, dct_scales[i]) == width && scaled_size(This->height, dct_scales[i]) == height)
+            break;
+    if (i == ARRAY_SIZE(dct_scales))
+    {
+        FIXME("unsupported size %ux%u\n", width, height);
+        return E_INVALIDARG;
+    }
+
+    EnterCriticalSection(&This->lock);
+
+    hr = decode_rows(This, dct_scales[i], prc && prc->Y >= 0 && prc->Height >= 0 ? prc->Y + prc->Height : height);
+    if (SUCCEEDED(hr))
+        hr = copy_pixels(This->bpp, This->image_data, width, height, This->stride,
+            prc, stride, buffer_size, buffer);
+
+    LeaveCriticalSection(&This->lock);
+
+    return hr;
+}
+
+static HRESULT WINAPI JpegDecoder_Transform_GetClosestSize(IWICBitmapSourceTransform *iface,
+    UINT *width, UINT *height)
+{
+    JpegDecoder *This = impl_from_IWICBitmapSourceTransform(iface);
+    UINT i;
+
+    TRACE("(%p,%p,%p)\n", iface, width, height);
+
+    if (!width || !height) return E_INVALIDARG;
+
+    /* smallest size that is not smaller than the requested one */
+    for (i = 0; i < ARRAY_SIZE(dct_scales) - 1; i++)
+        if (scaled_size(This->width, dct_scales[i]) >= *width && scaled_size(This->height, dct_scales[i]) >= *height)
+            break;
+
+    *width = scaled_size(This->width, dct_scales[i]);
+    *height = scaled_size(This->height, dct_scales[i]);
+    return S_OK;
+}
+
+static HRESULT WINAPI JpegDecoder_Transform_GetClosestPixelFormat(IWICBitmapSourceTransform *iface,
+    WICPixelFormatGUID *format)
+{
+    JpegDecoder *This = impl_from_IWICBitmapSourceTransform(iface);
+
+    TRACE("(%p,%p)\n", iface, format);
+
+    if (!format) return E_INVALIDARG;
+
+    return IWICBitmapFrameDecode_GetPixelFormat(&This->IWICBitmapFrameDecode_iface, format);
+}
+
+static HRESULT WINAPI JpegDecoder_Transform_DoesSupportTransform(IWICBitmapSourceTransform *iface,
+    WICBitmapTransformOptions transform, BOOL *supported)
+{
+    TRACE("(%p,%u,%p)\n", iface, transform, supported);
+
+    if (!supported) return E_INVALIDARG;
+
+    *supported = transform == WICBitmapTransformRotate0;
+    return S_OK;
+}
+
+static const IWICBitmapSourceTransformVtbl JpegDecoder_Transform_Vtbl = {
+    JpegDecoder_Transform_QueryInterface,
+    JpegDecoder_Transform_AddRef,
+    JpegDecoder_Transform_Release,
+    JpegDecoder_Transform_CopyPixels,
+    JpegDecoder_Transform_GetClosestSize,
+    JpegDecoder_Transform_GetClosestPixelFormat,
+    JpegDecoder_Transform_DoesSupportTransform
+};
+
 HRESULT JpegDecoder_CreateInstance(REFIID iid, void** ppv)
 {
     JpegDecoder *This;
@@ -780,11 +1019,14 @@ HRESULT JpegDecoder_CreateInstance(REFIID iid, void** ppv)
     This->IWICBitmapDecoder_iface.lpVtbl = &JpegDecoder_Vtbl;
     This->IWICBitmapFrameDecode_iface.lpVtbl = &JpegDecoder_Frame_Vtbl;
     This->IWICMetadataBlockReader_iface.lpVtbl = &JpegDecoder_Block_Vtbl;
+    This->IWICBitmapSourceTransform_iface.lpVtbl = &JpegDecoder_Transform_Vtbl;
     This->ref = 1;
     This->initialized = FALSE;
     This->cinfo_initialized = FALSE;
     This->stream = NULL;
     This->image_data = NULL;
+    This->image_rows = 0;
+    This->decode_failed = FALSE;
     InitializeCriticalSection(&This->lock);
     This->lock.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": JpegDecoder.lock");
 
@@ -825,6 +1067,7 @@ typedef struct JpegEncoder {
     BOOL committed;
     UINT width, height;
     double xres, yres;
+    int quality;
     const jpeg_compress_format *format;
     IStream *stream;
     WICColor palette[256];
@@ -931,8 +1174,32 @@ static HRESULT WINAPI JpegEncoder_Frame_Initialize(IWICBitmapFrameEncode *iface,
     IPropertyBag2 *pIEncoderOptions)
 {
     JpegEncoder *This = impl_from_IWICBitmapFrameEncode(iface);
+    PROPBAG2 opts[1]= {{0}};
+    VARIANT opt_values[1];
+    HRESULT opt_hres[1];
+    int quality = -1;
+    HRESULT hr;
+
     TRACE("(%p,%p)\n", iface, pIEncoderOptions);
 
+    opts[0].pstrName = (LPOLESTR)wszImageQuality;
+    opts[0].vt = VT_R4;
+
+    if (pIEncoderOptions)
+    {
+        hr = IPropertyBag2_Read(pIEncoderOptions, ARRAY_SIZE(opts), opts, NULL, opt_values, opt_hres);
+
+        if (FAILED(hr))
+            WARN("Failed to read the encoder options, hr %#x.\n", hr);
+        else if (V_VT(&opt_values[0]) == VT_R4)
+        {
+            if (V_R4(&opt_values[0]) >= 0.0f && V_R4(&opt_values[0]) <= 1.0f)
+                quality = V_R4(&opt_values[0]) * 100.0f + 0.5f;
+            else
+                WARN("Invalid image quality %f.\n", V_R4(&opt_values[0]));
+        }
+    }
+
     EnterCriticalSection(&This->lock);
 
     if (This->frame_initialized)
@@ -941,6 +1208,7 @@ static HRESULT WINAPI JpegEncoder_Frame_Initialize(IWICBitmapFrameEncode *iface,
         return WINCODEC_ERR_WRONGSTATE;
     }
 
+    This->quality = quality;
     This->frame_initialized = TRUE;
 
     LeaveCriticalSection(&This->lock);
@@ -1100,6 +1368,16 @@ static HRESULT WINAPI JpegEncoder_Frame_WritePixels(IWICBitmapFrameEncode *iface
 
         pjpeg_set_defaults(&This->cinfo);
 
+        if (This->quality >= 0)
+        {
+            pjpeg_set_quality(&This->cinfo, This->quality, TRUE);
+
+            /* the fast integer DCT is only noticeably less accurate at the
+             * highest quality settings */
+            if (This->quality <= 90)
+                This->cinfo.dct_method = JDCT_IFAST;
+        }
+
         if (This->xres != 0.0 && This->yres != 0.0)
         {
             This->cinfo.density_unit = 1; /* dots per inch */
@@ -1534,6 +1812,7 @@ HRESULT JpegEncoder_CreateInstance(REFIID iid, void** ppv)
     This->committed = FALSE;
     This->width = This->height = 0;
     This->xres = This->yres = 0.0;
+    This->quality = -1;
     This->format = NULL;
     This->stream = NULL;
     This->colors = 0;
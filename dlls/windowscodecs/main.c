@@ -171,6 +171,52 @@ HRESULT configure_write_source(IWICBitmapFrameEncode *iface,
     return hr;
 }
 
+/* largest temporary buffer used to copy a source that is not a bitmap */
+#define WRITE_SOURCE_BAND_SIZE (1024 * 1024)
+
+/* Bitmaps can pass their pixels to the encoder without an intermediate copy.
+ * Returns S_FALSE if the source can't be locked and has to be copied. */
+static HRESULT write_bitmap_lock(IWICBitmapFrameEncode *iface,
+    IWICBitmapSource *source, const WICRect *prc, UINT bpp)
+{
+    IWICBitmapLock *lock;
+    IWICBitmap *bitmap;
+    UINT width, height, stride, size;
+    BYTE *data;
+    HRESULT hr;
+
+    if (FAILED(IWICBitmapSource_QueryInterface(source, &IID_IWICBitmap, (void **)&bitmap)))
+        return S_FALSE;
+
+    /* rows of packed pixels must not start or end in the middle of a byte */
+    if (bpp < 8)
+    {
+        hr = IWICBitmap_GetSize(bitmap, &width, &height);
+        if (FAILED(hr) || prc->X != 0 || prc->Width != width)
+        {
+            IWICBitmap_Release(bitmap);
+            return S_FALSE;
+        }
+    }
+
+    hr = IWICBitmap_Lock(bitmap, prc, WICBitmapLockRead, &lock);
+    IWICBitmap_Release(bitmap);
+    if (FAILED(hr))
+    {
+        TRACE("failed to lock the source, hr %#x\n", hr);
+        return S_FALSE;
+    }
+
+    hr = IWICBitmapLock_GetStride(lock, &stride);
+    if (SUCCEEDED(hr))
+        hr = IWICBitmapLock_GetDataPointer(lock, &size, &data);
+    if (SUCCEEDED(hr))
+        hr = IWICBitmapFrameEncode_WritePixels(iface, prc->Height, stride, size, data);
+
+    IWICBitmapLock_Release(lock);
+    return hr;
+}
+
 HRESULT write_source(IWICBitmapFrameEncode *iface,
     IWICBitmapSource *source, const WICRect *prc,
     const WICPixelFormatGUID *format, UINT bpp, BOOL need_palette,
@@ -178,8 +224,9 @@ HRESULT write_source(IWICBitmapFrameEncode *iface,
 {
     IWICBitmapSource *converted_source;
     HRESULT hr=S_OK;
-    WICRect rc;
-    UINT stride;
+    WICRect rc, band;
+    UINT stride, band_height;
+    INT y;
     BYTE* pixeldata;
 
     if (!prc)
@@ -226,22 +273,37 @@ HRESULT write_source(IWICBitmapFrameEncode *iface,
         }
     }
 
+    hr = write_bitmap_lock(iface, converted_source, prc, bpp);
+    if (hr != S_FALSE)
+    {
+        IWICBitmapSource_Release(converted_source);
+        return hr;
+    }
+
     stride = (bpp * width + 7)/8;
+    band_height = min((UINT)prc->Height, max(1, WRITE_SOURCE_BAND_SIZE / stride));
 
-    pixeldata = HeapAlloc(GetProcessHeap(), 0, stride * prc->Height);
+    pixeldata = HeapAlloc(GetProcessHeap(), 0, stride * band_height);
     if (!pixeldata)
     {
         IWICBitmapSource_Release(converted_source);
         return E_OUTOFMEMORY;
     }
 
-    hr = IWICBitmapSource_CopyPixels(converted_source, prc, stride,
-        stride*prc->Height, pixeldata);
-
-    if (SUCCEEDED(hr))
+    band = *prc;
+    for (y = 0; y < prc->Height && SUCCEEDED(hr); y += band.Height)
     {
-        hr = IWICBitmapFrameEncode_WritePixels(iface, prc->Height, stride,
-            stride*prc->Height, pixeldata);
+        band.Y = prc->Y + y;
+        band.Height = min(band_height, (UINT)(prc->Height - y));
+
+        hr = IWICBitmapSource_CopyPixels(converted_source, &band, stride,
+            stride*band.Height, pixeldata);
+
+        if (SUCCEEDED(hr))
+        {
+            hr = IWICBitmapFrameEncode_WritePixels(iface, band.Height, stride,
+                stride*band.Height, pixeldata);
+        }
     }
 
     HeapFree(GetProcessHeap(), 0, pixeldata);
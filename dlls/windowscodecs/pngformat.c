@@ -332,9 +332,10 @@ MAKE_FUNCPTR(png_set_tRNS);
 MAKE_FUNCPTR(png_set_tRNS_to_alpha);
 MAKE_FUNCPTR(png_set_write_fn);
 MAKE_FUNCPTR(png_set_swap);
-MAKE_FUNCPTR(png_read_end);
 MAKE_FUNCPTR(png_read_image);
 MAKE_FUNCPTR(png_read_info);
+MAKE_FUNCPTR(png_read_row);
+MAKE_FUNCPTR(png_read_update_info);
 MAKE_FUNCPTR(png_write_end);
 MAKE_FUNCPTR(png_write_info);
 MAKE_FUNCPTR(png_write_rows);
@@ -399,9 +400,10 @@ static void *load_libpng(void)
         LOAD_FUNCPTR(png_set_tRNS_to_alpha);
         LOAD_FUNCPTR(png_set_write_fn);
         LOAD_FUNCPTR(png_set_swap);
-        LOAD_FUNCPTR(png_read_end);
         LOAD_FUNCPTR(png_read_image);
         LOAD_FUNCPTR(png_read_info);
+        LOAD_FUNCPTR(png_read_row);
+        LOAD_FUNCPTR(png_read_update_info);
         LOAD_FUNCPTR(png_write_end);
         LOAD_FUNCPTR(png_write_info);
         LOAD_FUNCPTR(png_write_rows);
@@ -452,7 +454,12 @@ typedef struct {
     int width, height;
     UINT stride;
     const WICPixelFormatGUID *format;
+    int passes;
+    ULARGE_INTEGER data_pos; /* where reading resumes when decoding more rows */
+    UINT decoded_rows;
+    BOOL decode_failed;
     BYTE *image_bits;
+    UINT image_rows; /* number of rows image_bits has room for */
     CRITICAL_SECTION lock; /* must be held when png structures are accessed or initialized is set */
     ULONG metadata_count;
     metadata_block_info* metadata_blocks;
@@ -573,9 +580,6 @@ static HRESULT WINAPI PngDecoder_Initialize(IWICBitmapDecoder *iface, IStream *p
     PngDecoder *This = impl_from_IWICBitmapDecoder(iface);
     LARGE_INTEGER seek;
     HRESULT hr=S_OK;
-    png_bytep *row_pointers=NULL;
-    UINT image_size;
-    UINT i;
     int color_type, bit_depth;
     png_bytep trans;
     int num_trans;
@@ -735,35 +739,17 @@ static HRESULT WINAPI PngDecoder_Initialize(IWICBitmapDecoder *iface, IStream *p
         goto end;
     }
 
-    /* read the image data */
     This->width = ppng_get_image_width(This->png_ptr, This->info_ptr);
     This->height = ppng_get_image_height(This->png_ptr, This->info_ptr);
     This->stride = (This->width * This->bpp + 7) / 8;
-    image_size = This->stride * This->height;
-
-    This->image_bits = HeapAlloc(GetProcessHeap(), 0, image_size);
-    if (!This->image_bits)
-    {
-        hr = E_OUTOFMEMORY;
-        goto end;
-    }
 
-    row_pointers = HeapAlloc(GetProcessHeap(), 0, sizeof(png_bytep)*This->height);
-    if (!row_pointers)
-    {
-        hr = E_OUTOFMEMORY;
-        goto end;
-    }
+    /* the image data is decoded on demand */
+    This->passes = ppng_set_interlace_handling(This->png_ptr);
+    ppng_read_update_info(This->png_ptr, This->info_ptr);
 
-    for (i=0; i<This->height; i++)
-        row_pointers[i] = This->image_bits + i * This->stride;
-
-    ppng_read_image(This->png_ptr, row_pointers);
-
-    HeapFree(GetProcessHeap(), 0, row_pointers);
-    row_pointers = NULL;
-
-    ppng_read_end(This->png_ptr, This->end_info);
+    seek.QuadPart = 0;
+    hr = IStream_Seek(pIStream, seek, STREAM_SEEK_CUR, &This->data_pos);
+    if (FAILED(hr)) goto end;
 
     /* Find the metadata chunks in the file. */
     seek.QuadPart = 8;
@@ -820,9 +806,83 @@ static HRESULT WINAPI PngDecoder_Initialize(IWICBitmapDecoder *iface, IStream *p
 end:
     LeaveCriticalSection(&This->lock);
 
+    return hr;
+}
+
+/* Decodes the image rows up to the end row, must be called with the lock held.
+ * Interlaced images can only be decoded as a whole. */
+static HRESULT decode_rows(PngDecoder *This, UINT end)
+{
+    png_bytep *row_pointers;
+    LARGE_INTEGER seek;
+    jmp_buf jmpbuf;
+    BYTE *new_bits;
+    HRESULT hr;
+    UINT i;
+
+    if (This->image_bits && end <= This->decoded_rows) return S_OK;
+    if (This->decode_failed) return E_FAIL;
+
+    /* only allocate the rows read so far, unless the image has to be decoded at once */
+    end = This->passes > 1 ? This->height : max(min(end, This->height), 1);
+    if (end > This->image_rows)
+    {
+        if (This->image_bits)
+            new_bits = HeapReAlloc(GetProcessHeap(), 0, This->image_bits, This->stride * end);
+        else
+            new_bits = HeapAlloc(GetProcessHeap(), 0, This->stride * end);
+        if (!new_bits) return E_OUTOFMEMORY;
+        This->image_bits = new_bits;
+        This->image_rows = end;
+    }
+
+    if (This->passes > 1)
+    {
+        row_pointers = HeapAlloc(GetProcessHeap(), 0, sizeof(png_bytep) * This->height);
+        if (!row_pointers) return E_OUTOFMEMORY;
+
+        for (i = 0; i < This->height; i++)
+            row_pointers[i] = This->image_bits + i * This->stride;
+    }
+    else row_pointers = NULL;
+
+    /* the stream may have been used by someone else in the meantime */
+    seek.QuadPart = This->data_pos.QuadPart;
+    hr = IStream_Seek(This->stream, seek, STREAM_SEEK_SET, NULL);
+    if (FAILED(hr))
+    {
+        HeapFree(GetProcessHeap(), 0, row_pointers);
+        return hr;
+    }
+
+    if (setjmp(jmpbuf))
+    {
+        HeapFree(GetProcessHeap(), 0, row_pointers);
+        This->decode_failed = TRUE;
+        return E_FAIL;
+    }
+    ppng_set_error_fn(This->png_ptr, jmpbuf, user_error_fn, user_warning_fn);
+
+    if (row_pointers)
+    {
+        ppng_read_image(This->png_ptr, row_pointers);
+        This->decoded_rows = This->height;
+    }
+    else
+    {
+        while (This->decoded_rows < end)
+        {
+            ppng_read_row(This->png_ptr, This->image_bits + This->decoded_rows * This->stride, NULL);
+            This->decoded_rows++;
+        }
+    }
+
     HeapFree(GetProcessHeap(), 0, row_pointers);
 
-    return hr;
+    seek.QuadPart = 0;
+    IStream_Seek(This->stream, seek, STREAM_SEEK_CUR, &This->data_pos);
+
+    return S_OK;
 }
 
 static HRESULT WINAPI PngDecoder_GetContainerFormat(IWICBitmapDecoder *iface,
@@ -1104,11 +1164,21 @@ static HRESULT WINAPI PngDecoder_Frame_CopyPixels(IWICBitmapFrameDecode *iface,
     const WICRect *prc, UINT cbStride, UINT cbBufferSize, BYTE *pbBuffer)
 {
     PngDecoder *This = impl_from_IWICBitmapFrameDecode(iface);
+    HRESULT hr;
+
     TRACE("(%p,%s,%u,%u,%p)\n", iface, debug_wic_rect(prc), cbStride, cbBufferSize, pbBuffer);
 
-    return copy_pixels(This->bpp, This->image_bits,
-        This->width, This->height, This->stride,
-        prc, cbStride, cbBufferSize, pbBuffer);
+    EnterCriticalSection(&This->lock);
+
+    hr = decode_rows(This, prc && prc->Y >= 0 && prc->Height >= 0 ? prc->Y + prc->Height : This->height);
+    if (SUCCEEDED(hr))
+        hr = copy_pixels(This->bpp, This->image_bits,
+            This->width, This->height, This->stride,
+            prc, cbStride, cbBufferSize, pbBuffer);
+
+    LeaveCriticalSection(&This->lock);
+
+    return hr;
 }
 
 static HRESULT WINAPI PngDecoder_Frame_GetMetadataQueryReader(IWICBitmapFrameDecode *iface,
@@ -1322,6 +1392,9 @@ HRESULT PngDecoder_CreateInstance(REFIID iid, void** ppv)
     This->stream = NULL;
     This->initialized = FALSE;
     This->image_bits = NULL;
+    This->image_rows = 0;
+    This->decoded_rows = 0;
+    This->decode_failed = FALSE;
     InitializeCriticalSection(&This->lock);
     This->lock.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": PngDecoder.lock");
     This->metadata_count = 0;
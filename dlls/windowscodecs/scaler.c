@@ -20,6 +20,7 @@
 #include "config.h"
 
 #include <stdarg.h>
+#include <math.h>
 
 #define COBJMACROS
 
@@ -29,10 +30,19 @@
 
 #include "wincodecs_private.h"
 
+#include "wine/heap.h"
 #include "wine/debug.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(wincodecs);
 
+/* source pixels and weights contributing to each destination column or row */
+struct filter_axis {
+    UINT *first;        /* first tap of each destination pixel, with one extra entry */
+    UINT *pixels;
+    float *weights;
+    UINT min_pixel, max_pixel;
+};
+
 typedef struct BitmapScaler {
     IWICBitmapScaler IWICBitmapScaler_iface;
     LONG ref;
@@ -44,9 +54,37 @@ typedef struct BitmapScaler {
     UINT bpp;
     void (*fn_get_required_source_rect)(struct BitmapScaler*,UINT,UINT,WICRect*);
     void (*fn_copy_scanline)(struct BitmapScaler*,UINT,UINT,UINT,BYTE**,UINT,UINT,BYTE*);
+    /* filtering modes */
+    struct filter_axis x_axis, y_axis;
+    UINT channels;
+    INT alpha;          /* straight alpha channel, -1 if none or premultiplied */
+    UINT cache_rows;
+    float *rows;        /* horizontally filtered source rows, alpha premultiplied */
+    INT *row_tags;      /* source row held by each entry of rows, -1 if none */
+    BYTE *src_rows;     /* source rows being filtered */
     CRITICAL_SECTION lock; /* must be held when initialized */
 } BitmapScaler;
 
+static void free_filter_axis(struct filter_axis *axis)
+{
+    heap_free(axis->first);
+    heap_free(axis->pixels);
+    heap_free(axis->weights);
+    memset(axis, 0, sizeof(*axis));
+}
+
+static void Filter_Cleanup(BitmapScaler *This)
+{
+    free_filter_axis(&This->x_axis);
+    free_filter_axis(&This->y_axis);
+    heap_free(This->rows);
+    heap_free(This->row_tags);
+    heap_free(This->src_rows);
+    This->rows = NULL;
+    This->row_tags = NULL;
+    This->src_rows = NULL;
+}
+
 static inline BitmapScaler *impl_from_IWICBitmapScaler(IWICBitmapScaler *iface)
 {
     return CONTAINING_RECORD(iface, BitmapScaler, IWICBitmapScaler_iface);
@@ -108,6 +146,7 @@ static ULONG WINAPI BitmapScaler_Release(IWICBitmapScaler *iface)
         This->lock.DebugInfo->Spare[0] = 0;
         DeleteCriticalSection(&This->lock);
         if (This->source) IWICBitmapSource_Release(This->source);
+        Filter_Cleanup(This);
         HeapFree(GetProcessHeap(), 0, This);
     }
 
@@ -205,6 +244,429 @@ static void NearestNeighbor_CopyScanline(BitmapScaler *This,
     }
 }
 
+/* Formats with 8-bit channels that can be filtered directly. */
+static const struct
+{
+    const WICPixelFormatGUID *format;
+    UINT channels;
+    INT alpha;
+} filter_formats[] =
+{
+    { &GUID_WICPixelFormat8bppGray, 1, -1 },
+    { &GUID_WICPixelFormat24bppBGR, 3, -1 },
+    { &GUID_WICPixelFormat24bppRGB, 3, -1 },
+    { &GUID_WICPixelFormat32bppBGR, 4, -1 },
+    { &GUID_WICPixelFormat32bppBGRA, 4, 3 },
+    { &GUID_WICPixelFormat32bppRGBA, 4, 3 },
+    { &GUID_WICPixelFormat32bppPBGRA, 4, -1 },
+    { &GUID_WICPixelFormat32bppPRGBA, 4, -1 },
+};
+
+static float linear_filter(float x)
+{
+    x = fabsf(x);
+    return x < 1.0f ? 1.0f - x : 0.0f;
+}
+
+/* Catmull-Rom spline */
+static float cubic_filter(float x)
+{
+    x = fabsf(x);
+    if (x < 1.0f) return (1.5f * x - 2.5f) * x * x + 1.0f;
+    if (x < 2.0f) return ((-0.5f * x + 2.5f) * x - 4.0f) * x + 2.0f;
+    return 0.0f;
+}
+
+/* Compute the taps of each destination pixel. Pixel centers are mapped to
+ * each other, and the source edges are extended. */
+static HRESULT Filter_InitAxis(struct filter_axis *axis, WICBitmapInterpolationMode mode,
+    UINT src_size, UINT dst_size)
+{
+    float scale = (float)src_size / dst_size, stretch = max(scale, 1.0f);
+    float radius, pos, weight, sum;
+    UINT i, k, n, taps = 0, max_taps;
+    INT j, first, last;
+
+    switch (mode)
+    {
+    case WICBitmapInterpolationModeLinear:
+        radius = 1.0f;
+        break;
+    case WICBitmapInterpolationModeCubic:
+        radius = 2.0f;
+        break;
+    case WICBitmapInterpolationModeHighQualityCubic:
+        radius = 2.0f * stretch;
+        break;
+    case WICBitmapInterpolationModeFant:
+    default:
+        radius = 0.5f * stretch + 0.5f;
+        break;
+    }
+
+    max_taps = (UINT)ceilf(radius * 2.0f) + 1;
+    axis->first = heap_alloc((dst_size + 1) * sizeof(*axis->first));
+    axis->pixels = heap_alloc(dst_size * max_taps * sizeof(*axis->pixels));
+    axis->weights = heap_alloc(dst_size * max_taps * sizeof(*axis->weights));
+    if (!axis->first || !axis->pixels || !axis->weights)
+    {
+        free_filter_axis(axis);
+        return E_OUTOFMEMORY;
+    }
+
+    axis->min_pixel = src_size - 1;
+    axis->max_pixel = 0;
+
+    for (i = 0; i < dst_size; i++)
+    {
+        pos = (i + 0.5f) * scale - 0.5f;
+        first = ceilf(pos - radius);
+        last = floorf(pos + radius);
+        axis->first[i] = n = taps;
+
+        for (j = first, sum = 0.0f; j <= last && taps < n + max_taps; j++)
+        {
+            switch (mode)
+            {
+            case WICBitmapInterpolationModeLinear:
+                weight = linear_filter(j - pos);
+                break;
+            case WICBitmapInterpolationModeCubic:
+                weight = cubic_filter(j - pos);
+                break;
+            case WICBitmapInterpolationModeHighQualityCubic:
+                weight = cubic_filter((j - pos) / stretch);
+                break;
+            case WICBitmapInterpolationModeFant:
+            default:
+                /* area of the source pixel covered by the destination pixel */
+                weight = min(j + 0.5f, pos + 0.5f * stretch) - max(j - 0.5f, pos - 0.5f * stretch);
+                weight = max(weight, 0.0f);
+                break;
+            }
+            if (weight == 0.0f) continue;
+
+            axis->pixels[taps] = min(max(j, 0), (INT)src_size - 1);
+            axis->weights[taps] = weight;
+            axis->min_pixel = min(axis->min_pixel, axis->pixels[taps]);
+            axis->max_pixel = max(axis->max_pixel, axis->pixels[taps]);
+            sum += weight;
+            taps++;
+        }
+
+        if (sum != 0.0f)
+            for (k = n; k < taps; k++) axis->weights[k] /= sum;
+    }
+    axis->first[dst_size] = taps;
+
+    return S_OK;
+}
+
+static UINT get_row_span(const struct filter_axis *axis, UINT first, UINT count)
+{
+    UINT i, tap, min_pixel = ~0u, max_pixel = 0;
+
+    for (i = axis->first[first]; i < axis->first[first + count]; i++)
+    {
+        tap = axis->pixels[i];
+        min_pixel = min(min_pixel, tap);
+        max_pixel = max(max_pixel, tap);
+    }
+    return max_pixel - min_pixel + 1;
+}
+
+/* destination rows filtered together, their source rows must fit in the cache */
+#define FILTER_CHUNK_ROWS 16
+
+static HRESULT Filter_Initialize(BitmapScaler *This)
+{
+    UINT i, count;
+    HRESULT hr;
+
+    hr = Filter_InitAxis(&This->x_axis, This->mode, This->src_width, This->width);
+    if (SUCCEEDED(hr))
+        hr = Filter_InitAxis(&This->y_axis, This->mode, This->src_height, This->height);
+    if (FAILED(hr)) return hr;
+
+    This->cache_rows = 0;
+    for (i = 0; i < This->height; i++)
+    {
+        count = min(FILTER_CHUNK_ROWS, This->height - i);
+        This->cache_rows = max(This->cache_rows, get_row_span(&This->y_axis, i, count));
+    }
+
+    This->rows = heap_alloc(This->cache_rows * This->width * This->channels * sizeof(float));
+    This->row_tags = heap_alloc(This->cache_rows * sizeof(*This->row_tags));
+    This->src_rows = heap_alloc(This->cache_rows * ((This->src_width * This->bpp + 7) / 8));
+    if (!This->rows || !This->row_tags || !This->src_rows)
+        return E_OUTOFMEMORY;
+
+    for (i = 0; i < This->cache_rows; i++)
+        This->row_tags[i] = -1;
+
+    return S_OK;
+}
+
+/* operations with fewer pixels are not worth waking up worker threads */
+#define MIN_PARALLEL_PIXELS (256 * 1024)
+#define BANDS_PER_THREAD 4
+#define MAX_THREADS 16
+
+typedef HRESULT (*band_func)(void *ctx, UINT start, UINT end);
+
+struct band_work
+{
+    band_func func;
+    void *ctx;
+    UINT count;
+    UINT bands;
+    LONG next;
+    LONG pending;       /* threads still processing bands, including the caller */
+    LONG hr;
+    HANDLE done;
+};
+
+static void process_bands(struct band_work *work)
+{
+    HRESULT hr;
+    LONG band;
+
+    while ((band = InterlockedIncrement(&work->next) - 1) < work->bands)
+    {
+        hr = work->func(work->ctx, (ULONGLONG)band * work->count / work->bands,
+                        (ULONGLONG)(band + 1) * work->count / work->bands);
+        if (FAILED(hr)) InterlockedCompareExchange(&work->hr, hr, S_OK);
+    }
+    if (!InterlockedDecrement(&work->pending)) SetEvent(work->done);
+}
+
+static void CALLBACK band_callback(TP_CALLBACK_INSTANCE *instance, void *context)
+{
+    process_bands(context);
+}
+
+/* Call func for consecutive ranges covering [0, count), concurrently on the
+ * thread pool when there is enough work. The ranges must not depend on each
+ * other. */
+static HRESULT run_bands(UINT count, UINT item_pixels, band_func func, void *ctx)
+{
+    static LONG threads;
+    struct band_work work;
+    SYSTEM_INFO info;
+    UINT i;
+
+    if (!threads)
+    {
+        GetSystemInfo(&info);
+        InterlockedCompareExchange(&threads, min(max(info.dwNumberOfProcessors, 1), MAX_THREADS), 0);
+    }
+
+    if (count < 2 || threads < 2 || (ULONGLONG)count * item_pixels < MIN_PARALLEL_PIXELS ||
+        !(work.done = CreateEventW(NULL, TRUE, FALSE, NULL)))
+        return func(ctx, 0, count);
+
+    work.func = func;
+    work.ctx = ctx;
+    work.count = count;
+    work.bands = min(count, threads * BANDS_PER_THREAD);
+    work.next = 0;
+    work.pending = 1;
+    work.hr = S_OK;
+
+    for (i = 1; i < threads; i++)
+    {
+        InterlockedIncrement(&work.pending);
+        if (!TrySubmitThreadpoolCallback(band_callback, &work, NULL))
+        {
+            InterlockedDecrement(&work.pending);
+            break;
+        }
+    }
+    process_bands(&work);
+    WaitForSingleObject(work.done, INFINITE);
+    CloseHandle(work.done);
+    return work.hr;
+}
+
+static inline BYTE clamp_channel(float value)
+{
+    if (value <= 0.0f) return 0;
+    if (value >= 255.0f) return 255;
+    return value + 0.5f;
+}
+
+struct filter_context
+{
+    BitmapScaler *This;
+    UINT src_y;             /* source row of the first entry of src_rows */
+    UINT src_stride;
+    const WICRect *rect;
+    UINT dst_y;             /* first destination row to filter, relative to rect */
+    UINT dst_stride;
+    BYTE *dst;
+};
+
+static HRESULT Filter_HorizontalRows(void *arg, UINT start, UINT end)
+{
+    const struct filter_context *ctx = arg;
+    const BitmapScaler *This = ctx->This;
+    const struct filter_axis *axis = &This->x_axis;
+    UINT i, x, c, tap, channels = This->channels;
+    INT alpha = This->alpha;
+    float acc[4];
+
+    for (i = start; i < end; i++)
+    {
+        const BYTE *src = This->src_rows + i * ctx->src_stride;
+        float *out = This->rows + ((ctx->src_y + i) % This->cache_rows) * This->width * channels;
+
+        for (x = 0; x < This->width; x++, out += channels)
+        {
+            acc[0] = acc[1] = acc[2] = acc[3] = 0.0f;
+            for (tap = axis->first[x]; tap < axis->first[x + 1]; tap++)
+            {
+                const BYTE *pixel = src + axis->pixels[tap] * channels;
+                float weight = axis->weights[tap];
+
+                if (alpha != -1)
+                {
+                    acc[alpha] += weight * pixel[alpha];
+                    weight *= pixel[alpha];
+                    for (c = 0; c < channels; c++)
+                        if (c != alpha) acc[c] += weight * pixel[c];
+                }
+                else
+                {
+                    for (c = 0; c < channels; c++)
+                        acc[c] += weight * pixel[c];
+                }
+            }
+            for (c = 0; c < channels; c++) out[c] = acc[c];
+        }
+    }
+    return S_OK;
+}
+
+static HRESULT Filter_VerticalRows(void *arg, UINT start, UINT end)
+{
+    const struct filter_context *ctx = arg;
+    const BitmapScaler *This = ctx->This;
+    const struct filter_axis *axis = &This->y_axis;
+    UINT channels = This->channels, count = ctx->rect->Width * channels;
+    UINT i, x, c, tap;
+    INT alpha = This->alpha;
+    float *acc;
+
+    if (!(acc = heap_alloc(count * sizeof(*acc)))) return E_OUTOFMEMORY;
+
+    for (i = start; i < end; i++)
+    {
+        UINT y = ctx->rect->Y + ctx->dst_y + i;
+        BYTE *dst = ctx->dst + (ctx->dst_y + i) * ctx->dst_stride;
+
+        memset(acc, 0, count * sizeof(*acc));
+        for (tap = axis->first[y]; tap < axis->first[y + 1]; tap++)
+        {
+            const float *row = This->rows + (axis->pixels[tap] % This->cache_rows) * This->width * channels +
+                               ctx->rect->X * channels;
+            float weight = axis->weights[tap];
+
+            for (x = 0; x < count; x++)
+                acc[x] += weight * row[x];
+        }
+
+        if (alpha == -1)
+        {
+            for (x = 0; x < count; x++)
+                dst[x] = clamp_channel(acc[x]);
+            continue;
+        }
+
+        for (x = 0; x < count; x += channels)
+        {
+            float a = acc[x + alpha];
+
+            for (c = 0; c < channels; c++)
+            {
+                if (a < 0.5f)
+                    dst[x + c] = 0;
+                else if (c == alpha)
+                    dst[x + c] = clamp_channel(a);
+                else
+                    dst[x + c] = clamp_channel(acc[x + c] / a);
+            }
+        }
+    }
+
+    heap_free(acc);
+    return S_OK;
+}
+
+/* Filter a destination rectangle. Horizontally filtered source rows are kept
+ * in a small cache, so that reading the image from top to bottom only reads
+ * and filters each source row once. */
+static HRESULT Filter_CopyPixels(BitmapScaler *This, const WICRect *rect, UINT stride, BYTE *buffer)
+{
+    struct filter_context ctx;
+    WICRect src_rect;
+    UINT i, y, count, tap, first, last, row;
+    HRESULT hr = S_OK;
+
+    ctx.This = This;
+    ctx.src_stride = (This->src_width * This->bpp + 7) / 8;
+    ctx.rect = rect;
+    ctx.dst_stride = stride;
+    ctx.dst = buffer;
+
+    for (y = 0; y < rect->Height && SUCCEEDED(hr); y += count)
+    {
+        count = min(FILTER_CHUNK_ROWS, rect->Height - y);
+
+        first = This->src_height;
+        last = 0;
+        for (tap = This->y_axis.first[rect->Y + y]; tap < This->y_axis.first[rect->Y + y + count]; tap++)
+        {
+            first = min(first, This->y_axis.pixels[tap]);
+            last = max(last, This->y_axis.pixels[tap]);
+        }
+
+        /* read and filter the runs of rows that are not cached yet */
+        for (row = first; row <= last && SUCCEEDED(hr); row = src_rect.Y + src_rect.Height)
+        {
+            src_rect.X = 0;
+            src_rect.Y = row;
+            src_rect.Width = This->src_width;
+            src_rect.Height = 0;
+
+            while (src_rect.Y <= last && This->row_tags[src_rect.Y % This->cache_rows] == src_rect.Y)
+                src_rect.Y++;
+            while (src_rect.Y + src_rect.Height <= last &&
+                   This->row_tags[(src_rect.Y + src_rect.Height) % This->cache_rows] != src_rect.Y + src_rect.Height)
+                src_rect.Height++;
+
+            if (!src_rect.Height) break;
+
+            hr = IWICBitmapSource_CopyPixels(This->source, &src_rect, ctx.src_stride,
+                ctx.src_stride * src_rect.Height, This->src_rows);
+            if (FAILED(hr)) break;
+
+            ctx.src_y = src_rect.Y;
+            hr = run_bands(src_rect.Height, This->width * This->channels, Filter_HorizontalRows, &ctx);
+            if (FAILED(hr)) break;
+
+            for (i = src_rect.Y; i < src_rect.Y + src_rect.Height; i++)
+                This->row_tags[i % This->cache_rows] = i;
+        }
+
+        if (FAILED(hr)) break;
+
+        ctx.dst_y = y;
+        hr = run_bands(count, rect->Width * This->channels, Filter_VerticalRows, &ctx);
+    }
+
+    return hr;
+}
+
 static HRESULT WINAPI BitmapScaler_CopyPixels(IWICBitmapScaler *iface,
     const WICRect *prc, UINT cbStride, UINT cbBufferSize, BYTE *pbBuffer)
 {
@@ -259,6 +721,12 @@ static HRESULT WINAPI BitmapScaler_CopyPixels(IWICBitmapScaler *iface,
         goto end;
     }
 
+    if (This->x_axis.first)
+    {
+        hr = Filter_CopyPixels(This, &dest_rect, cbStride, pbBuffer);
+        goto end;
+    }
+
     /* MSDN recommends calling CopyPixels once for each scanline from top to
      * bottom, and claims codecs optimize for this. Ideally, when called in this
      * way, we should avoid requesting a scanline from the source more than
@@ -321,6 +789,7 @@ static HRESULT WINAPI BitmapScaler_Initialize(IWICBitmapScaler *iface,
     BitmapScaler *This = impl_from_IWICBitmapScaler(iface);
     HRESULT hr;
     GUID src_pixelformat;
+    UINT i;
 
     TRACE("(%p,%p,%u,%u,%u)\n", iface, pISource, uiWidth, uiHeight, mode);
 
@@ -353,6 +822,39 @@ static HRESULT WINAPI BitmapScaler_Initialize(IWICBitmapScaler *iface,
     {
         switch (mode)
         {
+        case WICBitmapInterpolationModeLinear:
+        case WICBitmapInterpolationModeCubic:
+        case WICBitmapInterpolationModeFant:
+        case WICBitmapInterpolationModeHighQualityCubic:
+            for (i = 0; i < ARRAY_SIZE(filter_formats); i++)
+                if (IsEqualGUID(filter_formats[i].format, &src_pixelformat)) break;
+
+            if (i < ARRAY_SIZE(filter_formats))
+            {
+                IWICBitmapSource_AddRef(pISource);
+                This->source = pISource;
+                This->channels = filter_formats[i].channels;
+                This->alpha = filter_formats[i].alpha;
+            }
+            else
+            {
+                hr = WICConvertBitmapSource(&GUID_WICPixelFormat32bppBGRA,
+                    pISource, &This->source);
+                This->bpp = 32;
+                This->channels = 4;
+                This->alpha = 3;
+            }
+
+            if (SUCCEEDED(hr))
+                hr = Filter_Initialize(This);
+
+            if (FAILED(hr))
+            {
+                Filter_Cleanup(This);
+                if (This->source) IWICBitmapSource_Release(This->source);
+                This->source = NULL;
+            }
+            break;
         default:
             FIXME("unsupported mode %i\n", mode);
             /* fall-through */
@@ -529,6 +1031,14 @@ HRESULT BitmapScaler_Create(IWICBitmapScaler **scaler)
     This->src_height = 0;
     This->mode = 0;
     This->bpp = 0;
+    memset(&This->x_axis, 0, sizeof(This->x_axis));
+    memset(&This->y_axis, 0, sizeof(This->y_axis));
+    This->channels = 0;
+    This->alpha = -1;
+    This->cache_rows = 0;
+    This->rows = NULL;
+    This->row_tags = NULL;
+    This->src_rows = NULL;
     InitializeCriticalSection(&This->lock);
     This->lock.DebugInfo->Spare[0] = (DWORD_PTR)(__FILE__ ": BitmapScaler.lock");
 
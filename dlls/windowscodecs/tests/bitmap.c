@@ -1312,6 +1312,143 @@ static void test_bitmap_scaler(void)
     IWICBitmap_Release(bitmap);
 }
 
+static void test_bitmap_scaler_modes(void)
+{
+    static const WICBitmapInterpolationMode modes[] =
+    {
+        WICBitmapInterpolationModeLinear,
+        WICBitmapInterpolationModeCubic,
+        WICBitmapInterpolationModeFant,
+        WICBitmapInterpolationModeHighQualityCubic,
+    };
+    static const struct
+    {
+        UINT width, height;
+    }
+    sizes[] =
+    {
+        {  5,  3 },
+        { 16, 16 },
+        { 37, 29 },
+        { 90, 70 },
+    };
+    BYTE src[32 * 24 * 4], dst[90 * 70 * 4], row[90 * 4];
+    WICPixelFormatGUID pixel_format;
+    IWICBitmapScaler *scaler;
+    IWICBitmap *bitmap;
+    UINT i, j, x, y;
+    WICRect rect;
+    HRESULT hr;
+
+    for (i = 0; i < sizeof(src); i += 4)
+    {
+        src[i] = 0x40;
+        src[i + 1] = 0x80;
+        src[i + 2] = 0xc0;
+        src[i + 3] = 0xff;
+    }
+
+    hr = IWICImagingFactory_CreateBitmapFromMemory(factory, 32, 24, &GUID_WICPixelFormat32bppBGRA,
+            32 * 4, sizeof(src), src, &bitmap);
+    ok(hr == S_OK, "Failed to create a bitmap, hr %#x.\n", hr);
+
+    for (i = 0; i < ARRAY_SIZE(modes); i++)
+    {
+        for (j = 0; j < ARRAY_SIZE(sizes); j++)
+        {
+            hr = IWICImagingFactory_CreateBitmapScaler(factory, &scaler);
+            ok(hr == S_OK, "Failed to create bitmap scaler, hr %#x.\n", hr);
+
+            hr = IWICBitmapScaler_Initialize(scaler, (IWICBitmapSource *)bitmap, sizes[j].width, sizes[j].height,
+                    modes[i]);
+            ok(hr == S_OK, "%u: Failed to initialize bitmap scaler, hr %#x.\n", modes[i], hr);
+
+            hr = IWICBitmapScaler_GetPixelFormat(scaler, &pixel_format);
+            ok(hr == S_OK, "%u: Failed to get pixel format, hr %#x.\n", modes[i], hr);
+            ok(IsEqualGUID(&pixel_format, &GUID_WICPixelFormat32bppBGRA), "%u: Unexpected pixel format %s.\n",
+                    modes[i], wine_dbgstr_guid(&pixel_format));
+
+            memset(dst, 0, sizeof(dst));
+            hr = IWICBitmapScaler_CopyPixels(scaler, NULL, sizes[j].width * 4, sizeof(dst), dst);
+            ok(hr == S_OK, "%u: Failed to copy pixels, hr %#x.\n", modes[i], hr);
+
+            /* A uniform image has to stay uniform whatever the filter. */
+            for (x = 0; x < sizes[j].width * sizes[j].height * 4; x++)
+                if (dst[x] != src[x % 4]) break;
+            ok(x == sizes[j].width * sizes[j].height * 4, "%u: %ux%u: pixel data differs at %u.\n", modes[i],
+                    sizes[j].width, sizes[j].height, x);
+
+            /* Copying scanline by scanline must match the full copy. */
+            for (y = 0; y < sizes[j].height; y++)
+            {
+                rect.X = 0;
+                rect.Y = y;
+                rect.Width = sizes[j].width;
+                rect.Height = 1;
+                hr = IWICBitmapScaler_CopyPixels(scaler, &rect, sizes[j].width * 4, sizeof(row), row);
+                ok(hr == S_OK, "%u: Failed to copy pixels, hr %#x.\n", modes[i], hr);
+                if (memcmp(row, dst + y * sizes[j].width * 4, sizes[j].width * 4)) break;
+            }
+            ok(y == sizes[j].height, "%u: %ux%u: row %u differs.\n", modes[i], sizes[j].width, sizes[j].height, y);
+
+            IWICBitmapScaler_Release(scaler);
+        }
+    }
+
+    IWICBitmap_Release(bitmap);
+
+    /* blue horizontal ramp, green checkerboard */
+    for (y = 0; y < 24; y++)
+    {
+        for (x = 0; x < 32; x++)
+        {
+            src[(y * 32 + x) * 4] = x * 8;
+            src[(y * 32 + x) * 4 + 1] = (x ^ y) & 1 ? 0xff : 0;
+            src[(y * 32 + x) * 4 + 2] = 0x40;
+            src[(y * 32 + x) * 4 + 3] = 0xff;
+        }
+    }
+
+    hr = IWICImagingFactory_CreateBitmapFromMemory(factory, 32, 24, &GUID_WICPixelFormat32bppBGRA,
+            32 * 4, sizeof(src), src, &bitmap);
+    ok(hr == S_OK, "Failed to create a bitmap, hr %#x.\n", hr);
+
+    for (i = 0; i < ARRAY_SIZE(modes); i++)
+    {
+        /* enlarged twice, destination pixel 21 is a quarter of the way between source pixels 10 and 11 */
+        hr = IWICImagingFactory_CreateBitmapScaler(factory, &scaler);
+        ok(hr == S_OK, "Failed to create bitmap scaler, hr %#x.\n", hr);
+        hr = IWICBitmapScaler_Initialize(scaler, (IWICBitmapSource *)bitmap, 64, 48, modes[i]);
+        ok(hr == S_OK, "%u: Failed to initialize bitmap scaler, hr %#x.\n", modes[i], hr);
+        hr = IWICBitmapScaler_CopyPixels(scaler, NULL, 64 * 4, sizeof(dst), dst);
+        ok(hr == S_OK, "%u: Failed to copy pixels, hr %#x.\n", modes[i], hr);
+
+        x = dst[(20 * 64 + 21) * 4];
+        if (modes[i] == WICBitmapInterpolationModeFant)
+            ok(x >= 72 && x <= 88, "%u: got blue %u.\n", modes[i], x);
+        else
+            ok(x > 80 && x < 88, "%u: got blue %u.\n", modes[i], x);
+        ok(dst[(20 * 64 + 21) * 4 + 2] == 0x40, "%u: got red %u.\n", modes[i], dst[(20 * 64 + 21) * 4 + 2]);
+        IWICBitmapScaler_Release(scaler);
+
+        /* shrunk twice, each destination pixel averages a checkerboard block */
+        hr = IWICImagingFactory_CreateBitmapScaler(factory, &scaler);
+        ok(hr == S_OK, "Failed to create bitmap scaler, hr %#x.\n", hr);
+        hr = IWICBitmapScaler_Initialize(scaler, (IWICBitmapSource *)bitmap, 16, 12, modes[i]);
+        ok(hr == S_OK, "%u: Failed to initialize bitmap scaler, hr %#x.\n", modes[i], hr);
+        hr = IWICBitmapScaler_CopyPixels(scaler, NULL, 16 * 4, sizeof(dst), dst);
+        ok(hr == S_OK, "%u: Failed to copy pixels, hr %#x.\n", modes[i], hr);
+
+        x = dst[(6 * 16 + 8) * 4];
+        ok(x >= 130 && x <= 134, "%u: got blue %u.\n", modes[i], x);
+        x = dst[(6 * 16 + 8) * 4 + 1];
+        ok(x >= 126 && x <= 129, "%u: got green %u.\n", modes[i], x);
+        IWICBitmapScaler_Release(scaler);
+    }
+
+    IWICBitmap_Release(bitmap);
+}
+
 static LONG obj_refcount(void *obj)
 {
     IUnknown_AddRef((IUnknown *)obj);
@@ -1482,6 +1619,7 @@ START_TEST(bitmap)
     test_CreateBitmapFromHBITMAP();
     test_clipper();
     test_bitmap_scaler();
+    test_bitmap_scaler_modes();
 
     IWICImagingFactory_Release(factory);
 
@@ -1692,6 +1692,147 @@ static const struct setting png_interlace_settings[] = {
     {NULL}
 };
 
+static BOOL near_equal_byte(BYTE a, BYTE b)
+{
+    return abs(a - b) <= 1;
+}
+
+static void test_converter_large(void)
+{
+    static const struct
+    {
+        const WICPixelFormatGUID *src_format;
+        UINT src_bpp;
+        const WICPixelFormatGUID *dst_format;
+        UINT dst_bpp;
+        const char *name;
+    }
+    tests[] =
+    {
+        {&GUID_WICPixelFormat24bppBGR, 24, &GUID_WICPixelFormat32bppBGRA, 32, "24bppBGR -> 32bppBGRA"},
+        {&GUID_WICPixelFormat32bppBGRA, 32, &GUID_WICPixelFormat32bppPBGRA, 32, "32bppBGRA -> 32bppPBGRA"},
+        {&GUID_WICPixelFormat32bppPBGRA, 32, &GUID_WICPixelFormat32bppBGRA, 32, "32bppPBGRA -> 32bppBGRA"},
+        {&GUID_WICPixelFormat8bppGray, 8, &GUID_WICPixelFormat32bppBGRA, 32, "8bppGray -> 32bppBGRA"},
+        {&GUID_WICPixelFormat24bppBGR, 24, &GUID_WICPixelFormat8bppGray, 8, "24bppBGR -> 8bppGray"},
+    };
+    const UINT width = 509, height = 300;
+    struct bitmap_data data;
+    IWICBitmapSource *dst_bitmap;
+    BitmapTestSrc *src_obj;
+    BYTE *src, *dst, *row, expect[4];
+    UINT i, x, y, c, src_stride, dst_stride, seed = 1;
+    DWORD start;
+    WICRect rc;
+    HRESULT hr;
+
+    src = HeapAlloc(GetProcessHeap(), 0, width * height * 4);
+    dst = HeapAlloc(GetProcessHeap(), 0, width * height * 4);
+    row = HeapAlloc(GetProcessHeap(), 0, width * 4);
+
+    for (i = 0; i < ARRAY_SIZE(tests); i++)
+    {
+        src_stride = width * tests[i].src_bpp / 8;
+        dst_stride = width * tests[i].dst_bpp / 8;
+
+        for (x = 0; x < src_stride * height; x++)
+        {
+            seed = seed * 1103515245 + 12345;
+            src[x] = seed >> 16;
+        }
+        /* premultiplied colors can't exceed alpha */
+        if (IsEqualGUID(tests[i].src_format, &GUID_WICPixelFormat32bppPBGRA))
+            for (x = 0; x < src_stride * height; x++)
+                if (x % 4 != 3) src[x] %= src[x | 3] + 1;
+
+        data.format = tests[i].src_format;
+        data.bpp = tests[i].src_bpp;
+        data.bits = src;
+        data.width = width;
+        data.height = height;
+        data.xres = data.yres = 96.0;
+        data.alt_data = NULL;
+        CreateTestBitmap(&data, &src_obj);
+
+        hr = WICConvertBitmapSource(tests[i].dst_format, &src_obj->IWICBitmapSource_iface, &dst_bitmap);
+        ok(hr == S_OK, "%s: WICConvertBitmapSource failed, hr %#x.\n", tests[i].name, hr);
+        if (hr != S_OK)
+        {
+            DeleteTestBitmap(src_obj);
+            continue;
+        }
+
+        start = GetTickCount();
+        hr = IWICBitmapSource_CopyPixels(dst_bitmap, NULL, dst_stride, dst_stride * height, dst);
+        ok(hr == S_OK, "%s: CopyPixels failed, hr %#x.\n", tests[i].name, hr);
+        if (winetest_debug > 1)
+            trace("%s: %u pixels in %u ms\n", tests[i].name, width * height, GetTickCount() - start);
+
+        for (y = 0; y < height; y++)
+        {
+            for (x = 0; x < width; x++)
+            {
+                const BYTE *s = src + y * src_stride + x * tests[i].src_bpp / 8;
+                const BYTE *d = dst + y * dst_stride + x * tests[i].dst_bpp / 8;
+
+                switch (tests[i].src_bpp * 100 + tests[i].dst_bpp)
+                {
+                case 2432:
+                    expect[0] = s[0];
+                    expect[1] = s[1];
+                    expect[2] = s[2];
+                    expect[3] = 0xff;
+                    break;
+                case 3232:
+                    expect[3] = s[3];
+                    for (c = 0; c < 3; c++)
+                    {
+                        if (IsEqualGUID(tests[i].src_format, &GUID_WICPixelFormat32bppBGRA))
+                            expect[c] = s[c] * s[3] / 255;
+                        else
+                            expect[c] = s[3] ? s[c] * 255 / s[3] : s[c];
+                    }
+                    break;
+                case 832:
+                    expect[0] = expect[1] = expect[2] = s[0];
+                    expect[3] = 0xff;
+                    break;
+                case 2408:
+                {
+                    float gray = (s[2] * 0.2126f + s[1] * 0.7152f + s[0] * 0.0722f) / 255.0f;
+                    if (gray <= 0.0031308f) gray = 12.92f * gray;
+                    else gray = 1.055f * powf(gray, 1.0f / 2.4f) - 0.055f;
+                    expect[0] = (BYTE)floorf(gray * 255.0f + 0.51f);
+                    break;
+                }
+                }
+
+                for (c = 0; c < tests[i].dst_bpp / 8; c++)
+                    if (!near_equal_byte(d[c], expect[c])) break;
+                if (c < tests[i].dst_bpp / 8) break;
+            }
+            if (x < width) break;
+        }
+        ok(y == height, "%s: unexpected data at %u,%u.\n", tests[i].name, x, y);
+
+        /* converting a single row must give the same result */
+        rc.X = 1;
+        rc.Y = height / 2;
+        rc.Width = width - 1;
+        rc.Height = 1;
+        hr = IWICBitmapSource_CopyPixels(dst_bitmap, &rc, dst_stride, dst_stride, row);
+        ok(hr == S_OK, "%s: CopyPixels failed, hr %#x.\n", tests[i].name, hr);
+        ok(!memcmp(row, dst + rc.Y * dst_stride + tests[i].dst_bpp / 8, (width - 1) * tests[i].dst_bpp / 8),
+                "%s: row data differs.\n", tests[i].name);
+
+        IWICBitmapSource_Release(dst_bitmap);
+        DeleteTestBitmap(src_obj);
+    }
+
+    HeapFree(GetProcessHeap(), 0, row);
+    HeapFree(GetProcessHeap(), 0, dst);
+    HeapFree(GetProcessHeap(), 0, src);
+}
+
 static void test_converter_8bppIndexed(void)
 {
     HRESULT hr;
@@ -1904,6 +2045,7 @@ START_TEST(converter)
     test_invalid_conversion();
     test_default_converter();
     test_converter_8bppIndexed();
+    test_converter_large();
 
     test_encoder(&testdata_8bppIndexed, &CLSID_WICGifEncoder,
                  &testdata_8bppIndexed, &CLSID_WICGifDecoder, "GIF encoder 8bppIndexed");
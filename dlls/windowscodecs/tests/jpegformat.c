@@ -154,12 +154,323 @@ static void test_decode_adobe_cmyk(void)
     IWICImagingFactory_Release(factory);
 }
 
+static void test_source_transform(void)
+{
+    static const BYTE expected_pixel[4] = {0x00, 0xb0, 0xfc, 0x6d};
+    IWICBitmapSourceTransform *transform;
+    IWICBitmapFrameDecode *framedecode;
+    IWICBitmapDecoder *decoder;
+    WICPixelFormatGUID format;
+    BYTE imagedata[5 * 4];
+    UINT width, height, i;
+    IStream *jpegstream;
+    HGLOBAL hjpegdata;
+    BOOL supported;
+    WICRect rect;
+    HRESULT hr;
+
+    hr = CoCreateInstance(&CLSID_WICJpegDecoder, NULL, CLSCTX_INPROC_SERVER,
+        &IID_IWICBitmapDecoder, (void**)&decoder);
+    ok(SUCCEEDED(hr), "CoCreateInstance failed, hr=%x\n", hr);
+    if (FAILED(hr)) return;
+
+    hjpegdata = GlobalAlloc(GMEM_MOVEABLE, sizeof(jpeg_adobe_cmyk_1x5));
+    memcpy(GlobalLock(hjpegdata), jpeg_adobe_cmyk_1x5, sizeof(jpeg_adobe_cmyk_1x5));
+    GlobalUnlock(hjpegdata);
+
+    hr = CreateStreamOnHGlobal(hjpegdata, FALSE, &jpegstream);
+    ok(hr == S_OK, "CreateStreamOnHGlobal failed, hr=%x\n", hr);
+
+    hr = IWICBitmapDecoder_Initialize(decoder, jpegstream, WICDecodeMetadataCacheOnLoad);
+    ok(hr == S_OK, "Initialize failed, hr=%x\n", hr);
+
+    hr = IWICBitmapDecoder_GetFrame(decoder, 0, &framedecode);
+    ok(hr == S_OK, "GetFrame failed, hr=%x\n", hr);
+
+    hr = IWICBitmapFrameDecode_GetPixelFormat(framedecode, &format);
+    ok(hr == S_OK, "GetPixelFormat failed, hr=%x\n", hr);
+    if (!IsEqualGUID(&format, &GUID_WICPixelFormat32bppCMYK))
+    {
+        win_skip("CMYK JPEG decoding is not supported.\n");
+        goto done;
+    }
+
+    /* a single row in the middle */
+    rect.X = 0;
+    rect.Y = 2;
+    rect.Width = 1;
+    rect.Height = 1;
+    memset(imagedata, 0, sizeof(imagedata));
+    hr = IWICBitmapFrameDecode_CopyPixels(framedecode, &rect, 4, 4, imagedata);
+    ok(hr == S_OK, "CopyPixels failed, hr=%x\n", hr);
+    ok(!memcmp(imagedata, expected_pixel, 4), "unexpected image data\n");
+
+    hr = IWICBitmapFrameDecode_QueryInterface(framedecode, &IID_IWICBitmapSourceTransform, (void **)&transform);
+    ok(hr == S_OK, "QueryInterface failed, hr=%x\n", hr);
+    if (FAILED(hr)) goto done;
+
+    hr = IWICBitmapSourceTransform_DoesSupportTransform(transform, WICBitmapTransformRotate0, &supported);
+    ok(hr == S_OK, "DoesSupportTransform failed, hr=%x\n", hr);
+    ok(supported, "expected Rotate0 to be supported\n");
+
+    memset(&format, 0, sizeof(format));
+    hr = IWICBitmapSourceTransform_GetClosestPixelFormat(transform, &format);
+    ok(hr == S_OK, "GetClosestPixelFormat failed, hr=%x\n", hr);
+    ok(IsEqualGUID(&format, &GUID_WICPixelFormat32bppCMYK), "unexpected pixel format %s\n", wine_dbgstr_guid(&format));
+
+    width = height = 1;
+    hr = IWICBitmapSourceTransform_GetClosestSize(transform, &width, &height);
+    ok(hr == S_OK, "GetClosestSize failed, hr=%x\n", hr);
+    ok(width == 1 && height == 1, "unexpected size %ux%u\n", width, height);
+
+    width = height = 100;
+    hr = IWICBitmapSourceTransform_GetClosestSize(transform, &width, &height);
+    ok(hr == S_OK, "GetClosestSize failed, hr=%x\n", hr);
+    ok(width == 1 && height == 5, "unexpected size %ux%u\n", width, height);
+
+    /* downscaled in the decoder */
+    memset(imagedata, 0, sizeof(imagedata));
+    hr = IWICBitmapSourceTransform_CopyPixels(transform, NULL, 1, 1, &format, WICBitmapTransformRotate0,
+            4, 4, imagedata);
+    ok(hr == S_OK, "CopyPixels failed, hr=%x\n", hr);
+    ok(!memcmp(imagedata, expected_pixel, 4), "unexpected image data\n");
+
+    /* and back to the full size */
+    memset(imagedata, 0, sizeof(imagedata));
+    hr = IWICBitmapSourceTransform_CopyPixels(transform, NULL, 1, 5, &format, WICBitmapTransformRotate0,
+            4, sizeof(imagedata), imagedata);
+    ok(hr == S_OK, "CopyPixels failed, hr=%x\n", hr);
+    for (i = 0; i < 5; i++)
+        ok(!memcmp(imagedata + 4 * i, expected_pixel, 4), "unexpected image data in row %u\n", i);
+
+    IWICBitmapSourceTransform_Release(transform);
+
+done:
+    IWICBitmapFrameDecode_Release(framedecode);
+    IWICBitmapDecoder_Release(decoder);
+    IStream_Release(jpegstream);
+    GlobalFree(hjpegdata);
+}
+
+static UINT encode_jpeg(IWICBitmapSource *source, float quality)
+{
+    static const WCHAR wszImageQuality[] = {'I','m','a','g','e','Q','u','a','l','i','t','y',0};
+    IWICBitmapFrameEncode *frameencode;
+    IWICBitmapEncoder *encoder;
+    IPropertyBag2 *options;
+    ULARGE_INTEGER pos;
+    LARGE_INTEGER zero;
+    PROPBAG2 opt = {0};
+    IStream *stream;
+    VARIANT var;
+    HRESULT hr;
+
+    hr = CoCreateInstance(&CLSID_WICJpegEncoder, NULL, CLSCTX_INPROC_SERVER,
+        &IID_IWICBitmapEncoder, (void **)&encoder);
+    ok(hr == S_OK, "CoCreateInstance failed, hr=%x\n", hr);
+    if (FAILED(hr)) return 0;
+
+    hr = CreateStreamOnHGlobal(NULL, TRUE, &stream);
+    ok(hr == S_OK, "CreateStreamOnHGlobal failed, hr=%x\n", hr);
+
+    hr = IWICBitmapEncoder_Initialize(encoder, stream, WICBitmapEncoderNoCache);
+    ok(hr == S_OK, "Initialize failed, hr=%x\n", hr);
+
+    hr = IWICBitmapEncoder_CreateNewFrame(encoder, &frameencode, &options);
+    ok(hr == S_OK, "CreateNewFrame failed, hr=%x\n", hr);
+
+    opt.pstrName = (LPOLESTR)wszImageQuality;
+    V_VT(&var) = VT_R4;
+    V_R4(&var) = quality;
+    hr = IPropertyBag2_Write(options, 1, &opt, &var);
+    ok(hr == S_OK, "Write failed, hr=%x\n", hr);
+
+    hr = IWICBitmapFrameEncode_Initialize(frameencode, options);
+    ok(hr == S_OK, "Initialize failed, hr=%x\n", hr);
+
+    hr = IWICBitmapFrameEncode_WriteSource(frameencode, source, NULL);
+    ok(hr == S_OK, "WriteSource failed, hr=%x\n", hr);
+
+    hr = IWICBitmapFrameEncode_Commit(frameencode);
+    ok(hr == S_OK, "Commit failed, hr=%x\n", hr);
+
+    hr = IWICBitmapEncoder_Commit(encoder);
+    ok(hr == S_OK, "Commit failed, hr=%x\n", hr);
+
+    zero.QuadPart = 0;
+    hr = IStream_Seek(stream, zero, STREAM_SEEK_CUR, &pos);
+    ok(hr == S_OK, "Seek failed, hr=%x\n", hr);
+
+    IPropertyBag2_Release(options);
+    IWICBitmapFrameEncode_Release(frameencode);
+    IWICBitmapEncoder_Release(encoder);
+    IStream_Release(stream);
+
+    return pos.u.LowPart;
+}
+
+static void test_encoder_quality(void)
+{
+    static const UINT width = 640, height = 480;
+    IWICImagingFactory *factory;
+    IWICBitmapLock *lock;
+    IWICBitmap *bitmap;
+    UINT low, high, i;
+    LARGE_INTEGER start, end, freq;
+    BYTE *data;
+    HRESULT hr;
+
+    hr = CoCreateInstance(&CLSID_WICImagingFactory, NULL, CLSCTX_INPROC_SERVER,
+        &IID_IWICImagingFactory, (void **)&factory);
+    ok(hr == S_OK, "CoCreateInstance failed, hr=%x\n", hr);
+    if (FAILED(hr)) return;
+
+    data = HeapAlloc(GetProcessHeap(), 0, width * height * 3);
+    for (i = 0; i < width * height * 3; i++)
+        data[i] = (i % 3) * 40 + (i / 3 % width) / 4 + rand() % 32;
+
+    hr = IWICImagingFactory_CreateBitmapFromMemory(factory, width, height, &GUID_WICPixelFormat24bppBGR,
+        width * 3, width * height * 3, data, &bitmap);
+    ok(hr == S_OK, "CreateBitmapFromMemory failed, hr=%x\n", hr);
+
+    low = encode_jpeg((IWICBitmapSource *)bitmap, 0.1f);
+    high = encode_jpeg((IWICBitmapSource *)bitmap, 1.0f);
+    ok(low && low < high, "expected a smaller image at low quality, got %u and %u bytes\n", low, high);
+
+    /* a bitmap that is locked for writing still has to be encoded */
+    hr = IWICBitmap_Lock(bitmap, NULL, WICBitmapLockWrite, &lock);
+    ok(hr == S_OK, "Lock failed, hr=%x\n", hr);
+    i = encode_jpeg((IWICBitmapSource *)bitmap, 0.1f);
+    ok(i == low, "got %u bytes, expected %u\n", i, low);
+    IWICBitmapLock_Release(lock);
+
+    if (winetest_debug > 1)
+    {
+        QueryPerformanceFrequency(&freq);
+        QueryPerformanceCounter(&start);
+        for (i = 0; i < 10; i++)
+            encode_jpeg((IWICBitmapSource *)bitmap, 0.75f);
+        QueryPerformanceCounter(&end);
+        trace("encoded %ux%u 10 times in %u ms\n", width, height,
+              (UINT)((end.QuadPart - start.QuadPart) * 1000 / freq.QuadPart));
+    }
+
+    IWICBitmap_Release(bitmap);
+    IWICImagingFactory_Release(factory);
+    HeapFree(GetProcessHeap(), 0, data);
+}
+static IWICBitmapFrameDecode *decode_jpeg_stream(IStream *stream, IWICBitmapDecoder **decoder)
+{
+    IWICBitmapFrameDecode *framedecode;
+    LARGE_INTEGER seek;
+    HRESULT hr;
+
+    hr = CoCreateInstance(&CLSID_WICJpegDecoder, NULL, CLSCTX_INPROC_SERVER,
+        &IID_IWICBitmapDecoder, (void **)decoder);
+    ok(hr == S_OK, "CoCreateInstance failed, hr=%x\n", hr);
+
+    seek.QuadPart = 0;
+    IStream_Seek(stream, seek, STREAM_SEEK_SET, NULL);
+    hr = IWICBitmapDecoder_Initialize(*decoder, stream, WICDecodeMetadataCacheOnDemand);
+    ok(hr == S_OK, "Initialize failed, hr=%x\n", hr);
+
+    hr = IWICBitmapDecoder_GetFrame(*decoder, 0, &framedecode);
+    ok(hr == S_OK, "GetFrame failed, hr=%x\n", hr);
+    return framedecode;
+}
+
+static void test_decode_rows(void)
+{
+    static const UINT width = 64, height = 256, stride = 64 * 3;
+    IWICBitmapFrameDecode *framedecode;
+    IWICBitmapFrameEncode *frameencode;
+    ULARGE_INTEGER size, pos;
+    IWICBitmapEncoder *encoder;
+    IWICBitmapDecoder *decoder;
+    WICPixelFormatGUID format;
+    BYTE *bits, row[64 * 3];
+    IPropertyBag2 *options;
+    UINT x, y, seed = 1;
+    LARGE_INTEGER seek;
+    IStream *stream;
+    WICRect rect;
+    HRESULT hr;
+
+    hr = CoCreateInstance(&CLSID_WICJpegEncoder, NULL, CLSCTX_INPROC_SERVER,
+        &IID_IWICBitmapEncoder, (void **)&encoder);
+    ok(hr == S_OK, "CoCreateInstance failed, hr=%x\n", hr);
+    if (FAILED(hr)) return;
+
+    /* noise, so that the rows are all different and the image does not compress well */
+    bits = HeapAlloc(GetProcessHeap(), 0, stride * height);
+    for (y = 0; y < height; y++)
+        for (x = 0; x < stride; x++)
+        {
+            seed = seed * 1103515245 + 12345;
+            bits[y * stride + x] = seed >> 16;
+        }
+
+    hr = CreateStreamOnHGlobal(NULL, TRUE, &stream);
+    ok(hr == S_OK, "CreateStreamOnHGlobal failed, hr=%x\n", hr);
+    hr = IWICBitmapEncoder_Initialize(encoder, stream, WICBitmapEncoderNoCache);
+    ok(hr == S_OK, "Initialize failed, hr=%x\n", hr);
+    hr = IWICBitmapEncoder_CreateNewFrame(encoder, &frameencode, &options);
+    ok(hr == S_OK, "CreateNewFrame failed, hr=%x\n", hr);
+    hr = IWICBitmapFrameEncode_Initialize(frameencode, options);
+    ok(hr == S_OK, "Initialize failed, hr=%x\n", hr);
+    format = GUID_WICPixelFormat24bppBGR;
+    hr = IWICBitmapFrameEncode_SetPixelFormat(frameencode, &format);
+    ok(hr == S_OK, "SetPixelFormat failed, hr=%x\n", hr);
+    hr = IWICBitmapFrameEncode_SetSize(frameencode, width, height);
+    ok(hr == S_OK, "SetSize failed, hr=%x\n", hr);
+    hr = IWICBitmapFrameEncode_WritePixels(frameencode, height, stride, stride * height, bits);
+    ok(hr == S_OK, "WritePixels failed, hr=%x\n", hr);
+    hr = IWICBitmapFrameEncode_Commit(frameencode);
+    ok(hr == S_OK, "Commit failed, hr=%x\n", hr);
+    hr = IWICBitmapEncoder_Commit(encoder);
+    ok(hr == S_OK, "Commit failed, hr=%x\n", hr);
+    IPropertyBag2_Release(options);
+    IWICBitmapFrameEncode_Release(frameencode);
+    IWICBitmapEncoder_Release(encoder);
+
+    seek.QuadPart = 0;
+    IStream_Seek(stream, seek, STREAM_SEEK_END, &size);
+
+    /* reading a row near the top should not decode, nor read, the rest of the image */
+    framedecode = decode_jpeg_stream(stream, &decoder);
+    rect.X = 0;
+    rect.Y = 9;
+    rect.Width = width;
+    rect.Height = 1;
+    hr = IWICBitmapFrameDecode_CopyPixels(framedecode, &rect, stride, stride, row);
+    ok(hr == S_OK, "CopyPixels failed, hr=%x\n", hr);
+    IStream_Seek(stream, seek, STREAM_SEEK_CUR, &pos);
+    ok(pos.QuadPart < size.QuadPart / 2 || broken(pos.QuadPart == size.QuadPart),
+        "read %s of %s bytes\n", wine_dbgstr_longlong(pos.QuadPart), wine_dbgstr_longlong(size.QuadPart));
+    IWICBitmapFrameDecode_Release(framedecode);
+    IWICBitmapDecoder_Release(decoder);
+
+    /* and it must match the same row of the fully decoded image */
+    framedecode = decode_jpeg_stream(stream, &decoder);
+    hr = IWICBitmapFrameDecode_CopyPixels(framedecode, NULL, stride, stride * height, bits);
+    ok(hr == S_OK, "CopyPixels failed, hr=%x\n", hr);
+    ok(!memcmp(row, bits + 9 * stride, stride), "row 9 differs from the full image\n");
+    ok(memcmp(bits + 9 * stride, bits + 10 * stride, stride), "expected different rows\n");
+    IWICBitmapFrameDecode_Release(framedecode);
+    IWICBitmapDecoder_Release(decoder);
+
+    IStream_Release(stream);
+    HeapFree(GetProcessHeap(), 0, bits);
+}
 
 START_TEST(jpegformat)
 {
     CoInitializeEx(NULL, COINIT_APARTMENTTHREADED);
 
     test_decode_adobe_cmyk();
+    test_source_transform();
+    test_decode_rows();
+    test_encoder_quality();
 
     CoUninitialize();
 }
@@ -23,6 +23,7 @@
 #include "wine/vulkan_driver.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(d3d);
+WINE_DECLARE_DEBUG_CHANNEL(d3d_perf);
 
 static const struct wined3d_state_entry_template misc_state_template_vk[] =
 {
@@ -399,6 +400,211 @@ static const struct wined3d_allocator_ops wined3d_allocator_vk_ops =
     .allocator_destroy_chunk = wined3d_allocator_vk_destroy_chunk,
 };
 
+static BOOL wined3d_adapter_vk_get_pipeline_cache_path(const struct wined3d_adapter_vk *adapter_vk,
+        char *path, const char *suffix)
+{
+    const char *dir = wined3d_settings.shader_cache_path;
+    unsigned int i;
+    char *p;
+
+    if (!dir || strlen(dir) + strlen(suffix) + 16 + 2 * VK_UUID_SIZE >= MAX_PATH)
+        return FALSE;
+
+    p = path + sprintf(path, "%s\\vk-%04x-%04x-", dir, adapter_vk->vendor_id, adapter_vk->device_id);
+    for (i = 0; i < VK_UUID_SIZE; ++i)
+        p += sprintf(p, "%02x", adapter_vk->pipeline_cache_uuid[i]);
+    strcpy(p, suffix);
+
+    return TRUE;
+}
+
+static void *wined3d_adapter_vk_load_pipeline_cache_data(const struct wined3d_adapter_vk *adapter_vk,
+        size_t *size)
+{
+    LARGE_INTEGER file_size;
+    char path[MAX_PATH];
+    void *data = NULL;
+    HANDLE file;
+    DWORD read;
+
+    if (!wined3d_adapter_vk_get_pipeline_cache_path(adapter_vk, path, ".bin"))
+        return NULL;
+
+    if ((file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+            NULL, OPEN_EXISTING, 0, NULL)) == INVALID_HANDLE_VALUE)
+        return NULL;
+
+    if (GetFileSizeEx(file, &file_size) && file_size.QuadPart
+            && file_size.QuadPart <= WINED3D_VK_PIPELINE_CACHE_MAX_SIZE
+            && (data = heap_alloc(file_size.QuadPart)))
+    {
+        if (ReadFile(file, data, file_size.QuadPart, &read, NULL) && read == file_size.QuadPart)
+        {
+            TRACE("Loaded %u bytes of pipeline cache data from %s.\n", read, debugstr_a(path));
+            *size = read;
+        }
+        else
+        {
+            heap_free(data);
+            data = NULL;
+        }
+    }
+    CloseHandle(file);
+
+    return data;
+}
+
+static VkPipelineCache wined3d_device_vk_create_pipeline_cache(struct wined3d_device_vk *device_vk,
+        const struct wined3d_adapter_vk *adapter_vk)
+{
+    const struct wined3d_vk_info *vk_info = &device_vk->vk_info;
+    VkPipelineCacheCreateInfo cache_info;
+    VkPipelineCache vk_pipeline_cache;
+    size_t size = 0;
+    void *data;
+    VkResult vr;
+
+    data = wined3d_adapter_vk_load_pipeline_cache_data(adapter_vk, &size);
+
+    cache_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    cache_info.pNext = NULL;
+    cache_info.flags = 0;
+    cache_info.initialDataSize = size;
+    cache_info.pInitialData = data;
+    if ((vr = VK_CALL(vkCreatePipelineCache(device_vk->vk_device, &cache_info, NULL, &vk_pipeline_cache))) < 0
+            && data)
+    {
+        WARN("Failed to create pipeline cache from stored data, vr %s.\n", wined3d_debug_vkresult(vr));
+        cache_info.initialDataSize = 0;
+        cache_info.pInitialData = NULL;
+        vr = VK_CALL(vkCreatePipelineCache(device_vk->vk_device, &cache_info, NULL, &vk_pipeline_cache));
+    }
+    heap_free(data);
+
+    if (vr < 0)
+    {
+        WARN("Failed to create pipeline cache, vr %s.\n", wined3d_debug_vkresult(vr));
+        return VK_NULL_HANDLE;
+    }
+
+    device_vk->pipeline_cache_size = cache_info.initialDataSize;
+    device_vk->pipeline_cache_new_count = 0;
+    device_vk->pipeline_cache_store_time = GetTickCount();
+
+    return vk_pipeline_cache;
+}
+
+static void wined3d_device_vk_store_pipeline_cache(struct wined3d_device_vk *device_vk,
+        const struct wined3d_adapter_vk *adapter_vk)
+{
+    const struct wined3d_vk_info *vk_info = &device_vk->vk_info;
+    char path[MAX_PATH], tmp_path[MAX_PATH], suffix[16];
+    BOOL ret = FALSE;
+    size_t size = 0;
+    HANDLE file;
+    void *data;
+    DWORD written;
+    VkResult vr;
+
+    if (!device_vk->vk_pipeline_cache)
+        return;
+
+    device_vk->pipeline_cache_new_count = 0;
+    device_vk->pipeline_cache_store_time = GetTickCount();
+
+    /* Write to a file of our own and rename it, so that other processes never
+     * see partially written caches. */
+    sprintf(suffix, ".%x.tmp", GetCurrentThreadId());
+    if (!wined3d_adapter_vk_get_pipeline_cache_path(adapter_vk, path, ".bin")
+            || !wined3d_adapter_vk_get_pipeline_cache_path(adapter_vk, tmp_path, suffix))
+        return;
+
+    if ((vr = VK_CALL(vkGetPipelineCacheData(device_vk->vk_device,
+            device_vk->vk_pipeline_cache, &size, NULL))) < 0 || !size)
+        return;
+    /* Pipelines that were found in the cache don't change its size, so there
+     * is nothing new to store. */
+    if (size == device_vk->pipeline_cache_size)
+    {
+        TRACE("Pipeline cache data unchanged.\n");
+        return;
+    }
+    if (size > WINED3D_VK_PIPELINE_CACHE_MAX_SIZE)
+    {
+        WARN("Not storing %lu bytes of pipeline cache data.\n", (unsigned long)size);
+        return;
+    }
+    if (!(data = heap_alloc(size)))
+        return;
+
+    if ((vr = VK_CALL(vkGetPipelineCacheData(device_vk->vk_device,
+            device_vk->vk_pipeline_cache, &size, data))) < 0)
+    {
+        WARN("Failed to get pipeline cache data, vr %s.\n", wined3d_debug_vkresult(vr));
+        heap_free(data);
+        return;
+    }
+
+    if ((file = CreateFileA(tmp_path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, NULL)) != INVALID_HANDLE_VALUE)
+    {
+        ret = WriteFile(file, data, size, &written, NULL) && written == size;
+        CloseHandle(file);
+        if (ret)
+            ret = MoveFileExA(tmp_path, path, MOVEFILE_REPLACE_EXISTING);
+        if (!ret)
+            DeleteFileA(tmp_path);
+    }
+    heap_free(data);
+
+    if (ret)
+    {
+        TRACE("Stored %lu bytes of pipeline cache data in %s.\n", (unsigned long)size, debugstr_a(path));
+        device_vk->pipeline_cache_size = size;
+    }
+    else
+    {
+        WARN("Failed to store pipeline cache data in %s.\n", debugstr_a(path));
+    }
+}
+
+/* Store the pipeline cache while new pipelines are created, at most every
+ * WINED3D_VK_PIPELINE_CACHE_STORE_MS, so that it isn't lost when the
+ * application exits without destroying its device. Called from the CS
+ * thread after creating pipelines and on present. */
+void wined3d_device_vk_update_pipeline_cache(struct wined3d_device_vk *device_vk)
+{
+    if (!device_vk->pipeline_cache_new_count || !wined3d_settings.shader_cache_path
+            || GetTickCount() - device_vk->pipeline_cache_store_time < WINED3D_VK_PIPELINE_CACHE_STORE_MS)
+        return;
+
+    wined3d_device_vk_store_pipeline_cache(device_vk, wined3d_adapter_vk(device_vk->d.adapter));
+}
+
+static void wined3d_device_vk_destroy_pipeline_cache(struct wined3d_device_vk *device_vk,
+        const struct wined3d_adapter_vk *adapter_vk)
+{
+    const struct wined3d_pipeline_statistics_vk *stats = &device_vk->pipeline_statistics;
+    const struct wined3d_vk_info *vk_info = &device_vk->vk_info;
+    LARGE_INTEGER freq;
+
+    if (stats->graphics_pipeline_count && TRACE_ON(d3d_perf))
+    {
+        QueryPerformanceFrequency(&freq);
+        TRACE_(d3d_perf)("Device %p created %u graphics pipelines in %u ms, %u took longer than %u ms, "
+                "the longest took %u ms.\n", device_vk, stats->graphics_pipeline_count,
+                (unsigned int)(stats->total_ticks * 1000 / freq.QuadPart),
+                stats->hitch_count, WINED3D_VK_PIPELINE_HITCH_MS,
+                (unsigned int)(stats->max_ticks * 1000 / freq.QuadPart));
+    }
+
+    if (!device_vk->vk_pipeline_cache)
+        return;
+
+    wined3d_device_vk_store_pipeline_cache(device_vk, adapter_vk);
+    VK_CALL(vkDestroyPipelineCache(device_vk->vk_device, device_vk->vk_pipeline_cache, NULL));
+    device_vk->vk_pipeline_cache = VK_NULL_HANDLE;
+}
+
 static HRESULT adapter_vk_create_device(struct wined3d *wined3d, const struct wined3d_adapter *adapter,
         enum wined3d_device_type device_type, HWND focus_window, unsigned int flags, BYTE surface_alignment,
         const enum wined3d_feature_level *levels, unsigned int level_count,
@@ -509,10 +715,14 @@ static HRESULT adapter_vk_create_device(struct wined3d *wined3d, const struct wi
         goto fail;
     }
 
+    device_vk->vk_pipeline_cache = wined3d_device_vk_create_pipeline_cache(device_vk, adapter_vk);
+
     if (FAILED(hr = wined3d_device_init(&device_vk->d, wined3d, adapter->ordinal, device_type, focus_window,
             flags, surface_alignment, levels, level_count, vk_info->supported, device_parent)))
     {
         WARN("Failed to initialize device, hr %#x.\n", hr);
+        if (device_vk->vk_pipeline_cache)
+            VK_CALL(vkDestroyPipelineCache(vk_device, device_vk->vk_pipeline_cache, NULL));
         wined3d_allocator_cleanup(&device_vk->allocator);
         goto fail;
     }
@@ -533,6 +743,7 @@ static void adapter_vk_destroy_device(struct wined3d_device *device)
     const struct wined3d_vk_info *vk_info = &device_vk->vk_info;
 
     wined3d_device_cleanup(&device_vk->d);
+    wined3d_device_vk_destroy_pipeline_cache(device_vk, wined3d_adapter_vk(device->adapter));
     wined3d_allocator_cleanup(&device_vk->allocator);
     VK_CALL(vkDestroyDevice(device_vk->vk_device, NULL));
     heap_free(device_vk);
@@ -2269,6 +2480,9 @@ static BOOL wined3d_adapter_vk_init(struct wined3d_adapter_vk *adapter_vk,
     else
         VK_CALL(vkGetPhysicalDeviceProperties(adapter_vk->physical_device, &properties2.properties));
     adapter_vk->device_limits = properties2.properties.limits;
+    adapter_vk->vendor_id = properties2.properties.vendorID;
+    adapter_vk->device_id = properties2.properties.deviceID;
+    memcpy(adapter_vk->pipeline_cache_uuid, properties2.properties.pipelineCacheUUID, VK_UUID_SIZE);
 
     VK_CALL(vkGetPhysicalDeviceMemoryProperties(adapter_vk->physical_device, &adapter_vk->memory_properties));
 
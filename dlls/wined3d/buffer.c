@@ -1495,6 +1495,10 @@ static void wined3d_buffer_gl_upload_ranges(struct wined3d_buffer *buffer, struc
     TRACE("buffer %p, context %p, data %p, data_offset %u, range_count %u, ranges %p.\n",
             buffer, context, data, data_offset, range_count, ranges);
 
+    if (wined3d_device_gl_upload_bo(wined3d_device_gl(buffer->resource.device), context_gl,
+            &buffer_gl->bo, data, data_offset, range_count, ranges))
+        return;
+
     wined3d_buffer_gl_bind(buffer_gl, context_gl);
 
     while (range_count--)
@@ -28,6 +28,7 @@
 #include "wined3d_private.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(d3d);
+WINE_DECLARE_DEBUG_CHANNEL(d3d_perf);
 
 VkCompareOp vk_compare_op_from_wined3d(enum wined3d_cmp_func op)
 {
@@ -2721,10 +2722,13 @@ fail:
 static VkPipeline wined3d_context_vk_get_graphics_pipeline(struct wined3d_context_vk *context_vk)
 {
     struct wined3d_device_vk *device_vk = wined3d_device_vk(context_vk->c.device);
+    struct wined3d_pipeline_statistics_vk *stats = &device_vk->pipeline_statistics;
     const struct wined3d_vk_info *vk_info = context_vk->vk_info;
     struct wined3d_graphics_pipeline_vk *pipeline_vk;
     struct wined3d_graphics_pipeline_key_vk *key;
+    LARGE_INTEGER start, end, freq;
     struct wine_rb_entry *entry;
+    LONGLONG ticks;
     VkResult vr;
 
     key = &context_vk->graphics.pipeline_key_vk;
@@ -2735,17 +2739,37 @@ static VkPipeline wined3d_context_vk_get_graphics_pipeline(struct wined3d_contex
         return VK_NULL_HANDLE;
     pipeline_vk->key = *key;
 
+    QueryPerformanceCounter(&start);
     if ((vr = VK_CALL(vkCreateGraphicsPipelines(device_vk->vk_device,
-            VK_NULL_HANDLE, 1, &key->pipeline_desc, NULL, &pipeline_vk->vk_pipeline))) < 0)
+            device_vk->vk_pipeline_cache, 1, &key->pipeline_desc, NULL, &pipeline_vk->vk_pipeline))) < 0)
     {
         WARN("Failed to create graphics pipeline, vr %s.\n", wined3d_debug_vkresult(vr));
         heap_free(pipeline_vk);
         return VK_NULL_HANDLE;
     }
+    QueryPerformanceCounter(&end);
+
+    /* Pipelines are created on first use, so slow pipeline creation shows
+     * up as a hitch in the application's frame time. */
+    ticks = end.QuadPart - start.QuadPart;
+    ++stats->graphics_pipeline_count;
+    stats->total_ticks += ticks;
+    if (ticks > stats->max_ticks)
+        stats->max_ticks = ticks;
+    QueryPerformanceFrequency(&freq);
+    if (ticks * 1000 >= WINED3D_VK_PIPELINE_HITCH_MS * freq.QuadPart)
+    {
+        ++stats->hitch_count;
+        TRACE_(d3d_perf)("Creating graphics pipeline 0x%s took %u ms.\n",
+                wine_dbgstr_longlong(pipeline_vk->vk_pipeline), (unsigned int)(ticks * 1000 / freq.QuadPart));
+    }
 
     if (wine_rb_put(&context_vk->graphics_pipelines, &pipeline_vk->key, &pipeline_vk->entry) == -1)
         ERR("Failed to insert pipeline.\n");
 
+    ++device_vk->pipeline_cache_new_count;
+    wined3d_device_vk_update_pipeline_cache(device_vk);
+
     return pipeline_vk->vk_pipeline;
 }
 
@@ -418,6 +418,7 @@ struct wined3d_cs_update_sub_resource
     unsigned int sub_resource_idx;
     struct wined3d_box box;
     struct wined3d_sub_resource_data data;
+    BYTE copy_data[1];
 };
 
 struct wined3d_cs_add_dirty_texture_region
@@ -2463,6 +2464,32 @@ void wined3d_cs_emit_update_sub_resource(struct wined3d_cs *cs, struct wined3d_r
         unsigned int slice_pitch)
 {
     struct wined3d_cs_update_sub_resource *op;
+    unsigned int size;
+
+    /* Small buffer updates are copied into the packet and queued in order
+     * with the rest of the commands. This avoids waiting for both the
+     * resource to become idle and for the update to be executed. */
+    if (resource->type == WINED3D_RTYPE_BUFFER
+            && (size = box->right - box->left) <= WINED3D_CS_UPDATE_SUB_RESOURCE_COPY_SIZE)
+    {
+        op = wined3d_cs_require_space(cs, FIELD_OFFSET(struct wined3d_cs_update_sub_resource, copy_data[size]),
+                WINED3D_CS_QUEUE_DEFAULT);
+        op->opcode = WINED3D_CS_OP_UPDATE_SUB_RESOURCE;
+        op->resource = resource;
+        op->sub_resource_idx = sub_resource_idx;
+        op->box = *box;
+        op->data.row_pitch = row_pitch;
+        op->data.slice_pitch = slice_pitch;
+        memcpy(op->copy_data, data, size);
+        op->data.data = op->copy_data;
+
+        wined3d_resource_acquire(resource);
+
+        wined3d_cs_submit(cs, WINED3D_CS_QUEUE_DEFAULT);
+        return;
+    }
+
+    wined3d_resource_wait_idle(resource);
 
     op = wined3d_cs_require_space(cs, sizeof(*op), WINED3D_CS_QUEUE_MAP);
     op->opcode = WINED3D_CS_OP_UPDATE_SUB_RESOURCE;
@@ -2476,8 +2503,7 @@ void wined3d_cs_emit_update_sub_resource(struct wined3d_cs *cs, struct wined3d_r
     wined3d_resource_acquire(resource);
 
     wined3d_cs_submit(cs, WINED3D_CS_QUEUE_MAP);
-    /* The data pointer may go away, so we need to wait until it is read.
-     * Copying the data may be faster if it's small. */
+    /* The data pointer may go away, so we need to wait until it is read. */
     wined3d_cs_finish(cs, WINED3D_CS_QUEUE_MAP);
 }
 
@@ -2604,7 +2630,11 @@ static void wined3d_cs_emit_stop(struct wined3d_cs *cs)
     op->opcode = WINED3D_CS_OP_STOP;
 
     wined3d_cs_submit(cs, WINED3D_CS_QUEUE_DEFAULT);
-    wined3d_cs_finish(cs, WINED3D_CS_QUEUE_DEFAULT);
+
+    /* The CS thread doesn't signal progress after it stops, the event can be
+     * destroyed as soon as we return. */
+    while (cs->queue[WINED3D_CS_QUEUE_DEFAULT].head != *(volatile LONG *)&cs->queue[WINED3D_CS_QUEUE_DEFAULT].tail)
+        wined3d_pause();
 }
 
 static void (* const wined3d_cs_op_handlers[])(struct wined3d_cs *cs, const void *data) =
@@ -2724,14 +2754,45 @@ static BOOL wined3d_cs_queue_is_empty(const struct wined3d_cs *cs, const struct
     return *(volatile LONG *)&queue->head == queue->tail;
 }
 
+static size_t wined3d_cs_queue_buffer_offset(const struct wined3d_cs_queue_buffer *buffer, LONG pos)
+{
+    return ((ULONG)pos - (ULONG)buffer->base) & (buffer->size - 1);
+}
+
+static struct wined3d_cs_queue_buffer *wined3d_cs_queue_buffer_create(size_t size, LONG base)
+{
+    struct wined3d_cs_queue_buffer *buffer;
+
+    if (!(buffer = heap_alloc(FIELD_OFFSET(struct wined3d_cs_queue_buffer, data[size]))))
+        return NULL;
+    buffer->next = NULL;
+    buffer->base = base;
+    buffer->end = base;
+    buffer->size = size;
+
+    return buffer;
+}
+
+static void wined3d_cs_queue_cleanup(struct wined3d_cs_queue *queue)
+{
+    struct wined3d_cs_queue_buffer *buffer, *next;
+
+    for (buffer = queue->tail_buffer; buffer; buffer = next)
+    {
+        next = buffer->next;
+        heap_free(buffer);
+    }
+}
+
 static void wined3d_cs_queue_submit(struct wined3d_cs_queue *queue, struct wined3d_cs *cs)
 {
+    struct wined3d_cs_queue_buffer *buffer = queue->head_buffer;
     struct wined3d_cs_packet *packet;
     size_t packet_size;
 
-    packet = (struct wined3d_cs_packet *)&queue->data[queue->head];
+    packet = (struct wined3d_cs_packet *)&buffer->data[wined3d_cs_queue_buffer_offset(buffer, queue->head)];
     packet_size = FIELD_OFFSET(struct wined3d_cs_packet, data[packet->size]);
-    InterlockedExchange(&queue->head, (queue->head + packet_size) & (WINED3D_CS_QUEUE_SIZE - 1));
+    InterlockedExchange(&queue->head, (ULONG)queue->head + packet_size);
 
     if (InterlockedCompareExchange(&cs->waiting_for_event, FALSE, TRUE))
         SetEvent(cs->event);
@@ -2745,25 +2806,88 @@ static void wined3d_cs_mt_submit(struct wined3d_cs *cs, enum wined3d_cs_queue_id
     wined3d_cs_queue_submit(&cs->queue[queue_id], cs);
 }
 
+/* Wait until the CS thread moves the queue tail away from "tail". Most waits
+ * are short, so spin for a while before blocking. */
+static void wined3d_cs_queue_wait(struct wined3d_cs *cs, const struct wined3d_cs_queue *queue, LONG tail)
+{
+    unsigned int spin_count = 0;
+
+    while (*(volatile LONG *)&queue->tail == tail)
+    {
+        if (++spin_count < WINED3D_CS_WAIT_SPIN_COUNT)
+        {
+            wined3d_pause();
+            continue;
+        }
+
+        /* Like in wined3d_cs_wait_event(), the CS thread may have moved the
+         * tail before it could see "waiting_for_progress" set. */
+        InterlockedExchange(&cs->waiting_for_progress, TRUE);
+        if (*(volatile LONG *)&queue->tail != tail)
+        {
+            InterlockedExchange(&cs->waiting_for_progress, FALSE);
+            break;
+        }
+        WaitForSingleObject(cs->progress_event, INFINITE);
+    }
+}
+
+static void wined3d_cs_queue_drain(struct wined3d_cs *cs, const struct wined3d_cs_queue *queue)
+{
+    LONG tail;
+
+    while ((tail = *(volatile LONG *)&queue->tail) != queue->head)
+        wined3d_cs_queue_wait(cs, queue, tail);
+}
+
+/* Continue the queue in a larger buffer, starting at the current head. The
+ * CS thread keeps reading the packets left in the older buffers, and moves
+ * to the new one when it reaches their end. */
+static BOOL wined3d_cs_queue_grow(struct wined3d_cs_queue *queue, size_t packet_size)
+{
+    struct wined3d_cs_queue_buffer *buffer = queue->head_buffer, *new_buffer;
+    size_t size = buffer->size * 2;
+
+    while (size < packet_size)
+        size *= 2;
+    if (size > WINED3D_CS_QUEUE_MAX_SIZE)
+        return FALSE;
+
+    if (!(new_buffer = wined3d_cs_queue_buffer_create(size, queue->head)))
+        return FALSE;
+
+    TRACE("Growing queue %p from %#lx to %#lx bytes.\n", queue, (unsigned long)buffer->size, (unsigned long)size);
+    buffer->end = queue->head;
+    /* The CS thread may see the new buffer as soon as "next" is set, the end
+     * position has to be visible first. */
+    InterlockedExchangePointer((void **)&buffer->next, new_buffer);
+    queue->head_buffer = new_buffer;
+
+    return TRUE;
+}
+
 static void *wined3d_cs_queue_require_space(struct wined3d_cs_queue *queue, size_t size, struct wined3d_cs *cs)
 {
-    size_t queue_size = ARRAY_SIZE(queue->data);
     size_t header_size, packet_size, remaining;
+    struct wined3d_cs_queue_buffer *buffer;
     struct wined3d_cs_packet *packet;
 
     header_size = FIELD_OFFSET(struct wined3d_cs_packet, data[0]);
     packet_size = FIELD_OFFSET(struct wined3d_cs_packet, data[size]);
     packet_size = (packet_size + header_size - 1) & ~(header_size - 1);
     size = packet_size - header_size;
-    if (packet_size >= WINED3D_CS_QUEUE_SIZE)
+    if (packet_size > queue->head_buffer->size && !wined3d_cs_queue_grow(queue, packet_size))
     {
-        ERR("Packet size %lu >= queue size %u.\n",
-                (unsigned long)packet_size, WINED3D_CS_QUEUE_SIZE);
+        ERR("Packet size %lu > queue size %lu.\n",
+                (unsigned long)packet_size, (unsigned long)queue->head_buffer->size);
         return NULL;
     }
 
-    remaining = queue_size - queue->head;
-    if (remaining < packet_size)
+    /* Packets don't wrap around the end of the buffer. The queue may grow
+     * while waiting for space for the nop, the head is at the start of the
+     * new buffer in that case. */
+    while ((remaining = queue->head_buffer->size
+            - wined3d_cs_queue_buffer_offset(queue->head_buffer, queue->head)) < packet_size)
     {
         size_t nop_size = remaining - header_size;
         struct wined3d_cs_nop *nop;
@@ -2776,33 +2900,33 @@ static void *wined3d_cs_queue_require_space(struct wined3d_cs_queue *queue, size
             nop->opcode = WINED3D_CS_OP_NOP;
 
         wined3d_cs_queue_submit(queue, cs);
-        assert(!queue->head);
     }
 
     for (;;)
     {
         LONG tail = *(volatile LONG *)&queue->tail;
-        LONG head = queue->head;
-        LONG new_pos;
+        ULONG start;
 
-        /* Empty. */
-        if (head == tail)
+        /* Unread data in the head buffer starts at the tail, or at the start
+         * of the buffer while the CS thread is still reading older buffers. */
+        buffer = queue->head_buffer;
+        start = (LONG)((ULONG)tail - (ULONG)buffer->base) < 0 ? buffer->base : tail;
+        if ((ULONG)queue->head - start + packet_size <= buffer->size)
             break;
-        new_pos = (head + packet_size) & (WINED3D_CS_QUEUE_SIZE - 1);
-        /* Head ahead of tail. We checked the remaining size above, so we only
-         * need to make sure we don't make head equal to tail. */
-        if (head > tail && (new_pos != tail))
-            break;
-        /* Tail ahead of head. Make sure the new head is before the tail as
-         * well. Note that new_pos is 0 when it's at the end of the queue. */
-        if (new_pos < tail && new_pos)
+
+        /* The queue is full. Let it grow, so that the next burst of commands
+         * doesn't have to wait for the CS thread. The new buffer is empty,
+         * and the packet fits at its start. */
+        if (wined3d_cs_queue_grow(queue, packet_size))
             break;
 
         TRACE("Waiting for free space. Head %u, tail %u, packet size %lu.\n",
-                head, tail, (unsigned long)packet_size);
+                queue->head, tail, (unsigned long)packet_size);
+        wined3d_cs_queue_wait(cs, queue, tail);
     }
 
-    packet = (struct wined3d_cs_packet *)&queue->data[queue->head];
+    buffer = queue->head_buffer;
+    packet = (struct wined3d_cs_packet *)&buffer->data[wined3d_cs_queue_buffer_offset(buffer, queue->head)];
     packet->size = size;
     return packet->data;
 }
@@ -2820,8 +2944,7 @@ static void wined3d_cs_mt_finish(struct wined3d_cs *cs, enum wined3d_cs_queue_id
     if (cs->thread_id == GetCurrentThreadId())
         return wined3d_cs_st_finish(cs, queue_id);
 
-    while (cs->queue[queue_id].head != *(volatile LONG *)&cs->queue[queue_id].tail)
-        wined3d_pause();
+    wined3d_cs_queue_drain(cs, &cs->queue[queue_id]);
 }
 
 static const struct wined3d_cs_ops wined3d_cs_mt_ops =
@@ -2868,6 +2991,7 @@ static void wined3d_cs_wait_event(struct wined3d_cs *cs)
 
 static DWORD WINAPI wined3d_cs_run(void *ctx)
 {
+    struct wined3d_cs_queue_buffer *buffer;
     struct wined3d_cs_packet *packet;
     struct wined3d_cs_queue *queue;
     unsigned int spin_count = 0;
@@ -2906,8 +3030,15 @@ static DWORD WINAPI wined3d_cs_run(void *ctx)
         }
         spin_count = 0;
 
+        /* The application only writes past the end of a buffer after linking
+         * the next one, so "next" is set when the tail reached the end. */
         tail = queue->tail;
-        packet = (struct wined3d_cs_packet *)&queue->data[tail];
+        while ((buffer = queue->tail_buffer)->next && tail == buffer->end)
+        {
+            queue->tail_buffer = buffer->next;
+            heap_free(buffer);
+        }
+        packet = (struct wined3d_cs_packet *)&buffer->data[wined3d_cs_queue_buffer_offset(buffer, tail)];
         if (packet->size)
         {
             opcode = *(const enum wined3d_cs_op *)packet->data;
@@ -2924,9 +3055,12 @@ static DWORD WINAPI wined3d_cs_run(void *ctx)
             TRACE("%s executed.\n", debug_cs_op(opcode));
         }
 
-        tail += FIELD_OFFSET(struct wined3d_cs_packet, data[packet->size]);
-        tail &= (WINED3D_CS_QUEUE_SIZE - 1);
+        tail = (ULONG)tail + FIELD_OFFSET(struct wined3d_cs_packet, data[packet->size]);
         InterlockedExchange(&queue->tail, tail);
+
+        if (*(volatile LONG *)&cs->waiting_for_progress
+                && InterlockedCompareExchange(&cs->waiting_for_progress, FALSE, TRUE))
+            SetEvent(cs->progress_event);
     }
 
     cs->queue[WINED3D_CS_QUEUE_MAP].tail = cs->queue[WINED3D_CS_QUEUE_MAP].head;
@@ -2939,6 +3073,7 @@ struct wined3d_cs *wined3d_cs_create(struct wined3d_device *device)
 {
     const struct wined3d_d3d_info *d3d_info = &device->adapter->d3d_info;
     struct wined3d_cs *cs;
+    unsigned int i;
 
     if (!(cs = heap_alloc_zero(sizeof(*cs))))
         return NULL;
@@ -2957,10 +3092,21 @@ struct wined3d_cs *wined3d_cs_create(struct wined3d_device *device)
     {
         cs->ops = &wined3d_cs_mt_ops;
 
-        if (!(cs->event = CreateEventW(NULL, FALSE, FALSE, NULL)))
+        for (i = 0; i < ARRAY_SIZE(cs->queue); ++i)
+        {
+            cs->queue[i].tail_buffer = cs->queue[i].head_buffer
+                    = wined3d_cs_queue_buffer_create(WINED3D_CS_QUEUE_SIZE, 0);
+            if (!cs->queue[i].head_buffer)
+            {
+                ERR("Failed to allocate command stream queue memory.\n");
+                goto fail;
+            }
+        }
+
+        if (!(cs->event = CreateEventW(NULL, FALSE, FALSE, NULL))
+                || !(cs->progress_event = CreateEventW(NULL, FALSE, FALSE, NULL)))
         {
             ERR("Failed to create command stream event.\n");
-            heap_free(cs->data);
             goto fail;
         }
 
@@ -2968,8 +3114,6 @@ struct wined3d_cs *wined3d_cs_create(struct wined3d_device *device)
                 (const WCHAR *)wined3d_cs_run, &cs->wined3d_module)))
         {
             ERR("Failed to get wined3d module handle.\n");
-            CloseHandle(cs->event);
-            heap_free(cs->data);
             goto fail;
         }
 
@@ -2977,8 +3121,6 @@ struct wined3d_cs *wined3d_cs_create(struct wined3d_device *device)
         {
             ERR("Failed to create wined3d command stream thread.\n");
             FreeLibrary(cs->wined3d_module);
-            CloseHandle(cs->event);
-            heap_free(cs->data);
             goto fail;
         }
     }
@@ -2986,6 +3128,13 @@ struct wined3d_cs *wined3d_cs_create(struct wined3d_device *device)
     return cs;
 
 fail:
+    if (cs->progress_event)
+        CloseHandle(cs->progress_event);
+    if (cs->event)
+        CloseHandle(cs->event);
+    for (i = 0; i < ARRAY_SIZE(cs->queue); ++i)
+        wined3d_cs_queue_cleanup(&cs->queue[i]);
+    heap_free(cs->data);
     state_cleanup(&cs->state);
     heap_free(cs);
     return NULL;
@@ -2993,14 +3142,20 @@ fail:
 
 void wined3d_cs_destroy(struct wined3d_cs *cs)
 {
+    unsigned int i;
+
     if (cs->thread)
     {
         wined3d_cs_emit_stop(cs);
         CloseHandle(cs->thread);
         if (!CloseHandle(cs->event))
             ERR("Closing event failed.\n");
+        if (!CloseHandle(cs->progress_event))
+            ERR("Closing progress event failed.\n");
     }
 
+    for (i = 0; i < ARRAY_SIZE(cs->queue); ++i)
+        wined3d_cs_queue_cleanup(&cs->queue[i]);
     state_cleanup(&cs->state);
     heap_free(cs->data);
     heap_free(cs);
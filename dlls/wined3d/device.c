@@ -34,6 +34,7 @@
 #include "wined3d_private.h"
 
 WINE_DEFAULT_DEBUG_CHANNEL(d3d);
+WINE_DECLARE_DEBUG_CHANNEL(d3d_perf);
 WINE_DECLARE_DEBUG_CHANNEL(winediag);
 
 struct wined3d_matrix_3x3
@@ -524,6 +525,205 @@ static void wined3d_device_gl_destroy_dummy_textures(struct wined3d_device_gl *d
     memset(dummy_textures, 0, sizeof(*dummy_textures));
 }
 
+/* Context activation is done by the caller. */
+static BOOL wined3d_device_gl_create_upload_heap(struct wined3d_device_gl *device_gl,
+        struct wined3d_context_gl *context_gl)
+{
+    const GLbitfield map_flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+    struct wined3d_upload_heap_gl *heap = &device_gl->upload_heap;
+    const struct wined3d_gl_info *gl_info = context_gl->gl_info;
+
+    if (heap->disabled)
+        return FALSE;
+
+    if (!gl_info->supported[ARB_BUFFER_STORAGE] || !gl_info->supported[ARB_COPY_BUFFER]
+            || !gl_info->supported[ARB_MAP_BUFFER_RANGE] || !gl_info->supported[ARB_SYNC])
+    {
+        TRACE("Not using an upload heap.\n");
+        heap->disabled = TRUE;
+        return FALSE;
+    }
+
+    GL_EXTCALL(glGenBuffers(1, &heap->id));
+    GL_EXTCALL(glBindBuffer(GL_COPY_READ_BUFFER, heap->id));
+    GL_EXTCALL(glBufferStorage(GL_COPY_READ_BUFFER, WINED3D_UPLOAD_HEAP_SIZE, NULL, map_flags));
+    heap->map_ptr = GL_EXTCALL(glMapBufferRange(GL_COPY_READ_BUFFER, 0, WINED3D_UPLOAD_HEAP_SIZE, map_flags));
+    GL_EXTCALL(glBindBuffer(GL_COPY_READ_BUFFER, 0));
+    checkGLcall("upload heap creation");
+
+    if (!heap->map_ptr)
+    {
+        ERR("Failed to map upload heap.\n");
+        GL_EXTCALL(glDeleteBuffers(1, &heap->id));
+        heap->id = 0;
+        heap->disabled = TRUE;
+        return FALSE;
+    }
+
+    heap->head = 0;
+    heap->segment = 0;
+    TRACE("Created upload heap %u, size %#x.\n", heap->id, WINED3D_UPLOAD_HEAP_SIZE);
+
+    return TRUE;
+}
+
+/* Context activation is done by the caller. */
+static void wined3d_device_gl_destroy_upload_heap(struct wined3d_device_gl *device_gl,
+        struct wined3d_context_gl *context_gl)
+{
+    struct wined3d_upload_heap_gl *heap = &device_gl->upload_heap;
+    const struct wined3d_gl_info *gl_info = context_gl->gl_info;
+    unsigned int i;
+
+    if (!heap->id)
+        return;
+
+    for (i = 0; i < ARRAY_SIZE(heap->fences); ++i)
+    {
+        if (heap->fences[i])
+            GL_EXTCALL(glDeleteSync(heap->fences[i]));
+    }
+    /* Deleting the buffer object implicitly unmaps it. */
+    GL_EXTCALL(glDeleteBuffers(1, &heap->id));
+    checkGLcall("upload heap destruction");
+
+    memset(heap, 0, sizeof(*heap));
+}
+
+/* Context activation is done by the caller. */
+static void wined3d_upload_heap_gl_wait_segment(struct wined3d_upload_heap_gl *heap,
+        const struct wined3d_gl_info *gl_info, unsigned int segment)
+{
+    GLenum gl_ret;
+
+    if (!heap->fences[segment])
+        return;
+
+    gl_ret = GL_EXTCALL(glClientWaitSync(heap->fences[segment], GL_SYNC_FLUSH_COMMANDS_BIT, 0));
+    if (gl_ret == GL_TIMEOUT_EXPIRED)
+    {
+        TRACE("Waiting for upload heap segment %u.\n", segment);
+        ++heap->stall_count;
+        gl_ret = GL_EXTCALL(glClientWaitSync(heap->fences[segment], 0, ~(GLuint64)0));
+    }
+    if (gl_ret != GL_ALREADY_SIGNALED && gl_ret != GL_CONDITION_SATISFIED)
+        ERR("glClientWaitSync returned %#x.\n", gl_ret);
+
+    GL_EXTCALL(glDeleteSync(heap->fences[segment]));
+    heap->fences[segment] = NULL;
+    checkGLcall("upload heap wait");
+}
+
+/* The upload heap is a persistently mapped buffer object used as a ring
+ * buffer. It is divided into segments; when the write position leaves a
+ * segment, a fence is inserted after the copies sourcing from that segment,
+ * and the segment is only written again once that fence has signalled. The
+ * heap is shared by all the contexts of the device, so the fence is flushed
+ * right away by the context that inserted it.
+ *
+ * Context activation is done by the caller. */
+static BYTE *wined3d_upload_heap_gl_alloc(struct wined3d_upload_heap_gl *heap,
+        const struct wined3d_gl_info *gl_info, size_t size, size_t *offset)
+{
+    const size_t segment_size = WINED3D_UPLOAD_HEAP_SIZE / WINED3D_UPLOAD_HEAP_SEGMENT_COUNT;
+    size_t start;
+
+    if (size > segment_size)
+        return NULL;
+
+    start = (heap->head + WINED3D_UPLOAD_HEAP_ALIGNMENT - 1) & ~(size_t)(WINED3D_UPLOAD_HEAP_ALIGNMENT - 1);
+    if (start + size > (heap->segment + 1) * segment_size)
+    {
+        heap->fences[heap->segment] = GL_EXTCALL(glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+        /* The segment may be waited on from another context, where
+         * GL_SYNC_FLUSH_COMMANDS_BIT doesn't flush this one. An unflushed
+         * fence may never signal. */
+        gl_info->gl_ops.gl.p_glFlush();
+        checkGLcall("glFenceSync");
+        heap->segment = (heap->segment + 1) % WINED3D_UPLOAD_HEAP_SEGMENT_COUNT;
+        wined3d_upload_heap_gl_wait_segment(heap, gl_info, heap->segment);
+        start = heap->segment * segment_size;
+    }
+
+    heap->head = start + size;
+    *offset = start;
+
+    return heap->map_ptr + start;
+}
+
+/* Upload "ranges" of "data" to "bo" by copying them into the upload heap and
+ * issuing buffer to buffer copies. Unlike glBufferSubData(), this never
+ * requires the driver to stall or to make its own copy when "bo" is still in
+ * use by the GPU. Returns FALSE if the data should be uploaded directly.
+ *
+ * Context activation is done by the caller. */
+BOOL wined3d_device_gl_upload_bo(struct wined3d_device_gl *device_gl, struct wined3d_context_gl *context_gl,
+        const struct wined3d_bo_gl *bo, const void *data, unsigned int data_offset,
+        unsigned int range_count, const struct wined3d_range *ranges)
+{
+    struct wined3d_upload_heap_gl *heap = &device_gl->upload_heap;
+    const struct wined3d_gl_info *gl_info = context_gl->gl_info;
+    const struct wined3d_range *range;
+    size_t size, offset, src_offset;
+    unsigned int i;
+    BYTE *ptr;
+
+    if (!range_count)
+        return TRUE;
+
+    if (!heap->id && !wined3d_device_gl_create_upload_heap(device_gl, context_gl))
+        return FALSE;
+
+    for (i = 0, size = 0; i < range_count; ++i)
+        size += (ranges[i].size + WINED3D_UPLOAD_HEAP_ALIGNMENT - 1) & ~(WINED3D_UPLOAD_HEAP_ALIGNMENT - 1);
+
+    if (!(ptr = wined3d_upload_heap_gl_alloc(heap, gl_info, size, &offset)))
+    {
+        TRACE("Upload of %lu bytes does not fit in the upload heap.\n", (unsigned long)size);
+        ++heap->direct_count;
+        return FALSE;
+    }
+
+    GL_EXTCALL(glBindBuffer(GL_COPY_READ_BUFFER, heap->id));
+    GL_EXTCALL(glBindBuffer(GL_COPY_WRITE_BUFFER, bo->id));
+    for (i = 0, src_offset = offset; i < range_count; ++i)
+    {
+        range = &ranges[i];
+        memcpy(ptr, (const BYTE *)data + range->offset - data_offset, range->size);
+        GL_EXTCALL(glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                src_offset, range->offset, range->size));
+        size = (range->size + WINED3D_UPLOAD_HEAP_ALIGNMENT - 1) & ~(WINED3D_UPLOAD_HEAP_ALIGNMENT - 1);
+        ptr += size;
+        src_offset += size;
+        heap->upload_bytes += range->size;
+    }
+    GL_EXTCALL(glBindBuffer(GL_COPY_WRITE_BUFFER, 0));
+    GL_EXTCALL(glBindBuffer(GL_COPY_READ_BUFFER, 0));
+    checkGLcall("upload heap copy");
+
+    ++heap->upload_count;
+
+    return TRUE;
+}
+
+void wined3d_device_gl_upload_heap_end_frame(struct wined3d_device_gl *device_gl)
+{
+    struct wined3d_upload_heap_gl *heap = &device_gl->upload_heap;
+
+    if (!heap->id)
+        return;
+
+    if (heap->upload_count || heap->direct_count)
+        TRACE_(d3d_perf)("Device %p: %u uploads, 0x%s bytes through the upload heap, %u direct uploads, %u stalls.\n",
+                device_gl, heap->upload_count, wine_dbgstr_longlong(heap->upload_bytes),
+                heap->direct_count, heap->stall_count);
+
+    heap->upload_bytes = 0;
+    heap->upload_count = 0;
+    heap->direct_count = 0;
+    heap->stall_count = 0;
+}
+
 /* Context activation is done by the caller. */
 void wined3d_device_create_default_samplers(struct wined3d_device *device, struct wined3d_context *context)
 {
@@ -1013,6 +1213,7 @@ void wined3d_device_delete_opengl_contexts_cs(void *object)
     device->blitter->ops->blitter_destroy(device->blitter, context);
     device->shader_backend->shader_free_private(device, context);
     wined3d_device_gl_destroy_dummy_textures(device_gl, context_gl);
+    wined3d_device_gl_destroy_upload_heap(device_gl, context_gl);
     wined3d_device_destroy_default_samplers(device, context);
     context_release(context);
 
@@ -4790,8 +4991,6 @@ void CDECL wined3d_device_update_sub_resource(struct wined3d_device *device, str
         return;
     }
 
-    wined3d_resource_wait_idle(resource);
-
     wined3d_cs_emit_update_sub_resource(device->cs, resource, sub_resource_idx, box, data, row_pitch, depth_pitch);
 }
 
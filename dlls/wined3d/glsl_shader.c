@@ -639,6 +639,238 @@ void shader_glsl_validate_link(const struct wined3d_gl_info *gl_info, GLuint pro
     print_glsl_info_log(gl_info, program, TRUE);
 }
 
+/* Linked programs can be saved to the directory set by the "ShaderCachePath"
+ * option with ARB_get_program_binary. Each program is stored in its own file,
+ * named after a hash of its key. The key is made of the driver strings, the
+ * sources of the attached shaders and the state used to link them. It is
+ * stored in full in the file, and compared when the program is loaded. */
+#define GLSL_PROGRAM_CACHE_MAGIC    0x42505747 /* "GWPB" */
+#define GLSL_PROGRAM_CACHE_VERSION  2
+#define GLSL_PROGRAM_CACHE_MAX_SIZE (64 * 1024 * 1024)
+
+struct glsl_program_cache_header
+{
+    DWORD magic;
+    DWORD version;
+    DWORD key_size;
+    GLenum format;
+    DWORD size;
+};
+
+struct glsl_program_cache_key
+{
+    BYTE *data;
+    SIZE_T size;
+    SIZE_T capacity;
+    UINT64 hash;
+};
+
+static BOOL glsl_program_cache_key_append(struct glsl_program_cache_key *key, const void *data, SIZE_T size)
+{
+    if (!wined3d_array_reserve((void **)&key->data, &key->capacity, key->size + size, 1))
+        return FALSE;
+    memcpy(key->data + key->size, data, size);
+    key->size += size;
+    return TRUE;
+}
+
+/* Context activation is done by the caller. */
+static BOOL shader_glsl_get_program_cache_key(const struct wined3d_gl_info *gl_info, GLuint program,
+        const void *link_args, unsigned int link_args_size, struct glsl_program_cache_key *key)
+{
+    static const GLenum driver_strings[] = {GL_VENDOR, GL_RENDERER, GL_VERSION};
+    GLint shader_count, length, type;
+    GLuint shaders[8];
+    const char *str;
+    unsigned int i;
+    SIZE_T offset;
+
+    memset(key, 0, sizeof(*key));
+
+    GL_EXTCALL(glGetProgramiv(program, GL_ATTACHED_SHADERS, &shader_count));
+    if (shader_count > ARRAY_SIZE(shaders))
+        return FALSE;
+    GL_EXTCALL(glGetAttachedShaders(program, ARRAY_SIZE(shaders), &shader_count, shaders));
+
+    for (i = 0; i < ARRAY_SIZE(driver_strings); ++i)
+    {
+        if (!(str = (const char *)gl_info->gl_ops.gl.p_glGetString(driver_strings[i])))
+            str = "";
+        if (!glsl_program_cache_key_append(key, str, strlen(str) + 1))
+            goto fail;
+    }
+
+    if (!glsl_program_cache_key_append(key, &link_args_size, sizeof(link_args_size))
+            || (link_args_size && !glsl_program_cache_key_append(key, link_args, link_args_size)))
+        goto fail;
+
+    for (i = 0; i < shader_count; ++i)
+    {
+        GL_EXTCALL(glGetShaderiv(shaders[i], GL_SHADER_TYPE, &type));
+        GL_EXTCALL(glGetShaderiv(shaders[i], GL_SHADER_SOURCE_LENGTH, &length));
+        length = max(length, 1);
+        if (!glsl_program_cache_key_append(key, &type, sizeof(type))
+                || !wined3d_array_reserve((void **)&key->data, &key->capacity,
+                key->size + sizeof(length) + length, 1))
+            goto fail;
+        offset = key->size;
+        key->size += sizeof(length);
+        GL_EXTCALL(glGetShaderSource(shaders[i], length, &length, (char *)key->data + key->size));
+        memcpy(key->data + offset, &length, sizeof(length));
+        key->size += length;
+    }
+    checkGLcall("get program sources");
+
+    key->hash = 0xcbf29ce484222325ull;
+    for (offset = 0; offset < key->size; ++offset)
+        key->hash = (key->hash ^ key->data[offset]) * 0x100000001b3ull;
+
+    return TRUE;
+
+fail:
+    heap_free(key->data);
+    return FALSE;
+}
+
+static BOOL shader_glsl_get_program_cache_path(char *path, const struct glsl_program_cache_key *key,
+        const char *suffix)
+{
+    const char *dir = wined3d_settings.shader_cache_path;
+
+    if (strlen(dir) + strlen(suffix) + 18 >= MAX_PATH)
+        return FALSE;
+    sprintf(path, "%s\\%08x%08x%s", dir, (unsigned int)(key->hash >> 32), (unsigned int)key->hash, suffix);
+    return TRUE;
+}
+
+/* Context activation is done by the caller. */
+static BOOL shader_glsl_load_program_binary(const struct wined3d_gl_info *gl_info, GLuint program,
+        const struct glsl_program_cache_key *key)
+{
+    struct glsl_program_cache_header header;
+    char path[MAX_PATH];
+    GLint status = 0;
+    BYTE *data;
+    HANDLE file;
+    DWORD size;
+
+    if (!shader_glsl_get_program_cache_path(path, key, ".bin"))
+        return FALSE;
+
+    if ((file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+            NULL, OPEN_EXISTING, 0, NULL)) == INVALID_HANDLE_VALUE)
+        return FALSE;
+
+    if (!ReadFile(file, &header, sizeof(header), &size, NULL) || size != sizeof(header)
+            || header.magic != GLSL_PROGRAM_CACHE_MAGIC || header.version != GLSL_PROGRAM_CACHE_VERSION
+            || header.key_size != key->size || !header.size || header.size > GLSL_PROGRAM_CACHE_MAX_SIZE
+            || !(data = heap_alloc(key->size + header.size)))
+    {
+        CloseHandle(file);
+        return FALSE;
+    }
+
+    if (!ReadFile(file, data, key->size + header.size, &size, NULL) || size != key->size + header.size)
+        WARN("Failed to read %s.\n", debugstr_a(path));
+    else if (memcmp(data, key->data, key->size))
+        TRACE("Program key in %s doesn't match.\n", debugstr_a(path));
+    else
+    {
+        GL_EXTCALL(glProgramBinary(program, header.format, data + key->size, header.size));
+        GL_EXTCALL(glGetProgramiv(program, GL_LINK_STATUS, &status));
+        checkGLcall("glProgramBinary");
+    }
+
+    heap_free(data);
+    CloseHandle(file);
+
+    if (!status)
+        TRACE("Failed to load program %u from %s.\n", program, debugstr_a(path));
+    return status;
+}
+
+/* Context activation is done by the caller. */
+static void shader_glsl_store_program_binary(const struct wined3d_gl_info *gl_info, GLuint program,
+        const struct glsl_program_cache_key *key)
+{
+    struct glsl_program_cache_header header;
+    char path[MAX_PATH], tmp_path[MAX_PATH], suffix[16];
+    GLint status, length;
+    BOOL ret = FALSE;
+    void *binary;
+    HANDLE file;
+    DWORD size;
+
+    GL_EXTCALL(glGetProgramiv(program, GL_LINK_STATUS, &status));
+    GL_EXTCALL(glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length));
+    if (!status || length <= 0 || length > GLSL_PROGRAM_CACHE_MAX_SIZE)
+        return;
+
+    /* Write to a file of our own and rename it, so that other processes never
+     * see partially written programs. */
+    sprintf(suffix, ".%x.tmp", GetCurrentThreadId());
+    if (!shader_glsl_get_program_cache_path(path, key, ".bin")
+            || !shader_glsl_get_program_cache_path(tmp_path, key, suffix))
+        return;
+
+    if (!(binary = heap_alloc(length)))
+        return;
+    GL_EXTCALL(glGetProgramBinary(program, length, &length, &header.format, binary));
+    checkGLcall("glGetProgramBinary");
+
+    header.magic = GLSL_PROGRAM_CACHE_MAGIC;
+    header.version = GLSL_PROGRAM_CACHE_VERSION;
+    header.key_size = key->size;
+    header.size = length;
+
+    if ((file = CreateFileA(tmp_path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, 0, NULL)) != INVALID_HANDLE_VALUE)
+    {
+        ret = WriteFile(file, &header, sizeof(header), &size, NULL) && size == sizeof(header)
+                && WriteFile(file, key->data, key->size, &size, NULL) && size == key->size
+                && WriteFile(file, binary, header.size, &size, NULL) && size == header.size;
+        CloseHandle(file);
+
+        if (!ret || !MoveFileExA(tmp_path, path, MOVEFILE_REPLACE_EXISTING))
+        {
+            WARN("Failed to write %s.\n", debugstr_a(path));
+            DeleteFileA(tmp_path);
+        }
+    }
+
+    heap_free(binary);
+}
+
+/* Context activation is done by the caller. */
+static void shader_glsl_link_program(const struct wined3d_gl_info *gl_info, GLuint program,
+        BOOL cacheable, const void *link_args, unsigned int link_args_size)
+{
+    struct glsl_program_cache_key key;
+
+    cacheable = cacheable && wined3d_settings.shader_cache_path && gl_info->supported[ARB_GET_PROGRAM_BINARY]
+            && shader_glsl_get_program_cache_key(gl_info, program, link_args, link_args_size, &key);
+
+    if (cacheable)
+    {
+        if (shader_glsl_load_program_binary(gl_info, program, &key))
+        {
+            TRACE("Loaded GLSL shader program %u from the cache.\n", program);
+            heap_free(key.data);
+            return;
+        }
+        GL_EXTCALL(glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
+    }
+
+    TRACE("Linking GLSL shader program %u.\n", program);
+    GL_EXTCALL(glLinkProgram(program));
+    shader_glsl_validate_link(gl_info, program);
+
+    if (cacheable)
+    {
+        shader_glsl_store_program_binary(gl_info, program, &key);
+        heap_free(key.data);
+    }
+}
+
 static BOOL shader_glsl_use_layout_qualifier(const struct wined3d_gl_info *gl_info)
 {
     /* Layout qualifiers were introduced in GLSL 1.40. The Nvidia Legacy GPU
@@ -10111,9 +10343,7 @@ static HRESULT shader_glsl_compile_compute_shader(struct shader_glsl_priv *priv,
 
     list_add_head(&shader->linked_programs, &entry->cs.shader_entry);
 
-    TRACE("Linking GLSL shader program %u.\n", program_id);
-    GL_EXTCALL(glLinkProgram(program_id));
-    shader_glsl_validate_link(gl_info, program_id);
+    shader_glsl_link_program(gl_info, program_id, TRUE, NULL, 0);
 
     GL_EXTCALL(glUseProgram(program_id));
     checkGLcall("glUseProgram");
@@ -10196,6 +10426,12 @@ static void set_glsl_shader_program(const struct wined3d_context_gl *context_gl,
     struct list *ps_list, *vs_list;
     WORD attribs_map;
     struct wined3d_string_buffer *tmp_name;
+    struct
+    {
+        WORD attribs_map;
+        BYTE integer_attribs;
+        BYTE dual_source;
+    } link_args;
 
     if (!(context_gl->c.shader_update_mask & (1u << WINED3D_SHADER_TYPE_VERTEX)) && ctx_data->glsl_program)
     {
@@ -10360,6 +10596,10 @@ static void set_glsl_shader_program(const struct wined3d_context_gl *context_gl,
         attribs_map = (1u << WINED3D_FFP_ATTRIBS_COUNT) - 1;
     }
 
+    link_args.attribs_map = attribs_map;
+    link_args.integer_attribs = vshader && vshader->reg_maps.shader_version.major >= 4;
+    link_args.dual_source = state->blend_state && state->blend_state->dual_source;
+
     if (!shader_glsl_use_explicit_attrib_location(gl_info))
     {
         /* Bind vertex attributes to a corresponding index number to match
@@ -10443,10 +10683,10 @@ static void set_glsl_shader_program(const struct wined3d_context_gl *context_gl,
         list_add_head(ps_list, &entry->ps.shader_entry);
     }
 
-    /* Link the program */
-    TRACE("Linking GLSL shader program %u.\n", program_id);
-    GL_EXTCALL(glLinkProgram(program_id));
-    shader_glsl_validate_link(gl_info, program_id);
+    /* Link the program. Transform feedback varyings are not part of the
+     * cache key, so programs using stream output are always linked. */
+    shader_glsl_link_program(gl_info, program_id, !(gshader && gshader->u.gs.so_desc),
+            &link_args, sizeof(link_args));
 
     shader_glsl_init_vs_uniform_locations(gl_info, priv, program_id, &entry->vs,
             vshader ? vshader->limits->constant_float : 0);
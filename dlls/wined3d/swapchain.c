@@ -566,6 +566,7 @@ static void swapchain_gl_present(struct wined3d_swapchain *swapchain,
     wined3d_swapchain_gl_rotate(swapchain, context);
 
     TRACE("SwapBuffers called, Starting new frame\n");
+    wined3d_device_gl_upload_heap_end_frame(wined3d_device_gl(swapchain->device));
 
     wined3d_texture_validate_location(swapchain->front_buffer, 0, WINED3D_LOCATION_DRAWABLE);
     wined3d_texture_invalidate_location(swapchain->front_buffer, 0, ~WINED3D_LOCATION_DRAWABLE);
@@ -1143,6 +1144,8 @@ static void swapchain_vk_present(struct wined3d_swapchain *swapchain, const RECT
     wined3d_texture_validate_location(swapchain->front_buffer, 0, WINED3D_LOCATION_DRAWABLE);
     wined3d_texture_invalidate_location(swapchain->front_buffer, 0, ~WINED3D_LOCATION_DRAWABLE);
 
+    wined3d_device_vk_update_pipeline_cache(wined3d_device_vk(swapchain->device));
+
     TRACE("Starting new frame.\n");
 
     context_release(&context_vk->c);
@@ -120,6 +120,7 @@ struct wined3d_settings wined3d_settings =
     ~0u,            /* No CS shader model limit by default. */
     WINED3D_RENDERER_AUTO,
     WINED3D_SHADER_BACKEND_AUTO,
+    NULL,           /* No shader cache by default. */
 };
 
 struct wined3d * CDECL wined3d_create(DWORD flags)
@@ -350,6 +351,21 @@ static BOOL wined3d_dll_init(HINSTANCE hInstDLL)
             else
                 memcpy(wined3d_settings.logo, buffer, len);
         }
+        if (!get_config_key(hkey, appkey, "ShaderCachePath", buffer, size) && *buffer)
+        {
+            size_t len = strlen(buffer) + 1;
+
+            if (!(wined3d_settings.shader_cache_path = heap_alloc(len)))
+            {
+                ERR("Failed to allocate shader cache path memory.\n");
+            }
+            else
+            {
+                memcpy(wined3d_settings.shader_cache_path, buffer, len);
+                CreateDirectoryA(wined3d_settings.shader_cache_path, NULL);
+                ERR_(winediag)("Using shader cache %s.\n", debugstr_a(wined3d_settings.shader_cache_path));
+            }
+        }
         if (!get_config_key_dword(hkey, appkey, "MultisampleTextures", &wined3d_settings.multisample_textures))
             ERR_(winediag)("Setting multisample textures to %#x.\n", wined3d_settings.multisample_textures);
         if (!get_config_key_dword(hkey, appkey, "SampleCount", &wined3d_settings.sample_count))
@@ -435,6 +451,7 @@ static BOOL wined3d_dll_destroy(HINSTANCE hInstDLL)
     heap_free(swapchain_state_table.hooks);
 
     heap_free(wined3d_settings.logo);
+    heap_free(wined3d_settings.shader_cache_path);
     UnregisterClassA(WINED3D_OPENGL_WINDOW_CLASS_NAME, hInstDLL);
 
     DeleteCriticalSection(&wined3d_wndproc_cs);
@@ -442,6 +442,7 @@ struct wined3d_settings
     unsigned int max_sm_cs;
     enum wined3d_renderer renderer;
     enum wined3d_shader_backend shader_backend;
+    char *shader_cache_path;
 };
 
 extern struct wined3d_settings wined3d_settings DECLSPEC_HIDDEN;
@@ -3361,6 +3362,10 @@ struct wined3d_adapter_vk
 
     VkPhysicalDeviceLimits device_limits;
     VkPhysicalDeviceMemoryProperties memory_properties;
+
+    uint32_t vendor_id;
+    uint32_t device_id;
+    uint8_t pipeline_cache_uuid[VK_UUID_SIZE];
 };
 
 static inline struct wined3d_adapter_vk *wined3d_adapter_vk(struct wined3d_adapter *adapter)
@@ -3792,12 +3797,34 @@ static inline struct wined3d_device_no3d *wined3d_device_no3d(struct wined3d_dev
     return CONTAINING_RECORD(device, struct wined3d_device_no3d, d);
 }
 
+#define WINED3D_UPLOAD_HEAP_SIZE            0x800000u
+#define WINED3D_UPLOAD_HEAP_SEGMENT_COUNT   4u
+#define WINED3D_UPLOAD_HEAP_ALIGNMENT       16u
+
+struct wined3d_upload_heap_gl
+{
+    GLuint id;
+    BYTE *map_ptr;
+    BOOL disabled;
+    size_t head;
+    unsigned int segment;
+    GLsync fences[WINED3D_UPLOAD_HEAP_SEGMENT_COUNT];
+
+    /* Statistics for the current frame. */
+    UINT64 upload_bytes;
+    unsigned int upload_count;
+    unsigned int direct_count;
+    unsigned int stall_count;
+};
+
 struct wined3d_device_gl
 {
     struct wined3d_device d;
 
     /* Textures for when no other textures are bound. */
     struct wined3d_dummy_textures dummy_textures;
+
+    struct wined3d_upload_heap_gl upload_heap;
 };
 
 static inline struct wined3d_device_gl *wined3d_device_gl(struct wined3d_device *device)
@@ -3805,6 +3832,11 @@ static inline struct wined3d_device_gl *wined3d_device_gl(struct wined3d_device
     return CONTAINING_RECORD(device, struct wined3d_device_gl, d);
 }
 
+BOOL wined3d_device_gl_upload_bo(struct wined3d_device_gl *device_gl, struct wined3d_context_gl *context_gl,
+        const struct wined3d_bo_gl *bo, const void *data, unsigned int data_offset,
+        unsigned int range_count, const struct wined3d_range *ranges) DECLSPEC_HIDDEN;
+void wined3d_device_gl_upload_heap_end_frame(struct wined3d_device_gl *device_gl) DECLSPEC_HIDDEN;
+
 struct wined3d_null_image_vk
 {
     VkImage vk_image;
@@ -3907,6 +3939,18 @@ void wined3d_allocator_cleanup(struct wined3d_allocator *allocator) DECLSPEC_HID
 bool wined3d_allocator_init(struct wined3d_allocator *allocator,
         size_t pool_count, const struct wined3d_allocator_ops *allocator_ops) DECLSPEC_HIDDEN;
 
+#define WINED3D_VK_PIPELINE_CACHE_MAX_SIZE  0x4000000u
+#define WINED3D_VK_PIPELINE_CACHE_STORE_MS  10000u
+#define WINED3D_VK_PIPELINE_HITCH_MS        4u
+
+struct wined3d_pipeline_statistics_vk
+{
+    unsigned int graphics_pipeline_count;
+    unsigned int hitch_count;
+    LONGLONG total_ticks;
+    LONGLONG max_ticks;
+};
+
 struct wined3d_device_vk
 {
     struct wined3d_device d;
@@ -3924,6 +3968,12 @@ struct wined3d_device_vk
     struct wined3d_null_views_vk null_views_vk;
 
     struct wined3d_allocator allocator;
+
+    VkPipelineCache vk_pipeline_cache;
+    size_t pipeline_cache_size;             /* size of the stored cache data */
+    unsigned int pipeline_cache_new_count;  /* pipelines created since the last store */
+    DWORD pipeline_cache_store_time;
+    struct wined3d_pipeline_statistics_vk pipeline_statistics;
 };
 
 static inline struct wined3d_device_vk *wined3d_device_vk(struct wined3d_device *device)
@@ -3939,6 +3989,7 @@ void wined3d_device_vk_destroy_null_resources(struct wined3d_device_vk *device_v
         struct wined3d_context_vk *context_vk) DECLSPEC_HIDDEN;
 void wined3d_device_vk_destroy_null_views(struct wined3d_device_vk *device_vk,
         struct wined3d_context_vk *context_vk) DECLSPEC_HIDDEN;
+void wined3d_device_vk_update_pipeline_cache(struct wined3d_device_vk *device_vk) DECLSPEC_HIDDEN;
 
 static inline float wined3d_alpha_ref(const struct wined3d_state *state)
 {
@@ -4593,12 +4644,29 @@ enum wined3d_push_constants
 
 #define WINED3D_CS_QUERY_POLL_INTERVAL  10u
 #define WINED3D_CS_QUEUE_SIZE           0x100000u
+#define WINED3D_CS_QUEUE_MAX_SIZE       0x1000000u
 #define WINED3D_CS_SPIN_COUNT           10000000u
+#define WINED3D_CS_WAIT_SPIN_COUNT      4096u
+#define WINED3D_CS_UPDATE_SUB_RESOURCE_COPY_SIZE 0x4000u
+
+struct wined3d_cs_queue_buffer
+{
+    struct wined3d_cs_queue_buffer *next;
+    /* Queue positions of the start of the buffer, and of its end once "next"
+     * is set. */
+    LONG base, end;
+    size_t size; /* A power of two. */
+    BYTE data[1];
+};
 
 struct wined3d_cs_queue
 {
+    /* Positions only ever increase, they are not wrapped to the buffer size. */
     LONG head, tail;
-    BYTE data[WINED3D_CS_QUEUE_SIZE];
+    /* The application writes to "head_buffer", the CS thread reads from
+     * "tail_buffer". They differ after the queue grew, until the CS thread
+     * reaches the end of the older buffers, which it frees. */
+    struct wined3d_cs_queue_buffer *head_buffer, *tail_buffer;
 };
 
 struct wined3d_cs_ops
@@ -4627,6 +4695,8 @@ struct wined3d_cs
 
     HANDLE event;
     BOOL waiting_for_event;
+    HANDLE progress_event;
+    BOOL waiting_for_progress;
     LONG pending_presents;
 };
 
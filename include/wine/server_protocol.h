@@ -2000,23 +2000,26 @@ struct process_info
     process_id_t    parent_pid;
     int             handle_count;
     int             unix_pid;
-    int             __pad;
+    unsigned int    generation;
 
 
 };
 
 
+
 struct list_processes_request
 {
     struct request_header __header;
-    char __pad_12[4];
+    unsigned int    generation;
 };
 struct list_processes_reply
 {
     struct reply_header __header;
     data_size_t     info_size;
     int             process_count;
+    unsigned int    generation;
     /* VARARG(data,process_info,info_size); */
+    char __pad_20[4];
 };
 
 
@@ -6205,7 +6208,7 @@ union generic_reply
 
 /* ### protocol_version begin ### */
 
-#define SERVER_PROTOCOL_VERSION 651
+#define SERVER_PROTOCOL_VERSION 652
 
 /* ### protocol_version end ### */
 
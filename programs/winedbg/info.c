@@ -101,6 +101,7 @@ void info_help(void)
             "  info display         Shows auto-display expressions in use",
             "  info except <pid>    Shows exception handler chain (in a given process)",
             "  info locals          Displays values of all local vars for current frame",
+            "  info locks           Lists the most contended named critical sections",
             "  info maps <pid>      Shows virtual mappings (in a given process)",
             "  info process         Shows all running processes",
             "  info reg             Displays values of the general registers at top of stack",
@@ -792,6 +793,94 @@ void info_win32_virtual(DWORD pid)
     if (pid != dbg_curr_pid) CloseHandle(hProc);
 }
 
+struct info_lock
+{
+    void*                       crit;
+    DWORD                       entry_count;
+    DWORD                       contention_count;
+    DWORD_PTR                   name;
+};
+
+static int info_lock_compare(const void* p1, const void* p2)
+{
+    const struct info_lock*     lock1 = p1;
+    const struct info_lock*     lock2 = p2;
+
+    if (lock1->contention_count != lock2->contention_count)
+        return lock1->contention_count > lock2->contention_count ? -1 : 1;
+    if (lock1->entry_count != lock2->entry_count)
+        return lock1->entry_count > lock2->entry_count ? -1 : 1;
+    return 0;
+}
+
+void info_win32_locks(void)
+{
+    struct dbg_lvalue           lvalue;
+    RTL_CRITICAL_SECTION_DEBUG  debug;
+    RTL_CRITICAL_SECTION_DEBUG** sections = NULL;
+    char*                       table;
+    ULONG                       count, i;
+    struct info_lock*           locks = NULL;
+    unsigned                    num_used = 0;
+    char                        name[128];
+
+    if (!dbg_curr_process || !dbg_curr_thread)
+    {
+        dbg_printf("Cannot get info on locks while no process is loaded\n");
+        return;
+    }
+
+    if (symbol_get_lvalue("RtlContendedSections", -1, &lvalue, FALSE) != sglv_found)
+    {
+        dbg_printf("Unable to find the critical section table\n");
+        return;
+    }
+    /* the table is a ULONG count followed by a pointer aligned array of debug infos */
+    table = memory_to_linear_addr(&lvalue.addr);
+    if (!dbg_read_memory(table, &count, sizeof(count))) return;
+    if (count)
+    {
+        count = min(count, 65536);
+        sections = malloc(count * sizeof(*sections));
+        locks = malloc(count * sizeof(*locks));
+        if (!sections || !locks || !dbg_read_memory(table + sizeof(void*), sections, count * sizeof(*sections)))
+            count = 0;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        /* entries may point to modules that have been unloaded since */
+        if (!dbg_read_memory(sections[i], &debug, sizeof(debug))) continue;
+        locks[num_used].crit = debug.CriticalSection;
+        locks[num_used].entry_count = debug.EntryCount;
+        locks[num_used].contention_count = debug.ContentionCount;
+        locks[num_used].name = debug.Spare[0];
+        num_used++;
+    }
+
+    if (!num_used)
+    {
+        dbg_printf("No contended named critical section\n");
+        free(sections);
+        free(locks);
+        return;
+    }
+    qsort(locks, num_used, sizeof(*locks), info_lock_compare);
+
+    /* columns are in sort order: waits first, then contended entries */
+    dbg_printf("%-*s %10s %10s name\n", ADDRWIDTH, "section", "waited", "contended");
+    for (i = 0; i < num_used; i++)
+    {
+        if (!locks[i].name ||
+            !memory_get_string(dbg_curr_process, (void*)locks[i].name, TRUE, FALSE, name, sizeof(name)))
+            strcpy(name, "?");
+        dbg_printf("%0*lx %10u %10u %s\n", ADDRWIDTH, (DWORD_PTR)locks[i].crit,
+                   locks[i].contention_count, locks[i].entry_count, name);
+    }
+    free(sections);
+    free(locks);
+}
+
 void info_wine_dbg_channel(BOOL turn_on, const char* cls, const char* name)
 {
     struct dbg_lvalue           lvalue;
@@ -53,6 +53,7 @@
 /* process structure */
 
 static struct list process_list = LIST_INIT(process_list);
+static unsigned int process_info_generation;  /* generation of the last list_processes change */
 static int running_processes, user_processes;
 static struct event *shutdown_event;           /* signaled when shutdown starts */
 static struct timeout_user *shutdown_timeout;  /* timeout for server shutdown */
@@ -553,6 +554,7 @@ struct process *create_process( int fd, struct process *parent, int inherit_all,
 
     process->end_time = 0;
     list_add_tail( &process_list, &process->entry );
+    process_info_changed( process );
 
     if (sd && !default_set_sd( &process->obj, sd, OWNER_SECURITY_INFORMATION | GROUP_SECURITY_INFORMATION |
                                DACL_SECURITY_INFORMATION | SACL_SECURITY_INFORMATION ))
@@ -825,6 +827,7 @@ static struct process_dll *process_load_dll( struct process *process, mod_handle
             return NULL;
         }
         list_add_tail( &process->dlls, &dll->entry );
+        if (list_head( &process->dlls ) == &dll->entry) process_info_changed( process );
     }
     return dll;
 }
@@ -943,10 +946,18 @@ static void process_killed( struct process *process )
     wake_up( &process->obj, 0 );
 }
 
+/* mark the information returned by list_processes as changed for a process */
+void process_info_changed( struct process *process )
+{
+    if (!++process_info_generation) process_info_generation = 1;  /* 0 requests a full snapshot */
+    process->info_generation = process_info_generation;
+}
+
 /* add a thread to a process running threads list */
 void add_process_thread( struct process *process, struct thread *thread )
 {
     list_add_tail( &process->thread_list, &thread->proc_entry );
+    process_info_changed( process );
     if (!process->running_threads++)
     {
         running_processes++;
@@ -969,6 +980,7 @@ void remove_process_thread( struct process *process, struct thread *thread )
     assert( !list_empty( &process->thread_list ));
 
     list_remove( &thread->proc_entry );
+    process_info_changed( process );
 
     if (!--process->running_threads)
     {
@@ -1391,6 +1403,7 @@ DECL_HANDLER(init_process_done)
 
     process->ldt_copy = req->ldt_copy;
     process->start_time = current_time;
+    process_info_changed( process );
     current->entry_point = req->entry;
     if (process->exe_file) release_object( process->exe_file );
     process->exe_file = NULL;
@@ -1528,7 +1541,11 @@ DECL_HANDLER(set_process_info)
 
     if ((process = get_process_from_handle( req->handle, PROCESS_SET_INFORMATION )))
     {
-        if (req->mask & SET_PROCESS_INFO_PRIORITY) process->priority = req->priority;
+        if (req->mask & SET_PROCESS_INFO_PRIORITY)
+        {
+            process->priority = req->priority;
+            process_info_changed( process );
+        }
         if (req->mask & SET_PROCESS_INFO_AFFINITY) set_process_affinity( process, req->affinity );
         release_object( process );
     }
@@ -1834,21 +1851,26 @@ DECL_HANDLER(list_processes)
 {
     struct process *process;
     struct thread *thread;
-    unsigned int pos = 0;
+    unsigned int pos = 0, generation = req->generation;
     char *buffer;
 
+    /* a generation from the future means the counter wrapped, send everything */
+    if (generation > process_info_generation) generation = 0;
+
     reply->process_count = 0;
     reply->info_size = 0;
+    reply->generation = process_info_generation;
 
     LIST_FOR_EACH_ENTRY( process, &process_list, struct process, entry )
     {
         struct process_dll *exe = get_process_exe_module( process );
         reply->info_size = (reply->info_size + 7) & ~7;
         reply->info_size += sizeof(struct process_info);
+        reply->process_count++;
+        if (process->info_generation <= generation) continue;  /* unchanged, name and threads omitted */
         if (exe) reply->info_size += exe->namelen;
         reply->info_size = (reply->info_size + 7) & ~7;
         reply->info_size += process->running_threads * sizeof(struct thread_info);
-        reply->process_count++;
     }
 
     if (reply->info_size > get_reply_max_size())
@@ -1868,15 +1890,18 @@ DECL_HANDLER(list_processes)
         pos = (pos + 7) & ~7;
         process_info = (struct process_info *)(buffer + pos);
         process_info->start_time = process->start_time;
-        process_info->name_len = exe ? exe->namelen : 0;
-        process_info->thread_count = process->running_threads;
         process_info->priority = process->priority;
         process_info->pid = process->id;
         process_info->parent_pid = process->parent_id;
         process_info->handle_count = get_handle_table_count(process);
         process_info->unix_pid = process->unix_pid;
+        process_info->generation = process->info_generation;
         pos += sizeof(*process_info);
 
+        if (process->info_generation <= generation) continue;  /* name_len and thread_count left at 0 */
+        process_info->name_len = exe ? exe->namelen : 0;
+        process_info->thread_count = process->running_threads;
+
         if (exe)
         {
             memcpy( buffer + pos, exe->filename, exe->namelen );
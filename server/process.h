@@ -71,6 +71,7 @@ struct process
     timeout_t            end_time;        /* absolute time at process end */
     affinity_t           affinity;        /* process affinity mask */
     int                  priority;        /* priority class */
+    unsigned int         info_generation; /* generation of the last change to the listed info */
     int                  suspend;         /* global process suspend count */
     unsigned int         is_system:1;     /* is it a system process? */
     unsigned int         debug_children:1;/* also debug all child processes */
@@ -119,6 +120,7 @@ extern int process_set_debugger( struct process *process, struct thread *thread
 extern int debugger_detach( struct process* process, struct thread* debugger );
 extern int set_process_debug_flag( struct process *process, int flag );
 
+extern void process_info_changed( struct process *process );
 extern void add_process_thread( struct process *process,
                                 struct thread *thread );
 extern void remove_process_thread( struct process *process,
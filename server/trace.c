@@ -1151,9 +1151,9 @@ static void dump_varargs_process_info( const char *prefix, data_size_t size )
         if (size - pos < sizeof(*process)) break;
         if (pos) fputc( ',', stderr );
         dump_timeout( "{start_time=", &process->start_time );
-        fprintf( stderr, ",thread_count=%u,priority=%d,pid=%04x,parent_pid=%04x,handle_count=%u,unix_pid=%d,",
+        fprintf( stderr, ",thread_count=%u,priority=%d,pid=%04x,parent_pid=%04x,handle_count=%u,unix_pid=%d,generation=%08x,",
                  process->thread_count, process->priority, process->pid,
-                 process->parent_pid, process->handle_count, process->unix_pid );
+                 process->parent_pid, process->handle_count, process->unix_pid, process->generation );
         pos += sizeof(*process);
 
         pos = dump_inline_unicode_string( "name=L\"", pos, process->name_len, size );
@@ -2150,12 +2150,14 @@ static void dump_is_same_mapping_request( const struct is_same_mapping_request *
 
 static void dump_list_processes_request( const struct list_processes_request *req )
 {
+    fprintf( stderr, " generation=%08x", req->generation );
 }
 
 static void dump_list_processes_reply( const struct list_processes_reply *req )
 {
     fprintf( stderr, " info_size=%u", req->info_size );
     fprintf( stderr, ", process_count=%d", req->process_count );
+    fprintf( stderr, ", generation=%08x", req->generation );
     dump_varargs_process_info( ", data=", min(cur_size,req->info_size) );
 }
 